@@ -0,0 +1,14 @@
+#include "Benchmark.h"
+
+#include <iostream>
+#include <string>
+
+// Stand-alone entry point for the processing benchmarks. Unlike the main
+// application it has no Windows dependencies, so it also builds on the
+// Linux hosts.
+//
+// Usage: RGBStreamerBench [name|all]
+int main(int argc, char* argv[]) {
+    const std::string name = argc > 1 ? argv[1] : "all";
+    return runBenchmark(name) ? 0 : 1;
+}
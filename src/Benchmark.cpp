@@ -0,0 +1,1931 @@
+#include "Benchmark.h"
+#include "ChangeGate.h"
+#include "DeltaCodec.h"
+#include "DominantColor.h"
+#include "FramePool.h"
+#include "FramePyramid.h"
+#include "FrameScheduler.h"
+#include "FrameView.h"
+#include "IntegralImage.h"
+#include "LatencyWindow.h"
+#include "LatestMailbox.h"
+#include "LedProtocol.h"
+#include "LedSampler.h"
+#include "LetterboxDetector.h"
+#include "PayloadFormat.h"
+#include "PixelFormats.h"
+#include "PixelKernels.h"
+#include "ProtocolDecoder.h"
+#include "RGBProcessor.h"
+#include "SendPacer.h"
+#include "SpscRing.h"
+#include "ThreadTuning.h"
+#include "WorkerPool.h"
+#include "UDPSender.h"
+#include "ZoneExtractor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// CPU frame owning its pixels, used as benchmark input
+struct SyntheticFrame {
+    std::vector<uint8_t> pixels;
+    FrameView view;
+};
+
+//----------------------------------------------------------------------
+// makeFrame
+//----------------------------------------------------------------------
+// Fill a frame with deterministic noise. The row pitch is padded the
+// way GPU staging textures usually are.
+//----------------------------------------------------------------------
+SyntheticFrame makeFrame(int width, int height, PixelFormat format, uint32_t seed) {
+    SyntheticFrame f;
+    const size_t pitch = (static_cast<size_t>(width) * 4 + 255) & ~static_cast<size_t>(255);
+    f.pixels.resize(pitch * height);
+    std::mt19937 rng(seed);
+    for (auto& b : f.pixels)
+        b = static_cast<uint8_t>(rng());
+    f.view.data = f.pixels.data();
+    f.view.width = width;
+    f.view.height = height;
+    f.view.rowPitch = pitch;
+    f.view.format = format;
+    return f;
+}
+
+//----------------------------------------------------------------------
+// nsPerCall
+//----------------------------------------------------------------------
+// Run `fn` repeatedly for roughly `budgetMs` and return the mean time
+// per call in nanoseconds.
+//----------------------------------------------------------------------
+template <typename Fn>
+double nsPerCall(Fn&& fn, int budgetMs = 300) {
+    using clock = std::chrono::steady_clock;
+    fn(); // warm caches and lazy initialisation
+    const auto budget = std::chrono::milliseconds(budgetMs);
+    const auto start = clock::now();
+    long long calls = 0;
+    while (clock::now() - start < budget) {
+        fn();
+        ++calls;
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+    return static_cast<double>(elapsed.count()) / static_cast<double>(calls);
+}
+
+void printRow(const std::string& label, double ns) {
+    std::cout << "  " << std::left << std::setw(28) << label << std::right
+              << std::setw(12) << std::fixed << std::setprecision(1) << ns / 1000.0
+              << " us/frame\n";
+}
+
+//----------------------------------------------------------------------
+// benchAverage
+//----------------------------------------------------------------------
+// Time every available row kernel against the scalar reference at
+// 1080p and 4K.
+//----------------------------------------------------------------------
+bool benchAverage() {
+    const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+    std::cout << "average (active kernel: " << kernelIsaName(detectKernelIsa()) << ")\n";
+
+    for (const auto& size : sizes) {
+        auto frame = makeFrame(size[0], size[1], PixelFormat::BGRA8, 1234);
+        std::cout << " " << size[0] << "x" << size[1] << "\n";
+        printRow("reference", nsPerCall([&] { getRGBAverageScalar(frame.view); }));
+
+        for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::NEON}) {
+            RowSumKernel kernel = rowSumKernel(isa);
+            if (!kernel)
+                continue;
+            uint64_t lanes[3] = {0, 0, 0};
+            printRow(kernelIsaName(isa), nsPerCall([&] {
+                for (int y = 0; y < frame.view.height; ++y)
+                    kernel(frame.view.row(y), frame.view.width, lanes);
+            }));
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// benchParallel
+//----------------------------------------------------------------------
+// Scale the band reduction over 1..N threads at 4K and 8K and check
+// that the merged result matches the single-threaded one.
+//----------------------------------------------------------------------
+bool benchParallel() {
+    bool ok = true;
+    const int sizes[][2] = {{3840, 2160}, {7680, 4320}};
+    const int maxThreads = (std::max)(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::cout << "parallel (up to " << maxThreads << " threads)\n";
+
+    for (const auto& size : sizes) {
+        auto frame = makeFrame(size[0], size[1], PixelFormat::BGRA8, 42);
+        const auto expected = getRGBAverage(frame.view);
+        std::cout << " " << size[0] << "x" << size[1] << "\n";
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            WorkerPool pool(threads);
+            printRow(std::to_string(threads) + " thread(s)",
+                     nsPerCall([&] { getRGBAverage(frame.view, &pool); }));
+            if (getRGBAverage(frame.view, &pool) != expected) {
+                std::cout << "  MISMATCH with " << threads << " threads\n";
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// makeCorpus
+//----------------------------------------------------------------------
+// Frames that stress sampling: noise, smooth gradients, a sparse grid
+// of one-pixel UI lines on black and a mostly dark desktop with a single
+// bright window.
+//----------------------------------------------------------------------
+std::vector<SyntheticFrame> makeCorpus(int width, int height) {
+    std::vector<SyntheticFrame> corpus;
+    corpus.push_back(makeFrame(width, height, PixelFormat::BGRA8, 7));
+
+    auto fill = [&](auto&& pixel) {
+        SyntheticFrame f = makeFrame(width, height, PixelFormat::BGRA8, 0);
+        for (int y = 0; y < height; ++y) {
+            uint8_t* row = f.pixels.data() + y * f.view.rowPitch;
+            for (int x = 0; x < width; ++x) {
+                uint8_t* px = row + x * 4;
+                pixel(x, y, px);
+                px[3] = 255;
+            }
+        }
+        corpus.push_back(std::move(f));
+    };
+
+    fill([&](int x, int y, uint8_t* px) {
+        px[0] = static_cast<uint8_t>(x * 255 / width);
+        px[1] = static_cast<uint8_t>(y * 255 / height);
+        px[2] = static_cast<uint8_t>(255 - x * 255 / width);
+    });
+    fill([&](int x, int y, uint8_t* px) {
+        const uint8_t v = (x % 8 == 0 || y % 16 == 0) ? 255 : 0;
+        px[0] = px[1] = px[2] = v;
+    });
+    fill([&](int x, int y, uint8_t* px) {
+        const bool window = x > width / 3 && x < width / 2 && y > height / 4 && y < height / 2;
+        px[0] = window ? 40 : 18;
+        px[1] = window ? 60 : 18;
+        px[2] = window ? 230 : 20;
+    });
+    return corpus;
+}
+
+//----------------------------------------------------------------------
+// benchSampling
+//----------------------------------------------------------------------
+// Report the cost and the maximum error of strided and budgeted
+// sampling against the full average on the corpus.
+//----------------------------------------------------------------------
+bool benchSampling() {
+    const int width = 3840, height = 2160;
+    auto corpus = makeCorpus(width, height);
+    std::vector<FrameView> views;
+    for (const auto& f : corpus)
+        views.push_back(f.view);
+
+    struct Case {
+        const char* label;
+        SamplingOptions options;
+    };
+    const Case cases[] = {
+        {"full", {}},
+        {"stride 2x2", {2, 2, 0}},
+        {"stride 4x4", {4, 4, 0}},
+        {"stride 8x8", {8, 8, 0}},
+        {"stride 16x8", {16, 8, 0}},
+        {"budget 65536", {1, 1, 65536}},
+        {"budget 16384", {1, 1, 16384}},
+    };
+
+    std::cout << "sampling " << width << "x" << height << " (" << views.size()
+              << " frames, max/mean error in 8-bit steps)\n";
+    for (const auto& c : cases) {
+        const SamplingError err = measureSamplingError(views, c.options);
+        const double ns = nsPerCall([&] { getRGBAverageSampled(views[0], c.options); });
+        std::cout << "  " << std::left << std::setw(28) << c.label << std::right
+                  << std::setw(12) << std::fixed << std::setprecision(1) << ns / 1000.0
+                  << " us/frame  max " << err.maxError << "  mean "
+                  << std::setprecision(2) << err.meanError << "\n";
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// benchZones
+//----------------------------------------------------------------------
+// Single-pass zone extraction against one full-frame average and against
+// averaging every zone separately, which is also the reference result.
+//----------------------------------------------------------------------
+bool benchZones() {
+    bool ok = true;
+    const int width = 3840, height = 2160;
+    auto frame = makeFrame(width, height, PixelFormat::BGRA8, 5);
+    ZoneLayout layout;
+    layout.top = layout.bottom = 32;
+    layout.left = layout.right = 18;
+    layout.depth = 160;
+    ZoneExtractor extractor;
+    extractor.setLayout(layout);
+
+    // Reference: crop every zone and average it on its own
+    const FrameView& v = frame.view;
+    const int d = layout.depth;
+    std::vector<std::array<int, 3>> expected;
+    for (int i = 0; i < layout.top; ++i) {
+        const int x0 = i * width / layout.top, x1 = (i + 1) * width / layout.top;
+        expected.push_back(getRGBAverageScalar(v.crop(x0, 0, x1 - x0, d)));
+    }
+    auto rowRange = [&](int k, int n, int& y0, int& y1) {
+        y0 = (k * height + n - 1) / n;
+        y1 = ((k + 1) * height + n - 1) / n;
+    };
+    for (int k = 0; k < layout.right; ++k) {
+        int y0, y1;
+        rowRange(k, layout.right, y0, y1);
+        expected.push_back(getRGBAverageScalar(v.crop(width - d, y0, d, y1 - y0)));
+    }
+    for (int i = layout.bottom - 1; i >= 0; --i) {
+        const int x0 = i * width / layout.bottom, x1 = (i + 1) * width / layout.bottom;
+        expected.push_back(getRGBAverageScalar(v.crop(x0, height - d, x1 - x0, d)));
+    }
+    for (int k = layout.left - 1; k >= 0; --k) {
+        int y0, y1;
+        rowRange(k, layout.left, y0, y1);
+        expected.push_back(getRGBAverageScalar(v.crop(0, y0, d, y1 - y0)));
+    }
+
+    std::vector<Rgb8> zones;
+    std::cout << "zones " << width << "x" << height << " (" << layout.count()
+              << " zones, depth " << d << ")\n";
+    printRow("full-frame average", nsPerCall([&] { getRGBAverage(v); }));
+    printRow("single pass", nsPerCall([&] { extractor.extract(v, zones); }));
+    printRow("one average per zone", nsPerCall([&] {
+        for (int i = 0; i < layout.top; ++i)
+            getRGBAverage(v.crop(i * width / layout.top, 0, width / layout.top, d));
+        for (int i = 0; i < layout.bottom; ++i)
+            getRGBAverage(v.crop(i * width / layout.bottom, height - d, width / layout.bottom, d));
+        for (int k = 0; k < layout.left; ++k)
+            getRGBAverage(v.crop(0, k * height / layout.left, d, height / layout.left));
+        for (int k = 0; k < layout.right; ++k)
+            getRGBAverage(v.crop(width - d, k * height / layout.right, d, height / layout.right));
+    }));
+
+    extractor.extract(v, zones);
+    for (size_t z = 0; z < zones.size(); ++z) {
+        if (zones[z][0] != expected[z][0] || zones[z][1] != expected[z][1] ||
+            zones[z][2] != expected[z][2]) {
+            std::cout << "  MISMATCH in zone " << z << "\n";
+            ok = false;
+        }
+    }
+    return ok && zones.size() == expected.size();
+}
+
+//----------------------------------------------------------------------
+// benchRegions
+//----------------------------------------------------------------------
+// Summed-area table build cost at full resolution and on the default
+// 128x72 thumbnail (the pyramid pass included), and per-region lookup
+// cost, checked against averaging each cropped region directly.
+//----------------------------------------------------------------------
+bool benchRegions() {
+    bool ok = true;
+    const int sizes[][2] = {{1920, 1080}, {3840, 2160}, {7680, 4320}};
+    std::cout << "regions\n";
+    for (const auto& size : sizes) {
+        auto frame = makeFrame(size[0], size[1], PixelFormat::RGBA8, 11);
+        IntegralImage sat;
+        sat.build(frame.view);
+        std::cout << " " << size[0] << "x" << size[1]
+                  << (sat.uses64Bit() ? " (64-bit)" : " (32-bit)") << "\n";
+        printRow("build full-frame table", nsPerCall([&] { sat.build(frame.view); }));
+        FramePyramid pyramid;
+        pyramid.setTargetSize(128, 72);
+        IntegralImage thumbSat;
+        printRow("thumbnail and table", nsPerCall([&] { thumbSat.build(pyramid.build(frame.view)); }));
+        const FrameView& thumb = pyramid.thumbnail();
+        for (int y = 0; y < thumb.height && ok; y += 7) {
+            for (int x = 0; x < thumb.width && ok; x += 5) {
+                const int w = (std::min)(13, thumb.width - x), h = (std::min)(11, thumb.height - y);
+                if (thumbSat.average(x, y, w, h) != getRGBAverageScalar(thumb.crop(x, y, w, h))) {
+                    std::cout << "  MISMATCH in thumbnail table at " << x << "," << y << "\n";
+                    ok = false;
+                }
+            }
+        }
+
+        std::mt19937 rng(3);
+        std::vector<std::array<int, 4>> rects;
+        for (int i = 0; i < 64; ++i) {
+            const int w = 1 + static_cast<int>(rng() % size[0]);
+            const int h = 1 + static_cast<int>(rng() % size[1]);
+            const int x = static_cast<int>(rng() % (size[0] - w + 1));
+            const int y = static_cast<int>(rng() % (size[1] - h + 1));
+            rects.push_back({x, y, w, h});
+        }
+        printRow("64 region lookups", nsPerCall([&] {
+            for (const auto& r : rects)
+                sat.average(r[0], r[1], r[2], r[3]);
+        }));
+        for (const auto& r : rects) {
+            if (sat.average(r[0], r[1], r[2], r[3]) !=
+                getRGBAverageScalar(frame.view.crop(r[0], r[1], r[2], r[3]))) {
+                std::cout << "  MISMATCH for region " << r[0] << "," << r[1] << " "
+                          << r[2] << "x" << r[3] << "\n";
+                ok = false;
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// benchLeds
+//----------------------------------------------------------------------
+// Kernel rebuild and evaluation for a few thousand LEDs around a 4K
+// frame, read from the pyramid the analyzer would build for them. On a
+// solid-color frame every LED must come out exactly as that color,
+// which checks weight normalization and channel order; on a one-pixel
+// checkerboard every LED must come out mid-gray, which checks that
+// footprints average their area instead of aliasing.
+//----------------------------------------------------------------------
+bool benchLeds() {
+    const int width = 3840, height = 2160;
+    std::vector<LedSpot> leds;
+    for (int i = 0; i < 2000; ++i) {
+        // Ellipse hugging the screen border with a wobble, like a curved TV
+        const double a = i * 2.0 * 3.14159265358979 / 2000.0;
+        LedSpot led;
+        led.x = 0.5 + 0.48 * std::cos(a);
+        led.y = 0.5 + (0.46 + 0.02 * std::sin(7 * a)) * std::sin(a);
+        led.radius = i % 2 ? 0.03 : 0.12;
+        leds.push_back(led);
+    }
+    LedSampler sampler;
+    sampler.setLayout(leds);
+    FramePyramid pyramid;
+    pyramid.setTargetSize(128, (std::max)(72, sampler.detailHeight()));
+
+    auto frame = makeFrame(width, height, PixelFormat::BGRA8, 21);
+    pyramid.build(frame.view);
+    std::vector<Rgb8> out;
+    sampler.sample(pyramid, out);
+    std::cout << "leds " << width << "x" << height << " (" << leds.size() << " LEDs, "
+              << sampler.tapCount() << " taps)\n";
+    printRow("rebuild kernels", nsPerCall([&] {
+        sampler.setLayout(leds);
+        sampler.sample(pyramid, out);
+    }));
+    printRow("sample all LEDs", nsPerCall([&] { sampler.sample(pyramid, out); }));
+
+    bool ok = true;
+    for (size_t i = 0; i < frame.pixels.size(); i += 4) {
+        frame.pixels[i + 0] = 30;  // B
+        frame.pixels[i + 1] = 140; // G
+        frame.pixels[i + 2] = 250; // R
+    }
+    pyramid.build(frame.view);
+    sampler.sample(pyramid, out);
+    for (const auto& c : out) {
+        if (c[0] != 250 || c[1] != 140 || c[2] != 30) {
+            std::cout << "  MISMATCH on solid frame\n";
+            ok = false;
+            break;
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = frame.pixels.data() + y * frame.view.rowPitch;
+        for (int x = 0; x < width; ++x)
+            std::memset(row + x * 4, (x + y) % 2 ? 255 : 0, 4);
+    }
+    pyramid.build(frame.view);
+    sampler.sample(pyramid, out);
+    for (const auto& c : out) {
+        if (std::abs(c[0] - 128) > 1 || std::abs(c[1] - 128) > 1 || std::abs(c[2] - 128) > 1) {
+            std::cout << "  ALIASING on checkerboard: " << int(c[0]) << "," << int(c[1]) << ","
+                      << int(c[2]) << "\n";
+            ok = false;
+            break;
+        }
+    }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// benchPyramid
+//----------------------------------------------------------------------
+// Cost of reducing 1080p and 4K frames to 64x36 and 128x72 thumbnails,
+// which also yields the frame average, compared with one full-frame
+// average. Timings alternate and keep the best of five rounds, and the
+// pass must not cost more than the average it replaces.
+//----------------------------------------------------------------------
+bool benchPyramid() {
+    bool ok = true;
+    const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+    const int targets[][2] = {{64, 36}, {128, 72}};
+    std::cout << "pyramid\n";
+    for (const auto& size : sizes) {
+        auto frame = makeFrame(size[0], size[1], PixelFormat::BGRA8, 8);
+        for (const auto& target : targets) {
+            FramePyramid pyramid;
+            pyramid.setTargetSize(target[0], target[1]);
+            const FrameView thumb = pyramid.build(frame.view);
+            std::cout << " " << size[0] << "x" << size[1] << " -> " << thumb.width << "x"
+                      << thumb.height << " (target " << target[0] << "x" << target[1] << ", "
+                      << pyramid.levelCount() << " levels)\n";
+            double averageNs = 1e30, buildNs = 1e30;
+            for (int round = 0; round < 5; ++round) {
+                averageNs = (std::min)(averageNs, nsPerCall([&] { getRGBAverage(frame.view); }, 60));
+                buildNs = (std::min)(buildNs, nsPerCall([&] { pyramid.build(frame.view); }, 60));
+            }
+            printRow("full-frame average", averageNs);
+            printRow("thumbnail and average", buildNs);
+            if (buildNs > averageNs) {
+                std::cout << "  thumbnail costs more than the average it replaces\n";
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// benchDominant
+//----------------------------------------------------------------------
+// Cost of the dominant mode (thumbnail plus histogram, with and without
+// k-means refinement) against the mean path at 1080p and 4K. The left
+// 70% of the test frame is one slightly jittered color, the rest is
+// noise, and that color must be found.
+//----------------------------------------------------------------------
+bool benchDominant() {
+    bool ok = true;
+    const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+    const std::array<int, 3> expected = {200, 90, 40};
+    std::cout << "dominant (thumbnail 128x72)\n";
+    for (const auto& size : sizes) {
+        auto frame = makeFrame(size[0], size[1], PixelFormat::BGRA8, 9);
+        std::mt19937 rng(10);
+        for (int y = 0; y < frame.view.height; ++y) {
+            uint8_t* row = frame.pixels.data() + y * frame.view.rowPitch;
+            for (int x = 0; x < frame.view.width * 7 / 10; ++x) {
+                const int jitter = static_cast<int>(rng() % 7) - 3;
+                row[x * 4 + 0] = static_cast<uint8_t>(expected[2] + jitter);
+                row[x * 4 + 1] = static_cast<uint8_t>(expected[1] + jitter);
+                row[x * 4 + 2] = static_cast<uint8_t>(expected[0] + jitter);
+            }
+        }
+        std::cout << " " << size[0] << "x" << size[1] << "\n";
+        printRow("mean (full frame)", nsPerCall([&] { getRGBAverage(frame.view); }));
+
+        FramePyramid pyramid;
+        pyramid.setTargetSize(128, 72);
+        DominantColorExtractor extractor;
+        for (int iterations : {0, 3}) {
+            DominantOptions options;
+            options.kmeansIterations = iterations;
+            extractor.setOptions(options);
+            std::array<int, 3> color{};
+            const double ns = nsPerCall([&] { color = extractor.extract(pyramid.build(frame.view)); });
+            printRow(iterations == 0 ? "dominant (histogram)" : "dominant (+3 k-means)", ns);
+            for (int c = 0; c < 3; ++c) {
+                if (std::abs(color[c] - expected[c]) > 8) {
+                    std::cout << "  WRONG dominant color " << color[0] << "," << color[1] << ","
+                              << color[2] << "\n";
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// floatToHalf
+//----------------------------------------------------------------------
+// Round a value in [0, 1] to the nearest IEEE half bit pattern.
+//----------------------------------------------------------------------
+uint16_t floatToHalf(double v) {
+    if (v <= 0.0)
+        return 0;
+    int e = 0;
+    const double m = std::frexp(v, &e); // v = m * 2^e, m in [0.5, 1)
+    int exponent = e - 1 + 15;
+    if (exponent <= 0)
+        return static_cast<uint16_t>(std::lround(std::ldexp(v, 24)));
+    int mantissa = static_cast<int>(std::lround((2.0 * m - 1.0) * 1024.0));
+    if (mantissa == 1024) {
+        mantissa = 0;
+        ++exponent;
+    }
+    return static_cast<uint16_t>((exponent << 10) | mantissa);
+}
+
+//----------------------------------------------------------------------
+// benchFormats
+//----------------------------------------------------------------------
+// Averaging cost per pixel format and of linear-light averaging at
+// 1080p and 4K, on the same picture in every format.
+//----------------------------------------------------------------------
+bool benchFormats() {
+    const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+    std::cout << "formats\n";
+
+    for (const auto& size : sizes) {
+        auto frame = makeFrame(size[0], size[1], PixelFormat::RGBA8, 77);
+        SamplingOptions linear;
+        linear.linearLight = true;
+
+        // Same picture as 10-bit and as linear half floats
+        std::vector<uint8_t> tenBit(static_cast<size_t>(size[0]) * size[1] * 4);
+        std::vector<uint8_t> half(static_cast<size_t>(size[0]) * size[1] * 8);
+        for (int y = 0; y < size[1]; ++y) {
+            const uint8_t* src = frame.view.row(y);
+            for (int x = 0; x < size[0]; ++x) {
+                const uint8_t* px = src + x * 4;
+                uint32_t packed = 3u << 30;
+                uint16_t h[4] = {0, 0, 0, 0x3C00};
+                for (int c = 0; c < 3; ++c) {
+                    packed |= static_cast<uint32_t>((px[c] << 2) | (px[c] >> 6)) << (10 * c);
+                    h[c] = floatToHalf(srgbToLinear(px[c] / 255.0));
+                }
+                const size_t i = static_cast<size_t>(y) * size[0] + x;
+                std::memcpy(&tenBit[i * 4], &packed, 4);
+                std::memcpy(&half[i * 8], h, 8);
+            }
+        }
+        FrameView tenBitView{tenBit.data(), size[0], size[1], static_cast<size_t>(size[0]) * 4,
+                             PixelFormat::RGB10A2};
+        FrameView halfView{half.data(), size[0], size[1], static_cast<size_t>(size[0]) * 8,
+                           PixelFormat::RGBA16F};
+
+        std::cout << " " << size[0] << "x" << size[1] << "\n";
+        printRow("RGBA8 mean", nsPerCall([&] { getRGBAverage(frame.view); }));
+        printRow("RGBA8 linear light", nsPerCall([&] { getRGBAverage(frame.view, linear, nullptr); }));
+        printRow("RGB10A2 mean", nsPerCall([&] { getRGBAverage(tenBitView); }));
+        printRow("RGBA16F (linear)", nsPerCall([&] { getRGBAverage(halfView); }));
+
+        const uint16_t* table = linearLightTable(PixelFormat::RGBA8);
+        for (KernelIsa isa : {KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::AVX512, KernelIsa::NEON}) {
+            const TableRowSumKernel kernel = tableRowSumKernel(isa);
+            if (!kernel)
+                continue;
+            uint64_t sums[3] = {0, 0, 0};
+            printRow(std::string("RGBA8 linear light, ") + kernelIsaName(isa), nsPerCall([&] {
+                for (int y = 0; y < size[1]; ++y)
+                    kernel(frame.view.row(y), size[0], table, sums);
+            }));
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// benchLetterbox
+//----------------------------------------------------------------------
+// Detect the bars of a 2.39:1 movie in a 4K frame, check that a dark
+// frame does not move them at once, and compare the per-frame cost of
+// the detector with the time saved by averaging only the picture.
+//----------------------------------------------------------------------
+bool benchLetterbox() {
+    bool ok = true;
+    const int w = 3840, h = 2160;
+    const int bar = (h - static_cast<int>(w / 2.39)) / 2;
+    auto frame = makeFrame(w, h, PixelFormat::BGRA8, 11);
+    for (int y = 0; y < h; ++y) {
+        if (y < bar || y >= h - bar)
+            std::fill_n(frame.pixels.data() + y * frame.view.rowPitch, w * 4, static_cast<uint8_t>(0));
+    }
+    std::cout << "letterbox " << w << "x" << h << " (bars " << bar << " rows)\n";
+
+    LetterboxOptions options;
+    LetterboxDetector detector;
+    detector.setOptions(options);
+    const int settleFrames = options.recheckFrames * options.stableChecks;
+    for (int i = 0; i < settleFrames; ++i)
+        detector.update(frame.view);
+    const ContentBounds expected{0, bar, w, h - 2 * bar};
+    if (!(detector.bounds() == expected)) {
+        const ContentBounds& b = detector.bounds();
+        std::cout << "  WRONG bounds " << b.x << "," << b.y << " " << b.width << "x" << b.height << "\n";
+        ok = false;
+    }
+
+    // One dark frame must not shrink the picture
+    auto dark = makeFrame(w, h, PixelFormat::BGRA8, 12);
+    std::fill(dark.pixels.begin(), dark.pixels.end(), static_cast<uint8_t>(0));
+    std::fill_n(dark.pixels.data() + (h / 2) * dark.view.rowPitch, w * 4, static_cast<uint8_t>(200));
+    for (int i = 0; i < options.recheckFrames; ++i)
+        detector.update(dark.view);
+    if (!(detector.bounds() == expected)) {
+        std::cout << "  bounds moved after a single dark scan\n";
+        ok = false;
+    }
+
+    LetterboxDetector scanning;
+    LetterboxOptions everyFrame;
+    everyFrame.recheckFrames = 1;
+    scanning.setOptions(everyFrame);
+    printRow("detector, one scan", nsPerCall([&] { scanning.update(frame.view); }));
+    printRow("detector, per frame", nsPerCall([&] { detector.update(frame.view); }));
+    const FrameView picture = frame.view.crop(expected.x, expected.y, expected.width, expected.height);
+    printRow("average, full frame", nsPerCall([&] { getRGBAverage(frame.view); }));
+    printRow("average, picture only", nsPerCall([&] { getRGBAverage(picture); }));
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// renderWithRegex
+//----------------------------------------------------------------------
+// The payload formatting UDPSender used before formats were compiled,
+// kept as the baseline: three regexes built and searched per packet.
+//----------------------------------------------------------------------
+std::string renderWithRegex(const std::string& format, const std::array<int, 3>& rgb) {
+    auto replaceFormat = [](const std::string& str, const std::string& pattern, int value) {
+        std::regex regexPattern(pattern);
+        std::smatch match;
+        std::string result = str;
+        while (std::regex_search(result, match, regexPattern)) {
+            std::string replacement;
+            if (match[1].matched) {
+                const int width = std::stoi(match[1].str());
+                char buf[32];
+                if (width == 1)
+                    std::snprintf(buf, sizeof(buf), "%d", value);
+                else
+                    std::snprintf(buf, sizeof(buf), "%0*d", width, value);
+                replacement = buf;
+            } else {
+                replacement = std::to_string(value);
+            }
+            result.replace(match.position(), match.length(), replacement);
+        }
+        return result;
+    };
+    std::string message = replaceFormat(format, R"(\{r(?::(\d+)d)?\})", rgb[0]);
+    message = replaceFormat(message, R"(\{g(?::(\d+)d)?\})", rgb[1]);
+    return replaceFormat(message, R"(\{b(?::(\d+)d)?\})", rgb[2]);
+}
+
+//----------------------------------------------------------------------
+// benchPayload
+//----------------------------------------------------------------------
+// ns per rendered payload: the regex path, the compiled program with
+// changing colors (cache misses) and with a steady color (cache hits).
+//----------------------------------------------------------------------
+bool benchPayload() {
+    bool ok = true;
+    const char* formats[] = {"R{r:03d}G{g:03d}B{b:03d}\n", "{r},{g},{b}",
+                             "{\"seg\":{\"col\":[[{r},{g},{b}]]}}"};
+    std::cout << "payload (ns per render)\n";
+    char buf[256];
+
+    for (const char* format : formats) {
+        PayloadFormat compiled;
+        compiled.compile(format);
+        std::cout << " " << std::regex_replace(format, std::regex("\n"), "\\n") << "\n";
+
+        // Compiled renders are timed in batches so the clock reads do
+        // not dominate
+        constexpr int kBatch = 1000;
+        int k = 0;
+        auto rotating = [&] {
+            ++k;
+            return std::array<int, 3>{k & 255, (k >> 8) & 255, (k * 7) & 255};
+        };
+        const std::array<int, 3> steady = {12, 34, 56};
+        size_t sink = 0;
+        auto printNs = [](const char* label, double ns) {
+            std::cout << "  " << std::left << std::setw(28) << label << std::right << std::setw(12)
+                      << std::fixed << std::setprecision(1) << ns << " ns\n";
+        };
+        printNs("regex", nsPerCall([&] { sink += renderWithRegex(format, rotating()).size(); }, 200));
+        printNs("compiled, new colors", nsPerCall([&] {
+            for (int b = 0; b < kBatch; ++b)
+                sink += compiled.render(rotating(), 0, buf, sizeof(buf));
+        }, 200) / kBatch);
+        printNs("compiled, steady color", nsPerCall([&] {
+            for (int b = 0; b < kBatch; ++b)
+                sink += compiled.render(steady, 0, buf, sizeof(buf));
+        }, 200) / kBatch);
+        if (sink == 0)
+            ok = false;
+    }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// benchProtocols
+//----------------------------------------------------------------------
+// Packets, bytes and encode time of a 300-LED frame with every binary
+// protocol.
+//----------------------------------------------------------------------
+bool benchProtocols() {
+    bool ok = true;
+    struct Named {
+        const char* name;
+        WireProtocol protocol;
+    };
+    const Named protocols[] = {{"ddp", WireProtocol::Ddp},
+                               {"e131", WireProtocol::E131},
+                               {"artnet", WireProtocol::ArtNet},
+                               {"wled", WireProtocol::Wled}};
+    std::cout << "protocols (encode per frame)\n";
+
+    for (const auto& named : protocols) {
+        ProtocolOptions options;
+        options.universe = named.protocol == WireProtocol::E131 ? 7 : 3;
+        ProtocolEncoder encoder(named.protocol, options);
+        std::vector<Rgb8> strip(300, Rgb8{10, 20, 30});
+        size_t bytes = 0, packets = 0;
+        for (const auto& packet : encoder.encode(strip.data(), strip.size())) {
+            bytes += packet.size;
+            ++packets;
+        }
+        size_t sink = 0;
+        const double ns = nsPerCall([&] { sink += encoder.encode(strip.data(), strip.size()).size(); });
+        std::cout << "  " << std::left << std::setw(8) << named.name << "300 LEDs: " << std::right
+                  << std::setw(2) << packets << " packets, " << std::setw(4) << bytes << " bytes, "
+                  << std::fixed << std::setprecision(1) << ns << " ns\n";
+        if (sink == 0)
+            ok = false;
+    }
+    return ok;
+}
+
+#ifndef _WIN32
+// UDP sockets bound to ephemeral loopback ports, standing in for devices
+struct LoopbackReceivers {
+    std::vector<int> sockets;
+    std::vector<sockaddr_in> addrs;
+
+    LoopbackReceivers() = default;
+    LoopbackReceivers(const LoopbackReceivers&) = delete;
+    LoopbackReceivers& operator=(const LoopbackReceivers&) = delete;
+    ~LoopbackReceivers() {
+        for (int s : sockets)
+            ::close(s);
+    }
+
+    bool open(int count) {
+        for (int i = 0; i < count; ++i) {
+            const int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            if (s < 0)
+                return false;
+            sockets.push_back(s);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t len = sizeof(addr);
+            if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+                getsockname(s, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+                return false;
+            addrs.push_back(addr);
+        }
+        return true;
+    }
+
+    // Empty every receive queue; returns how many receivers got `expected`
+    size_t drain(const std::string& expected) {
+        size_t got = 0;
+        std::vector<char> buf(2048);
+        for (int r : sockets) {
+            bool match = false;
+            ssize_t n;
+            while ((n = recv(r, buf.data(), buf.size(), MSG_DONTWAIT)) >= 0)
+                match = match || std::string(buf.data(), static_cast<size_t>(n)) == expected;
+            got += match ? 1 : 0;
+        }
+        return got;
+    }
+};
+#endif
+
+//----------------------------------------------------------------------
+// benchFanout
+//----------------------------------------------------------------------
+// Time sending one frame to 200 devices over loopback: one sendto per
+// device, one batched flush (a single sendmmsg on Linux) and a flush
+// over connected sockets. Every receiver must get its payload.
+//----------------------------------------------------------------------
+bool benchFanout() {
+#ifdef _WIN32
+    std::cout << "fanout: needs POSIX sockets for the receivers, skipped\n";
+    return true;
+#else
+    constexpr int kDevices = 200;
+    std::cout << "fanout (" << kDevices << " devices on loopback)\n";
+
+    LoopbackReceivers receivers;
+    if (!receivers.open(kDevices)) {
+        std::cout << "  cannot bind loopback receivers, skipped\n";
+        return true;
+    }
+
+    bool ok = true;
+    for (bool connected : {false, true}) {
+        UDPSender sender;
+        if (!sender.open() || !sender.setDestinations(receivers.addrs, connected)) {
+            std::cout << "  cannot open the sender\n";
+            ok = false;
+            break;
+        }
+        const std::array<int, 3> color = {1, 2, connected ? 4 : 3};
+        char expected[32];
+        std::snprintf(expected, sizeof(expected), "R%03dG%03dB%03d\n", color[0], color[1], color[2]);
+        for (int i = 0; i < kDevices; ++i)
+            sender.queue(static_cast<size_t>(i), color);
+        if (!sender.flush() || receivers.drain(expected) != kDevices) {
+            std::cout << "  batch " << (connected ? "(connected) " : "") << "did not reach every device\n";
+            ok = false;
+        }
+
+        // Receivers are not drained while timing; once their buffers are
+        // full the kernel drops the datagrams after the send path ran
+        if (!connected) {
+            char payload[] = "R001G002B003\n";
+            printRow("sendto per device", nsPerCall([&] {
+                for (const auto& addr : receivers.addrs)
+                    sender.sendPacket(addr, payload, sizeof(payload) - 1);
+            }));
+        }
+        printRow(connected ? "batch, connected sockets" : "batch (sendmmsg on Linux)", nsPerCall([&] {
+            for (int i = 0; i < kDevices; ++i)
+                sender.queue(static_cast<size_t>(i), color);
+            sender.flush();
+        }));
+        receivers.drain(expected);
+    }
+    return ok;
+#endif
+}
+
+//----------------------------------------------------------------------
+// benchMulticast
+//----------------------------------------------------------------------
+// One color for a room of 200 controllers on loopback: 200 unicast
+// datagrams in one batch versus a single datagram to a multicast group
+// all receivers joined. Every receiver must get the group datagram.
+// On loopback the kernel delivers to each member inside the send call;
+// on a network the sender's cost stays one datagram.
+//----------------------------------------------------------------------
+bool benchMulticast() {
+#ifdef _WIN32
+    std::cout << "multicast: needs POSIX sockets for the receivers, skipped\n";
+    return true;
+#else
+    constexpr int kDevices = 200;
+    std::cout << "multicast (" << kDevices << " controllers on loopback)\n";
+
+    LoopbackReceivers unicast;
+    if (!unicast.open(kDevices)) {
+        std::cout << "  cannot bind loopback receivers, skipped\n";
+        return true;
+    }
+    // Group members share the group's port
+    sockaddr_in group{};
+    group.sin_family = AF_INET;
+    group.sin_port = htons(47123);
+    inet_pton(AF_INET, "239.255.77.1", &group.sin_addr);
+    LoopbackReceivers members;
+    for (int i = 0; i < kDevices; ++i) {
+        const int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (s < 0)
+            break;
+        members.sockets.push_back(s);
+        const int on = 1;
+        ip_mreq mreq{};
+        mreq.imr_multiaddr = group.sin_addr;
+        mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+        if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+            bind(s, reinterpret_cast<const sockaddr*>(&group), sizeof(group)) != 0 ||
+            setsockopt(s, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+            std::cout << "  cannot join a multicast group on loopback, skipped\n";
+            return true;
+        }
+    }
+
+    UDPSender sender;
+    GroupDelivery delivery;
+    delivery.multicastLoop = true;
+    inet_pton(AF_INET, "127.0.0.1", &delivery.multicastInterface);
+    if (!sender.open() || !sender.setDestinations({group}, false, {delivery})) {
+        std::cout << "  cannot open the sender\n";
+        return false;
+    }
+    UDPSender fanout;
+    if (!fanout.open() || !fanout.setDestinations(unicast.addrs)) {
+        std::cout << "  cannot open the sender\n";
+        return false;
+    }
+
+    bool ok = true;
+    const std::array<int, 3> color = {9, 8, 7};
+    const std::string expected = "R009G008B007\n";
+    sender.queue(0, color);
+    if (!sender.flush() || members.drain(expected) != kDevices) {
+        std::cout << "  the group datagram did not reach every member\n";
+        ok = false;
+    }
+
+    printRow("unicast batch", nsPerCall([&] {
+        for (int i = 0; i < kDevices; ++i)
+            fanout.queue(static_cast<size_t>(i), color);
+        fanout.flush();
+    }));
+    unicast.drain(expected);
+    printRow("one multicast datagram", nsPerCall([&] {
+        sender.queue(0, color);
+        sender.flush();
+    }));
+    members.drain(expected);
+    return ok;
+#endif
+}
+
+//----------------------------------------------------------------------
+// benchHealth
+//----------------------------------------------------------------------
+// Frame time over 200 connected loopback devices when one of them is a
+// closed port: every other send to it fails with ECONNREFUSED. Without
+// the circuit breaker it costs a failed syscall per frame; with it the
+// device is paused.
+//----------------------------------------------------------------------
+bool benchHealth() {
+#ifdef _WIN32
+    std::cout << "health: needs POSIX sockets for the receivers, skipped\n";
+    return true;
+#else
+    constexpr int kDevices = 200;
+    std::cout << "health (" << kDevices << " connected devices on loopback, one refusing)\n";
+    LoopbackReceivers receivers;
+    if (!receivers.open(kDevices)) {
+        std::cout << "  cannot bind loopback receivers, skipped\n";
+        return true;
+    }
+    std::vector<sockaddr_in> addrs = receivers.addrs;
+    ::close(receivers.sockets[0]); // nobody listens on device 0 anymore
+    receivers.sockets.erase(receivers.sockets.begin());
+
+    const std::array<int, 3> color = {4, 5, 6};
+    struct Variant {
+        const char* label;
+        bool dead;
+        int failureThreshold;
+    };
+    const Variant variants[] = {{"all healthy", false, 5},
+                                {"one refusing, no breaker", true, 1 << 24},
+                                {"one refusing, breaker", true, 5}};
+    for (const auto& variant : variants) {
+        UDPSender sender;
+        HealthOptions options;
+        options.failureThreshold = variant.failureThreshold;
+        sender.setHealthOptions(options);
+        std::vector<sockaddr_in> targets = addrs;
+        if (!variant.dead)
+            targets[0] = addrs[1];
+        if (!sender.open() || !sender.setDestinations(targets, true)) {
+            std::cout << "  cannot open the sender\n";
+            return false;
+        }
+        size_t frames = 0;
+        printRow(variant.label, nsPerCall([&] {
+            for (int i = 0; i < kDevices; ++i)
+                sender.queue(static_cast<size_t>(i), color);
+            sender.flush();
+            ++frames;
+        }));
+        receivers.drain("");
+        if (variant.dead) {
+            const DeviceHealth& dead = sender.health()[0];
+            std::cout << "    refusing device: " << dead.sent << " sent, " << dead.errors
+                      << " errors, " << dead.dropped << " dropped of " << frames << " frames"
+                      << (dead.circuitOpen ? ", paused" : "") << "\n";
+        }
+    }
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------
+// benchPacing
+//----------------------------------------------------------------------
+// Run the send pacer for 10 s of simulated 60 fps capture with 200
+// devices, one limited to 20 and one to 120 packets per second, and
+// report the rates and the largest burst with and without spreading
+// over 4 slices. Also times the pacer itself.
+//----------------------------------------------------------------------
+bool benchPacing() {
+    using Clock = SendPacer::Clock;
+    constexpr int kDevices = 200;
+    constexpr double kFps = 60.0;
+    constexpr double kSeconds = 10.0;
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / kFps));
+    std::vector<double> rates(kDevices, 0.0);
+    rates[0] = 20.0;
+    rates[1] = 120.0;
+    std::cout << "pacing (" << kDevices << " devices, " << kFps << " fps, device 0 at " << rates[0]
+              << "/s, device 1 at " << rates[1] << "/s)\n";
+
+    for (int slices : {1, 4}) {
+        SendPacer pacer;
+        pacer.reset(rates, interval, slices);
+        const Clock::time_point start{};
+        const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+                                                  std::chrono::duration<double>(kSeconds));
+        std::vector<size_t> sends(kDevices, 0);
+        std::vector<Clock::time_point> last(kDevices, Clock::time_point::min());
+        Clock::duration minGap0 = Clock::duration::max();
+        size_t maxBurst = 0;
+        Clock::time_point nextFrame = start;
+        std::vector<size_t> due;
+        while (true) {
+            const Clock::time_point now = (std::min)(nextFrame, pacer.nextDue());
+            if (now >= end)
+                break;
+            if (now == nextFrame) {
+                pacer.onFrame(now);
+                nextFrame += interval;
+            }
+            due.clear();
+            pacer.collectDue(now, due);
+            maxBurst = (std::max)(maxBurst, due.size());
+            for (size_t i : due) {
+                if (i == 0 && last[0] != Clock::time_point::min())
+                    minGap0 = (std::min)(minGap0, now - last[0]);
+                last[i] = now;
+                ++sends[i];
+            }
+        }
+
+        const double rate0 = static_cast<double>(sends[0]) / kSeconds;
+        const double rate1 = static_cast<double>(sends[1]) / kSeconds;
+        const double rateFree = static_cast<double>(sends[2]) / kSeconds;
+        std::cout << "  " << slices << " slice" << (slices > 1 ? "s" : " ") << ": device 0 " << std::fixed
+                  << std::setprecision(1) << rate0 << "/s (min gap "
+                  << std::chrono::duration<double, std::milli>(minGap0).count() << " ms), device 1 "
+                  << rate1 << "/s, others " << rateFree << "/s, largest burst " << maxBurst << "\n";
+    }
+
+    SendPacer pacer;
+    pacer.reset(rates, interval, 4);
+    Clock::time_point now{};
+    std::vector<size_t> due;
+    printRow("pacer, 4 slices, per frame", nsPerCall([&] {
+        pacer.onFrame(now);
+        while (pacer.nextDue() != Clock::time_point::max()) {
+            now = pacer.nextDue();
+            due.clear();
+            pacer.collectDue(now, due);
+        }
+        now += interval;
+    }));
+    return true;
+}
+
+//----------------------------------------------------------------------
+// benchGate
+//----------------------------------------------------------------------
+// Feed the change gate 20 s each of a static picture with +-1 noise, a
+// slow fade and a busy picture at 30 fps, for a single color and a
+// 300-LED strip, with a threshold of 2 and a 1 s keepalive. Reported
+// are the suppressed share per phase, the longest gap between two
+// packets and the cost of one decision.
+//----------------------------------------------------------------------
+bool benchGate() {
+    using Clock = ChangeGate::Clock;
+    constexpr int kFps = 30;
+    constexpr int kPhaseFrames = 20 * kFps;
+    ChangeGateOptions options;
+    options.threshold = 2;
+    options.keepalive = std::chrono::milliseconds(1000);
+    std::cout << "gate (threshold " << options.threshold << ", keepalive " << options.keepalive.count()
+              << " ms, " << kFps << " fps)\n";
+
+    std::mt19937 rng(7);
+    const char* phases[] = {"static + noise", "slow fade", "busy"};
+    for (size_t bytes : {size_t{3}, size_t{900}}) {
+        ChangeGate gate;
+        gate.reset(1, options);
+        std::vector<uint8_t> base(bytes), colors(bytes);
+        for (auto& b : base)
+            b = static_cast<uint8_t>(64 + rng() % 128);
+        Clock::time_point now{}, lastPassed{};
+        bool anyPassed = false;
+        Clock::duration longestGap{};
+        std::cout << "  " << (bytes == 3 ? "single color " : "300 LEDs     ");
+        for (int phase = 0; phase < 3; ++phase) {
+            const uint64_t suppressedBefore = gate.suppressed(0);
+            for (int f = 0; f < kPhaseFrames; ++f) {
+                for (size_t i = 0; i < bytes; ++i) {
+                    int v = base[i];
+                    if (phase == 0)
+                        v += static_cast<int>(rng() % 3) - 1;
+                    else if (phase == 1)
+                        v += f / 10;
+                    else
+                        v = static_cast<int>(rng() % 256);
+                    colors[i] = static_cast<uint8_t>((std::clamp)(v, 0, 255));
+                }
+                if (gate.pass(0, colors.data(), bytes, now)) {
+                    if (anyPassed)
+                        longestGap = (std::max)(longestGap, now - lastPassed);
+                    lastPassed = now;
+                    anyPassed = true;
+                }
+                now += std::chrono::microseconds(1000000 / kFps);
+            }
+            const double share = 100.0 * static_cast<double>(gate.suppressed(0) - suppressedBefore) / kPhaseFrames;
+            std::cout << phases[phase] << " " << std::fixed << std::setprecision(0) << share << "%  ";
+        }
+        std::cout << "suppressed, longest gap "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(longestGap).count() << " ms\n";
+    }
+
+    // Worst case: unchanged strip, every byte compared
+    ChangeGate gate;
+    gate.reset(1, options);
+    std::vector<uint8_t> strip(900, 100);
+    gate.pass(0, strip.data(), strip.size(), Clock::time_point{});
+    printRow("300-LED decision, unchanged", nsPerCall([&] {
+        gate.pass(0, strip.data(), strip.size(), Clock::time_point{});
+    }));
+    return true;
+}
+
+//----------------------------------------------------------------------
+// benchUring
+//----------------------------------------------------------------------
+// Packets per second to 200 loopback devices with small text payloads
+// and 1400-byte pixel payloads: sendto per device, one sendmmsg batch,
+// and the io_uring transport copying, with zero-copy sends and with a
+// kernel polling thread (SQPOLL).
+// Each io_uring variant must deliver a frame to every receiver.
+//----------------------------------------------------------------------
+bool benchUring() {
+#ifndef RGBSTREAMER_HAS_URING
+    std::cout << "uring: io_uring is Linux only, skipped\n";
+    return true;
+#else
+    constexpr int kDevices = 200;
+    std::cout << "uring (" << kDevices << " devices on loopback, us per frame / packets per second)\n";
+    LoopbackReceivers receivers;
+    if (!receivers.open(kDevices)) {
+        std::cout << "  cannot bind loopback receivers, skipped\n";
+        return true;
+    }
+    auto printRate = [&](const std::string& label, double ns) {
+        std::cout << "  " << std::left << std::setw(28) << label << std::right << std::setw(10)
+                  << std::fixed << std::setprecision(1) << ns / 1000.0 << " us" << std::setw(10)
+                  << std::setprecision(0) << kDevices * 1e6 / ns << " kpps\n";
+    };
+
+    bool ok = true;
+    for (size_t size : {size_t{13}, size_t{1400}}) {
+        std::string payload(size, 'x');
+        for (size_t i = 0; i < size; ++i)
+            payload[i] = static_cast<char>('a' + i % 26);
+        std::cout << " " << size << "-byte payloads\n";
+        auto frame = [&](UDPSender& sender) {
+            for (int i = 0; i < kDevices; ++i)
+                sender.queuePacket(static_cast<size_t>(i), payload.data(), payload.size());
+            return sender.flush();
+        };
+
+        UDPSender plain;
+        if (!plain.open() || !plain.setDestinations(receivers.addrs)) {
+            std::cout << "  cannot open the sender\n";
+            return false;
+        }
+        printRate("sendto per device", nsPerCall([&] {
+            for (const auto& addr : receivers.addrs)
+                plain.sendPacket(addr, payload.data(), payload.size());
+        }));
+        printRate("batch (sendmmsg)", nsPerCall([&] { frame(plain); }));
+        receivers.drain(payload);
+
+        struct Variant {
+            const char* label;
+            size_t zeroCopyThreshold;
+            bool sqPoll;
+        };
+        const Variant variants[] = {{"io_uring, copy", 0, false},
+                                    {"io_uring, zero copy", 1, false},
+                                    {"io_uring, SQPOLL", 0, true}};
+        for (const auto& variant : variants) {
+            if (variant.zeroCopyThreshold > 0 && size < 1024)
+                continue;
+            UDPSender sender;
+            UringOptions options;
+            options.zeroCopyThreshold = variant.zeroCopyThreshold;
+            options.sqPoll = variant.sqPoll;
+            if (!sender.open() || !sender.setDestinations(receivers.addrs) ||
+                !sender.setTransport(UdpTransport::IoUring, options)) {
+                std::cout << "  io_uring unavailable here, skipped\n";
+                return ok;
+            }
+            // Completions are asynchronous: give the frame a moment
+            frame(sender);
+            size_t got = 0;
+            for (int tries = 0; tries < 100 && got < kDevices; ++tries) {
+                got += receivers.drain(payload);
+                if (got < kDevices)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (got != kDevices) {
+                std::cout << "  " << variant.label << ": " << got << " of " << kDevices
+                          << " devices received the frame\n";
+                ok = false;
+            }
+            // The rate counts only datagrams the ring accepted and sent:
+            // a full ring drops instead of waiting
+            size_t attempted = 0, failed = 0;
+            const double ns = nsPerCall([&] {
+                frame(sender);
+                attempted += kDevices;
+                failed += sender.failedDevices().size();
+            });
+            const double delivered = 1.0 - static_cast<double>(failed) / static_cast<double>(attempted);
+            printRate(variant.label, ns / (std::max)(delivered, 1e-6));
+            if (failed > 0)
+                std::cout << "    (" << std::setprecision(1) << 100.0 * (1.0 - delivered)
+                          << "% of the datagrams dropped, ring full"
+                          << (variant.sqPoll && std::thread::hardware_concurrency() < 2
+                                  ? "; the poll thread needs a spare core" : "")
+                          << ")\n";
+            receivers.drain(payload);
+        }
+    }
+    return ok;
+#endif
+}
+
+//----------------------------------------------------------------------
+// benchDelta
+//----------------------------------------------------------------------
+// Compare the bytes on the wire (UDP/IP headers included) with DDP on
+// synthetic desktop content, where delta must need less than half, and
+// time the encode of a 300-LED frame.
+//----------------------------------------------------------------------
+bool benchDelta() {
+    constexpr size_t kIpUdpHeaders = 28;
+    bool ok = true;
+    std::mt19937 rng(19);
+    auto randomColor = [&] {
+        return Rgb8{static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng())};
+    };
+    std::cout << "delta (keyframe every " << DeltaOptions{}.keyframeInterval << " frames)\n";
+
+    // 300 LEDs for 20 s at 30 fps each: a still desktop with a clock
+    // ticking, a video playing in a fifth of the screen, fullscreen video
+    constexpr int kPhaseFrames = 20 * 30;
+    constexpr size_t kLeds = 300;
+    const char* phases[] = {"still desktop", "video window", "fullscreen video"};
+    const size_t changing[] = {2, kLeds / 5, kLeds};
+    std::vector<Rgb8> strip(kLeds);
+    for (auto& px : strip)
+        px = randomColor();
+    ProtocolEncoder ddp(WireProtocol::Ddp);
+    DeltaEncoder encoder;
+    size_t typicalDelta = 0, typicalDdp = 0;
+    for (int phase = 0; phase < 3; ++phase) {
+        size_t deltaBytes = 0, ddpBytes = 0;
+        for (int f = 0; f < kPhaseFrames; ++f) {
+            const size_t first = phase == 1 ? 100 : 0;
+            const bool tick = phase != 0 || f % 30 == 0;
+            for (size_t i = first; tick && i < first + changing[phase]; ++i)
+                strip[i] = randomColor();
+            for (const PacketView& packet : ddp.encode(strip.data(), strip.size()))
+                ddpBytes += packet.size + kIpUdpHeaders;
+            for (const PacketView& packet : encoder.encode(strip.data(), strip.size()))
+                deltaBytes += packet.size + kIpUdpHeaders;
+        }
+        if (phase < 2) {
+            typicalDelta += deltaBytes;
+            typicalDdp += ddpBytes;
+        }
+        std::cout << "  " << std::left << std::setw(18) << phases[phase] << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(7) << deltaBytes * 30.0 / kPhaseFrames / 1000.0
+                  << " kB/s, " << std::setprecision(0) << std::setw(3) << 100.0 * deltaBytes / ddpBytes
+                  << "% of DDP\n";
+    }
+    if (typicalDelta * 2 >= typicalDdp) {
+        std::cout << "  desktop content needs half the DDP bandwidth or more\n";
+        ok = false;
+    }
+
+    for (auto& px : strip)
+        px = randomColor();
+    printRow("300-LED encode, 20% changed", nsPerCall([&] {
+        for (size_t i = 100; i < 160; ++i)
+            strip[i][0] ^= 1;
+        encoder.encode(strip.data(), strip.size());
+    }));
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// benchGso
+//----------------------------------------------------------------------
+// A 10k-LED frame as DDP (21 packets) and E1.31 (59 universes) to a
+// loopback receiver, one datagram per packet against one segmented
+// datagram (UDP GSO) per frame.
+//----------------------------------------------------------------------
+bool benchGso() {
+#ifdef _WIN32
+    std::cout << "gso: UDP segmentation offload is Linux only, skipped\n";
+    return true;
+#else
+    constexpr size_t kLeds = 10000;
+    std::cout << "gso (" << kLeds << " LEDs to one loopback device)\n";
+    LoopbackReceivers receiver;
+    if (!receiver.open(1)) {
+        std::cout << "  cannot bind a loopback receiver, skipped\n";
+        return true;
+    }
+    const int bufferSize = 4 << 20;
+    setsockopt(receiver.sockets[0], SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+    std::mt19937 rng(20);
+    std::vector<Rgb8> pixels(kLeds);
+    for (auto& px : pixels)
+        px = {static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng())};
+
+    struct Named {
+        const char* name;
+        WireProtocol protocol;
+    };
+    for (const Named& named : {Named{"DDP", WireProtocol::Ddp}, Named{"E1.31", WireProtocol::E131}}) {
+        const ProtocolOptions options;
+        ProtocolEncoder encoder(named.protocol, options);
+        for (bool segmented : {false, true}) {
+            // Timed over the shared socket; the receiver is drained after
+            // every run so its buffer never fills
+            UDPSender sender;
+            if (!sender.open() || !sender.setDestinations(receiver.addrs)) {
+                std::cout << "  cannot open the sender\n";
+                return false;
+            }
+            if (segmented && !sender.setSegmentation(true)) {
+                std::cout << "  kernel without UDP_SEGMENT, segmented sends skipped\n";
+                continue;
+            }
+            const size_t packetCount = encoder.encode(pixels.data(), pixels.size()).size();
+            const double ns = nsPerCall([&] {
+                for (const PacketView& packet : encoder.encode(pixels.data(), pixels.size()))
+                    sender.queuePacket(0, packet.data, packet.size);
+                sender.flush();
+            });
+            std::cout << "  " << std::left << std::setw(28)
+                      << (std::string(named.name) + (segmented ? ", segmented" : ", per packet"))
+                      << std::right << std::setw(10) << std::fixed << std::setprecision(1) << ns / 1000.0
+                      << " us" << std::setw(10) << std::setprecision(0) << packetCount * 1e6 / ns
+                      << " kpps\n";
+            receiver.drain("");
+        }
+    }
+    return true;
+#endif
+}
+
+// Unbounded mutex and condition variable queue, as the pipeline used
+// before the rings, for comparison
+template <typename T>
+class MutexQueue {
+public:
+    void push(T value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(value));
+        }
+        cv_.notify_one();
+    }
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !queue_.empty(); });
+        value = std::move(queue_.front());
+        queue_.pop_front();
+        return true;
+    }
+
+private:
+    std::deque<T> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+//----------------------------------------------------------------------
+// benchRings
+//----------------------------------------------------------------------
+// Time a handoff round trip between two threads, ring against the
+// mutex queue.
+//----------------------------------------------------------------------
+bool benchRings() {
+    std::cout << "rings (8 slots, " << std::thread::hardware_concurrency() << " cores)\n";
+
+    // Round trip: A pushes to B, B pushes back; both sides sleep when idle
+    constexpr int kRoundTrips = 20000;
+    auto roundTrip = [&](auto& there, auto& back) {
+        std::thread echo([&] {
+            int value = 0;
+            for (int i = 0; i < kRoundTrips; ++i) {
+                there.pop(value);
+                back.push(value);
+            }
+        });
+        const auto start = std::chrono::steady_clock::now();
+        int value = 0;
+        for (int i = 0; i < kRoundTrips; ++i) {
+            there.push(i);
+            back.pop(value);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        echo.join();
+        return std::chrono::duration<double, std::nano>(elapsed).count() / kRoundTrips;
+    };
+    SpscRing<int> there(8, OverflowPolicy::Block), back(8, OverflowPolicy::Block);
+    MutexQueue<int> mutexThere, mutexBack;
+    printRow("round trip, mutex queue", roundTrip(mutexThere, mutexBack));
+    printRow("round trip, ring", roundTrip(there, back));
+    return true;
+}
+
+//----------------------------------------------------------------------
+// benchMailbox
+//----------------------------------------------------------------------
+// A capture thread stamps a frame every millisecond while processing
+// takes 3 ms per frame. Reported is the age of each frame when its
+// processing starts, through the unbounded mutex queue, a 2-slot
+// drop-oldest ring and the latest-frame mailbox.
+//----------------------------------------------------------------------
+bool benchMailbox() {
+    using Clock = std::chrono::steady_clock;
+    constexpr auto kCaptureInterval = std::chrono::milliseconds(1);
+    constexpr auto kProcessing = std::chrono::milliseconds(3);
+    constexpr int kFrames = 300;
+    std::cout << "mailbox (capture every 1 ms, processing 3 ms, " << kFrames << " frames)\n";
+
+    // Runs capture and processing; `push(stamp)` and `pop(stamp)` wrap
+    // the handoff, a stamp of -1 ends the run
+    auto run = [&](const char* label, auto push, auto pop, auto finish) {
+        std::vector<double> ages;
+        std::thread processing([&] {
+            Clock::rep stamp = 0;
+            while (pop(stamp) && stamp >= 0) {
+                ages.push_back(std::chrono::duration<double, std::milli>(
+                                   Clock::now() - Clock::time_point(Clock::duration(stamp)))
+                                   .count());
+                std::this_thread::sleep_for(kProcessing);
+            }
+        });
+        for (int i = 0; i < kFrames; ++i) {
+            push(Clock::now().time_since_epoch().count());
+            std::this_thread::sleep_for(kCaptureInterval);
+        }
+        finish();
+        processing.join();
+        std::sort(ages.begin(), ages.end());
+        double mean = 0.0;
+        for (double age : ages)
+            mean += age / static_cast<double>(ages.size());
+        std::cout << "  " << std::left << std::setw(26) << label << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(7) << mean << " ms mean " << std::setw(7)
+                  << ages.back() << " ms max frame age, " << ages.size() << " processed\n";
+    };
+
+    MutexQueue<Clock::rep> fifo;
+    run("mutex queue (unbounded)", [&](Clock::rep v) { fifo.push(v); },
+        [&](Clock::rep& v) { return fifo.pop(v); }, [&] { fifo.push(-1); });
+    SpscRing<Clock::rep> ring(2, OverflowPolicy::DropOldest);
+    run("ring, 2 slots drop oldest", [&](Clock::rep v) { ring.push(v); },
+        [&](Clock::rep& v) { return ring.pop(v); }, [&] { ring.stop(); });
+    LatestMailbox<Clock::rep> mailbox;
+    run("latest-frame mailbox", [&](Clock::rep v) { mailbox.publish(v); },
+        [&](Clock::rep& v) { return mailbox.take(v); }, [&] { mailbox.stop(); });
+    return true;
+}
+
+//----------------------------------------------------------------------
+// benchPool
+//----------------------------------------------------------------------
+// Cost of handing a captured 1080p frame to processing in a buffer of
+// its own: a fresh vector per frame against a FramePool lease. Then
+// capture and processing threads run through the mailbox, once sharing
+// a single buffer the way the staging texture used to be shared and
+// once with pool leases, counting frames processing saw half
+// overwritten.
+//----------------------------------------------------------------------
+bool benchPool() {
+    auto frame = makeFrame(1920, 1080, PixelFormat::BGRA8, 31);
+    std::cout << "pool (1920x1080 BGRA copy per capture)\n";
+    const size_t rowBytes = static_cast<size_t>(frame.view.width) * 4;
+    printRow("vector per frame", nsPerCall([&] {
+                 std::vector<uint8_t> copy(rowBytes * frame.view.height);
+                 for (int y = 0; y < frame.view.height; ++y)
+                     std::memcpy(copy.data() + y * rowBytes, frame.view.row(y), rowBytes);
+                 volatile uint8_t sink = copy[copy.size() / 2];
+                 (void)sink;
+             }));
+    FramePool pool;
+    printRow("pool lease", nsPerCall([&] {
+                 FrameLease lease = pool.copy(frame.view);
+                 volatile uint8_t sink = lease.data()[rowBytes / 2];
+                 (void)sink;
+             }));
+    FramePool huge(FramePoolOptions{3, true});
+    printRow("pool lease, huge pages", nsPerCall([&] {
+                 FrameLease lease = huge.copy(frame.view);
+                 volatile uint8_t sink = lease.data()[rowBytes / 2];
+                 (void)sink;
+             }));
+    std::cout << "  buffers on huge pages: " << huge.hugePageBuffers() << " of " << huge.allocations() << "\n";
+
+    // Capture overwrites frames while processing reads them; every
+    // frame is filled with one value, so a mixed frame was torn
+    constexpr int kFrames = 3000;
+    constexpr int kSide = 256;
+    constexpr size_t kBytes = size_t(kSide) * kSide * 4;
+    auto uniform = [](const uint8_t* data, size_t size) {
+        for (size_t i = 1; i < size; ++i)
+            if (data[i] != data[0])
+                return false;
+        return true;
+    };
+    // Relaxed word accesses keep the deliberate race well defined
+    std::vector<uint32_t> shared(size_t(kSide) * kSide);
+    LatestMailbox<int> signal;
+    int sharedTorn = 0;
+    int sharedSeen = 0;
+    std::thread reader([&] {
+        int value = 0;
+        while (signal.take(value)) {
+            const uint32_t first = std::atomic_ref<uint32_t>(shared[0]).load(std::memory_order_relaxed);
+            bool same = true;
+            for (uint32_t& word : shared)
+                same = same && std::atomic_ref<uint32_t>(word).load(std::memory_order_relaxed) == first;
+            sharedTorn += same ? 0 : 1;
+            ++sharedSeen;
+        }
+    });
+    for (int i = 0; i < kFrames; ++i) {
+        for (uint32_t& word : shared)
+            std::atomic_ref<uint32_t>(word).store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+        signal.publish(i);
+    }
+    signal.stop();
+    reader.join();
+    std::cout << "  shared buffer: " << sharedTorn << " of " << sharedSeen << " processed frames torn\n";
+
+    FramePool leases(FramePoolOptions{3, false});
+    std::vector<uint8_t> source(kBytes);
+    FrameView sourceView{source.data(), kSide, kSide, size_t(kSide) * 4, PixelFormat::BGRA8};
+    LatestMailbox<FrameLease> mailbox([](FrameLease& lease) { lease.reset(); });
+    int leaseTorn = 0;
+    int leaseSeen = 0;
+    std::thread processing([&] {
+        FrameLease lease;
+        while (mailbox.take(lease)) {
+            const FrameView& v = lease.view();
+            bool same = true;
+            for (int y = 0; y < v.height; ++y)
+                same = same && uniform(v.row(y), static_cast<size_t>(v.width) * 4) && v.row(y)[0] == v.data[0];
+            leaseTorn += same ? 0 : 1;
+            ++leaseSeen;
+            lease.reset();
+        }
+    });
+    for (int i = 0; i < kFrames; ++i) {
+        // Resolution changes now and then while frames are in flight
+        sourceView.width = sourceView.height = (i / 500) % 2 ? kSide / 2 : kSide;
+        std::memset(source.data(), i & 0xff, kBytes);
+        FrameLease lease = leases.copy(sourceView);
+        if (lease)
+            mailbox.publish(std::move(lease));
+    }
+    mailbox.stop();
+    processing.join();
+    std::cout << "  pool leases:   " << leaseTorn << " of " << leaseSeen << " processed frames torn, "
+              << leases.exhausted() << " captures skipped, " << leases.allocations() << " allocations\n";
+    return true;
+}
+
+//----------------------------------------------------------------------
+// benchSchedule
+//----------------------------------------------------------------------
+// A capture loop with a 4 ms period whose work takes 0.3-1.5 ms, with a
+// 10 ms overrun every 50 cycles: sleeping for the interval after the
+// work against FrameScheduler deadlines, sleeping only and with the
+// hybrid spin.
+//----------------------------------------------------------------------
+bool benchSchedule() {
+    using Clock = FrameScheduler::Clock;
+    using std::chrono::microseconds;
+    using std::chrono::milliseconds;
+    constexpr auto kPeriod = milliseconds(4);
+    constexpr int kCycles = 150;
+    std::cout << "schedule (4 ms period, 0.3-1.5 ms work, 10 ms overrun every 50, " << kCycles << " cycles)\n";
+
+    auto work = [](int cycle, std::mt19937& rng) {
+        const auto busy = cycle % 50 == 25 ? microseconds(10000) : microseconds(300 + rng() % 1200);
+        const auto until = Clock::now() + busy;
+        while (Clock::now() < until) {
+        }
+    };
+    auto report = [](const char* label, const ScheduleStats& st) {
+        std::cout << "  " << std::left << std::setw(24) << label << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(7) << st.meanPeriodUs / 1000.0 << " ms mean "
+                  << std::setprecision(0) << std::setw(6) << st.jitterUs << " us jitter " << std::setw(6)
+                  << st.maxDeviationUs << " us max, " << st.overruns << " overruns\n";
+    };
+
+    // The old loop: the period is the interval plus the work plus oversleep
+    {
+        std::mt19937 rng(3);
+        FrameScheduler stats;
+        stats.reset(kPeriod, microseconds(0), Clock::now());
+        for (int i = 0; i < kCycles; ++i) {
+            stats.tick(Clock::now());
+            work(i, rng);
+            std::this_thread::sleep_for(kPeriod);
+        }
+        report("sleep after work", stats.stats());
+    }
+    auto runDeadline = [&](const char* label, microseconds spin) {
+        std::mt19937 rng(3);
+        FrameScheduler scheduler;
+        const auto start = Clock::now();
+        scheduler.reset(kPeriod, spin, start);
+        for (int i = 0; i < kCycles; ++i) {
+            scheduler.waitForDeadline();
+            work(i, rng);
+            scheduler.advance(Clock::now());
+        }
+        report(label, scheduler.stats());
+    };
+    runDeadline("deadline, sleep only", microseconds(0));
+    runDeadline("deadline, 500 us spin", microseconds(500));
+    return true;
+}
+
+//----------------------------------------------------------------------
+// benchFused
+//----------------------------------------------------------------------
+// Capture-to-send latency of each frame through the three-thread
+// pipeline (pool copy, mailbox, average, ring, DDP to a loopback
+// device) against the same stages run inline on one pinned thread,
+// idle and with a busy thread per core competing for the CPU. Both
+// pipelines must deliver the color of the frame.
+//----------------------------------------------------------------------
+bool benchFused() {
+#ifdef _WIN32
+    std::cout << "fused: loopback receivers are POSIX only, skipped\n";
+    return true;
+#else
+    using Clock = std::chrono::steady_clock;
+    constexpr auto kPeriod = std::chrono::milliseconds(4);
+    constexpr auto kSpin = std::chrono::microseconds(500);
+    constexpr int kFrames = 250;
+    constexpr size_t kLeds = 30;
+    std::cout << "fused (960x540 frames every 4 ms, average to " << kLeds << " DDP LEDs, " << kFrames
+              << " frames)\n";
+    LoopbackReceivers receiver;
+    if (!receiver.open(1)) {
+        std::cout << "  cannot bind a loopback receiver, skipped\n";
+        return true;
+    }
+    const auto source = makeFrame(960, 540, PixelFormat::BGRA8, 41);
+    const std::array<int, 3> expected = getRGBAverage(source.view);
+    const ProtocolOptions options;
+
+    struct Stamped {
+        FrameLease frame;
+        Clock::time_point at;
+    };
+    struct Result {
+        std::array<int, 3> rgb{};
+        Clock::time_point at;
+    };
+    auto send = [&](UDPSender& sender, ProtocolEncoder& encoder, const std::array<int, 3>& rgb) {
+        const Rgb8 color = {static_cast<uint8_t>(rgb[0]), static_cast<uint8_t>(rgb[1]), static_cast<uint8_t>(rgb[2])};
+        const std::vector<Rgb8> pixels(kLeds, color);
+        for (const PacketView& packet : encoder.encode(pixels.data(), pixels.size()))
+            sender.queuePacket(0, packet.data, packet.size);
+        sender.flush();
+    };
+
+    auto threaded = [&](LatencyWindow& latency) {
+        UDPSender sender;
+        sender.open();
+        sender.setDestinations(receiver.addrs, false);
+        ProtocolEncoder encoder(WireProtocol::Ddp, options);
+        FramePool pool;
+        LatestMailbox<Stamped> mailbox([](Stamped& stamped) { stamped.frame.reset(); });
+        SpscRing<Result> ring(4, OverflowPolicy::DropOldest);
+        std::thread processing([&] {
+            Stamped stamped;
+            while (mailbox.take(stamped)) {
+                Result result{getRGBAverage(stamped.frame.view()), stamped.at};
+                stamped.frame.reset();
+                ring.push(result);
+            }
+            ring.stop();
+        });
+        std::thread sending([&] {
+            Result result;
+            while (ring.pop(result)) {
+                send(sender, encoder, result.rgb);
+                latency.add(Clock::now() - result.at);
+            }
+        });
+        FrameScheduler scheduler;
+        scheduler.reset(kPeriod, kSpin, Clock::now());
+        for (int i = 0; i < kFrames; ++i) {
+            scheduler.waitForDeadline();
+            Stamped stamped{pool.copy(source.view), {}};
+            stamped.at = Clock::now();
+            mailbox.publish(std::move(stamped));
+            scheduler.advance(Clock::now());
+        }
+        mailbox.stop();
+        processing.join();
+        sending.join();
+        return true;
+    };
+    auto fused = [&](LatencyWindow& latency) {
+        bool pinned = false;
+        std::thread pipeline([&] {
+            pinned = pinCurrentThread(0);
+            UDPSender sender;
+            sender.open();
+            sender.setDestinations(receiver.addrs, false);
+            ProtocolEncoder encoder(WireProtocol::Ddp, options);
+            FramePool pool;
+            FrameScheduler scheduler;
+            scheduler.reset(kPeriod, kSpin, Clock::now());
+            for (int i = 0; i < kFrames; ++i) {
+                scheduler.waitForDeadline();
+                FrameLease frame = pool.copy(source.view);
+                const auto at = Clock::now();
+                const std::array<int, 3> rgb = getRGBAverage(frame.view());
+                frame.reset();
+                send(sender, encoder, rgb);
+                latency.add(Clock::now() - at);
+                scheduler.advance(Clock::now());
+            }
+        });
+        pipeline.join();
+        return pinned;
+    };
+
+    // The last datagram must carry the frame's average on every LED
+    auto delivered = [&] {
+        std::vector<uint8_t> last;
+        std::vector<uint8_t> buf(2048);
+        ssize_t n;
+        while ((n = recv(receiver.sockets[0], buf.data(), buf.size(), MSG_DONTWAIT)) >= 0)
+            last.assign(buf.begin(), buf.begin() + n);
+        std::vector<Rgb8> decoded;
+        int sequence = -1;
+        std::string error;
+        const Rgb8 color = {static_cast<uint8_t>(expected[0]), static_cast<uint8_t>(expected[1]),
+                            static_cast<uint8_t>(expected[2])};
+        return !last.empty() &&
+               decodePackets(WireProtocol::Ddp, options, {PacketView{last.data(), last.size()}}, decoded,
+                             sequence, error) &&
+               decoded == std::vector<Rgb8>(kLeds, color);
+    };
+
+    bool ok = true;
+    const int cores = static_cast<int>((std::max)(std::thread::hardware_concurrency(), 1u));
+    for (bool loaded : {false, true}) {
+        std::atomic<bool> stopLoad{false};
+        std::vector<std::thread> load;
+        for (int i = 0; loaded && i < cores; ++i)
+            load.emplace_back([&] {
+                volatile uint64_t spin = 0;
+                while (!stopLoad.load(std::memory_order_relaxed))
+                    spin = spin + 1;
+            });
+        for (bool inlined : {false, true}) {
+            LatencyWindow latency(kFrames);
+            const bool pinned = inlined ? fused(latency) : threaded(latency);
+            std::string label = inlined ? (pinned ? "fused, pinned" : "fused") : "threaded";
+            label += loaded ? ", busy cores" : ", idle";
+            std::cout << "  " << std::left << std::setw(26) << label << std::right << std::fixed
+                      << std::setprecision(0) << std::setw(7) << latency.percentileUs(0.5) << " us p50 "
+                      << std::setw(7) << latency.percentileUs(0.99) << " us p99, " << latency.recorded()
+                      << " frames sent\n";
+            if (latency.recorded() == 0 || (inlined && latency.recorded() != kFrames) || !delivered()) {
+                std::cout << "  " << label << " lost frames or sent a wrong color\n";
+                ok = false;
+            }
+        }
+        stopLoad = true;
+        for (auto& thread : load)
+            thread.join();
+    }
+
+    // Percentiles by nearest rank
+    LatencyWindow window(4);
+    for (int us : {500, 100, 400, 200, 300})
+        window.add(std::chrono::microseconds(us)); // 500 is overwritten
+    if (window.size() != 4 || window.recorded() != 5 || window.percentileUs(0.5) != 200.0 ||
+        window.percentileUs(0.99) != 400.0 || window.percentileUs(0.0) != 100.0) {
+        std::cout << "  latency percentiles wrong\n";
+        ok = false;
+    }
+    return ok;
+#endif
+}
+
+struct BenchEntry {
+    const char* name;
+    bool (*run)();
+};
+
+const BenchEntry kBenchmarks[] = {
+    {"average", benchAverage},
+    {"parallel", benchParallel},
+    {"sampling", benchSampling},
+    {"zones", benchZones},
+    {"regions", benchRegions},
+    {"leds", benchLeds},
+    {"pyramid", benchPyramid},
+    {"dominant", benchDominant},
+    {"formats", benchFormats},
+    {"letterbox", benchLetterbox},
+    {"payload", benchPayload},
+    {"protocols", benchProtocols},
+    {"fanout", benchFanout},
+    {"multicast", benchMulticast},
+    {"health", benchHealth},
+    {"pacing", benchPacing},
+    {"gate", benchGate},
+    {"uring", benchUring},
+    {"delta", benchDelta},
+    {"gso", benchGso},
+    {"rings", benchRings},
+    {"mailbox", benchMailbox},
+    {"pool", benchPool},
+    {"schedule", benchSchedule},
+    {"fused", benchFused},
+};
+
+} // namespace
+
+//----------------------------------------------------------------------
+// runBenchmark
+//----------------------------------------------------------------------
+// Dispatch to a benchmark by name, or run all of them for "all".
+//----------------------------------------------------------------------
+bool runBenchmark(const std::string& name) {
+    bool found = false;
+    bool ok = true;
+    for (const auto& bench : kBenchmarks) {
+        if (name != "all" && name != bench.name)
+            continue;
+        found = true;
+        ok = bench.run() && ok;
+    }
+    if (!found) {
+        std::cerr << "Unknown benchmark: " << name << "\nAvailable: all";
+        for (const auto& bench : kBenchmarks)
+            std::cerr << ", " << bench.name;
+        std::cerr << "\n";
+    }
+    return found && ok;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Run a named micro benchmark and print the results to stdout.
+ *
+ * Benchmarks only use synthetic frames and platform-neutral code, so they
+ * run on any build host. Correctness is checked by the tests under
+ * tests/: kernel equivalence, sampling accuracy, the pyramid, protocol
+ * conformance, the payload grammar, delta round trips, loopback
+ * delivery with segmentation offload, the queue overflow policies, the
+ * latest-frame mailbox, the frame pool, the capture scheduler, the
+ * pixel formats, the change gate, the circuit breaker and the send
+ * pacer.
+ * The remaining benchmarks still check their own results and some fail
+ * when a cost bound is missed.
+ *
+ * @param name Benchmark name, or "all" to run every benchmark.
+ * @return true if the benchmark exists and all of its checks passed.
+ */
+bool runBenchmark(const std::string& name);
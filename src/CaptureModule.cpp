@@ -1,5 +1,6 @@
 #include "CaptureModule.h"
 #include "Logger.h"
+#include "RGBProcessor.h"
 #include <windows.h>
 #include <iostream>
 #include <cstdio>
@@ -196,8 +197,21 @@ bool CaptureModule::initializeInternal(HMONITOR monitorHandle) {
     logger.logCapture("DirectX device created, setting up desktop duplication");
 
     // Create the desktop duplication interface
-    // This is what actually captures the screen content
-    hr = output1->DuplicateOutput(device_.Get(), duplication_.GetAddressOf());
+    // This is what actually captures the screen content. On Windows 10
+    // 1703+ DuplicateOutput1 delivers HDR desktops in their own format
+    // (half float scRGB or 10-bit) instead of a clipped 8-bit copy; the
+    // classic call remains as fallback for older systems and processes
+    // that are not per-monitor DPI aware.
+    hr = E_NOINTERFACE;
+    ComPtr<IDXGIOutput5> output5;
+    if (SUCCEEDED(output.As(&output5))) {
+        const DXGI_FORMAT formats[] = {DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R10G10B10A2_UNORM,
+                                       DXGI_FORMAT_B8G8R8A8_UNORM};
+        hr = output5->DuplicateOutput1(device_.Get(), 0, ARRAYSIZE(formats), formats,
+                                       duplication_.GetAddressOf());
+    }
+    if (FAILED(hr))
+        hr = output1->DuplicateOutput(device_.Get(), duplication_.GetAddressOf());
     if (FAILED(hr)) {
         logger.logCapture("DuplicateOutput failed");
         logError("DuplicateOutput failed", hr);
@@ -213,7 +227,7 @@ bool CaptureModule::initializeInternal(HMONITOR monitorHandle) {
  * This method acquires a frame from the desktop duplication interface
  * and copies it to a staging texture for CPU access
  */
-bool CaptureModule::grabFrame(ID3D11Texture2D*& outTex) {
+bool CaptureModule::grabFrame(FramePool& pool, FrameLease& outFrame, UINT timeoutMs) {
     // Check if we have a valid duplication interface
     if (!duplication_) {
         Logger::getInstance().logCapture("Cannot grab frame: duplication interface not initialized");
@@ -221,14 +235,14 @@ bool CaptureModule::grabFrame(ID3D11Texture2D*& outTex) {
     }
 
     // Initialize output parameter
-    outTex = nullptr;
+    outFrame.reset();
     
     // Variables to receive the captured frame
     ComPtr<IDXGIResource> resource;
     DXGI_OUTDUPL_FRAME_INFO frameInfo = {};
     
     // Try to acquire the next frame with specified timeout
-    HRESULT hr = duplication_->AcquireNextFrame(0, &frameInfo, resource.GetAddressOf());
+    HRESULT hr = duplication_->AcquireNextFrame(timeoutMs, &frameInfo, resource.GetAddressOf());
     if (hr == DXGI_ERROR_ACCESS_LOST) {
         // Monitor is likely powered off or disconnected
         static int consecutiveAccessLostCount = 0;
@@ -238,7 +252,7 @@ bool CaptureModule::grabFrame(ID3D11Texture2D*& outTex) {
         
         // If we've had multiple consecutive access lost errors, generate rainbow pattern
         if (consecutiveAccessLostCount >= 3) {
-            if (rainbowFlow_.generateTexture(device_.Get(), context_.Get(), outTex, outputDesc_)) {
+            if (rainbowFlow_.generateFrame(pool, outFrame, outputDesc_)) {
                 Logger::getInstance().logCapture("Generated rainbow pattern due to monitor access lost");
                 return true;
             }
@@ -293,9 +307,10 @@ bool CaptureModule::grabFrame(ID3D11Texture2D*& outTex) {
         // Check if we need to recreate the staging texture due to resolution change
         D3D11_TEXTURE2D_DESC currentDesc;
         stagingTex_->GetDesc(&currentDesc);
-        if (currentDesc.Width != desc.Width || currentDesc.Height != desc.Height) {
-            // Resolution changed, recreate staging texture
-            Logger::getInstance().logCapture("Resolution changed, recreating staging texture");
+        if (currentDesc.Width != desc.Width || currentDesc.Height != desc.Height ||
+            currentDesc.Format != desc.Format) {
+            // Resolution or format (HDR toggled) changed, recreate staging texture
+            Logger::getInstance().logCapture("Resolution or format changed, recreating staging texture");
             hr = device_->CreateTexture2D(&desc, nullptr, stagingTex_.ReleaseAndGetAddressOf());
             if (FAILED(hr)) {
                 Logger::getInstance().logCapture("CreateTexture2D for staging failed");
@@ -314,13 +329,62 @@ bool CaptureModule::grabFrame(ID3D11Texture2D*& outTex) {
     // This is important - must be called after we're done with the frame
     duplication_->ReleaseFrame();
 
-    // Return the staging texture to the caller
-    outTex = stagingTex_.Get();
-    if (outTex) {
-        // Add a reference so the caller can use it safely
-        outTex->AddRef();
+    // Read the frame back into a pool buffer the caller owns. Mapping
+    // waits for the copy; the staging texture is free again once it is
+    // unmapped, so the next CopyResource cannot overwrite a frame that
+    // is still being processed.
+    {
+        MappedTexture mapped(context_.Get(), stagingTex_.Get());
+        if (!mapped) {
+            Logger::getInstance().logCapture("Mapping the staging texture failed");
+            return false;
+        }
+        if (pool.width() != mapped.view().width || pool.height() != mapped.view().height ||
+            pool.format() != mapped.view().format) {
+            Logger::getInstance().logCapture("Resolution or format changed, resizing frame pool");
+        }
+        outFrame = pool.copy(mapped.view());
     }
-    return true;
+    // An empty frame means every pool buffer is still in flight
+    return static_cast<bool>(outFrame);
+}
+
+/**
+ * Look up the SDR white level of the captured output
+ * DXGI only names the output (DeviceName); the display configuration
+ * path with the same GDI source name carries the white level, in
+ * thousandths of 80 nits.
+ */
+double CaptureModule::sdrWhiteNits() const {
+    UINT32 pathCount = 0, modeCount = 0;
+    if (GetDisplayConfigBufferSizes(QDC_ONLY_ACTIVE_PATHS, &pathCount, &modeCount) != ERROR_SUCCESS)
+        return kScRgbWhiteNits;
+    std::vector<DISPLAYCONFIG_PATH_INFO> paths(pathCount);
+    std::vector<DISPLAYCONFIG_MODE_INFO> modes(modeCount);
+    if (QueryDisplayConfig(QDC_ONLY_ACTIVE_PATHS, &pathCount, paths.data(), &modeCount, modes.data(),
+                           nullptr) != ERROR_SUCCESS)
+        return kScRgbWhiteNits;
+
+    for (UINT32 i = 0; i < pathCount; ++i) {
+        DISPLAYCONFIG_SOURCE_DEVICE_NAME source = {};
+        source.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SOURCE_NAME;
+        source.header.size = sizeof(source);
+        source.header.adapterId = paths[i].sourceInfo.adapterId;
+        source.header.id = paths[i].sourceInfo.id;
+        if (DisplayConfigGetDeviceInfo(&source.header) != ERROR_SUCCESS ||
+            wcscmp(source.viewGdiDeviceName, outputDesc_.DeviceName) != 0)
+            continue;
+
+        DISPLAYCONFIG_SDR_WHITE_LEVEL white = {};
+        white.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SDR_WHITE_LEVEL;
+        white.header.size = sizeof(white);
+        white.header.adapterId = paths[i].targetInfo.adapterId;
+        white.header.id = paths[i].targetInfo.id;
+        if (DisplayConfigGetDeviceInfo(&white.header) == ERROR_SUCCESS && white.SDRWhiteLevel > 0)
+            return white.SDRWhiteLevel / 1000.0 * kScRgbWhiteNits;
+        break;
+    }
+    return kScRgbWhiteNits;
 }
 
 /**
@@ -333,9 +397,6 @@ void CaptureModule::shutdown() {
     // Release staging texture (CPU-accessible copy of frames)
     stagingTex_.Reset();
     
-    // Clean up rainbow flow resources
-    rainbowFlow_.cleanup();
-    
     // Release desktop duplication interface
     duplication_.Reset();
     
@@ -3,9 +3,11 @@
 // Windows DirectX headers for screen capture functionality
 #include <d3d11.h>      // DirectX 11 core functionality
 #include <dxgi1_2.h>    // DXGI 1.2 for Desktop Duplication API
+#include <dxgi1_5.h>    // DXGI 1.5 for HDR-aware duplication (DuplicateOutput1)
 #include <wrl/client.h> // Microsoft WRL (Windows Runtime Library) for COM smart pointers
 #include <vector>
 #include <string>
+#include "FramePool.h"
 #include "RainbowFlow.h"
 
 /**
@@ -24,7 +26,8 @@ struct MonitorInfo {
  * 
  * This class provides functionality to capture screen content in real-time
  * using DirectX 11 and DXGI Output Duplication. It can capture frames from
- * any monitor and provide them as D3D11 textures for further processing.
+ * any monitor and copies each one into a FramePool buffer owned by the
+ * caller, so processing never shares a texture with the next capture.
  */
 class CaptureModule {
 public:
@@ -44,11 +47,13 @@ public:
     
     /**
      * Capture the next available frame from the screen
-     * @param outTex Reference to receive the captured frame as D3D11 texture
-     * @param timeoutMs Timeout in milliseconds to wait for next frame (0 = non-blocking)
-     * @return true if frame captured successfully, false if no frame available or error
+     * @param pool Pool the frame is copied into; follows resolution changes
+     * @param outFrame Receives the captured frame
+     * @param timeoutMs Time to wait for a new desktop frame (0 = non-blocking)
+     * @return true if frame captured successfully, false if no frame available,
+     *         the pool is exhausted or an error occurred
      */
-    bool grabFrame(ID3D11Texture2D*& outTex);
+    bool grabFrame(FramePool& pool, FrameLease& outFrame, UINT timeoutMs = 0);
 
     /**
      * Get list of all available monitors
@@ -61,6 +66,14 @@ public:
      */
     void shutdown();
 
+    /**
+     * SDR white level of the captured display in nits, i.e. the "SDR
+     * content brightness" of an HDR desktop. Read from the display
+     * configuration of the output found by `initialize`.
+     * @return The level, or 80 (scRGB 1.0) if it cannot be read
+     */
+    double sdrWhiteNits() const;
+
 private:
     /**
      * Internal initialization method that takes a monitor handle
@@ -78,7 +91,8 @@ private:
     // DXGI Output Duplication interface - handles screen capture
     Microsoft::WRL::ComPtr<IDXGIOutputDuplication> duplication_;
     
-    // Staging texture - CPU-accessible copy of captured frame
+    // Staging texture - CPU-accessible copy of captured frame, read back
+    // into a pool buffer before the next frame is copied in
     Microsoft::WRL::ComPtr<ID3D11Texture2D> stagingTex_;
     
     // Rainbow flow generator for fallback scenarios
@@ -0,0 +1,52 @@
+#include "ChangeGate.h"
+#include "PixelKernels.h"
+#include <cstring>
+
+//----------------------------------------------------------------------
+// reset
+//----------------------------------------------------------------------
+void ChangeGate::reset(size_t devices, const ChangeGateOptions& options) {
+    options_ = options;
+    devices_.assign(devices, Device{});
+}
+
+//----------------------------------------------------------------------
+// changed
+//----------------------------------------------------------------------
+// Whether any channel moved by more than the threshold.
+//----------------------------------------------------------------------
+bool ChangeGate::changed(const std::vector<uint8_t>& sent, const uint8_t* rgb, size_t size) const {
+    if (sent.size() != size)
+        return true;
+    if (options_.threshold == 0)
+        return std::memcmp(sent.data(), rgb, size) != 0;
+    static const BytesDifferKernel differ = activeBytesDifferKernel();
+    return differ(sent.data(), rgb, size, static_cast<uint8_t>(options_.threshold));
+}
+
+//----------------------------------------------------------------------
+// pass
+//----------------------------------------------------------------------
+bool ChangeGate::pass(size_t device, const uint8_t* rgb, size_t size, Clock::time_point now) {
+    if (!enabled() || device >= devices_.size())
+        return true;
+    Device& d = devices_[device];
+    if (d.hasSent && now - d.sentAt < options_.keepalive && !changed(d.sent, rgb, size)) {
+        ++d.suppressed;
+        return false;
+    }
+    d.sent.assign(rgb, rgb + size);
+    d.sentAt = now;
+    d.hasSent = true;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// suppressedTotal
+//----------------------------------------------------------------------
+uint64_t ChangeGate::suppressedTotal() const {
+    uint64_t total = 0;
+    for (const Device& d : devices_)
+        total += d.suppressed;
+    return total;
+}
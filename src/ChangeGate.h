@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Tuning of the change-suppression gate.
+ */
+struct ChangeGateOptions {
+    int threshold = -1;                       ///< Largest per-channel change still suppressed (-1 = gate off)
+    std::chrono::milliseconds keepalive{1000}; ///< Longest time between two packets to a device
+};
+
+/**
+ * Skips packets whose colors barely differ from what a device already
+ * shows.
+ *
+ * A device's colors (one RGB triple, or every zone or LED) are compared
+ * channel by channel with the last colors actually sent to it, not with
+ * the previous frame, so a slow fade still goes out once it has moved
+ * by more than `threshold`. A keepalive packet goes out after
+ * `keepalive` regardless, so receivers with a realtime timeout (WLED,
+ * E1.31) keep showing the stream.
+ */
+class ChangeGate {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /** Configure the gate for `devices` devices and forget what was sent. */
+    void reset(size_t devices, const ChangeGateOptions& options);
+
+    /** Whether the gate suppresses anything at all. */
+    bool enabled() const { return options_.threshold >= 0; }
+
+    /**
+     * Decide whether a device gets its packet and, if so, remember the
+     * colors as sent.
+     * @param device Device index.
+     * @param rgb    Packed RGB bytes the packet would carry.
+     * @param size   Number of bytes.
+     * @param now    Current time, for the keepalive.
+     * @return false if the packet is suppressed.
+     */
+    bool pass(size_t device, const uint8_t* rgb, size_t size, Clock::time_point now);
+
+    /** Packets suppressed for a device so far. */
+    uint64_t suppressed(size_t device) const { return devices_[device].suppressed; }
+
+    /** Packets suppressed for all devices so far. */
+    uint64_t suppressedTotal() const;
+
+private:
+    struct Device {
+        std::vector<uint8_t> sent; ///< Colors of the last packet that passed
+        Clock::time_point sentAt{};
+        bool hasSent = false;
+        uint64_t suppressed = 0;
+    };
+
+    bool changed(const std::vector<uint8_t>& sent, const uint8_t* rgb, size_t size) const;
+
+    ChangeGateOptions options_;
+    std::vector<Device> devices_;
+};
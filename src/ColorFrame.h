@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Compact 8-bit {R, G, B} color. */
+using Rgb8 = std::array<uint8_t, 3>;
+
+/**
+ * Result of analyzing one captured frame, passed from the processing
+ * thread to the sending thread.
+ */
+struct ColorFrame {
+    std::array<int, 3> average{0, 0, 0}; ///< Whole-frame average {R, G, B}
+    std::vector<Rgb8> zones;              ///< Edge zone colors, see ZoneExtractor
+    /// Color per configured device, in config order. Empty when no
+    /// device has a region, in which case every device shows `average`.
+    std::vector<std::array<int, 3>> deviceColors;
+    /// LED colors per device with an LED layout, in config order. Empty
+    /// when no device has a layout.
+    std::vector<std::vector<Rgb8>> devicePixels;
+    /// When the frame was captured, for the per-frame latency.
+    std::chrono::steady_clock::time_point capturedAt{};
+
+    /** Color to send to the device at `index`. */
+    const std::array<int, 3>& colorFor(size_t index) const {
+        return index < deviceColors.size() ? deviceColors[index] : average;
+    }
+
+    /** Per-LED colors for the device at `index`: its layout or the edge zones. */
+    const std::vector<Rgb8>& pixelsFor(size_t index) const {
+        if (index < devicePixels.size() && !devicePixels[index].empty())
+            return devicePixels[index];
+        return zones;
+    }
+};
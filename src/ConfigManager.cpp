@@ -1,7 +1,13 @@
 #include "ConfigManager.h"
+#include "PayloadFormat.h"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <stdexcept>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#endif
 
 using json = nlohmann::json;
 
@@ -12,23 +18,420 @@ namespace {
 // Parse a device entry from JSON and return a Device struct. Throws
 // std::runtime_error if any required field is missing or invalid.
 //--------------------------------------------------------------------
-Device parseDevice(const json& j) {
+Device parseDevice(const json& j, const std::filesystem::path& baseDir) {
     if (!j.is_object())
         throw std::runtime_error("device entry must be object");
     Device d{};
     auto ipIt = j.find("ip");
-    auto portIt = j.find("port");
     if (ipIt == j.end() || !ipIt->is_string())
         throw std::runtime_error("device.ip missing or not string");
-    if (portIt == j.end() || !portIt->is_number_unsigned())
-        throw std::runtime_error("device.port missing or not unsigned");
     d.ip = ipIt->get<std::string>();
-    unsigned long portVal = portIt->get<unsigned long>();
-    if (portVal > 65535)
-        throw std::runtime_error("device.port out of range");
-    d.port = static_cast<uint16_t>(portVal);
+
+    // Optional wire protocol; standard binary protocols have a default port
+    auto protocolIt = j.find("protocol");
+    if (protocolIt != j.end()) {
+        if (!protocolIt->is_string())
+            throw std::runtime_error("device.protocol must be string");
+        const std::string protocol = protocolIt->get<std::string>();
+        if (protocol == "text")
+            d.protocol = WireProtocol::Text;
+        else if (protocol == "ddp")
+            d.protocol = WireProtocol::Ddp;
+        else if (protocol == "e131")
+            d.protocol = WireProtocol::E131;
+        else if (protocol == "artnet")
+            d.protocol = WireProtocol::ArtNet;
+        else if (protocol == "wled")
+            d.protocol = WireProtocol::Wled;
+        else if (protocol == "delta")
+            d.protocol = WireProtocol::Delta;
+        else
+            throw std::runtime_error("device.protocol must be \"text\", \"ddp\", \"e131\", \"artnet\", \"wled\" or \"delta\"");
+    }
+
+    auto portIt = j.find("port");
+    if (portIt == j.end() && ProtocolEncoder::defaultPort(d.protocol) != 0) {
+        d.port = ProtocolEncoder::defaultPort(d.protocol);
+    } else {
+        if (portIt == j.end() || !portIt->is_number_unsigned())
+            throw std::runtime_error("device.port missing or not unsigned");
+        unsigned long portVal = portIt->get<unsigned long>();
+        if (portVal > 65535)
+            throw std::runtime_error("device.port out of range");
+        d.port = static_cast<uint16_t>(portVal);
+    }
+
+    auto intField = [&](const char* name, int& out, int minValue, int maxValue) {
+        auto it = j.find(name);
+        if (it == j.end())
+            return;
+        if (!it->is_number_integer() || it->get<int>() < minValue || it->get<int>() > maxValue)
+            throw std::runtime_error(std::string("device.") + name + " must be an integer in [" +
+                                     std::to_string(minValue) + ", " + std::to_string(maxValue) + "]");
+        out = it->get<int>();
+    };
+    if (d.protocol == WireProtocol::E131)
+        intField("universe", d.protocolOptions.universe, 1, ProtocolEncoder::maxUniverse(d.protocol));
+    else
+        intField("universe", d.protocolOptions.universe, 0, ProtocolEncoder::maxUniverse(WireProtocol::ArtNet));
+    intField("priority", d.protocolOptions.priority, 0, 200);
+    intField("wledTimeout", d.protocolOptions.wledTimeout, 1, 255);
+    intField("keyframeInterval", d.protocolOptions.delta.keyframeInterval, 1, 3600);
+    intField("deltaThreshold", d.protocolOptions.delta.threshold, 0, 255);
+    intField("ledCount", d.ledCount, 1, 100000);
+
+    auto maxRateIt = j.find("maxRate");
+    if (maxRateIt != j.end()) {
+        if (!maxRateIt->is_number() || maxRateIt->get<double>() < 0.0 || maxRateIt->get<double>() > 10000.0)
+            throw std::runtime_error("device.maxRate must be a number in [0, 10000]");
+        d.maxRate = maxRateIt->get<double>();
+    }
+
+    // Optional group delivery: one datagram for every controller listening
+    // on a multicast group or a broadcast address
+    in_addr ip{};
+    const bool isIpv4 = inet_pton(AF_INET, d.ip.c_str(), &ip) == 1;
+    const bool multicast = isIpv4 && (ntohl(ip.s_addr) & 0xF0000000u) == 0xE0000000u;
+    auto boolField = [&](const char* name, bool& out) {
+        auto it = j.find(name);
+        if (it == j.end())
+            return;
+        if (!it->is_boolean())
+            throw std::runtime_error(std::string("device.") + name + " must be boolean");
+        out = it->get<bool>();
+    };
+    for (const char* name : {"multicastTtl", "multicastInterface", "multicastLoop"})
+        if (!multicast && j.contains(name))
+            throw std::runtime_error(std::string("device.") + name + " needs a multicast ip (224.0.0.0/4)");
+    boolField("broadcast", d.group.broadcast);
+    if (d.group.broadcast && (!isIpv4 || multicast))
+        throw std::runtime_error("device.broadcast needs an IPv4 broadcast address");
+    intField("multicastTtl", d.group.multicastTtl, 0, 255);
+    boolField("multicastLoop", d.group.multicastLoop);
+    auto interfaceIt = j.find("multicastInterface");
+    if (interfaceIt != j.end()) {
+        if (!interfaceIt->is_string() ||
+            inet_pton(AF_INET, interfaceIt->get<std::string>().c_str(), &d.group.multicastInterface) != 1)
+            throw std::runtime_error("device.multicastInterface must be an IPv4 address string");
+    }
+
+    // Optional screen rectangle in normalized [0,1] coordinates
+    auto regionIt = j.find("region");
+    if (regionIt != j.end()) {
+        if (!regionIt->is_object())
+            throw std::runtime_error("device.region must be object");
+        auto coord = [&](const char* name, double def) {
+            auto it = regionIt->find(name);
+            if (it == regionIt->end())
+                return def;
+            if (!it->is_number())
+                throw std::runtime_error(std::string("device.region.") + name + " must be a number");
+            double v = it->get<double>();
+            if (v < 0.0 || v > 1.0)
+                throw std::runtime_error(std::string("device.region.") + name + " out of range [0,1]");
+            return v;
+        };
+        d.region.x = coord("x", 0.0);
+        d.region.y = coord("y", 0.0);
+        d.region.width = coord("width", 1.0 - d.region.x);
+        d.region.height = coord("height", 1.0 - d.region.y);
+        if (d.region.width <= 0.0 || d.region.height <= 0.0)
+            throw std::runtime_error("device.region must not be empty");
+        d.hasRegion = true;
+    }
+
+    // Optional LED layout file, relative to the configuration file
+    auto layoutIt = j.find("layout");
+    if (layoutIt != j.end()) {
+        if (!layoutIt->is_string())
+            throw std::runtime_error("device.layout must be string");
+        std::filesystem::path layoutPath = layoutIt->get<std::string>();
+        if (layoutPath.is_relative())
+            layoutPath = baseDir / layoutPath;
+        if (!ConfigManager::loadLayout(layoutPath.string(), d.leds))
+            throw std::runtime_error("cannot read layout file " + layoutPath.string());
+    }
+
+    // Long E1.31 / Art-Net strips continue on the following universes,
+    // which must all exist
+    const int maxUniverse = ProtocolEncoder::maxUniverse(d.protocol);
+    if (maxUniverse > 0) {
+        const size_t leds = d.leds.empty() ? static_cast<size_t>(d.ledCount) : d.leds.size();
+        const size_t perUniverse = ProtocolEncoder::pixelsPerPacket(d.protocol);
+        const int first = d.protocolOptions.universe >= 0 ? d.protocolOptions.universe
+                                                          : ProtocolEncoder::defaultUniverse(d.protocol);
+        const size_t last = static_cast<size_t>(first) + (leds + perUniverse - 1) / perUniverse - 1;
+        if (last > static_cast<size_t>(maxUniverse))
+            throw std::runtime_error("device.universe " + std::to_string(first) + " with " + std::to_string(leds) +
+                                     " LEDs ends on universe " + std::to_string(last) + ", above the last one (" +
+                                     std::to_string(maxUniverse) + ")");
+    }
     return d;
 }
+
+//--------------------------------------------------------------------
+// parseZones
+//--------------------------------------------------------------------
+// Parse the optional "zones" object. Every field is optional and must
+// be a non-negative integer.
+//--------------------------------------------------------------------
+ZoneLayout parseZones(const json& j) {
+    if (!j.is_object())
+        throw std::runtime_error("zones must be object");
+    ZoneLayout z{};
+    auto field = [&](const char* name, int& out) {
+        auto it = j.find(name);
+        if (it == j.end())
+            return;
+        if (!it->is_number_integer() || it->get<int>() < 0)
+            throw std::runtime_error(std::string("zones.") + name + " must be a non-negative integer");
+        out = it->get<int>();
+    };
+    field("top", z.top);
+    field("right", z.right);
+    field("bottom", z.bottom);
+    field("left", z.left);
+    field("depth", z.depth);
+    return z;
+}
+
+//--------------------------------------------------------------------
+// parseDominant
+//--------------------------------------------------------------------
+// Parse the optional "dominant" object. Every field is optional.
+//--------------------------------------------------------------------
+DominantOptions parseDominant(const json& j) {
+    if (!j.is_object())
+        throw std::runtime_error("dominant must be object");
+    DominantOptions o{};
+    auto field = [&](const char* name, int& out) {
+        auto it = j.find(name);
+        if (it == j.end())
+            return;
+        if (!it->is_number_integer() || it->get<int>() < 0)
+            throw std::runtime_error(std::string("dominant.") + name + " must be a non-negative integer");
+        out = it->get<int>();
+    };
+    field("kmeansIterations", o.kmeansIterations);
+    field("kmeansSamples", o.kmeansSamples);
+    auto budgetIt = j.find("timeBudgetMs");
+    if (budgetIt != j.end()) {
+        if (!budgetIt->is_number() || budgetIt->get<double>() < 0.0)
+            throw std::runtime_error("dominant.timeBudgetMs must be a non-negative number");
+        o.timeBudgetMs = budgetIt->get<double>();
+    }
+    return o;
+}
+
+//--------------------------------------------------------------------
+// parseUring
+//--------------------------------------------------------------------
+// Parse the optional "uring" object. Every field is optional.
+//--------------------------------------------------------------------
+UringOptions parseUring(const json& j) {
+    if (!j.is_object())
+        throw std::runtime_error("uring must be object");
+    UringOptions o{};
+    auto entriesIt = j.find("entries");
+    if (entriesIt != j.end()) {
+        if (!entriesIt->is_number_integer() || entriesIt->get<int>() < 8 || entriesIt->get<int>() > 4096)
+            throw std::runtime_error("uring.entries must be an integer in [8, 4096]");
+        o.entries = entriesIt->get<unsigned>();
+    }
+    auto thresholdIt = j.find("zeroCopyThreshold");
+    if (thresholdIt != j.end()) {
+        if (!thresholdIt->is_number_integer() || thresholdIt->get<long long>() < 0)
+            throw std::runtime_error("uring.zeroCopyThreshold must be a non-negative integer");
+        o.zeroCopyThreshold = thresholdIt->get<size_t>();
+    }
+    auto sqPollIt = j.find("sqPoll");
+    if (sqPollIt != j.end()) {
+        if (!sqPollIt->is_boolean())
+            throw std::runtime_error("uring.sqPoll must be boolean");
+        o.sqPoll = sqPollIt->get<bool>();
+    }
+    return o;
+}
+
+//--------------------------------------------------------------------
+// parseQueue
+//--------------------------------------------------------------------
+// Parse one edge of the optional "queues" object into `o`, keeping the
+// defaults of missing fields.
+//--------------------------------------------------------------------
+void parseQueue(const json& j, const std::string& name, QueueOptions& o) {
+    if (!j.is_object())
+        throw std::runtime_error("queues." + name + " must be object");
+    auto capacityIt = j.find("capacity");
+    if (capacityIt != j.end()) {
+        if (!capacityIt->is_number_integer() || capacityIt->get<int>() < 1 || capacityIt->get<int>() > 1024)
+            throw std::runtime_error("queues." + name + ".capacity must be an integer in [1, 1024]");
+        o.capacity = capacityIt->get<size_t>();
+    }
+    auto policyIt = j.find("policy");
+    if (policyIt != j.end()) {
+        const std::string policy = policyIt->is_string() ? policyIt->get<std::string>() : "";
+        if (policy == "block")
+            o.policy = OverflowPolicy::Block;
+        else if (policy == "dropOldest")
+            o.policy = OverflowPolicy::DropOldest;
+        else if (policy == "dropNewest")
+            o.policy = OverflowPolicy::DropNewest;
+        else
+            throw std::runtime_error("queues." + name + ".policy must be \"block\", \"dropOldest\" or \"dropNewest\"");
+    }
+}
+
+//--------------------------------------------------------------------
+// parseFramePool
+//--------------------------------------------------------------------
+// Parse the optional "framePool" object. Every field is optional.
+//--------------------------------------------------------------------
+FramePoolOptions parseFramePool(const json& j) {
+    if (!j.is_object())
+        throw std::runtime_error("framePool must be object");
+    FramePoolOptions o{};
+    auto buffersIt = j.find("buffers");
+    if (buffersIt != j.end()) {
+        if (!buffersIt->is_number_integer() || buffersIt->get<int>() < 2 || buffersIt->get<int>() > 64)
+            throw std::runtime_error("framePool.buffers must be an integer in [2, 64]");
+        o.buffers = buffersIt->get<int>();
+    }
+    auto hugePagesIt = j.find("hugePages");
+    if (hugePagesIt != j.end()) {
+        if (!hugePagesIt->is_boolean())
+            throw std::runtime_error("framePool.hugePages must be boolean");
+        o.hugePages = hugePagesIt->get<bool>();
+    }
+    return o;
+}
+
+//--------------------------------------------------------------------
+// parseSchedule
+//--------------------------------------------------------------------
+// Parse the optional "schedule" object. Every field is optional.
+//--------------------------------------------------------------------
+ScheduleOptions parseSchedule(const json& j) {
+    if (!j.is_object())
+        throw std::runtime_error("schedule must be object");
+    ScheduleOptions o{};
+    auto modeIt = j.find("mode");
+    if (modeIt != j.end()) {
+        const std::string mode = modeIt->is_string() ? modeIt->get<std::string>() : "";
+        if (mode == "deadline")
+            o.mode = ScheduleMode::Deadline;
+        else if (mode == "frame")
+            o.mode = ScheduleMode::Frame;
+        else
+            throw std::runtime_error("schedule.mode must be \"deadline\" or \"frame\"");
+    }
+    auto spinIt = j.find("spinUs");
+    if (spinIt != j.end()) {
+        if (!spinIt->is_number_integer() || spinIt->get<int>() < 0 || spinIt->get<int>() > 10000)
+            throw std::runtime_error("schedule.spinUs must be an integer in [0, 10000]");
+        o.spinUs = spinIt->get<int>();
+    }
+    auto rateIt = j.find("frameRate");
+    if (rateIt != j.end()) {
+        if (!rateIt->is_number() || rateIt->get<double>() < 1.0 || rateIt->get<double>() > 1000.0)
+            throw std::runtime_error("schedule.frameRate must be a number in [1, 1000]");
+        o.frameRate = rateIt->get<double>();
+    }
+    return o;
+}
+
+//--------------------------------------------------------------------
+// parsePipeline
+//--------------------------------------------------------------------
+// Parse the optional "pipeline" object. Every field is optional.
+//--------------------------------------------------------------------
+PipelineOptions parsePipeline(const json& j) {
+    if (!j.is_object())
+        throw std::runtime_error("pipeline must be object");
+    PipelineOptions o{};
+    auto modeIt = j.find("mode");
+    if (modeIt != j.end()) {
+        const std::string mode = modeIt->is_string() ? modeIt->get<std::string>() : "";
+        if (mode == "threaded")
+            o.mode = PipelineMode::Threaded;
+        else if (mode == "fused")
+            o.mode = PipelineMode::Fused;
+        else
+            throw std::runtime_error("pipeline.mode must be \"threaded\" or \"fused\"");
+    }
+    auto cpuIt = j.find("cpu");
+    if (cpuIt != j.end()) {
+        if (!cpuIt->is_number_integer() || cpuIt->get<int>() < -1 || cpuIt->get<int>() > 1023)
+            throw std::runtime_error("pipeline.cpu must be an integer in [-1, 1023]");
+        o.cpu = cpuIt->get<int>();
+    }
+    auto priorityIt = j.find("priority");
+    if (priorityIt != j.end()) {
+        const std::string priority = priorityIt->is_string() ? priorityIt->get<std::string>() : "";
+        if (priority == "normal")
+            o.priority = ThreadPriority::Normal;
+        else if (priority == "high")
+            o.priority = ThreadPriority::High;
+        else if (priority == "realtime")
+            o.priority = ThreadPriority::Realtime;
+        else
+            throw std::runtime_error("pipeline.priority must be \"normal\", \"high\" or \"realtime\"");
+    }
+    return o;
+}
+
+//--------------------------------------------------------------------
+// parseCircuitBreaker
+//--------------------------------------------------------------------
+// Parse the optional "circuitBreaker" object. Every field is optional
+// and must be a positive integer.
+//--------------------------------------------------------------------
+HealthOptions parseCircuitBreaker(const json& j) {
+    if (!j.is_object())
+        throw std::runtime_error("circuitBreaker must be object");
+    HealthOptions o{};
+    auto field = [&](const char* name) -> long long {
+        auto it = j.find(name);
+        if (it == j.end())
+            return 0;
+        if (!it->is_number_integer() || it->get<long long>() < 1)
+            throw std::runtime_error(std::string("circuitBreaker.") + name + " must be a positive integer");
+        return it->get<long long>();
+    };
+    if (const long long failures = field("failures"))
+        o.failureThreshold = static_cast<int>((std::min)(failures, 1000000LL));
+    if (const long long backoff = field("backoffMs"))
+        o.backoff = std::chrono::milliseconds(backoff);
+    if (const long long maxBackoff = field("maxBackoffMs"))
+        o.maxBackoff = std::chrono::milliseconds(maxBackoff);
+    if (o.maxBackoff < o.backoff)
+        throw std::runtime_error("circuitBreaker.maxBackoffMs must not be below backoffMs");
+    return o;
+}
+
+//--------------------------------------------------------------------
+// parseLetterbox
+//--------------------------------------------------------------------
+// Parse the optional "letterbox" object. Every field is optional.
+//--------------------------------------------------------------------
+LetterboxOptions parseLetterbox(const json& j) {
+    if (!j.is_object())
+        throw std::runtime_error("letterbox must be object");
+    LetterboxOptions o{};
+    auto field = [&](const char* name, int& out, int minValue, int maxValue) {
+        auto it = j.find(name);
+        if (it == j.end())
+            return;
+        if (!it->is_number_integer() || it->get<int>() < minValue || it->get<int>() > maxValue)
+            throw std::runtime_error(std::string("letterbox.") + name + " must be an integer in [" +
+                                     std::to_string(minValue) + ", " + std::to_string(maxValue) + "]");
+        out = it->get<int>();
+    };
+    field("threshold", o.threshold, 0, 255);
+    field("recheckFrames", o.recheckFrames, 1, 100000);
+    field("stableChecks", o.stableChecks, 1, 1000);
+    return o;
+}
 }
 
 //--------------------------------------------------------------------
@@ -57,11 +460,198 @@ bool ConfigManager::load(const std::string& path, Config& outCfg) {
     if (intervalIt == root.end() || !intervalIt->is_number_integer())
         throw std::runtime_error("captureIntervalMs missing or invalid");
     outCfg.intervalMs = intervalIt->get<int>();
+    outCfg.schedule = ScheduleOptions{};
+    auto scheduleIt = root.find("schedule");
+    if (scheduleIt != root.end())
+        outCfg.schedule = parseSchedule(*scheduleIt);
+
+    // Optional: sampling pattern used to estimate the frame average.
+    // sampleRowStride defaults to sampleStride.
+    outCfg.sampleStride = 1;
+    auto strideIt = root.find("sampleStride");
+    if (strideIt != root.end()) {
+        if (!strideIt->is_number_integer() || strideIt->get<int>() < 1)
+            throw std::runtime_error("sampleStride must be a positive integer");
+        outCfg.sampleStride = strideIt->get<int>();
+    }
+    outCfg.sampleRowStride = outCfg.sampleStride;
+    auto rowStrideIt = root.find("sampleRowStride");
+    if (rowStrideIt != root.end()) {
+        if (!rowStrideIt->is_number_integer() || rowStrideIt->get<int>() < 1)
+            throw std::runtime_error("sampleRowStride must be a positive integer");
+        outCfg.sampleRowStride = rowStrideIt->get<int>();
+    }
+    outCfg.sampleBudget = 0;
+    auto budgetIt = root.find("sampleBudget");
+    if (budgetIt != root.end()) {
+        if (!budgetIt->is_number_integer() || budgetIt->get<long long>() < 0)
+            throw std::runtime_error("sampleBudget must be a non-negative integer");
+        outCfg.sampleBudget = budgetIt->get<long long>();
+    }
+
+    // Optional: average in linear light
+    outCfg.linearLight = false;
+    auto linearIt = root.find("linearLight");
+    if (linearIt != root.end()) {
+        if (!linearIt->is_boolean())
+            throw std::runtime_error("linearLight must be boolean");
+        outCfg.linearLight = linearIt->get<bool>();
+    }
+
+    // Optional: SDR white level of HDR (half float) captures
+    outCfg.sdrWhiteNits = 0.0;
+    auto whiteIt = root.find("sdrWhiteNits");
+    if (whiteIt != root.end()) {
+        if (!whiteIt->is_number() || whiteIt->get<double>() <= 0.0)
+            throw std::runtime_error("sdrWhiteNits must be a positive number");
+        outCfg.sdrWhiteNits = whiteIt->get<double>();
+    }
+
+    // Optional: number of threads used to average a frame
+    outCfg.processingThreads = 0;
+    auto threadsIt = root.find("processingThreads");
+    if (threadsIt != root.end()) {
+        if (!threadsIt->is_number_integer() || threadsIt->get<int>() < 0)
+            throw std::runtime_error("processingThreads must be a non-negative integer");
+        outCfg.processingThreads = threadsIt->get<int>();
+    }
+
+    outCfg.zones = ZoneLayout{};
+    auto zonesIt = root.find("zones");
+    if (zonesIt != root.end())
+        outCfg.zones = parseZones(*zonesIt);
+
+    // Optional: analyze zones, regions and layouts on a thumbnail
+    outCfg.thumbnailWidth = 0;
+    outCfg.thumbnailHeight = 0;
+    auto thumbIt = root.find("thumbnail");
+    if (thumbIt != root.end()) {
+        if (!thumbIt->is_object())
+            throw std::runtime_error("thumbnail must be object");
+        auto wIt = thumbIt->find("width");
+        auto hIt = thumbIt->find("height");
+        if (wIt == thumbIt->end() || !wIt->is_number_integer() || wIt->get<int>() <= 0 ||
+            hIt == thumbIt->end() || !hIt->is_number_integer() || hIt->get<int>() <= 0)
+            throw std::runtime_error("thumbnail.width/height must be positive integers");
+        outCfg.thumbnailWidth = wIt->get<int>();
+        outCfg.thumbnailHeight = hIt->get<int>();
+    }
+
+    // Optional: "mean" (default) or "dominant" frame color
+    outCfg.processingMode = ProcessingMode::Mean;
+    auto modeIt = root.find("processingMode");
+    if (modeIt != root.end()) {
+        if (!modeIt->is_string())
+            throw std::runtime_error("processingMode must be string");
+        const std::string mode = modeIt->get<std::string>();
+        if (mode == "dominant")
+            outCfg.processingMode = ProcessingMode::Dominant;
+        else if (mode != "mean")
+            throw std::runtime_error("processingMode must be \"mean\" or \"dominant\"");
+    }
+    outCfg.dominant = DominantOptions{};
+    auto dominantIt = root.find("dominant");
+    if (dominantIt != root.end())
+        outCfg.dominant = parseDominant(*dominantIt);
+
+    // Optional: crop letterbox/pillarbox bars
+    outCfg.detectLetterbox = false;
+    outCfg.letterbox = LetterboxOptions{};
+    auto letterboxIt = root.find("letterbox");
+    if (letterboxIt != root.end()) {
+        outCfg.letterbox = parseLetterbox(*letterboxIt);
+        outCfg.detectLetterbox = true;
+    }
 
     auto formatIt = root.find("format");
     if (formatIt == root.end() || !formatIt->is_string())
         throw std::runtime_error("format missing or invalid");
     outCfg.format = formatIt->get<std::string>();
+    std::string formatError;
+    if (!PayloadFormat().compile(outCfg.format, &formatError))
+        throw std::runtime_error("format invalid: " + formatError);
+
+    // Optional: one connected socket per device
+    outCfg.connectedSockets = false;
+    auto connectedIt = root.find("connectedSockets");
+    if (connectedIt != root.end()) {
+        if (!connectedIt->is_boolean())
+            throw std::runtime_error("connectedSockets must be boolean");
+        outCfg.connectedSockets = connectedIt->get<bool>();
+    }
+
+    // Optional: UDP segmentation offload for multi-packet frames
+    outCfg.udpSegmentation = true;
+    auto segmentationIt = root.find("udpSegmentation");
+    if (segmentationIt != root.end()) {
+        if (!segmentationIt->is_boolean())
+            throw std::runtime_error("udpSegmentation must be boolean");
+        outCfg.udpSegmentation = segmentationIt->get<bool>();
+    }
+
+    // Optional: spread each frame's fan-out over this many send bursts
+    outCfg.paceSlices = 1;
+    auto paceIt = root.find("paceSlices");
+    if (paceIt != root.end()) {
+        if (!paceIt->is_number_integer() || paceIt->get<int>() < 1 || paceIt->get<int>() > 64)
+            throw std::runtime_error("paceSlices must be an integer in [1, 64]");
+        outCfg.paceSlices = paceIt->get<int>();
+    }
+
+    // Optional: skip packets whose colors barely changed, with keepalive
+    outCfg.changeGate = ChangeGateOptions{};
+    auto thresholdIt = root.find("changeThreshold");
+    if (thresholdIt != root.end()) {
+        if (!thresholdIt->is_number_integer() || thresholdIt->get<int>() < 0 || thresholdIt->get<int>() > 255)
+            throw std::runtime_error("changeThreshold must be an integer in [0, 255]");
+        outCfg.changeGate.threshold = thresholdIt->get<int>();
+    }
+    auto keepaliveIt = root.find("keepaliveMs");
+    if (keepaliveIt != root.end()) {
+        if (!keepaliveIt->is_number_integer() || keepaliveIt->get<int>() < 10 || keepaliveIt->get<int>() > 60000)
+            throw std::runtime_error("keepaliveMs must be an integer in [10, 60000]");
+        outCfg.changeGate.keepalive = std::chrono::milliseconds(keepaliveIt->get<int>());
+    }
+
+    // Optional: "batched" (default) or "io_uring" transmit path
+    outCfg.transport = UdpTransport::Batched;
+    auto transportIt = root.find("transport");
+    if (transportIt != root.end()) {
+        if (!transportIt->is_string())
+            throw std::runtime_error("transport must be string");
+        const std::string transport = transportIt->get<std::string>();
+        if (transport == "io_uring")
+            outCfg.transport = UdpTransport::IoUring;
+        else if (transport != "batched")
+            throw std::runtime_error("transport must be \"batched\" or \"io_uring\"");
+    }
+    outCfg.uring = UringOptions{};
+    auto uringIt = root.find("uring");
+    if (uringIt != root.end())
+        outCfg.uring = parseUring(*uringIt);
+    outCfg.health = HealthOptions{};
+    auto breakerIt = root.find("circuitBreaker");
+    if (breakerIt != root.end())
+        outCfg.health = parseCircuitBreaker(*breakerIt);
+
+    // Optional: bound of the queue between processing and sending; capture
+    // hands its newest frame over through a mailbox
+    outCfg.colorQueue = QueueOptions{4, OverflowPolicy::DropOldest};
+    auto queuesIt = root.find("queues");
+    if (queuesIt != root.end()) {
+        if (!queuesIt->is_object())
+            throw std::runtime_error("queues must be object");
+        if (queuesIt->contains("colors"))
+            parseQueue(queuesIt->at("colors"), "colors", outCfg.colorQueue);
+    }
+    outCfg.pipeline = PipelineOptions{};
+    auto pipelineIt = root.find("pipeline");
+    if (pipelineIt != root.end())
+        outCfg.pipeline = parsePipeline(*pipelineIt);
+    outCfg.framePool = FramePoolOptions{};
+    auto framePoolIt = root.find("framePool");
+    if (framePoolIt != root.end())
+        outCfg.framePool = parseFramePool(*framePoolIt);
 
     auto devicesIt = root.find("devices");
     if (devicesIt == root.end() || !devicesIt->is_array())
@@ -69,9 +659,59 @@ bool ConfigManager::load(const std::string& path, Config& outCfg) {
 
     outCfg.devices.clear();
     for (const auto& item : *devicesIt) {
-        outCfg.devices.push_back(parseDevice(item));
+        outCfg.devices.push_back(parseDevice(item, std::filesystem::path(path).parent_path()));
     }
 
     return true;
 }
 
+
+//--------------------------------------------------------------------
+// ConfigManager::loadLayout
+//--------------------------------------------------------------------
+// Load LED positions and footprints. Returns false if the file cannot
+// be opened or parsed. Throws std::runtime_error on invalid entries.
+//--------------------------------------------------------------------
+bool ConfigManager::loadLayout(const std::string& path, std::vector<LedSpot>& outLeds) {
+    std::ifstream file(path);
+    if (!file.is_open())
+        return false;
+
+    json root;
+    try {
+        file >> root;
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    const json* leds = &root;
+    if (root.is_object()) {
+        auto ledsIt = root.find("leds");
+        if (ledsIt == root.end())
+            throw std::runtime_error("layout.leds missing");
+        leds = &*ledsIt;
+    }
+    if (!leds->is_array())
+        throw std::runtime_error("layout.leds must be array");
+
+    outLeds.clear();
+    for (const auto& item : *leds) {
+        if (!item.is_object())
+            throw std::runtime_error("layout entry must be object");
+        auto xIt = item.find("x");
+        auto yIt = item.find("y");
+        if (xIt == item.end() || !xIt->is_number() || yIt == item.end() || !yIt->is_number())
+            throw std::runtime_error("layout entry x/y missing or not number");
+        LedSpot led;
+        led.x = xIt->get<double>();
+        led.y = yIt->get<double>();
+        auto radiusIt = item.find("radius");
+        if (radiusIt != item.end()) {
+            if (!radiusIt->is_number() || radiusIt->get<double>() <= 0.0)
+                throw std::runtime_error("layout entry radius must be positive");
+            led.radius = radiusIt->get<double>();
+        }
+        outLeds.push_back(led);
+    }
+    return true;
+}
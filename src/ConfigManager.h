@@ -3,6 +3,18 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include "ChangeGate.h"
+#include "DominantColor.h"
+#include "FramePool.h"
+#include "FrameScheduler.h"
+#include "IntegralImage.h"
+#include "LedProtocol.h"
+#include "LetterboxDetector.h"
+#include "UDPSender.h"
+#include "LedSampler.h"
+#include "SpscRing.h"
+#include "ThreadTuning.h"
+#include "ZoneExtractor.h"
 
 /**
  * Network device configuration.
@@ -10,6 +22,22 @@
 struct Device {
     std::string ip;   ///< IPv4/IPv6 address of the device
     uint16_t port;    ///< UDP port number
+    bool hasRegion = false; ///< Whether the device mirrors only `region`
+    Region region;          ///< Screen rectangle shown by the device
+    std::vector<LedSpot> leds; ///< LED layout of the device (empty = none)
+    WireProtocol protocol = WireProtocol::Text; ///< Packet format sent to the device
+    ProtocolOptions protocolOptions;            ///< Universe, priority, ... of binary protocols
+    int ledCount = 1;       ///< LEDs lit with the device color when there is no layout or zone
+    GroupDelivery group;    ///< Multicast/broadcast options when `ip` reaches many controllers
+    double maxRate = 0.0;   ///< Packets per second the device accepts (0 = every frame)
+};
+
+/**
+ * How the frame color sent to devices is computed.
+ */
+enum class ProcessingMode {
+    Mean,     ///< Average of all pixels
+    Dominant  ///< Most prominent color (histogram peak)
 };
 
 /**
@@ -17,9 +45,33 @@ struct Device {
  */
 struct Config {
     int intervalMs = 0;            ///< Delay between frames in milliseconds
+    ScheduleOptions schedule;      ///< Pacing of the capture thread
+    int sampleStride = 1;          ///< Read every Nth pixel of a row (1 = all)
+    int sampleRowStride = 1;       ///< Read every Mth row (1 = all)
+    long long sampleBudget = 0;    ///< Max pixels sampled per frame (0 = no limit)
+    bool linearLight = false;      ///< Average in linear light instead of on sRGB values
+    double sdrWhiteNits = 0.0;     ///< SDR white of half float captures in nits (0 = from the display)
     std::vector<Device> devices;   ///< List of destination devices
     std::string format;            ///< Packet format string
+    bool connectedSockets = false; ///< One connected UDP socket per device
+    UdpTransport transport = UdpTransport::Batched; ///< How a frame's datagrams reach the kernel
+    UringOptions uring;            ///< Tuning of UdpTransport::IoUring
+    bool udpSegmentation = true;   ///< Send packet runs as segmented datagrams where supported
+    HealthOptions health;          ///< When failing devices are paused
+    int paceSlices = 1;            ///< Send bursts a frame's fan-out is spread over (1 = one burst)
+    ChangeGateOptions changeGate;  ///< Suppression of unchanged packets
+    QueueOptions colorQueue{4, OverflowPolicy::DropOldest}; ///< Processed frames waiting for sending
+    FramePoolOptions framePool;    ///< CPU buffers captured frames are copied into
+    PipelineOptions pipeline;      ///< Threaded or fused pipeline, affinity and priority
     int monitorIndex = -1;         ///< Monitor index to capture (-1 = auto-detect from window)
+    int processingThreads = 0;     ///< Threads used to reduce a frame (0 = all cores)
+    ZoneLayout zones;              ///< Edge zones to extract (empty = none)
+    int thumbnailWidth = 0;        ///< Thumbnail size for zones/regions/layouts (0 = full frame)
+    int thumbnailHeight = 0;       ///< See thumbnailWidth
+    ProcessingMode processingMode = ProcessingMode::Mean; ///< Frame color computation
+    DominantOptions dominant;      ///< Tuning of ProcessingMode::Dominant
+    bool detectLetterbox = false;  ///< Crop black bars before analyzing
+    LetterboxOptions letterbox;    ///< Tuning of the bar detection
 };
 
 /**
@@ -36,5 +88,19 @@ public:
      * @throws std::runtime_error on missing or invalid entries.
      */
     static bool load(const std::string& path, Config& outCfg);
+
+    /**
+     * Load an LED layout file.
+     *
+     * The file holds either an array of LEDs or an object with a "leds"
+     * array. Each LED has normalized "x" and "y" coordinates and an
+     * optional "radius" (fraction of the screen height).
+     *
+     * @param path    Path to the JSON layout file.
+     * @param outLeds Receives the LEDs in file order.
+     * @return true if the file was opened and parsed successfully.
+     * @throws std::runtime_error on missing or invalid entries.
+     */
+    static bool loadLayout(const std::string& path, std::vector<LedSpot>& outLeds);
 };
 
@@ -0,0 +1,198 @@
+#include "DeltaCodec.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+void putBe16(uint8_t* p, size_t v) {
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+}
+
+size_t getBe16(const uint8_t* p) {
+    return static_cast<size_t>(p[0]) << 8 | p[1];
+}
+
+// Whether a pixel moved by more than `threshold` on any channel
+bool moved(const Rgb8& a, const Rgb8& b, int threshold) {
+    auto delta = [](uint8_t x, uint8_t y) { return x > y ? x - y : y - x; };
+    return delta(a[0], b[0]) > threshold || delta(a[1], b[1]) > threshold || delta(a[2], b[2]) > threshold;
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// DeltaEncoder
+//----------------------------------------------------------------------
+DeltaEncoder::DeltaEncoder(const DeltaOptions& options) : options_(options) {
+    options_.keyframeInterval = (std::max)(options_.keyframeInterval, 1);
+    options_.threshold = (std::clamp)(options_.threshold, 0, 255);
+}
+
+//----------------------------------------------------------------------
+// isKeyframeRequest
+//----------------------------------------------------------------------
+bool DeltaEncoder::isKeyframeRequest(const uint8_t* data, size_t size) {
+    return size >= sizeof(DeltaWire::kKeyframeRequest) &&
+           std::memcmp(data, DeltaWire::kKeyframeRequest, sizeof(DeltaWire::kKeyframeRequest)) == 0;
+}
+
+//----------------------------------------------------------------------
+// findRanges
+//----------------------------------------------------------------------
+// Collect the runs of changed pixels. A gap of one unchanged pixel costs
+// 3 bytes inside a range but 4 as a new range header, so such runs are
+// joined.
+//----------------------------------------------------------------------
+void DeltaEncoder::findRanges(const Rgb8* pixels, size_t count) {
+    ranges_.clear();
+    const int threshold = options_.threshold;
+    size_t i = 0;
+    while (i < count) {
+        if (!moved(pixels[i], shown_[i], threshold)) {
+            ++i;
+            continue;
+        }
+        const size_t start = i;
+        size_t end = ++i; // one past the last changed pixel
+        while (i < count && i <= end + 1) {
+            if (moved(pixels[i], shown_[i], threshold))
+                end = i + 1;
+            ++i;
+        }
+        ranges_.push_back({start, end - start});
+        i = end;
+    }
+}
+
+//----------------------------------------------------------------------
+// pack
+//----------------------------------------------------------------------
+// Write the ranges into packets of at most kMaxPacket bytes, splitting
+// a range where a packet is full, then fill in the part counts.
+//----------------------------------------------------------------------
+void DeltaEncoder::pack(const Rgb8* pixels, size_t count, bool keyframe) {
+    using namespace DeltaWire;
+    buffer_.clear();
+    offsets_.clear();
+    views_.clear();
+
+    auto startPacket = [&] {
+        offsets_.push_back(buffer_.size());
+        uint8_t header[kHeaderSize] = {'R', 'D', kVersion, 0};
+        header[3] = keyframe ? kFlagKeyframe : 0;
+        putBe16(header + 4, sequence_);
+        header[6] = static_cast<uint8_t>(offsets_.size() - 1);
+        putBe16(header + 8, count);
+        buffer_.insert(buffer_.end(), header, header + kHeaderSize);
+    };
+
+    startPacket();
+    for (const Range& range : ranges_) {
+        size_t done = 0;
+        while (done < range.count) {
+            size_t room = kMaxPacket - (buffer_.size() - offsets_.back());
+            if (room < kRangeHeaderSize + 3) {
+                startPacket();
+                room = kMaxPacket - kHeaderSize;
+            }
+            const size_t n = (std::min)(range.count - done, (room - kRangeHeaderSize) / 3);
+            const size_t at = buffer_.size();
+            buffer_.resize(at + kRangeHeaderSize + n * 3);
+            putBe16(&buffer_[at], range.start + done);
+            putBe16(&buffer_[at + 2], n);
+            std::memcpy(&buffer_[at + kRangeHeaderSize], pixels + range.start + done, n * 3);
+            done += n;
+        }
+    }
+
+    const size_t parts = offsets_.size();
+    for (size_t p = 0; p < parts; ++p) {
+        uint8_t* packet = buffer_.data() + offsets_[p];
+        packet[7] = static_cast<uint8_t>(parts);
+        if (p + 1 == parts)
+            packet[3] |= kFlagLastPart;
+        const size_t end = p + 1 < parts ? offsets_[p + 1] : buffer_.size();
+        views_.push_back({packet, end - offsets_[p]});
+    }
+}
+
+//----------------------------------------------------------------------
+// encode
+//----------------------------------------------------------------------
+const std::vector<PacketView>& DeltaEncoder::encode(const Rgb8* pixels, size_t count) {
+    count = (std::min)(count, DeltaWire::kMaxPixels);
+    ++sequence_;
+    const bool keyframe = keyframeRequested_ || shown_.size() != count ||
+                          ++framesSinceKeyframe_ >= options_.keyframeInterval;
+    if (keyframe) {
+        keyframeRequested_ = false;
+        framesSinceKeyframe_ = 0;
+        shown_.assign(pixels, pixels + count);
+        ranges_.assign(1, Range{0, count});
+        if (count == 0)
+            ranges_.clear();
+    } else {
+        findRanges(pixels, count);
+        for (const Range& range : ranges_)
+            std::copy(pixels + range.start, pixels + range.start + range.count, shown_.begin() + range.start);
+    }
+    pack(pixels, count, keyframe);
+    return views_;
+}
+
+//----------------------------------------------------------------------
+// DeltaDecoder::apply
+//----------------------------------------------------------------------
+// Packets of an older frame are ignored. A new frame that does not
+// directly follow a complete one means something was lost.
+//----------------------------------------------------------------------
+bool DeltaDecoder::apply(const uint8_t* data, size_t size) {
+    using namespace DeltaWire;
+    if (size < kHeaderSize || data[0] != 'R' || data[1] != 'D' || data[2] != kVersion)
+        return false;
+    const bool keyframe = (data[3] & kFlagKeyframe) != 0;
+    const uint16_t sequence = static_cast<uint16_t>(getBe16(data + 4));
+    const uint8_t parts = data[7];
+    const size_t count = getBe16(data + 8);
+    if (parts == 0 || data[6] >= parts)
+        return false;
+
+    if (!started_ || sequence != sequence_) {
+        const auto ahead = static_cast<int16_t>(sequence - sequence_);
+        if (started_ && ahead < 0)
+            return true; // late packet of an older frame
+        if (started_ && (ahead != 1 || !complete_))
+            needsKeyframe_ = true;
+        started_ = true;
+        sequence_ = sequence;
+        parts_ = parts;
+        partsSeen_ = 0;
+        keyframe_ = keyframe;
+        complete_ = false;
+    }
+    if (pixels_.size() != count) {
+        pixels_.assign(count, Rgb8{});
+        if (!keyframe)
+            needsKeyframe_ = true;
+    }
+
+    size_t at = kHeaderSize;
+    while (at < size) {
+        if (size - at < kRangeHeaderSize)
+            return false;
+        const size_t start = getBe16(data + at);
+        const size_t n = getBe16(data + at + 2);
+        at += kRangeHeaderSize;
+        if (start + n > count || size - at < n * 3)
+            return false;
+        std::memcpy(pixels_.data() + start, data + at, n * 3);
+        at += n * 3;
+    }
+
+    if (++partsSeen_ == parts_) {
+        complete_ = true;
+        ++frames_;
+        if (keyframe_)
+            needsKeyframe_ = false;
+    }
+    return true;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ColorFrame.h"
+
+/**
+ * Tuning of the delta encoding.
+ */
+struct DeltaOptions {
+    int keyframeInterval = 30; ///< Frames between two full frames
+    int threshold = 0;         ///< Largest per-channel change not worth sending (0 = lossless)
+};
+
+/** One encoded datagram, pointing into the encoder's buffer. */
+struct PacketView {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * Wire format of the delta protocol. All fields are big endian.
+ *
+ * Frame packet:
+ *
+ *     0  'R' 'D'        magic
+ *     2  version        1
+ *     3  flags          0x01 keyframe, 0x02 last packet of the frame
+ *     4  sequence (16)  frame number, all packets of a frame share it
+ *     6  part           packet index within the frame
+ *     7  parts          packets in the frame
+ *     8  pixels (16)    LEDs of the whole strip
+ *    10  ranges         until the end of the datagram:
+ *                       start (16), count (16), count * RGB
+ *
+ * A keyframe covers the whole strip; other frames carry only the ranges
+ * that changed since the previous frame, and a frame without changes is
+ * a header without ranges. A receiver that misses a frame or packet
+ * replies with a keyframe request: 'R' 'K', version 1.
+ */
+namespace DeltaWire {
+constexpr size_t kHeaderSize = 10;
+constexpr size_t kRangeHeaderSize = 4;
+constexpr size_t kMaxPacket = 1472;    ///< Fits an Ethernet frame without IP fragmentation
+constexpr size_t kMaxPixels = 65535;
+constexpr uint8_t kVersion = 1;
+constexpr uint8_t kFlagKeyframe = 0x01;
+constexpr uint8_t kFlagLastPart = 0x02;
+constexpr uint8_t kKeyframeRequest[3] = {'R', 'K', kVersion};
+} // namespace DeltaWire
+
+/**
+ * Encodes LED colors as changes against the previous frame.
+ *
+ * The encoder keeps the colors the receiver shows if nothing was lost.
+ * Pixels that moved by more than `threshold` on any channel form ranges;
+ * ranges separated by a single unchanged pixel are merged, since three
+ * bytes of color are cheaper than a four byte range header. A keyframe
+ * goes out every `keyframeInterval` frames, when the strip length
+ * changes and after `requestKeyframe`.
+ */
+class DeltaEncoder {
+public:
+    explicit DeltaEncoder(const DeltaOptions& options = DeltaOptions{});
+
+    /**
+     * Encode one frame.
+     * @param pixels LED colors in strip order.
+     * @param count  Number of LEDs, at most `DeltaWire::kMaxPixels`.
+     * @return Packets to send in order, valid until the next call.
+     */
+    const std::vector<PacketView>& encode(const Rgb8* pixels, size_t count);
+
+    /** Make the next frame a keyframe, e.g. on a receiver's request. */
+    void requestKeyframe() { keyframeRequested_ = true; }
+
+    /** Whether a datagram from a receiver is a keyframe request. */
+    static bool isKeyframeRequest(const uint8_t* data, size_t size);
+
+private:
+    struct Range {
+        size_t start = 0;
+        size_t count = 0;
+    };
+
+    void findRanges(const Rgb8* pixels, size_t count);
+    void pack(const Rgb8* pixels, size_t count, bool keyframe);
+
+    DeltaOptions options_;
+    std::vector<Rgb8> shown_;      ///< Colors the receiver shows
+    std::vector<Range> ranges_;
+    std::vector<uint8_t> buffer_;  ///< Packets of the frame, back to back
+    std::vector<size_t> offsets_;  ///< Start of each packet in buffer_
+    std::vector<PacketView> views_;
+    uint16_t sequence_ = 0;
+    int framesSinceKeyframe_ = 0;
+    bool keyframeRequested_ = true;
+};
+
+/**
+ * Receiver side of the delta protocol, used to verify the encoder.
+ *
+ * Packets are applied as they arrive. A missing frame or packet sets
+ * `needsKeyframe` until a complete keyframe arrived; later deltas are
+ * still applied, so only the pixels of the lost packets stay stale.
+ */
+class DeltaDecoder {
+public:
+    /**
+     * Apply one datagram.
+     * @return false if it is not a well-formed delta packet.
+     */
+    bool apply(const uint8_t* data, size_t size);
+
+    /** LED colors after the packets applied so far. */
+    const std::vector<Rgb8>& pixels() const { return pixels_; }
+
+    /** Whether a packet was lost since the last complete keyframe. */
+    bool needsKeyframe() const { return needsKeyframe_; }
+
+    /** Frames completed so far. */
+    uint64_t frames() const { return frames_; }
+
+private:
+    std::vector<Rgb8> pixels_;
+    bool started_ = false;
+    bool needsKeyframe_ = true;
+    uint16_t sequence_ = 0;    ///< Frame currently being received
+    uint8_t parts_ = 0;
+    uint8_t partsSeen_ = 0;
+    bool keyframe_ = false;
+    bool complete_ = false;    ///< Every packet of sequence_ arrived
+    uint64_t frames_ = 0;
+};
@@ -0,0 +1,228 @@
+#include "DominantColor.h"
+#include <algorithm>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RGBS_DOMINANT_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RGBS_DOMINANT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr int kClusters = 4;
+
+// Bin index from byte lanes: lane 2 in the high nibble, lane 0 in the low
+inline uint16_t binOf(const uint8_t* px) {
+    return static_cast<uint16_t>(((px[2] >> 4) << 8) | ((px[1] >> 4) << 4) | (px[0] >> 4));
+}
+
+//----------------------------------------------------------------------
+// computeBins
+//----------------------------------------------------------------------
+// Bin indices of a row, four pixels per SIMD step: the top nibble of
+// each byte lane is masked and shifted into place within the 32-bit
+// pixel, then the indices are narrowed to 16 bits.
+//----------------------------------------------------------------------
+void computeBins(const uint8_t* row, int width, uint16_t* bins) {
+    int x = 0;
+#if defined(RGBS_DOMINANT_SSE2)
+    const __m128i mask0 = _mm_set1_epi32(0x000000F0);
+    const __m128i mask1 = _mm_set1_epi32(0x0000F000);
+    const __m128i mask2 = _mm_set1_epi32(0x00F00000);
+    for (; x + 4 <= width; x += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+        const __m128i idx = _mm_or_si128(
+            _mm_or_si128(_mm_srli_epi32(_mm_and_si128(px, mask0), 4),
+                         _mm_srli_epi32(_mm_and_si128(px, mask1), 8)),
+            _mm_srli_epi32(_mm_and_si128(px, mask2), 12));
+        // Indices are < 4096, so a signed 32->16 pack is lossless
+        const __m128i packed = _mm_packs_epi32(idx, idx);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(bins + x), packed);
+    }
+#elif defined(RGBS_DOMINANT_NEON)
+    for (; x + 4 <= width; x += 4) {
+        const uint32x4_t px = vld1q_u32(reinterpret_cast<const uint32_t*>(row + x * 4));
+        const uint32x4_t idx = vorrq_u32(
+            vorrq_u32(vshrq_n_u32(vandq_u32(px, vdupq_n_u32(0x000000F0)), 4),
+                      vshrq_n_u32(vandq_u32(px, vdupq_n_u32(0x0000F000)), 8)),
+            vshrq_n_u32(vandq_u32(px, vdupq_n_u32(0x00F00000)), 12));
+        vst1_u16(bins + x, vmovn_u32(idx));
+    }
+#endif
+    for (; x < width; ++x)
+        bins[x] = binOf(row + x * 4);
+}
+
+inline int distance2(const uint8_t* px, const std::array<double, 3>& c) {
+    const int d0 = px[0] - static_cast<int>(c[0]);
+    const int d1 = px[1] - static_cast<int>(c[1]);
+    const int d2 = px[2] - static_cast<int>(c[2]);
+    return d0 * d0 + d1 * d1 + d2 * d2;
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// buildHistogram
+//----------------------------------------------------------------------
+// Count pixels and sum their byte lanes per 4-4-4 bin.
+//----------------------------------------------------------------------
+void DominantColorExtractor::buildHistogram(const FrameView& frame) {
+    counts_.assign(kBins, 0);
+    sums_.assign(static_cast<size_t>(kBins) * 3, 0);
+    rowBins_.resize(frame.width);
+
+    for (int y = 0; y < frame.height; ++y) {
+        const uint8_t* row = frame.row(y);
+        computeBins(row, frame.width, rowBins_.data());
+        for (int x = 0; x < frame.width; ++x) {
+            const uint16_t bin = rowBins_[x];
+            const uint8_t* px = row + x * 4;
+            ++counts_[bin];
+            uint64_t* s = &sums_[bin * 3];
+            s[0] += px[0];
+            s[1] += px[1];
+            s[2] += px[2];
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// refine
+//----------------------------------------------------------------------
+// Fixed k-means iterations on an evenly strided pixel sample. Cluster 0
+// is seeded with the histogram winner, the others with the next peaks.
+// Returns the mean of the largest cluster, in byte lane order.
+//----------------------------------------------------------------------
+std::array<int, 3> DominantColorExtractor::refine(const FrameView& frame,
+                                                  const std::array<double, 3>& seed) {
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double, std::milli>(options_.timeBudgetMs));
+
+    // Further seeds: the most populated bins that are clearly apart from
+    // the centers chosen so far
+    std::array<std::array<double, 3>, kClusters> centers{};
+    centers[0] = seed;
+    std::vector<int> order(kBins);
+    for (int i = 0; i < kBins; ++i)
+        order[i] = i;
+    std::partial_sort(order.begin(), order.begin() + 64, order.end(),
+                      [&](int a, int b) { return counts_[a] > counts_[b]; });
+    int clusters = 1;
+    for (int i = 0; i < 64 && clusters < kClusters; ++i) {
+        const int bin = order[i];
+        if (counts_[bin] == 0)
+            break;
+        std::array<double, 3> c;
+        for (int ch = 0; ch < 3; ++ch)
+            c[ch] = static_cast<double>(sums_[bin * 3 + ch]) / counts_[bin];
+        bool distinct = true;
+        for (int k = 0; k < clusters && distinct; ++k) {
+            const double d0 = c[0] - centers[k][0], d1 = c[1] - centers[k][1], d2 = c[2] - centers[k][2];
+            distinct = d0 * d0 + d1 * d1 + d2 * d2 > 32.0 * 32.0;
+        }
+        if (distinct)
+            centers[clusters++] = c;
+    }
+
+    const long long total = static_cast<long long>(frame.width) * frame.height;
+    const long long step = (std::max)(1LL, total / (std::max)(1, options_.kmeansSamples));
+    std::array<std::array<double, 3>, kClusters> sum{};
+    std::array<long long, kClusters> members{};
+
+    for (int it = 0; it < options_.kmeansIterations; ++it) {
+        sum = {};
+        members = {};
+        for (long long i = 0; i < total; i += step) {
+            const int x = static_cast<int>(i % frame.width);
+            const int y = static_cast<int>(i / frame.width);
+            const uint8_t* px = frame.row(y) + x * 4;
+            int best = 0;
+            int bestDist = distance2(px, centers[0]);
+            for (int k = 1; k < clusters; ++k) {
+                const int d = distance2(px, centers[k]);
+                if (d < bestDist) {
+                    bestDist = d;
+                    best = k;
+                }
+            }
+            ++members[best];
+            for (int ch = 0; ch < 3; ++ch)
+                sum[best][ch] += px[ch];
+        }
+        for (int k = 0; k < clusters; ++k) {
+            if (members[k] > 0) {
+                for (int ch = 0; ch < 3; ++ch)
+                    centers[k][ch] = sum[k][ch] / members[k];
+            }
+        }
+        if (clock::now() >= deadline)
+            break;
+    }
+
+    int largest = 0;
+    for (int k = 1; k < clusters; ++k) {
+        if (members[k] > members[largest])
+            largest = k;
+    }
+    return {static_cast<int>(centers[largest][0] + 0.5), static_cast<int>(centers[largest][1] + 0.5),
+            static_cast<int>(centers[largest][2] + 0.5)};
+}
+
+//----------------------------------------------------------------------
+// extract
+//----------------------------------------------------------------------
+// Histogram, neighbourhood peak search and optional refinement. The
+// channel order of the frame is resolved on the final color only.
+//----------------------------------------------------------------------
+std::array<int, 3> DominantColorExtractor::extract(const FrameView& frame) {
+    if (frame.empty())
+        return {0, 0, 0};
+
+    buildHistogram(frame);
+
+    // Score each bin by the pixels in its 3x3x3 neighbourhood so a color
+    // that straddles a bin boundary is not split in two
+    int bestBin = 0;
+    uint64_t bestScore = 0;
+    for (int bin = 0; bin < kBins; ++bin) {
+        if (counts_[bin] == 0)
+            continue;
+        const int c2 = bin >> 8, c1 = (bin >> 4) & 0xF, c0 = bin & 0xF;
+        uint64_t score = 0;
+        for (int d2 = (std::max)(0, c2 - 1); d2 <= (std::min)(15, c2 + 1); ++d2)
+            for (int d1 = (std::max)(0, c1 - 1); d1 <= (std::min)(15, c1 + 1); ++d1)
+                for (int d0 = (std::max)(0, c0 - 1); d0 <= (std::min)(15, c0 + 1); ++d0)
+                    score += counts_[(d2 << 8) | (d1 << 4) | d0];
+        if (score > bestScore) {
+            bestScore = score;
+            bestBin = bin;
+        }
+    }
+
+    // Mean color of the winning neighbourhood
+    const int c2 = bestBin >> 8, c1 = (bestBin >> 4) & 0xF, c0 = bestBin & 0xF;
+    uint64_t lanes[3] = {0, 0, 0};
+    for (int d2 = (std::max)(0, c2 - 1); d2 <= (std::min)(15, c2 + 1); ++d2)
+        for (int d1 = (std::max)(0, c1 - 1); d1 <= (std::min)(15, c1 + 1); ++d1)
+            for (int d0 = (std::max)(0, c0 - 1); d0 <= (std::min)(15, c0 + 1); ++d0) {
+                const int bin = (d2 << 8) | (d1 << 4) | d0;
+                lanes[0] += sums_[bin * 3 + 0];
+                lanes[1] += sums_[bin * 3 + 1];
+                lanes[2] += sums_[bin * 3 + 2];
+            }
+    std::array<int, 3> color = {static_cast<int>(lanes[0] / bestScore),
+                                static_cast<int>(lanes[1] / bestScore),
+                                static_cast<int>(lanes[2] / bestScore)};
+
+    if (options_.kmeansIterations > 0) {
+        const std::array<double, 3> seed = {double(color[0]), double(color[1]), double(color[2])};
+        color = refine(frame, seed);
+    }
+
+    if (frame.format == PixelFormat::RGBA8)
+        return color;
+    return {color[2], color[1], color[0]};
+}
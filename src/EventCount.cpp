@@ -0,0 +1,110 @@
+#include "EventCount.h"
+#include <thread>
+#ifdef __linux__
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "the epoch is passed to the kernel as a plain 32-bit word");
+
+//----------------------------------------------------------------------
+// prepareWait / cancelWait
+//----------------------------------------------------------------------
+// The waiter count is raised before the epoch is read, and notifyAll
+// bumps the epoch before it reads the count: either the notifier sees
+// the waiter, or the waiter sees the new epoch.
+//----------------------------------------------------------------------
+uint32_t EventCount::prepareWait() {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_seq_cst);
+}
+
+void EventCount::cancelWait() {
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------
+// notifyAll
+//----------------------------------------------------------------------
+void EventCount::notifyAll() {
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_seq_cst) == 0)
+        return;
+#ifdef __linux__
+    ::syscall(SYS_futex, &epoch_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+    WakeByAddressAll(&epoch_);
+#else
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    cv_.notify_all();
+#endif
+}
+
+//----------------------------------------------------------------------
+// wait
+//----------------------------------------------------------------------
+// The kernel only puts the thread to sleep while the epoch still equals
+// the key, so a notify between prepareWait and the syscall is not lost.
+// On Linux steady_clock is CLOCK_MONOTONIC, the clock of an absolute
+// FUTEX_WAIT_BITSET timeout.
+//----------------------------------------------------------------------
+bool EventCount::wait(uint32_t key, Clock::time_point deadline) {
+    const bool forever = deadline == Clock::time_point::max();
+    bool woken = true;
+    while (epoch_.load(std::memory_order_acquire) == key) {
+#ifdef __linux__
+        timespec until{};
+        if (!forever) {
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+            until.tv_sec = static_cast<time_t>(ns.count() / 1000000000);
+            until.tv_nsec = static_cast<long>(ns.count() % 1000000000);
+        }
+        if (::syscall(SYS_futex, &epoch_, FUTEX_WAIT_BITSET_PRIVATE, key, forever ? nullptr : &until,
+                      nullptr, FUTEX_BITSET_MATCH_ANY) != 0 &&
+            errno == ETIMEDOUT) {
+            woken = false;
+            break;
+        }
+#elif defined(_WIN32)
+        DWORD ms = INFINITE;
+        if (!forever) {
+            const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+            if (left.count() <= 0) {
+                woken = false;
+                break;
+            }
+            ms = static_cast<DWORD>(left.count());
+        }
+        if (!WaitOnAddress(&epoch_, &key, sizeof(key), ms) && GetLastError() == ERROR_TIMEOUT) {
+            woken = false;
+            break;
+        }
+#else
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto changed = [&] { return epoch_.load(std::memory_order_acquire) != key; };
+        if (forever) {
+            cv_.wait(lock, changed);
+        } else if (!cv_.wait_until(lock, deadline, changed)) {
+            woken = false;
+            break;
+        }
+#endif
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return woken;
+}
+
+//----------------------------------------------------------------------
+// spinIterations
+//----------------------------------------------------------------------
+int spinIterations() {
+    static const int iterations = std::thread::hardware_concurrency() > 1 ? 256 : 0;
+    return iterations;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+#if !defined(__linux__) && !defined(_WIN32)
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/**
+ * Sleeps a thread until another thread signals progress, without a
+ * mutex on the signalling side.
+ *
+ * A waiter takes a key with `prepareWait`, checks its condition once
+ * more and then either calls `cancelWait` or sleeps in `wait`. A notify
+ * between the two bumps the epoch, so `wait` returns at once instead of
+ * missing it. `notifyAll` costs one atomic increment while nobody
+ * sleeps. Sleeping uses a futex on Linux and WaitOnAddress on Windows.
+ */
+class EventCount {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /** Announce a wait; the returned key goes to `wait`. */
+    uint32_t prepareWait();
+
+    /** Withdraw a `prepareWait` whose condition turned true meanwhile. */
+    void cancelWait();
+
+    /**
+     * Sleep until a notify after `prepareWait` returned `key`.
+     * @param key      Key from `prepareWait`.
+     * @param deadline Give up at this time; `time_point::max()` waits forever.
+     * @return false on timeout.
+     */
+    bool wait(uint32_t key, Clock::time_point deadline = Clock::time_point::max());
+
+    /** Wake every thread sleeping in `wait`. */
+    void notifyAll();
+
+private:
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> waiters_{0};
+#if !defined(__linux__) && !defined(_WIN32)
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+};
+
+/** Hint to the CPU that the thread is spinning. */
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * Polls worth trying before sleeping: a short spin catches a handoff
+ * that is microseconds away, while on a single core the other thread
+ * cannot make progress during the spin, so there is none.
+ */
+int spinIterations();
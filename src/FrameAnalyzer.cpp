@@ -0,0 +1,88 @@
+#include "FrameAnalyzer.h"
+#include "PixelFormats.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------
+// FrameAnalyzer
+//----------------------------------------------------------------------
+// Translate the configuration into processing options.
+//----------------------------------------------------------------------
+FrameAnalyzer::FrameAnalyzer(const Config& cfg, double displayWhite)
+    : pool_(cfg.processingThreads) {
+    sdrWhiteNits_ = cfg.sdrWhiteNits > 0.0 ? cfg.sdrWhiteNits : displayWhite;
+    sampling_.strideX = cfg.sampleStride;
+    sampling_.strideY = cfg.sampleRowStride;
+    sampling_.sampleBudget = cfg.sampleBudget;
+    sampling_.linearLight = cfg.linearLight;
+    sampling_.sdrWhiteNits = sdrWhiteNits_;
+    zones_.setLayout(cfg.zones);
+    useThumbnail_ = cfg.thumbnailWidth > 0 && cfg.thumbnailHeight > 0;
+    const int targetWidth = useThumbnail_ ? cfg.thumbnailWidth : kDefaultThumbnailWidth;
+    int targetHeight = useThumbnail_ ? cfg.thumbnailHeight : kDefaultThumbnailHeight;
+    dominant_ = cfg.processingMode == ProcessingMode::Dominant;
+    dominantExtractor_.setOptions(cfg.dominant);
+    detectLetterbox_ = cfg.detectLetterbox;
+    letterbox_.setOptions(cfg.letterbox, sdrWhiteNits_);
+    devices_ = cfg.devices;
+    ledSamplers_.resize(devices_.size());
+    for (size_t i = 0; i < devices_.size(); ++i) {
+        hasRegions_ = hasRegions_ || devices_[i].hasRegion;
+        hasLayouts_ = hasLayouts_ || !devices_[i].leds.empty();
+        ledSamplers_[i].setLayout(devices_[i].leds);
+        // LED layouts read the pyramid; keep its finest level fine enough
+        // for the smallest footprint
+        targetHeight = (std::max)(targetHeight, ledSamplers_[i].detailHeight());
+    }
+    pyramid_.setTargetSize(targetWidth, targetHeight);
+}
+
+//----------------------------------------------------------------------
+// analyze
+//----------------------------------------------------------------------
+// Compute the frame average and, if configured, the edge zones, the
+// per-device region colors and the LED layout colors. Regions share one
+// summed-area table of the thumbnail (at least 128x72 if none is
+// configured), so each additional device costs four lookups. LED
+// layouts read the pyramid level that suits each footprint; zones read
+// the thumbnail when one is configured. The pass that
+// builds it also sums 8-bit frames exactly, so the frame is read once.
+// In dominant mode the frame color comes from the thumbnail.
+// 10-bit and half float frames are averaged in their own format but
+// converted to 8 bits once for the other analyses. With letterbox
+// detection, every analysis reads only the active picture.
+//----------------------------------------------------------------------
+void FrameAnalyzer::analyze(const FrameView& captured, ColorFrame& out) {
+    FrameView frame = captured;
+    if (detectLetterbox_ && !captured.empty()) {
+        const ContentBounds& b = letterbox_.update(captured);
+        frame = captured.crop(b.x, b.y, b.width, b.height);
+    }
+
+    const bool needsDetail = zones_.layout().count() > 0 || hasRegions_ || hasLayouts_;
+    const FrameView eightBit = (dominant_ || needsDetail) ? convertToRgba8(frame, converted_, sdrWhiteNits_) : frame;
+    const bool pyramid = dominant_ || hasRegions_ || hasLayouts_ || (useThumbnail_ && needsDetail);
+    const FrameView& thumbnail = pyramid ? pyramid_.build(eightBit, &pool_) : eightBit;
+    const FrameView& source = useThumbnail_ ? thumbnail : eightBit;
+
+    if (dominant_)
+        out.average = dominantExtractor_.extract(thumbnail);
+    else if (pyramid && eightBit.data == frame.data && !sampling_.linearLight)
+        out.average = pyramid_.average(); // exact totals of the pass that built the thumbnail
+    else
+        out.average = getRGBAverage(frame, sampling_, &pool_);
+
+    zones_.extract(source, out.zones, source.height != frame.height ? frame.height : 0);
+
+    out.deviceColors.clear();
+    if (hasRegions_) {
+        integral_.build(thumbnail);
+        out.deviceColors.reserve(devices_.size());
+        for (const auto& dev : devices_)
+            out.deviceColors.push_back(dev.hasRegion ? integral_.average(dev.region) : out.average);
+    }
+
+    // LED kernels are cached per pyramid geometry inside each sampler
+    out.devicePixels.resize(hasLayouts_ ? devices_.size() : 0);
+    for (size_t i = 0; i < out.devicePixels.size(); ++i)
+        ledSamplers_[i].sample(pyramid_, out.devicePixels[i]);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ColorFrame.h"
+#include "ConfigManager.h"
+#include "DominantColor.h"
+#include "FramePyramid.h"
+#include "FrameView.h"
+#include "IntegralImage.h"
+#include "LetterboxDetector.h"
+#include "LedSampler.h"
+#include "RGBProcessor.h"
+#include "WorkerPool.h"
+#include "ZoneExtractor.h"
+
+/**
+ * Runs every configured color analysis on a captured frame.
+ *
+ * One analyzer lives on the processing thread. It owns the state that
+ * must survive between frames (worker pool, precomputed zone geometry,
+ * summed-area table storage) so that per-frame work is limited to
+ * reading the pixels.
+ *
+ * The frame pyramid is built in one pass whenever an analysis needs it:
+ * a configured thumbnail, regions, LED layouts or dominant mode (128x72
+ * and up without a configured thumbnail). Zones read the thumbnail when
+ * one is configured, regions always read it and LED layouts read the
+ * level that suits each footprint. The same pass yields the exact
+ * average of 8-bit frames; otherwise the average reads the captured
+ * frame (optionally sampled). In dominant mode the average is replaced
+ * by the dominant color of the thumbnail.
+ *
+ * With letterbox detection enabled, black bars are cropped off before
+ * any analysis runs, so they neither darken the colors nor cost time.
+ */
+class FrameAnalyzer {
+public:
+    /**
+     * Configure the analyses from the application configuration.
+     * @param cfg          Application configuration.
+     * @param displayWhite SDR white level of the captured display in
+     *                     nits, used unless `cfg.sdrWhiteNits` is set.
+     */
+    explicit FrameAnalyzer(const Config& cfg, double displayWhite = kScRgbWhiteNits);
+
+    /**
+     * Analyze a frame.
+     * @param captured Captured frame.
+     * @param out   Receives the average, all configured zone colors and,
+     *              if any device has a region or LED layout, the
+     *              per-device colors.
+     */
+    void analyze(const FrameView& captured, ColorFrame& out);
+
+    /** Number of threads used by the frame reductions. */
+    int threadCount() const { return pool_.threadCount(); }
+
+private:
+    /** Pyramid target for dominant mode and regions without `thumbnail`. */
+    static constexpr int kDefaultThumbnailWidth = 128;
+    static constexpr int kDefaultThumbnailHeight = 72;
+
+    WorkerPool pool_;
+    SamplingOptions sampling_;
+    bool detectLetterbox_ = false;  ///< Crop to the active picture first
+    LetterboxDetector letterbox_;
+    bool useThumbnail_ = false;     ///< Run zone/region/layout analyses on the pyramid
+    FramePyramid pyramid_;
+    std::vector<uint8_t> converted_; ///< 8-bit copy of 10-bit/half float frames
+    double sdrWhiteNits_ = kScRgbWhiteNits; ///< Brightness half floats are scaled to 1.0 from
+    bool dominant_ = false;         ///< Frame color is the dominant color
+    DominantColorExtractor dominantExtractor_;
+    ZoneExtractor zones_;
+    std::vector<Device> devices_;
+    bool hasRegions_ = false;       ///< Any device mirrors a sub-rectangle
+    IntegralImage integral_;        ///< Built from the thumbnail per frame when hasRegions_
+    std::vector<LedSampler> ledSamplers_; ///< One per device, empty layout = unused
+    bool hasLayouts_ = false;       ///< Any device has an LED layout
+};
@@ -0,0 +1,231 @@
+#include "FramePool.h"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <malloc.h>
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr size_t kCacheLine = 64;
+constexpr size_t kPageSize = 4096;
+constexpr size_t kHugePageSize = size_t(2) << 20;
+constexpr int kMaxBuffers = 64; // one bit each in the free mask
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+//----------------------------------------------------------------------
+// allocatePages / freePages
+//----------------------------------------------------------------------
+// Huge pages need a privilege (SeLockMemoryPrivilege) on Windows and
+// transparent huge pages enabled on Linux; without them the buffer
+// falls back to normal pages. `huge` reports what was used.
+//----------------------------------------------------------------------
+uint8_t* allocatePages(size_t& size, bool wantHuge, bool& huge) {
+    huge = false;
+#ifdef _WIN32
+    if (wantHuge) {
+        const size_t large = GetLargePageMinimum();
+        if (large > 0) {
+            const size_t rounded = roundUp(size, large);
+            void* p = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (p) {
+                size = rounded;
+                huge = true;
+                return static_cast<uint8_t*>(p);
+            }
+        }
+    }
+    size = roundUp(size, kPageSize);
+    return static_cast<uint8_t*>(_aligned_malloc(size, kPageSize));
+#else
+    const size_t alignment = wantHuge ? kHugePageSize : kPageSize;
+    const size_t rounded = roundUp(size, alignment);
+    void* p = nullptr;
+    if (posix_memalign(&p, alignment, rounded) != 0)
+        return nullptr;
+    size = rounded;
+#ifdef __linux__
+    if (wantHuge)
+        huge = madvise(p, rounded, MADV_HUGEPAGE) == 0;
+#endif
+    return static_cast<uint8_t*>(p);
+#endif
+}
+
+void freePages(uint8_t* data, bool huge) {
+    if (!data)
+        return;
+#ifdef _WIN32
+    if (huge)
+        VirtualFree(data, 0, MEM_RELEASE);
+    else
+        _aligned_free(data);
+#else
+    (void)huge;
+    free(data);
+#endif
+}
+
+} // namespace
+
+//----------------------------------------------------------------------
+// FrameLease
+//----------------------------------------------------------------------
+FrameLease& FrameLease::operator=(FrameLease&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        index_ = other.index_;
+        data_ = other.data_;
+        view_ = other.view_;
+        other.pool_ = nullptr;
+        other.index_ = -1;
+        other.data_ = nullptr;
+        other.view_ = FrameView{};
+    }
+    return *this;
+}
+
+void FrameLease::reset() {
+    if (pool_)
+        pool_->release(index_);
+    pool_ = nullptr;
+    index_ = -1;
+    data_ = nullptr;
+    view_ = FrameView{};
+}
+
+//----------------------------------------------------------------------
+// FramePool
+//----------------------------------------------------------------------
+// Buffers are allocated on first use, once the geometry is known.
+//----------------------------------------------------------------------
+FramePool::FramePool(const FramePoolOptions& options)
+    : count_((std::clamp)(options.buffers, 1, kMaxBuffers)),
+      hugePages_(options.hugePages),
+      buffers_(new Buffer[count_]),
+      free_(count_ == kMaxBuffers ? ~uint64_t(0) : (uint64_t(1) << count_) - 1) {}
+
+FramePool::~FramePool() {
+    for (int i = 0; i < count_; ++i)
+        freePages(buffers_[i].data, buffers_[i].huge);
+}
+
+//----------------------------------------------------------------------
+// resize
+//----------------------------------------------------------------------
+void FramePool::resize(int width, int height, PixelFormat format) {
+    width_ = (std::max)(width, 0);
+    height_ = (std::max)(height, 0);
+    format_ = format;
+    rowPitch_ = roundUp(static_cast<size_t>(width_) * bytesPerPixel(format), kCacheLine);
+}
+
+//----------------------------------------------------------------------
+// acquire
+//----------------------------------------------------------------------
+// Only this thread clears bits, so the lowest set bit stays set until
+// the exchange below; releases on other threads only add bits.
+//----------------------------------------------------------------------
+FrameLease FramePool::acquire() {
+    FrameLease lease;
+    if (width_ <= 0 || height_ <= 0)
+        return lease;
+    uint64_t mask = free_.load(std::memory_order_acquire);
+    if (mask == 0) {
+        exhausted_.fetch_add(1, std::memory_order_relaxed);
+        return lease;
+    }
+    const int index = std::countr_zero(mask);
+    const uint64_t bit = uint64_t(1) << index;
+    free_.fetch_and(~bit, std::memory_order_acquire);
+
+    Buffer& buffer = buffers_[index];
+    if (!ensureSize(buffer, rowPitch_ * static_cast<size_t>(height_))) {
+        free_.fetch_or(bit, std::memory_order_release);
+        return lease;
+    }
+    lease.pool_ = this;
+    lease.index_ = index;
+    lease.data_ = buffer.data;
+    lease.view_.data = buffer.data;
+    lease.view_.width = width_;
+    lease.view_.height = height_;
+    lease.view_.rowPitch = rowPitch_;
+    lease.view_.format = format_;
+    return lease;
+}
+
+//----------------------------------------------------------------------
+// copy
+//----------------------------------------------------------------------
+FrameLease FramePool::copy(const FrameView& frame) {
+    if (frame.empty())
+        return FrameLease{};
+    if (frame.width != width_ || frame.height != height_ || frame.format != format_)
+        resize(frame.width, frame.height, frame.format);
+    FrameLease lease = acquire();
+    if (!lease)
+        return lease;
+    const size_t rowBytes = static_cast<size_t>(frame.width) * bytesPerPixel(frame.format);
+    if (frame.rowPitch == rowPitch_) {
+        std::memcpy(lease.data(), frame.data, rowPitch_ * static_cast<size_t>(frame.height - 1) + rowBytes);
+    } else {
+        for (int y = 0; y < frame.height; ++y)
+            std::memcpy(lease.data() + static_cast<size_t>(y) * rowPitch_, frame.row(y), rowBytes);
+    }
+    return lease;
+}
+
+//----------------------------------------------------------------------
+// available / hugePageBuffers
+//----------------------------------------------------------------------
+int FramePool::available() const {
+    return std::popcount(free_.load(std::memory_order_relaxed));
+}
+
+int FramePool::hugePageBuffers() const {
+    int huge = 0;
+    for (int i = 0; i < count_; ++i)
+        huge += buffers_[i].huge ? 1 : 0;
+    return huge;
+}
+
+//----------------------------------------------------------------------
+// ensureSize
+//----------------------------------------------------------------------
+// The new buffer is touched once here, so the page faults are taken at
+// the resize and not while a frame is being copied in.
+//----------------------------------------------------------------------
+bool FramePool::ensureSize(Buffer& buffer, size_t bytes) {
+    if (buffer.data && buffer.size >= bytes)
+        return true;
+    freePages(buffer.data, buffer.huge);
+    buffer = Buffer{};
+    size_t size = bytes;
+    bool huge = false;
+    uint8_t* data = allocatePages(size, hugePages_, huge);
+    if (!data)
+        return false;
+    std::memset(data, 0, size);
+    buffer.data = data;
+    buffer.size = size;
+    buffer.huge = huge;
+    ++allocations_;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// release
+//----------------------------------------------------------------------
+void FramePool::release(int index) {
+    free_.fetch_or(uint64_t(1) << index, std::memory_order_release);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include "FrameView.h"
+
+/**
+ * Size and backing memory of a FramePool.
+ */
+struct FramePoolOptions {
+    int buffers = 3;        ///< Frames in flight at most (2-64): one filling, one waiting, one processing
+    bool hugePages = false; ///< Back buffers with 2 MiB pages where the system allows it
+};
+
+class FramePool;
+
+/**
+ * Exclusive use of one FramePool buffer; returns it to the pool when
+ * destroyed or reset. Move-only. An empty lease (the pool was
+ * exhausted) converts to false.
+ */
+class FrameLease {
+public:
+    FrameLease() = default;
+    ~FrameLease() { reset(); }
+
+    FrameLease(FrameLease&& other) noexcept { *this = std::move(other); }
+    FrameLease& operator=(FrameLease&& other) noexcept;
+
+    FrameLease(const FrameLease&) = delete;
+    FrameLease& operator=(const FrameLease&) = delete;
+
+    /** True if the lease holds a buffer. */
+    explicit operator bool() const { return pool_ != nullptr; }
+
+    /** Writable first byte of the first row. */
+    uint8_t* data() const { return data_; }
+
+    /** The frame the buffer holds, for the analyzers. */
+    const FrameView& view() const { return view_; }
+
+    /** Give the buffer back to the pool early. */
+    void reset();
+
+private:
+    friend class FramePool;
+
+    FramePool* pool_ = nullptr;
+    int index_ = -1;
+    uint8_t* data_ = nullptr;
+    FrameView view_;
+};
+
+/**
+ * Fixed set of CPU frame buffers handed from capture to processing.
+ *
+ * Each capture is copied into a buffer of its own, so processing never
+ * reads memory the next capture is writing, and the number of frames in
+ * flight is bounded by the pool: when every buffer is leased `acquire`
+ * fails and the capture is skipped instead of allocating another.
+ *
+ * Buffers are page aligned and every row starts on a cache line. A
+ * resolution change only updates the geometry; a buffer is reallocated
+ * the next time it is acquired and found too small, so growing costs
+ * one allocation per buffer and shrinking none, and buffers still
+ * leased at the old size are never touched.
+ *
+ * `resize`, `acquire` and `copy` belong to one thread (capture); leases
+ * may be released on any thread. The pool must outlive its leases.
+ */
+class FramePool {
+public:
+    explicit FramePool(const FramePoolOptions& options = FramePoolOptions{});
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /** Set the geometry of buffers acquired from now on. */
+    void resize(int width, int height, PixelFormat format);
+
+    /**
+     * Lease a free buffer with the current geometry.
+     * @return an empty lease if every buffer is in use or allocation failed.
+     */
+    FrameLease acquire();
+
+    /** Resize to `frame`, lease a buffer and copy the frame into it. */
+    FrameLease copy(const FrameView& frame);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    size_t rowPitch() const { return rowPitch_; }
+    PixelFormat format() const { return format_; }
+
+    /** Buffers in the pool. */
+    int capacity() const { return count_; }
+
+    /** Buffers not leased right now. */
+    int available() const;
+
+    /** `acquire` calls that found every buffer in use. */
+    uint64_t exhausted() const { return exhausted_.load(std::memory_order_relaxed); }
+
+    /** Buffer allocations so far, including the first ones. */
+    uint64_t allocations() const { return allocations_; }
+
+    /** Buffers currently backed by huge pages. */
+    int hugePageBuffers() const;
+
+private:
+    friend class FrameLease;
+
+    struct Buffer {
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        bool huge = false; ///< Allocated with huge pages, freed accordingly
+    };
+
+    bool ensureSize(Buffer& buffer, size_t bytes);
+    void release(int index);
+
+    const int count_;
+    const bool hugePages_;
+    std::unique_ptr<Buffer[]> buffers_;
+    std::atomic<uint64_t> free_;         ///< Bit i set: buffer i is in the pool
+    std::atomic<uint64_t> exhausted_{0};
+    uint64_t allocations_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    size_t rowPitch_ = 0;
+    PixelFormat format_ = PixelFormat::BGRA8;
+};
@@ -0,0 +1,161 @@
+#include "FramePyramid.h"
+#include "PixelKernels.h"
+#include "RGBProcessor.h"
+#include "WorkerPool.h"
+#include <algorithm>
+
+namespace {
+constexpr int kMaxBlockShift = 8; // log2(FramePyramid::kMaxBlock)
+static_assert((1 << kMaxBlockShift) == FramePyramid::kMaxBlock, "block size");
+constexpr int kColumnRows = 8;    // rows per column sum call: few enough streams to prefetch
+} // namespace
+
+//----------------------------------------------------------------------
+// setTargetSize
+//----------------------------------------------------------------------
+void FramePyramid::setTargetSize(int width, int height) {
+    targetWidth_ = (std::max)(1, width);
+    targetHeight_ = (std::max)(1, height);
+}
+
+//----------------------------------------------------------------------
+// build
+//----------------------------------------------------------------------
+// Sum the blocks of the finest level in one pass, in row bands on the
+// pool for large frames, then halve down to 1x1. Level buffers only
+// grow, so steady-state frames do not allocate.
+//----------------------------------------------------------------------
+const FrameView& FramePyramid::build(const FrameView& frame, WorkerPool* pool) {
+    levelCount_ = 0;
+    thumbnailLevel_ = 0;
+    lanes_[0] = lanes_[1] = lanes_[2] = 0;
+    pixels_ = 0;
+    format_ = frame.format;
+    levels_[0].view = frame;
+    levels_[0].scale = 1;
+    if (frame.empty())
+        return thumbnail();
+    pixels_ = static_cast<uint64_t>(frame.width) * static_cast<uint64_t>(frame.height);
+
+    int halvings = 0;
+    while ((frame.width >> (halvings + 1)) >= targetWidth_ && (frame.height >> (halvings + 1)) >= targetHeight_)
+        ++halvings;
+    const int shift = (std::min)(halvings, kMaxBlockShift);
+    const int block = 1 << shift;
+    const int height = frame.height >> shift;
+
+    if (shift == 0) {
+        // Small enough already: the frame is the finest level
+        const RowSumKernel kernel = activeRowSumKernel();
+        for (int y = 0; y < frame.height; ++y)
+            kernel(frame.row(y), frame.width, lanes_);
+    } else {
+        addLevel(0, frame.width >> shift, height, block, frame.format);
+
+        const bool parallel = pool && pool->threadCount() > 1 &&
+                              static_cast<long long>(pixels_) >= kParallelMinPixels;
+        const int bandCount = parallel ? (std::min)(height, pool->threadCount() * 4) : 1;
+        const int bandRows = (height + bandCount - 1) / bandCount;
+        if (static_cast<int>(bands_.size()) < bandCount)
+            bands_.resize(bandCount);
+        auto runBand = [&](int band) {
+            const int y0 = band * bandRows;
+            sumBand(frame, shift, y0, (std::min)(height, y0 + bandRows), bands_[band]);
+        };
+        if (parallel)
+            pool->run(bandCount, runBand);
+        else
+            runBand(0);
+
+        // Merge in band order, then add the rows below the last block
+        for (int band = 0; band < bandCount; ++band) {
+            for (int c = 0; c < 3; ++c)
+                lanes_[c] += bands_[band].lanes[c];
+        }
+        const RowSumKernel kernel = activeRowSumKernel();
+        for (int y = height * block; y < frame.height; ++y)
+            kernel(frame.row(y), frame.width, lanes_);
+    }
+
+    const DownsampleKernel halve = activeDownsampleKernel();
+    levelCount_ = 1;
+    while (levels_[levelCount_ - 1].view.width >= 2 && levels_[levelCount_ - 1].view.height >= 2) {
+        const Level& prev = levels_[levelCount_ - 1];
+        const int w = prev.view.width / 2;
+        const int h = prev.view.height / 2;
+        addLevel(levelCount_, w, h, prev.scale * 2, frame.format);
+        const Level& src = levels_[levelCount_ - 1];
+        Level& dst = levels_[levelCount_];
+        for (int y = 0; y < h; ++y)
+            halve(src.view.row(2 * y), src.view.row(2 * y + 1), w, dst.pixels.data() + y * dst.view.rowPitch);
+        ++levelCount_;
+    }
+    thumbnailLevel_ = halvings - shift;
+    return thumbnail();
+}
+
+//----------------------------------------------------------------------
+// sumBand
+//----------------------------------------------------------------------
+// Block rows [y0, y1) of the finest level. Rows of a block are added
+// up to eight at a time into column totals, which the block kernel turns into level
+// pixels and frame totals. The columns right of the last block are
+// added to the totals here.
+//----------------------------------------------------------------------
+void FramePyramid::sumBand(const FrameView& frame, int shift, int y0, int y1, Band& band) {
+    const ColumnSumKernel columnSum = activeColumnSumKernel();
+    const BlockMeanKernel blockMean = activeBlockMeanKernel();
+    const int block = 1 << shift;
+    const int width = frame.width >> shift;
+    const int bytes = frame.width * 4;
+    if (band.columns.size() < static_cast<size_t>(bytes))
+        band.columns.resize(bytes);
+
+    Level& level = levels_[0];
+    uint64_t lanes[4] = {0, 0, 0, 0};
+    for (int y = y0; y < y1; ++y) {
+        for (int r = 0; r < block; r += kColumnRows) {
+            columnSum(frame.row(y * block + r), frame.rowPitch, (std::min)(block - r, kColumnRows), bytes,
+                      band.columns.data(), r > 0);
+        }
+        blockMean(band.columns.data(), width, shift, level.pixels.data() + y * level.view.rowPitch, lanes);
+        for (int i = width * block * 4; i < bytes; i += 4) {
+            lanes[0] += band.columns[i];
+            lanes[1] += band.columns[i + 1];
+            lanes[2] += band.columns[i + 2];
+        }
+    }
+    for (int c = 0; c < 3; ++c)
+        band.lanes[c] = lanes[c];
+}
+
+//----------------------------------------------------------------------
+// addLevel
+//----------------------------------------------------------------------
+void FramePyramid::addLevel(int index, int width, int height, int scale, PixelFormat format) {
+    if (static_cast<int>(levels_.size()) <= index)
+        levels_.resize(index + 1);
+    Level& level = levels_[index];
+    const size_t pitch = static_cast<size_t>(width) * 4;
+    if (level.pixels.size() < pitch * height)
+        level.pixels.resize(pitch * height);
+    level.view.data = level.pixels.data();
+    level.view.width = width;
+    level.view.height = height;
+    level.view.rowPitch = pitch;
+    level.view.format = format;
+    level.scale = scale;
+}
+
+//----------------------------------------------------------------------
+// average
+//----------------------------------------------------------------------
+// Integer division of the exact totals, like the full-frame reduction.
+//----------------------------------------------------------------------
+std::array<int, 3> FramePyramid::average() const {
+    if (pixels_ == 0)
+        return {0, 0, 0};
+    const int rLane = format_ == PixelFormat::RGBA8 ? 0 : 2;
+    return {static_cast<int>(lanes_[rLane] / pixels_), static_cast<int>(lanes_[1] / pixels_),
+            static_cast<int>(lanes_[2 - rLane] / pixels_)};
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "FrameView.h"
+
+class WorkerPool;
+
+/**
+ * Reduces a frame to a small thumbnail and a chain of coarser levels.
+ *
+ * The frame is read exactly once: every 2^k x 2^k block is summed in a
+ * single pass (rows into 16-bit column totals, then columns into block
+ * means and totals) and becomes one pixel of the finest level. The
+ * same pass yields the exact totals of the whole frame, so `average`
+ * costs nothing more. Coarser levels are halved from the previous one
+ * with the 2x2 box filter and only touch images that fit in the L1/L2
+ * cache. Analyses that run on the pyramid (zones, regions, LED layouts,
+ * dominant color, ...) therefore share one pass over the staging buffer.
+ *
+ * The thumbnail is the level reached by halving until either dimension
+ * would drop below the target, so it is between 1x and 2x the target
+ * size in each direction and keeps the aspect ratio of the frame. A
+ * remainder of less than one block at the right or bottom edge is left
+ * out of the levels but counted in the average. Blocks are at most
+ * `kMaxBlock` pixels wide; a thumbnail further down is halved from there.
+ */
+class FramePyramid {
+public:
+    /** Largest block summed in the single pass (16-bit column totals). */
+    static constexpr int kMaxBlock = 256;
+
+    /** Set the smallest acceptable thumbnail size, e.g. 64x36. */
+    void setTargetSize(int width, int height);
+
+    /**
+     * Build the pyramid for a frame with 4-byte pixels.
+     * @param frame Frame to reduce.
+     * @param pool  Optional worker pool; bands of blocks are summed in
+     *              parallel for large frames.
+     * @return View of the thumbnail, valid until the next call. Returns
+     *         the input itself if it is already small enough.
+     */
+    const FrameView& build(const FrameView& frame, WorkerPool* pool = nullptr);
+
+    /** Thumbnail produced by the last build. */
+    const FrameView& thumbnail() const { return levels_[thumbnailLevel_].view; }
+
+    /** Levels from the finest (0, read from the frame) to 1x1. */
+    int levelCount() const { return levelCount_; }
+
+    /** View of level `index`; the thumbnail is one of them. */
+    const FrameView& level(int index) const { return levels_[index].view; }
+
+    /** Frame pixels per pixel of level `index` along each axis. */
+    int levelScale(int index) const { return levels_[index].scale; }
+
+    /**
+     * Exact average {R, G, B} of the whole frame of the last build,
+     * equal to `getRGBAverage` on it.
+     */
+    std::array<int, 3> average() const;
+
+private:
+    struct Level {
+        std::vector<uint8_t> pixels; ///< Tightly packed storage, reused
+        FrameView view;
+        int scale = 1;
+    };
+
+    /** Scratch of one band of block rows, so bands can run in parallel. */
+    struct Band {
+        std::vector<uint16_t> columns; ///< Column totals of the current block row
+        uint64_t lanes[3] = {0, 0, 0}; ///< Byte lane totals of the band
+    };
+
+    void sumBand(const FrameView& frame, int shift, int y0, int y1, Band& band);
+    void addLevel(int index, int width, int height, int scale, PixelFormat format);
+
+    int targetWidth_ = 64;
+    int targetHeight_ = 36;
+    std::vector<Level> levels_ = std::vector<Level>(1);
+    int levelCount_ = 0;
+    int thumbnailLevel_ = 0;
+    std::vector<Band> bands_;
+    uint64_t lanes_[3] = {0, 0, 0}; ///< Frame totals per byte lane
+    uint64_t pixels_ = 0;
+    PixelFormat format_ = PixelFormat::BGRA8;
+};
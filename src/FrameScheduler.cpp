@@ -0,0 +1,120 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+double toUs(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+} // namespace
+
+//----------------------------------------------------------------------
+// reset
+//----------------------------------------------------------------------
+void FrameScheduler::reset(Clock::duration period, Clock::duration spin, Clock::time_point now) {
+    period_ = (std::max)(period, Clock::duration::zero());
+    spin_ = (std::max)(spin, Clock::duration::zero());
+    deadline_ = now;
+    lastTick_ = Clock::time_point{};
+    resetStats();
+}
+
+//----------------------------------------------------------------------
+// waitForDeadline
+//----------------------------------------------------------------------
+// sleep_until wakes up late by the timer slack, so it aims `spin_`
+// early and the rest is spent yielding. Yielding rather than pausing
+// lets other threads run on a single core.
+//----------------------------------------------------------------------
+FrameScheduler::Clock::time_point FrameScheduler::waitForDeadline() {
+    Clock::time_point now = Clock::now();
+    if (now < deadline_ - spin_) {
+        std::this_thread::sleep_until(deadline_ - spin_);
+        now = Clock::now();
+    }
+    while (now < deadline_) {
+        std::this_thread::yield();
+        now = Clock::now();
+    }
+    tick(now);
+    return now;
+}
+
+//----------------------------------------------------------------------
+// tick
+//----------------------------------------------------------------------
+void FrameScheduler::tick(Clock::time_point now) {
+    if (lastTick_ != Clock::time_point{}) {
+        const double us = toUs(now - lastTick_);
+        // A realigned cycle spans several periods; it is measured against
+        // those. Unpaced, the spread around the mean is what counts.
+        const double periodUs = toUs(period_);
+        const double deviation =
+            periodUs > 0.0 ? us - (std::max)(std::round(us / periodUs), 1.0) * periodUs : 0.0;
+        sumUs_ += us;
+        sumSquaresUs_ += us * us;
+        sumSquaredDeviationUs_ += deviation * deviation;
+        maxDeviationUs_ = (std::max)(maxDeviationUs_, std::abs(deviation));
+        ++periods_;
+    }
+    latenessUs_ += toUs((std::max)(now - deadline_, Clock::duration::zero()));
+    lastTick_ = now;
+    ++ticks_;
+}
+
+//----------------------------------------------------------------------
+// advance
+//----------------------------------------------------------------------
+// The next deadline stays on the grid. If the work ran past it, the
+// missed ones are skipped instead of being served back to back.
+//----------------------------------------------------------------------
+void FrameScheduler::advance(Clock::time_point now) {
+    if (period_ == Clock::duration::zero()) {
+        deadline_ = now;
+        return;
+    }
+    deadline_ += period_;
+    if (deadline_ <= now) {
+        const auto missed = (now - deadline_) / period_ + 1;
+        deadline_ += period_ * missed;
+        ++overruns_;
+        skipped_ += static_cast<uint64_t>(missed);
+    }
+}
+
+//----------------------------------------------------------------------
+// stats / resetStats
+//----------------------------------------------------------------------
+ScheduleStats FrameScheduler::stats() const {
+    ScheduleStats s;
+    s.ticks = ticks_;
+    s.overruns = overruns_;
+    s.skipped = skipped_;
+    s.maxDeviationUs = maxDeviationUs_;
+    if (ticks_ > 0)
+        s.meanLatenessUs = latenessUs_ / static_cast<double>(ticks_);
+    if (periods_ > 0) {
+        const double n = static_cast<double>(periods_);
+        s.meanPeriodUs = sumUs_ / n;
+        s.jitterUs = period_ > Clock::duration::zero()
+                         ? std::sqrt(sumSquaredDeviationUs_ / n)
+                         : std::sqrt((std::max)(sumSquaresUs_ / n - s.meanPeriodUs * s.meanPeriodUs, 0.0));
+    }
+    return s;
+}
+
+// The last tick is kept, so the next period is measured across the reset
+void FrameScheduler::resetStats() {
+    ticks_ = 0;
+    periods_ = 0;
+    sumUs_ = 0.0;
+    sumSquaresUs_ = 0.0;
+    sumSquaredDeviationUs_ = 0.0;
+    maxDeviationUs_ = 0.0;
+    latenessUs_ = 0.0;
+    overruns_ = 0;
+    skipped_ = 0;
+}
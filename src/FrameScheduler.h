@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * How the capture thread spends the time until its next capture.
+ */
+enum class ScheduleMode {
+    Deadline, ///< Sleep until the deadline, then capture whatever is on screen
+    Frame     ///< Wait for the next desktop frame, up to the deadline
+};
+
+/**
+ * Pacing of the capture thread.
+ */
+struct ScheduleOptions {
+    ScheduleMode mode = ScheduleMode::Deadline; ///< What the thread waits for
+    int spinUs = 500;       ///< End of each wait spent spinning instead of sleeping (0-10000)
+    double frameRate = 0.0; ///< Captures per second; 0 uses captureIntervalMs
+};
+
+/**
+ * Period statistics of a FrameScheduler since the last `resetStats`.
+ */
+struct ScheduleStats {
+    uint64_t ticks = 0;          ///< Deadlines reached
+    double meanPeriodUs = 0.0;   ///< Mean time between ticks
+    double jitterUs = 0.0;       ///< RMS distance of the time between ticks from the target period
+    double maxDeviationUs = 0.0; ///< Largest distance of one period from the target
+    double meanLatenessUs = 0.0; ///< Mean time a tick came after its deadline
+    uint64_t overruns = 0;       ///< Cycles that ran past the next deadline
+    uint64_t skipped = 0;        ///< Deadlines dropped to realign after overruns
+};
+
+/**
+ * Paces a loop on absolute deadlines.
+ *
+ * Deadlines lie on a fixed grid of `period`, so the time the work takes
+ * and the oversleep of one wait do not add up over the following
+ * frames, as they did with a sleep after every capture. Each wait
+ * sleeps until shortly before the deadline and spins the rest, which
+ * hides the timer slack of the OS (about 1 ms on Windows, 50 us on
+ * Linux). A cycle that runs past the next deadline does not try to
+ * catch up with back-to-back frames: the missed deadlines are skipped
+ * and the loop continues on the grid.
+ */
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Start a new grid; the first deadline is `now`.
+     * @param period Time between deadlines; zero runs unpaced.
+     * @param spin   End of each wait spent spinning.
+     */
+    void reset(Clock::duration period, Clock::duration spin, Clock::time_point now);
+
+    Clock::duration period() const { return period_; }
+
+    /** The deadline the loop is waiting for. */
+    Clock::time_point deadline() const { return deadline_; }
+
+    /** Sleep and spin until the deadline; returns the time it was reached. */
+    Clock::time_point waitForDeadline();
+
+    /**
+     * Record that the deadline was reached at `now` without waiting for
+     * it, e.g. because a new frame arrived right at it.
+     */
+    void tick(Clock::time_point now);
+
+    /**
+     * Move to the next deadline once the cycle's work is done, skipping
+     * those already past `now`.
+     */
+    void advance(Clock::time_point now);
+
+    /** Statistics since the last `resetStats`. */
+    ScheduleStats stats() const;
+
+    void resetStats();
+
+private:
+    Clock::duration period_{};
+    Clock::duration spin_{};
+    Clock::time_point deadline_{};
+    Clock::time_point lastTick_{};
+    uint64_t ticks_ = 0;
+    uint64_t periods_ = 0;     ///< Tick intervals summed below
+    double sumUs_ = 0.0;
+    double sumSquaresUs_ = 0.0;
+    double sumSquaredDeviationUs_ = 0.0;
+    double maxDeviationUs_ = 0.0;
+    double latenessUs_ = 0.0;
+    uint64_t overruns_ = 0;
+    uint64_t skipped_ = 0;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Memory layout of a pixel in a CPU-readable frame.
+ */
+enum class PixelFormat {
+    BGRA8,   ///< 8 bits per channel, blue first (`DXGI_FORMAT_B8G8R8A8_UNORM`)
+    RGBA8,   ///< 8 bits per channel, red first (`DXGI_FORMAT_R8G8B8A8_UNORM`)
+    RGB10A2, ///< 10 bits per color channel, red in the low bits (`DXGI_FORMAT_R10G10B10A2_UNORM`)
+    RGBA16F, ///< Linear half floats, scRGB (`DXGI_FORMAT_R16G16B16A16_FLOAT`)
+};
+
+/**
+ * Number of bytes used by one pixel of the given format.
+ */
+inline constexpr int bytesPerPixel(PixelFormat format) {
+    return format == PixelFormat::RGBA16F ? 8 : 4;
+}
+
+/**
+ * True for the 8-bit formats that the byte-oriented kernels (zones,
+ * regions, LED layouts, pyramid) read directly. Other formats are
+ * converted with `convertToRgba8()` first.
+ */
+inline constexpr bool isEightBit(PixelFormat format) {
+    return format == PixelFormat::BGRA8 || format == PixelFormat::RGBA8;
+}
+
+/**
+ * Non-owning view of a CPU-readable frame.
+ *
+ * This is the platform-neutral input of the RGB processing functions. It
+ * can point into a mapped Direct3D texture, a buffer captured by another
+ * backend or a synthetic frame created for benchmarking.
+ */
+struct FrameView {
+    const uint8_t* data = nullptr;           ///< First byte of the first row
+    int width = 0;                           ///< Width in pixels
+    int height = 0;                          ///< Height in pixels
+    size_t rowPitch = 0;                     ///< Distance between rows in bytes
+    PixelFormat format = PixelFormat::BGRA8; ///< Pixel layout
+
+    /** Pointer to the first byte of row `y`. */
+    const uint8_t* row(int y) const {
+        return data + static_cast<size_t>(y) * rowPitch;
+    }
+
+    /**
+     * Sub-rectangle of this view. The rectangle must lie inside the
+     * frame; no pixels are copied.
+     */
+    FrameView crop(int x, int y, int w, int h) const {
+        FrameView v = *this;
+        v.data = row(y) + static_cast<size_t>(x) * bytesPerPixel(format);
+        v.width = w;
+        v.height = h;
+        return v;
+    }
+
+    /** True if the view references at least one pixel. */
+    bool empty() const {
+        return !data || width <= 0 || height <= 0;
+    }
+};
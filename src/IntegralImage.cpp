@@ -0,0 +1,230 @@
+#include "IntegralImage.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RGBS_SAT_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RGBS_SAT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+#if defined(RGBS_SAT_SSE2)
+__m128i load4(const uint32_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+#endif
+
+//----------------------------------------------------------------------
+// prefixRow (32-bit)
+//----------------------------------------------------------------------
+// out[x] = above[x] + sum of pixels 0 to x of the row, in the first
+// three byte lanes. SSE2 and NEON widen four pixels at a time and add
+// the group total to the running sum separately, so the carried
+// dependency is one add per four pixels. Entries are three lanes apart,
+// so each 4-lane store also writes the first lane of the next entry;
+// the next store (or the next row) overwrites it again.
+//----------------------------------------------------------------------
+void prefixRow(const uint8_t* px, int width, const uint32_t* above, uint32_t* out) {
+    int x = 0;
+#if defined(RGBS_SAT_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i run = zero;
+    for (; x + 4 <= width; x += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + x * 4));
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        const __m128i p0 = _mm_unpacklo_epi16(lo, zero);
+        const __m128i p01 = _mm_add_epi32(p0, _mm_unpackhi_epi16(lo, zero));
+        const __m128i p2 = _mm_unpacklo_epi16(hi, zero);
+        const __m128i p23 = _mm_add_epi32(p2, _mm_unpackhi_epi16(hi, zero));
+        const __m128i s0 = _mm_add_epi32(run, p0);
+        const __m128i s1 = _mm_add_epi32(run, p01);
+        const __m128i s2 = _mm_add_epi32(s1, p2);
+        run = _mm_add_epi32(run, _mm_add_epi32(p01, p23));
+        const uint32_t* a = above + x * 3;
+        uint32_t* o = out + x * 3;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_add_epi32(load4(a), s0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 3), _mm_add_epi32(load4(a + 3), s1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 6), _mm_add_epi32(load4(a + 6), s2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 9), _mm_add_epi32(load4(a + 9), run));
+    }
+    alignas(16) uint32_t r[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(r), run);
+#elif defined(RGBS_SAT_NEON)
+    uint32x4_t run = vdupq_n_u32(0);
+    for (; x + 4 <= width; x += 4) {
+        const uint8x16_t v = vld1q_u8(px + x * 4);
+        const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        const uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+        const uint16x4_t p01 = vadd_u16(vget_low_u16(lo), vget_high_u16(lo));
+        const uint16x4_t p23 = vadd_u16(vget_low_u16(hi), vget_high_u16(hi));
+        const uint32x4_t s0 = vaddw_u16(run, vget_low_u16(lo));
+        const uint32x4_t s1 = vaddw_u16(run, p01);
+        const uint32x4_t s2 = vaddw_u16(s1, vget_low_u16(hi));
+        run = vaddw_u16(run, vadd_u16(p01, p23));
+        const uint32_t* a = above + x * 3;
+        uint32_t* o = out + x * 3;
+        vst1q_u32(o, vaddq_u32(vld1q_u32(a), s0));
+        vst1q_u32(o + 3, vaddq_u32(vld1q_u32(a + 3), s1));
+        vst1q_u32(o + 6, vaddq_u32(vld1q_u32(a + 6), s2));
+        vst1q_u32(o + 9, vaddq_u32(vld1q_u32(a + 9), run));
+    }
+    uint32_t r[4];
+    vst1q_u32(r, run);
+#else
+    uint32_t r[4] = {0, 0, 0, 0};
+#endif
+    for (; x < width; ++x) {
+        for (int c = 0; c < 3; ++c) {
+            r[c] += px[x * 4 + c];
+            out[x * 3 + c] = above[x * 3 + c] + r[c];
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// prefixRow (64-bit)
+//----------------------------------------------------------------------
+// Same for tables of very large frames, one pixel per step in two
+// 64-bit halves; the second store spills into the next entry.
+//----------------------------------------------------------------------
+void prefixRow(const uint8_t* px, int width, const uint64_t* above, uint64_t* out) {
+    int x = 0;
+#if defined(RGBS_SAT_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i runLo = zero, runHi = zero;
+    for (; x < width; ++x) {
+        int32_t bits;
+        std::memcpy(&bits, px + x * 4, 4);
+        const __m128i p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero);
+        runLo = _mm_add_epi64(runLo, _mm_unpacklo_epi32(p, zero));
+        runHi = _mm_add_epi64(runHi, _mm_unpackhi_epi32(p, zero));
+        const __m128i* a = reinterpret_cast<const __m128i*>(above + x * 3);
+        __m128i* o = reinterpret_cast<__m128i*>(out + x * 3);
+        _mm_storeu_si128(o, _mm_add_epi64(_mm_loadu_si128(a), runLo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 3 + 2),
+                         _mm_add_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(above + x * 3 + 2)), runHi));
+    }
+#elif defined(RGBS_SAT_NEON)
+    uint64x2_t runLo = vdupq_n_u64(0), runHi = vdupq_n_u64(0);
+    for (; x < width; ++x) {
+        uint32_t bits;
+        std::memcpy(&bits, px + x * 4, 4);
+        const uint32x4_t p = vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8(bits))));
+        runLo = vaddw_u32(runLo, vget_low_u32(p));
+        runHi = vaddw_u32(runHi, vget_high_u32(p));
+        vst1q_u64(out + x * 3, vaddq_u64(vld1q_u64(above + x * 3), runLo));
+        vst1q_u64(out + x * 3 + 2, vaddq_u64(vld1q_u64(above + x * 3 + 2), runHi));
+    }
+#else
+    uint64_t r[3] = {0, 0, 0};
+    for (; x < width; ++x) {
+        for (int c = 0; c < 3; ++c) {
+            r[c] += px[x * 4 + c];
+            out[x * 3 + c] = above[x * 3 + c] + r[c];
+        }
+    }
+#endif
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// build
+//----------------------------------------------------------------------
+// Pick the accumulator width for the resolution and fill the table.
+//----------------------------------------------------------------------
+void IntegralImage::build(const FrameView& frame) {
+    if (frame.empty()) {
+        width_ = height_ = 0;
+        return;
+    }
+    width_ = frame.width;
+    height_ = frame.height;
+    rLane_ = frame.format == PixelFormat::RGBA8 ? 0 : 2;
+    const uint64_t maxTotal = static_cast<uint64_t>(width_) * height_ * 255u;
+    wide_ = maxTotal > UINT32_MAX;
+    if (wide_)
+        buildTable(frame, table64_);
+    else
+        buildTable(frame, table32_);
+}
+
+//----------------------------------------------------------------------
+// buildTable
+//----------------------------------------------------------------------
+// Entry (x, y) holds the sums of all pixels above and to the left of
+// pixel (x, y), in the byte lanes of the frame. Each row keeps a running
+// sum and adds the entry above, so the table is written in a single
+// sequential pass. One spare entry at the end takes the spill of the
+// last 4-lane store.
+//----------------------------------------------------------------------
+template <typename T>
+void IntegralImage::buildTable(const FrameView& frame, std::vector<T>& table) {
+    const size_t stride = static_cast<size_t>(width_ + 1) * 3;
+    table.resize(stride * (height_ + 1) + 1);
+    std::fill(table.begin(), table.begin() + stride + 1, T{0});
+
+    for (int y = 0; y < height_; ++y) {
+        T* out = &table[stride * (y + 1)];
+        out[0] = out[1] = out[2] = 0;
+        prefixRow(frame.row(y), width_, &table[stride * y + 3], out + 3);
+    }
+}
+
+//----------------------------------------------------------------------
+// rectSum
+//----------------------------------------------------------------------
+// Sum {R, G, B} of pixels in [x0, x1) x [y0, y1) from the four corner
+// entries.
+//----------------------------------------------------------------------
+template <typename T>
+std::array<uint64_t, 3> IntegralImage::rectSum(const std::vector<T>& table, int x0, int y0,
+                                               int x1, int y1) const {
+    const size_t stride = static_cast<size_t>(width_ + 1) * 3;
+    const T* a = &table[stride * y0 + x0 * 3];
+    const T* b = &table[stride * y0 + x1 * 3];
+    const T* c = &table[stride * y1 + x0 * 3];
+    const T* d = &table[stride * y1 + x1 * 3];
+    std::array<uint64_t, 3> sum;
+    for (int ch = 0; ch < 3; ++ch) {
+        const int lane = ch == 1 ? 1 : (ch == 0 ? rLane_ : 2 - rLane_);
+        sum[ch] = static_cast<uint64_t>(d[lane] - b[lane] - c[lane] + a[lane]);
+    }
+    return sum;
+}
+
+//----------------------------------------------------------------------
+// average (pixels)
+//----------------------------------------------------------------------
+std::array<int, 3> IntegralImage::average(int x, int y, int w, int h) const {
+    const int x0 = std::clamp(x, 0, width_);
+    const int y0 = std::clamp(y, 0, height_);
+    const int x1 = std::clamp(x + w, x0, width_);
+    const int y1 = std::clamp(y + h, y0, height_);
+    const uint64_t n = static_cast<uint64_t>(x1 - x0) * static_cast<uint64_t>(y1 - y0);
+    if (n == 0)
+        return {0, 0, 0};
+
+    const auto sum = wide_ ? rectSum(table64_, x0, y0, x1, y1)
+                           : rectSum(table32_, x0, y0, x1, y1);
+    return {static_cast<int>(sum[0] / n), static_cast<int>(sum[1] / n),
+            static_cast<int>(sum[2] / n)};
+}
+
+//----------------------------------------------------------------------
+// average (normalized)
+//----------------------------------------------------------------------
+// Scale the region to the current resolution; at least one pixel is
+// always covered.
+//----------------------------------------------------------------------
+std::array<int, 3> IntegralImage::average(const Region& region) const {
+    const int x0 = static_cast<int>(std::floor(region.x * width_));
+    const int y0 = static_cast<int>(std::floor(region.y * height_));
+    const int x1 = static_cast<int>(std::ceil((region.x + region.width) * width_));
+    const int y1 = static_cast<int>(std::ceil((region.y + region.height) * height_));
+    return average(x0, y0, (std::max)(1, x1 - x0), (std::max)(1, y1 - y0));
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "FrameView.h"
+
+/**
+ * Rectangle of the screen in normalized coordinates, so it stays valid
+ * across resolution changes. (0, 0) is the top-left corner and
+ * (1, 1) the bottom-right corner.
+ */
+struct Region {
+    double x = 0.0;      ///< Left edge
+    double y = 0.0;      ///< Top edge
+    double width = 1.0;  ///< Width as a fraction of the frame width
+    double height = 1.0; ///< Height as a fraction of the frame height
+};
+
+/**
+ * Summed-area table of a frame.
+ *
+ * After one linear pass in `build`, the average color of any rectangle
+ * is answered with four lookups per channel, independent of the size of
+ * the rectangle. Tables use 32-bit accumulators when every entry fits
+ * (width * height * 255 < 2^32, i.e. up to about 16 megapixels) and
+ * 64-bit accumulators above that, which halves memory traffic for the
+ * common 1080p and 4K cases. Entries keep the first three byte lanes of
+ * the frame; channel order is resolved on lookup.
+ */
+class IntegralImage {
+public:
+    /**
+     * Build the table for a frame. Storage is reused between frames of
+     * the same size.
+     */
+    void build(const FrameView& frame);
+
+    /**
+     * Average {R, G, B} of a pixel rectangle. The rectangle is clipped
+     * to the frame; an empty rectangle yields {0, 0, 0}.
+     */
+    std::array<int, 3> average(int x, int y, int w, int h) const;
+
+    /** Average {R, G, B} of a normalized region. */
+    std::array<int, 3> average(const Region& region) const;
+
+    /** Width of the frame the table was built from. */
+    int width() const { return width_; }
+
+    /** Height of the frame the table was built from. */
+    int height() const { return height_; }
+
+    /** True if the current table uses 64-bit accumulators. */
+    bool uses64Bit() const { return wide_; }
+
+private:
+    template <typename T>
+    void buildTable(const FrameView& frame, std::vector<T>& table);
+
+    template <typename T>
+    std::array<uint64_t, 3> rectSum(const std::vector<T>& table, int x0, int y0,
+                                    int x1, int y1) const;
+
+    int width_ = 0;
+    int height_ = 0;
+    bool wide_ = false;
+    int rLane_ = 2;                 ///< Byte lane of red in the frame (0 for RGBA8, 2 for BGRA8)
+    std::vector<uint32_t> table32_; ///< (width+1) x (height+1) x 3 byte lanes, first row/column zero
+    std::vector<uint64_t> table64_; ///< Same layout, used for very large frames
+};
@@ -0,0 +1,37 @@
+#include "LatencyWindow.h"
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------
+// LatencyWindow
+//----------------------------------------------------------------------
+LatencyWindow::LatencyWindow(size_t capacity) : samplesUs_((std::max)(capacity, size_t(1))) {}
+
+void LatencyWindow::add(Clock::duration latency) {
+    samplesUs_[next_] = std::chrono::duration<double, std::micro>(latency).count();
+    next_ = (next_ + 1) % samplesUs_.size();
+    count_ = (std::min)(count_ + 1, samplesUs_.size());
+    ++recorded_;
+}
+
+//----------------------------------------------------------------------
+// percentileUs
+//----------------------------------------------------------------------
+// Nearest rank on a copy, so recording stays O(1) and the order of the
+// ring is kept.
+//----------------------------------------------------------------------
+double LatencyWindow::percentileUs(double fraction) const {
+    if (count_ == 0)
+        return 0.0;
+    sorted_.assign(samplesUs_.begin(), samplesUs_.begin() + static_cast<std::ptrdiff_t>(count_));
+    const double rank = std::ceil((std::clamp)(fraction, 0.0, 1.0) * static_cast<double>(count_));
+    const size_t index = rank < 1.0 ? 0 : static_cast<size_t>(rank) - 1;
+    std::nth_element(sorted_.begin(), sorted_.begin() + static_cast<std::ptrdiff_t>(index), sorted_.end());
+    return sorted_[index];
+}
+
+void LatencyWindow::clear() {
+    next_ = 0;
+    count_ = 0;
+    recorded_ = 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Latencies of the most recent frames, for percentiles.
+ *
+ * Keeps the last `capacity` samples in a ring, so a percentile always
+ * describes recent behaviour and recording never allocates.
+ */
+class LatencyWindow {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit LatencyWindow(size_t capacity = 1000);
+
+    /** Record the latency of one frame. */
+    void add(Clock::duration latency);
+
+    /** Samples currently held, at most the capacity. */
+    size_t size() const { return count_; }
+
+    /** Samples recorded since the last `clear`, including overwritten ones. */
+    size_t recorded() const { return recorded_; }
+
+    /**
+     * Latency that `fraction` (0-1) of the held samples do not exceed,
+     * in microseconds; 0 without samples.
+     */
+    double percentileUs(double fraction) const;
+
+    void clear();
+
+private:
+    std::vector<double> samplesUs_;
+    size_t next_ = 0;
+    size_t count_ = 0;
+    size_t recorded_ = 0;
+    mutable std::vector<double> sorted_; ///< Scratch for percentileUs
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include "EventCount.h"
+
+/**
+ * Hands the newest item from one producer to one consumer thread,
+ * triple buffered.
+ *
+ * Of three slots the producer owns one (back), the consumer one (front)
+ * and the third (middle) holds the latest published item. Publishing
+ * fills back and swaps it with middle; taking swaps front with middle
+ * if that holds something new. Each swap is one atomic exchange, so
+ * neither side ever waits for the other, and the consumer always gets
+ * the freshest completed item instead of working through a backlog.
+ *
+ * An item replaced before the consumer took it goes to the drop
+ * handler on the producer thread, e.g. to release a texture, and is
+ * counted.
+ */
+template <typename T>
+class LatestMailbox {
+public:
+    using DropHandler = std::function<void(T&)>;
+
+    explicit LatestMailbox(DropHandler onDrop = nullptr) : onDrop_(std::move(onDrop)) {}
+
+    LatestMailbox(const LatestMailbox&) = delete;
+    LatestMailbox& operator=(const LatestMailbox&) = delete;
+
+    /**
+     * Publish an item (producer thread), replacing one not yet taken.
+     * @return false if the mailbox is stopped; the item was dropped.
+     */
+    bool publish(T value) {
+        if (stopped_.load(std::memory_order_acquire)) {
+            drop(value);
+            return false;
+        }
+        slots_[back_] = std::move(value);
+        const uint8_t previous = state_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel);
+        back_ = previous & kIndexMask;
+        if (previous & kFresh)
+            drop(slots_[back_]);
+        published_.fetch_add(1, std::memory_order_relaxed);
+        ready_.notifyAll();
+        return true;
+    }
+
+    /** Take the newest item if one arrived since the last take (consumer thread). */
+    bool tryTake(T& value) {
+        if (!(state_.load(std::memory_order_acquire) & kFresh))
+            return false;
+        const uint8_t previous = state_.exchange(front_, std::memory_order_acq_rel);
+        front_ = previous & kIndexMask;
+        value = std::move(slots_[front_]);
+        return true;
+    }
+
+    /**
+     * Take the newest item, waiting for one.
+     * @return false once the mailbox is stopped and its last item taken.
+     */
+    bool take(T& value) {
+        for (;;) {
+            if (tryTake(value))
+                return true;
+            if (stopped_.load(std::memory_order_acquire))
+                return tryTake(value);
+            bool arrived = false;
+            for (int i = spinIterations(); i > 0 && !arrived; --i) {
+                arrived = hasNew();
+                cpuRelax();
+            }
+            if (arrived)
+                continue;
+            const uint32_t key = ready_.prepareWait();
+            if (hasNew() || stopped_.load(std::memory_order_acquire)) {
+                ready_.cancelWait();
+                continue;
+            }
+            ready_.wait(key);
+        }
+    }
+
+    /** Wake the consumer; `take` returns false once the last item is taken. */
+    void stop() {
+        stopped_.store(true, std::memory_order_release);
+        ready_.notifyAll();
+    }
+
+    /** Items published so far. */
+    uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+
+    /** Items replaced before the consumer took them. */
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4; ///< Middle holds an item not yet taken
+
+    bool hasNew() const { return (state_.load(std::memory_order_acquire) & kFresh) != 0; }
+
+    void drop(T& value) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        if (onDrop_)
+            onDrop_(value);
+    }
+
+    DropHandler onDrop_;
+    std::array<T, 3> slots_{};
+    alignas(kCacheLine) uint8_t back_ = 0;              ///< Producer's slot
+    alignas(kCacheLine) uint8_t front_ = 1;             ///< Consumer's slot
+    alignas(kCacheLine) std::atomic<uint8_t> state_{2}; ///< Middle slot index, plus kFresh
+    std::atomic<bool> stopped_{false};
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> dropped_{0};
+    EventCount ready_;                  ///< Consumer sleeps here
+};
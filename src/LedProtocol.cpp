@@ -0,0 +1,253 @@
+#include "LedProtocol.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+static_assert(sizeof(Rgb8) == 3, "Rgb8 arrays are copied as packed RGB bytes");
+
+namespace {
+constexpr size_t kDdpHeader = 10;
+constexpr size_t kE131Header = 126;
+constexpr size_t kArtNetHeader = 18;
+constexpr size_t kWledDrgbPixels = 490;  ///< DRGB limit; larger strips use DNRGB
+constexpr size_t kWledDnrgbPixels = 489;
+
+// E1.31 field offsets (ANSI E1.31-2018, section 4)
+constexpr size_t kE131RootFlags = 16;
+constexpr size_t kE131FramingFlags = 38;
+constexpr size_t kE131Sequence = 111;
+constexpr size_t kE131Universe = 113;
+constexpr size_t kE131DmpFlags = 115;
+
+void putBe16(uint8_t* p, size_t v) {
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+}
+
+void putBe32(uint8_t* p, size_t v) {
+    putBe16(p, v >> 16);
+    putBe16(p + 2, v & 0xFFFF);
+}
+
+// PDU flags (0x7) and length in 12 bits
+void putPduLength(uint8_t* p, size_t length) {
+    putBe16(p, 0x7000 | (length & 0x0FFF));
+}
+
+bool usesDnrgb(size_t pixelCount) {
+    return pixelCount > kWledDrgbPixels;
+}
+
+// LEDs per packet for a strip of `pixelCount` LEDs
+size_t chunkSize(WireProtocol protocol, size_t pixelCount) {
+    if (protocol == WireProtocol::Wled && usesDnrgb(pixelCount))
+        return kWledDnrgbPixels;
+    return ProtocolEncoder::pixelsPerPacket(protocol);
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// ProtocolEncoder
+//----------------------------------------------------------------------
+// The E1.31 CID only has to be stable for the lifetime of the source,
+// so a random (version 4) UUID per encoder is enough.
+//----------------------------------------------------------------------
+ProtocolEncoder::ProtocolEncoder(WireProtocol protocol, const ProtocolOptions& options)
+    : protocol_(protocol), options_(options), delta_(options.delta) {
+    if (options_.universe < 0)
+        options_.universe = defaultUniverse(protocol_);
+    std::random_device rd;
+    for (auto& b : cid_)
+        b = static_cast<uint8_t>(rd());
+    cid_[6] = static_cast<uint8_t>((cid_[6] & 0x0F) | 0x40);
+    cid_[8] = static_cast<uint8_t>((cid_[8] & 0x3F) | 0x80);
+}
+
+//----------------------------------------------------------------------
+// defaultPort / pixelsPerPacket / headerSize / defaultUniverse /
+// maxUniverse
+//----------------------------------------------------------------------
+uint16_t ProtocolEncoder::defaultPort(WireProtocol protocol) {
+    switch (protocol) {
+        case WireProtocol::Ddp:    return 4048;
+        case WireProtocol::E131:   return 5568;
+        case WireProtocol::ArtNet: return 6454;
+        case WireProtocol::Wled:   return 21324;
+        case WireProtocol::Text:
+        case WireProtocol::Delta:  break; // no registered port
+    }
+    return 0;
+}
+
+size_t ProtocolEncoder::pixelsPerPacket(WireProtocol protocol) {
+    switch (protocol) {
+        case WireProtocol::Ddp:    return 480; // 1440 data bytes, as WLED sends
+        case WireProtocol::E131:
+        case WireProtocol::ArtNet: return 170; // 510 of 512 DMX channels
+        case WireProtocol::Wled:   return kWledDrgbPixels;
+        case WireProtocol::Delta:  return (DeltaWire::kMaxPacket - DeltaWire::kHeaderSize - DeltaWire::kRangeHeaderSize) / 3;
+        case WireProtocol::Text:   break;
+    }
+    return 1;
+}
+
+size_t ProtocolEncoder::headerSize(WireProtocol protocol, size_t pixelCount) {
+    switch (protocol) {
+        case WireProtocol::Ddp:    return kDdpHeader;
+        case WireProtocol::E131:   return kE131Header;
+        case WireProtocol::ArtNet: return kArtNetHeader;
+        case WireProtocol::Wled:   return usesDnrgb(pixelCount) ? 4 : 2;
+        case WireProtocol::Delta:  return DeltaWire::kHeaderSize + DeltaWire::kRangeHeaderSize;
+        case WireProtocol::Text:   break;
+    }
+    return 0;
+}
+
+int ProtocolEncoder::defaultUniverse(WireProtocol protocol) {
+    return protocol == WireProtocol::E131 ? 1 : 0;
+}
+
+int ProtocolEncoder::maxUniverse(WireProtocol protocol) {
+    switch (protocol) {
+        case WireProtocol::E131:   return 63999;
+        case WireProtocol::ArtNet: return 32767; // 7-bit net, 4-bit subnet, 4-bit universe
+        default: break;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// writeHeader
+//----------------------------------------------------------------------
+// Write every header field that does not change between frames.
+//----------------------------------------------------------------------
+void ProtocolEncoder::writeHeader(uint8_t* p, const Packet& packet, size_t index,
+                                  size_t packetCount) const {
+    const size_t dataBytes = packet.pixelCount * 3;
+    switch (protocol_) {
+        case WireProtocol::Ddp:
+            // Version 1; the last packet of a frame carries PUSH
+            p[0] = static_cast<uint8_t>(0x40 | (index + 1 == packetCount ? 0x01 : 0x00));
+            p[2] = 0x0B; // RGB, 8 bits per channel
+            p[3] = 0x01; // default output device
+            putBe32(p + 4, packet.firstPixel * 3);
+            putBe16(p + 8, dataBytes);
+            break;
+
+        case WireProtocol::E131: {
+            const size_t universe = static_cast<size_t>(options_.universe) + index;
+            putBe16(p, 0x0010);                     // preamble size
+            std::memcpy(p + 4, "ASC-E1.17\0\0\0", 12);
+            putPduLength(p + kE131RootFlags, packet.size - kE131RootFlags);
+            putBe32(p + 18, 0x00000004);            // VECTOR_ROOT_E131_DATA
+            std::memcpy(p + 22, cid_, sizeof(cid_));
+            putPduLength(p + kE131FramingFlags, packet.size - kE131FramingFlags);
+            putBe32(p + 40, 0x00000002);            // VECTOR_E131_DATA_PACKET
+            std::strncpy(reinterpret_cast<char*>(p + 44), "RGBStreamer", 64);
+            p[108] = static_cast<uint8_t>(options_.priority);
+            putBe16(p + kE131Universe, universe);
+            putPduLength(p + kE131DmpFlags, packet.size - kE131DmpFlags);
+            p[117] = 0x02;                          // VECTOR_DMP_SET_PROPERTY
+            p[118] = 0xA1;                          // address and data type
+            putBe16(p + 121, 0x0001);               // address increment
+            putBe16(p + 123, dataBytes + 1);        // start code + channels
+            break;
+        }
+
+        case WireProtocol::ArtNet: {
+            const size_t universe = static_cast<size_t>(options_.universe) + index;
+            std::memcpy(p, "Art-Net", 8);
+            p[8] = 0x00;                            // OpDmx, little endian
+            p[9] = 0x50;
+            putBe16(p + 10, 14);                    // protocol version
+            p[14] = static_cast<uint8_t>(universe & 0xFF);
+            p[15] = static_cast<uint8_t>((universe >> 8) & 0x7F);
+            putBe16(p + 16, packet.size - kArtNetHeader); // even, padded
+            break;
+        }
+
+        case WireProtocol::Wled:
+            p[0] = usesDnrgb(pixelCount_) ? 4 : 2; // DNRGB / DRGB
+            p[1] = static_cast<uint8_t>(options_.wledTimeout);
+            if (usesDnrgb(pixelCount_))
+                putBe16(p + 2, packet.firstPixel);
+            break;
+
+        case WireProtocol::Text:
+        case WireProtocol::Delta:
+            break;
+    }
+}
+
+//----------------------------------------------------------------------
+// layout
+//----------------------------------------------------------------------
+// Split a strip of `count` LEDs into packets and write their headers.
+// E1.31 and Art-Net strips end at the last universe of the protocol;
+// the configuration rejects longer ones, but the edge zones can
+// still hand over more LEDs than fit.
+//----------------------------------------------------------------------
+void ProtocolEncoder::layout(size_t count) {
+    pixelCount_ = count;
+    packets_.clear();
+    views_.clear();
+    buffer_.clear();
+    if (protocol_ == WireProtocol::Text || protocol_ == WireProtocol::Delta || count == 0)
+        return;
+
+    const size_t chunk = chunkSize(protocol_, count);
+    const size_t header = headerSize(protocol_, count);
+    size_t sent = count;
+    if (maxUniverse(protocol_) > 0) {
+        const int universes = (std::max)(maxUniverse(protocol_) - options_.universe + 1, 0);
+        sent = (std::min)(count, static_cast<size_t>(universes) * chunk);
+    }
+    size_t offset = 0;
+    for (size_t first = 0; first < sent; first += chunk) {
+        Packet packet;
+        packet.offset = offset;
+        packet.firstPixel = first;
+        packet.pixelCount = (std::min)(chunk, sent - first);
+        size_t dataBytes = packet.pixelCount * 3;
+        if (protocol_ == WireProtocol::ArtNet)
+            dataBytes += dataBytes & 1; // ArtDmx lengths are even
+        packet.size = header + dataBytes;
+        offset += packet.size;
+        packets_.push_back(packet);
+    }
+
+    buffer_.assign(offset, 0);
+    for (size_t i = 0; i < packets_.size(); ++i) {
+        writeHeader(buffer_.data() + packets_[i].offset, packets_[i], i, packets_.size());
+        views_.push_back({buffer_.data() + packets_[i].offset, packets_[i].size});
+    }
+}
+
+//----------------------------------------------------------------------
+// encode
+//----------------------------------------------------------------------
+// Copy the colors behind the prebuilt headers and advance the sequence
+// number.
+//----------------------------------------------------------------------
+const std::vector<PacketView>& ProtocolEncoder::encode(const Rgb8* pixels, size_t count) {
+    if (protocol_ == WireProtocol::Delta)
+        return count == 0 ? views_ : delta_.encode(pixels, count);
+    if (count != pixelCount_)
+        layout(count);
+
+    ++sequence_;
+    if (sequence_ == 0)
+        sequence_ = 1; // 0 means "no sequence" in DDP and Art-Net
+    const size_t header = headerSize(protocol_, count);
+    for (const Packet& packet : packets_) {
+        uint8_t* p = buffer_.data() + packet.offset;
+        std::memcpy(p + header, pixels + packet.firstPixel, packet.pixelCount * 3);
+        switch (protocol_) {
+            case WireProtocol::Ddp:    p[1] = static_cast<uint8_t>(1 + sequence_ % 15); break;
+            case WireProtocol::E131:   p[kE131Sequence] = sequence_; break;
+            case WireProtocol::ArtNet: p[12] = sequence_; break;
+            default: break;
+        }
+    }
+    return views_;
+}
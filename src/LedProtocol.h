@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ColorFrame.h"
+#include "DeltaCodec.h"
+
+/**
+ * Wire format of the packets sent to a device.
+ */
+enum class WireProtocol {
+    Text,   ///< The configured `format` string, one color per packet
+    Ddp,    ///< Distributed Display Protocol, 480 LEDs per packet
+    E131,   ///< E1.31 (sACN), one 170-LED universe per packet
+    ArtNet, ///< Art-Net ArtDmx, one 170-LED universe per packet
+    Wled,   ///< WLED realtime UDP (DRGB, or DNRGB above 490 LEDs)
+    Delta   ///< Changed ranges only, with keyframes; see DeltaCodec.h
+};
+
+/**
+ * Per-device settings of the binary protocols.
+ */
+struct ProtocolOptions {
+    int universe = -1;    ///< First E1.31 / Art-Net universe (-1 = 1 for E1.31, 0 for Art-Net)
+    int priority = 100;   ///< E1.31 source priority (0-200)
+    int wledTimeout = 2;  ///< Seconds before WLED resumes its own effects (255 = never)
+    DeltaOptions delta;   ///< Keyframe interval and change threshold of WireProtocol::Delta
+};
+
+/**
+ * Encodes LED colors into the packets of a binary pixel protocol.
+ *
+ * All packets of a frame live back to back in one buffer. Their headers
+ * are written once, when the LED count changes; `encode` then only
+ * copies the pixel bytes and patches the sequence numbers, so a frame
+ * costs little more than a memcpy of the colors. Long strips are split
+ * into as many packets (DDP offsets, universes, DNRGB start indices) as
+ * the protocol needs. `WireProtocol::Delta` is stateful and handed to a
+ * DeltaEncoder instead.
+ */
+class ProtocolEncoder {
+public:
+    explicit ProtocolEncoder(WireProtocol protocol = WireProtocol::Ddp,
+                             const ProtocolOptions& options = ProtocolOptions{});
+
+    /**
+     * Encode one frame.
+     * @param pixels LED colors in strip order.
+     * @param count  Number of LEDs.
+     * @return Packets to send in order, valid until the next call. Empty
+     *         for `WireProtocol::Text` or when `count` is 0. LEDs past
+     *         the last universe of E1.31 or Art-Net are not sent.
+     */
+    const std::vector<PacketView>& encode(const Rgb8* pixels, size_t count);
+
+    WireProtocol protocol() const { return protocol_; }
+
+    /** Make the next delta frame a keyframe; other protocols ignore it. */
+    void requestKeyframe() { delta_.requestKeyframe(); }
+
+    /** UDP port the protocol's receivers listen on by default. */
+    static uint16_t defaultPort(WireProtocol protocol);
+
+    /** Most LEDs carried by one packet. */
+    static size_t pixelsPerPacket(WireProtocol protocol);
+
+    /** Size of the fixed header in front of the pixel bytes. */
+    static size_t headerSize(WireProtocol protocol, size_t pixelCount);
+
+    /** First universe when `ProtocolOptions::universe` is -1. */
+    static int defaultUniverse(WireProtocol protocol);
+
+    /**
+     * Highest universe the protocol can address: 63999 for E1.31, 32767
+     * (15 bits) for Art-Net, 0 for protocols without universes.
+     */
+    static int maxUniverse(WireProtocol protocol);
+
+private:
+    // Placement of one packet inside buffer_
+    struct Packet {
+        size_t offset = 0;     ///< Start of the packet in buffer_
+        size_t size = 0;
+        size_t firstPixel = 0;
+        size_t pixelCount = 0;
+    };
+
+    void layout(size_t count);
+    void writeHeader(uint8_t* p, const Packet& packet, size_t index, size_t packetCount) const;
+
+    WireProtocol protocol_;
+    ProtocolOptions options_;
+    uint8_t cid_[16];              ///< E1.31 component identifier
+    std::vector<uint8_t> buffer_;
+    std::vector<Packet> packets_;
+    std::vector<PacketView> views_;
+    size_t pixelCount_ = 0;
+    uint8_t sequence_ = 0;
+    DeltaEncoder delta_;
+};
@@ -0,0 +1,190 @@
+#include "LedSampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RGBS_LED_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RGBS_LED_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+//----------------------------------------------------------------------
+// accumulateTaps
+//----------------------------------------------------------------------
+// Weighted sum of the byte lanes 0-3 of the taps [begin, end). SSE2 and
+// NEON widen one pixel to four floats and apply the weight to all
+// channels at once.
+//----------------------------------------------------------------------
+void accumulateTaps(const uint8_t* base, const uint32_t* offsets, const float* weights,
+                    uint32_t begin, uint32_t end, float out[4]) {
+#if defined(RGBS_LED_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128 acc = _mm_setzero_ps();
+    for (uint32_t t = begin; t < end; ++t) {
+        int32_t bits;
+        std::memcpy(&bits, base + offsets[t], 4);
+        __m128i v = _mm_cvtsi32_si128(bits);
+        v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero);
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(weights[t])));
+    }
+    _mm_storeu_ps(out, acc);
+#elif defined(RGBS_LED_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (uint32_t t = begin; t < end; ++t) {
+        uint32_t bits;
+        std::memcpy(&bits, base + offsets[t], 4);
+        const uint16x8_t wide = vmovl_u8(vcreate_u8(bits));
+        const float32x4_t px = vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide)));
+        acc = vmlaq_n_f32(acc, px, weights[t]);
+    }
+    vst1q_f32(out, acc);
+#else
+    out[0] = out[1] = out[2] = out[3] = 0.0f;
+    for (uint32_t t = begin; t < end; ++t) {
+        const uint8_t* px = base + offsets[t];
+        for (int c = 0; c < 4; ++c)
+            out[c] += weights[t] * px[c];
+    }
+#endif
+}
+
+uint8_t toByte(float v) {
+    return static_cast<uint8_t>(std::clamp(static_cast<int>(v + 0.5f), 0, 255));
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// setLayout
+//----------------------------------------------------------------------
+// Store the layout and force a kernel rebuild.
+//----------------------------------------------------------------------
+void LedSampler::setLayout(const std::vector<LedSpot>& leds) {
+    leds_ = leds;
+    width_ = 0;
+    height_ = 0;
+    rowPitch_ = 0;
+    levelCount_ = 0;
+}
+
+//----------------------------------------------------------------------
+// detailHeight
+//----------------------------------------------------------------------
+int LedSampler::detailHeight() const {
+    if (leds_.empty())
+        return 0;
+    double smallest = 1.0;
+    for (const auto& led : leds_)
+        smallest = (std::min)(smallest, led.radius);
+    return static_cast<int>(std::ceil(kLevelRadius / (std::max)(smallest, 1e-4)));
+}
+
+//----------------------------------------------------------------------
+// rebuild
+//----------------------------------------------------------------------
+// Pick a level for every footprint and turn it into taps: the pixels of
+// that level under the footprint's bounding box, each weighted by a
+// Gaussian (sigma = radius / 2) sampled on a 4x4 grid inside the pixel
+// and cut off at the circle, normalized to sum to one. Positions are
+// scaled from the finest level, so the part of the frame right of or
+// below its last block is left out, as in the pyramid itself.
+//----------------------------------------------------------------------
+void LedSampler::rebuild(const FramePyramid& pyramid) {
+    constexpr int kSubsamples = 4;
+    const FrameView& finest = pyramid.level(0);
+    width_ = finest.width;
+    height_ = finest.height;
+    rowPitch_ = finest.rowPitch;
+    levelCount_ = pyramid.levelCount();
+    ledLevel_.clear();
+    rowStart_.clear();
+    offsets_.clear();
+    weights_.clear();
+
+    for (const auto& led : leds_) {
+        rowStart_.push_back(static_cast<uint32_t>(offsets_.size()));
+
+        // Coarsest level that keeps the footprint kLevelRadius pixels wide
+        int level = 0;
+        double scale = 1.0;
+        while (level + 1 < levelCount_ && led.radius * height_ / (scale * 2.0) >= kLevelRadius) {
+            ++level;
+            scale *= 2.0;
+        }
+        ledLevel_.push_back(static_cast<uint8_t>(level));
+        const FrameView& view = pyramid.level(level);
+
+        const double cx = led.x * width_ / scale;
+        const double cy = led.y * height_ / scale;
+        const double r = (std::max)(0.5, led.radius * height_ / scale);
+        const double twoSigma2 = 2.0 * (r / 2.0) * (r / 2.0);
+        const int x0 = (std::max)(0, static_cast<int>(std::floor(cx - r)));
+        const int x1 = (std::min)(view.width - 1, static_cast<int>(std::floor(cx + r)));
+        const int y0 = (std::max)(0, static_cast<int>(std::floor(cy - r)));
+        const int y1 = (std::min)(view.height - 1, static_cast<int>(std::floor(cy + r)));
+
+        const size_t first = weights_.size();
+        double total = 0.0;
+        for (int iy = y0; iy <= y1; ++iy) {
+            for (int ix = x0; ix <= x1; ++ix) {
+                double w = 0.0;
+                for (int sy = 0; sy < kSubsamples; ++sy) {
+                    const double dy = iy + (sy + 0.5) / kSubsamples - cy;
+                    for (int sx = 0; sx < kSubsamples; ++sx) {
+                        const double dx = ix + (sx + 0.5) / kSubsamples - cx;
+                        const double d2 = dx * dx + dy * dy;
+                        if (d2 <= r * r)
+                            w += std::exp(-d2 / twoSigma2);
+                    }
+                }
+                if (w == 0.0)
+                    continue;
+                offsets_.push_back(static_cast<uint32_t>(iy * view.rowPitch + ix * 4));
+                weights_.push_back(static_cast<float>(w));
+                total += w;
+            }
+        }
+
+        // Footprint entirely off-screen: use the nearest pixel to the center
+        if (weights_.size() == first) {
+            const int ix = std::clamp(static_cast<int>(cx), 0, view.width - 1);
+            const int iy = std::clamp(static_cast<int>(cy), 0, view.height - 1);
+            offsets_.push_back(static_cast<uint32_t>(iy * view.rowPitch + ix * 4));
+            weights_.push_back(1.0f);
+            continue;
+        }
+        for (size_t t = first; t < weights_.size(); ++t)
+            weights_[t] = static_cast<float>(weights_[t] / total);
+    }
+    rowStart_.push_back(static_cast<uint32_t>(offsets_.size()));
+}
+
+//----------------------------------------------------------------------
+// sample
+//----------------------------------------------------------------------
+// Evaluate every LED kernel on its level. Channel order is resolved once
+// per frame.
+//----------------------------------------------------------------------
+void LedSampler::sample(const FramePyramid& pyramid, std::vector<Rgb8>& out) {
+    const FrameView& finest = pyramid.level(0);
+    if (leds_.empty() || finest.empty()) {
+        out.clear();
+        return;
+    }
+    if (finest.width != width_ || finest.height != height_ || finest.rowPitch != rowPitch_ ||
+        pyramid.levelCount() != levelCount_)
+        rebuild(pyramid);
+
+    const int rLane = finest.format == PixelFormat::RGBA8 ? 0 : 2;
+    const int bLane = finest.format == PixelFormat::RGBA8 ? 2 : 0;
+    out.resize(leds_.size());
+    alignas(16) float acc[4];
+    for (size_t i = 0; i < leds_.size(); ++i) {
+        accumulateTaps(pyramid.level(ledLevel_[i]).data, offsets_.data(), weights_.data(), rowStart_[i],
+                       rowStart_[i + 1], acc);
+        out[i] = {toByte(acc[rLane]), toByte(acc[1]), toByte(acc[bLane])};
+    }
+}
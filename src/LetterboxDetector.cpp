@@ -0,0 +1,156 @@
+#include "LetterboxDetector.h"
+#include "PixelFormats.h"
+#include <algorithm>
+#include <cstdlib>
+
+//----------------------------------------------------------------------
+// setOptions
+//----------------------------------------------------------------------
+void LetterboxDetector::setOptions(const LetterboxOptions& options, double sdrWhiteNits) {
+    options_ = options;
+    options_.recheckFrames = (std::max)(1, options_.recheckFrames);
+    options_.stableChecks = (std::max)(1, options_.stableChecks);
+    linearThreshold_ = static_cast<uint16_t>(
+        srgbToLinear((std::clamp)(options_.threshold, 0, 255) / 255.0) * kLinearLightMax);
+    halfTable_ = linearLightTable(PixelFormat::RGBA16F, sdrWhiteNits);
+    width_ = 0;
+    height_ = 0;
+}
+
+//----------------------------------------------------------------------
+// isDark
+//----------------------------------------------------------------------
+// True if no color channel of the pixel is above the threshold. Only
+// called for sampled pixels, so the format switch is cheap.
+//----------------------------------------------------------------------
+bool LetterboxDetector::isDark(const uint8_t* px, PixelFormat format) const {
+    uint32_t c[3];
+    switch (format) {
+        case PixelFormat::BGRA8:
+        case PixelFormat::RGBA8:
+            return (std::max)({px[0], px[1], px[2]}) <= options_.threshold;
+        case PixelFormat::RGB10A2:
+            PixelTraits<PixelFormat::RGB10A2>::codes(px, c);
+            return ((std::max)({c[0], c[1], c[2]}) >> 2) <= static_cast<uint32_t>(options_.threshold);
+        case PixelFormat::RGBA16F: {
+            PixelTraits<PixelFormat::RGBA16F>::codes(px, c);
+            return (std::max)({halfTable_[c[0]], halfTable_[c[1]], halfTable_[c[2]]}) <= linearThreshold_;
+        }
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------
+// isClose
+//----------------------------------------------------------------------
+// Bounds that differ by at most 1% of the frame size on every edge are
+// treated as the same, so soft picture edges do not restart hysteresis.
+//----------------------------------------------------------------------
+bool LetterboxDetector::isClose(const ContentBounds& a, const ContentBounds& b) const {
+    const int tolX = (std::max)(2, width_ / 100);
+    const int tolY = (std::max)(2, height_ / 100);
+    return std::abs(a.x - b.x) <= tolX && std::abs(a.y - b.y) <= tolY &&
+           std::abs((a.x + a.width) - (b.x + b.width)) <= tolX &&
+           std::abs((a.y + a.height) - (b.y + b.height)) <= tolY;
+}
+
+//----------------------------------------------------------------------
+// scan
+//----------------------------------------------------------------------
+// Walk inward from the top and bottom testing sampled columns, then
+// from the left and right testing sampled rows of the remaining band.
+// Returns false if the frame looks entirely black.
+//----------------------------------------------------------------------
+bool LetterboxDetector::scan(const FrameView& frame, ContentBounds& out) const {
+    const int w = frame.width;
+    const int h = frame.height;
+    const size_t pixelBytes = static_cast<size_t>(bytesPerPixel(frame.format));
+
+    const int columns = (std::min)(w, kSamplesPerLine);
+    auto rowIsDark = [&](int y) {
+        const uint8_t* row = frame.row(y);
+        for (int i = 0; i < columns; ++i) {
+            const int x = static_cast<int>((2LL * i + 1) * w / (2 * columns));
+            if (!isDark(row + x * pixelBytes, frame.format))
+                return false;
+        }
+        return true;
+    };
+
+    int top = 0;
+    while (top < h && rowIsDark(top))
+        ++top;
+    if (top == h)
+        return false;
+    int bottom = h;
+    while (bottom > top + 1 && rowIsDark(bottom - 1))
+        --bottom;
+
+    const int rows = (std::min)(bottom - top, kSamplesPerLine);
+    auto columnIsDark = [&](int x) {
+        for (int i = 0; i < rows; ++i) {
+            const int y = top + static_cast<int>((2LL * i + 1) * (bottom - top) / (2 * rows));
+            if (!isDark(frame.row(y) + x * pixelBytes, frame.format))
+                return false;
+        }
+        return true;
+    };
+
+    int left = 0;
+    while (left < w - 1 && columnIsDark(left))
+        ++left;
+    int right = w;
+    while (right > left + 1 && columnIsDark(right - 1))
+        --right;
+
+    out = {left, top, right - left, bottom - top};
+    return true;
+}
+
+//----------------------------------------------------------------------
+// update
+//----------------------------------------------------------------------
+// Rescan when due and apply the hysteresis.
+//----------------------------------------------------------------------
+const ContentBounds& LetterboxDetector::update(const FrameView& frame) {
+    if (frame.empty()) {
+        bounds_ = {};
+        return bounds_;
+    }
+    if (frame.width != width_ || frame.height != height_) {
+        width_ = frame.width;
+        height_ = frame.height;
+        bounds_ = {0, 0, width_, height_};
+        candidateCount_ = 0;
+        framesUntilScan_ = 0;
+    }
+    if (--framesUntilScan_ > 0)
+        return bounds_;
+    framesUntilScan_ = options_.recheckFrames;
+
+    ContentBounds found;
+    if (!scan(frame, found))
+        return bounds_;
+
+    if (isClose(found, bounds_)) {
+        candidateCount_ = 0;
+        return bounds_;
+    }
+    if (candidateCount_ > 0 && isClose(found, candidate_)) {
+        // Keep the union so no agreeing scan loses picture
+        const int x0 = (std::min)(candidate_.x, found.x);
+        const int y0 = (std::min)(candidate_.y, found.y);
+        const int x1 = (std::max)(candidate_.x + candidate_.width, found.x + found.width);
+        const int y1 = (std::max)(candidate_.y + candidate_.height, found.y + found.height);
+        candidate_ = {x0, y0, x1 - x0, y1 - y0};
+        ++candidateCount_;
+    } else {
+        candidate_ = found;
+        candidateCount_ = 1;
+    }
+    if (candidateCount_ >= options_.stableChecks) {
+        bounds_ = candidate_;
+        candidateCount_ = 0;
+    }
+    return bounds_;
+}
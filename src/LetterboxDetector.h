@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include "FrameView.h"
+#include "PixelFormats.h"
+
+/**
+ * Tuning of the letterbox detection.
+ */
+struct LetterboxOptions {
+    int threshold = 24;     ///< Brightest channel value (0-255) still counted as black
+    int recheckFrames = 15; ///< Frames between two scans of the bars
+    int stableChecks = 3;   ///< Scans that must agree before the bounds change
+};
+
+/**
+ * Pixel rectangle of the active picture inside a frame.
+ */
+struct ContentBounds {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool operator==(const ContentBounds&) const = default;
+};
+
+/**
+ * Finds the active picture of letterboxed (black bars above and below)
+ * and pillarboxed (bars left and right) content.
+ *
+ * A scan walks inward from each edge and tests 64 evenly spaced pixels
+ * of every row or column it crosses, so its cost depends on the bar
+ * size, not on the resolution. Scans run only every `recheckFrames`
+ * frames; in between `update()` returns the cached bounds.
+ *
+ * The bounds change only after `stableChecks` consecutive scans agree on
+ * the new rectangle (within 1% of the frame size; the union of the
+ * agreeing scans is adopted), so a dark scene, a fade to black or a
+ * subtitle flashing in the bottom bar does not make the picture jump. A
+ * scan that finds no content at all (a black frame) is ignored.
+ */
+class LetterboxDetector {
+public:
+    LetterboxDetector() { setOptions(LetterboxOptions{}); }
+
+    /**
+     * Replace the tuning options and restart detection.
+     * @param options      Tuning options.
+     * @param sdrWhiteNits SDR white level of the desktop; half float
+     *                     frames are compared with `threshold` on the same
+     *                     scale the analyzer averages them on.
+     */
+    void setOptions(const LetterboxOptions& options, double sdrWhiteNits = kScRgbWhiteNits);
+
+    /**
+     * Bounds of the active picture for this frame. The first frame and
+     * every resolution change start from the full frame.
+     */
+    const ContentBounds& update(const FrameView& frame);
+
+    /** Bounds returned by the last update. */
+    const ContentBounds& bounds() const { return bounds_; }
+
+private:
+    /** Samples tested per row or column during a scan. */
+    static constexpr int kSamplesPerLine = 64;
+
+    bool scan(const FrameView& frame, ContentBounds& out) const;
+    bool isDark(const uint8_t* px, PixelFormat format) const;
+    bool isClose(const ContentBounds& a, const ContentBounds& b) const;
+
+    LetterboxOptions options_;
+    uint16_t linearThreshold_ = 0; ///< `threshold` in linear light for half floats
+    const uint16_t* halfTable_ = nullptr; ///< Linear-light table of half floats
+    ContentBounds bounds_;
+    ContentBounds candidate_;   ///< Last scanned bounds that differ from bounds_
+    int candidateCount_ = 0;    ///< Consecutive scans that found candidate_
+    int framesUntilScan_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+};
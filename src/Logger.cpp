@@ -1,7 +1,5 @@
 #include "Logger.h"
 #include <iostream>
-#include <direct.h>
-#include <windows.h>
 
 Logger& Logger::getInstance() {
     static Logger instance;
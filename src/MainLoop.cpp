@@ -1,15 +1,24 @@
 #define WIN32_LEAN_AND_MEAN
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <timeapi.h>
 #include "CaptureModule.h"
 #include "RGBProcessor.h"
 #include "UDPSender.h"
 #include "ConfigManager.h"
 #include "Logger.h"
-#include <queue>
+#include "FrameAnalyzer.h"
+#include "LedProtocol.h"
+#include "SendPacer.h"
+#include "ChangeGate.h"
+#include "FramePool.h"
+#include "FrameScheduler.h"
+#include "LatencyWindow.h"
+#include "LatestMailbox.h"
+#include "SpscRing.h"
+#include "ThreadTuning.h"
+#include <algorithm>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
 #include <atomic>
 #include <chrono>
 #include <vector>
@@ -18,43 +27,193 @@
 
 namespace {
 
-// Simple thread-safe queue using mutex and condition variable
-template<typename T>
-class ThreadSafeQueue {
+//----------------------------------------------------------------------
+// devicePixels
+//----------------------------------------------------------------------
+// LED colors of one device for binary protocols. Devices without a
+// layout or zones get their color on `ledCount` LEDs, built in `fill`.
+//----------------------------------------------------------------------
+const std::vector<Rgb8>& devicePixels(const ColorFrame& frame, size_t index, int ledCount,
+                                      std::vector<Rgb8>& fill) {
+    const std::vector<Rgb8>& pixels = frame.pixelsFor(index);
+    if (!pixels.empty())
+        return pixels;
+    const auto& rgb = frame.colorFor(index);
+    const Rgb8 color = {static_cast<uint8_t>(rgb[0]), static_cast<uint8_t>(rgb[1]),
+                        static_cast<uint8_t>(rgb[2])};
+    fill.assign(static_cast<size_t>(ledCount), color);
+    return fill;
+}
+
+using Clock = std::chrono::steady_clock;
+
+// A captured frame on its way to processing
+struct CapturedFrame {
+    FrameLease frame;
+    Clock::time_point at; ///< When the capture completed
+};
+
+//----------------------------------------------------------------------
+// grabTimeoutMs
+//----------------------------------------------------------------------
+// In frame mode the capture waits for the next desktop frame, but not
+// past the deadline after `tickAt`.
+//----------------------------------------------------------------------
+UINT grabTimeoutMs(const ScheduleOptions& schedule, Clock::time_point tickAt, Clock::duration period) {
+    if (schedule.mode != ScheduleMode::Frame)
+        return 0;
+    const long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(tickAt + period - Clock::now()).count();
+    return static_cast<UINT>((std::max)(ms, 0LL));
+}
+
+//----------------------------------------------------------------------
+// logSchedule
+//----------------------------------------------------------------------
+// Log the period jitter every 300 deadlines and start a new window.
+//----------------------------------------------------------------------
+void logSchedule(FrameScheduler& scheduler) {
+    const ScheduleStats stats = scheduler.stats();
+    if (stats.ticks < 300)
+        return;
+    Logger::getInstance().logCapture("Capture period " + std::to_string(stats.meanPeriodUs / 1000.0) +
+                                     "ms mean, jitter " + std::to_string(stats.jitterUs) + "us, max deviation " +
+                                     std::to_string(stats.maxDeviationUs) + "us, " +
+                                     std::to_string(stats.overruns) + " overruns (" +
+                                     std::to_string(stats.skipped) + " deadlines skipped)");
+    scheduler.resetStats();
+}
+
+//----------------------------------------------------------------------
+// logLatency
+//----------------------------------------------------------------------
+// Log capture-to-send latency percentiles every 300 frames, so the
+// threaded and fused pipelines can be compared on the same machine.
+//----------------------------------------------------------------------
+void logLatency(LatencyWindow& latency, const std::string& mode) {
+    if (latency.recorded() < 300)
+        return;
+    Logger::getInstance().log("Frame latency (" + mode + "): p50 " +
+                              std::to_string(static_cast<int>(latency.percentileUs(0.5))) + "us, p99 " +
+                              std::to_string(static_cast<int>(latency.percentileUs(0.99))) + "us");
+    latency.clear();
+}
+
+//----------------------------------------------------------------------
+// FrameDelivery
+//----------------------------------------------------------------------
+// Sends the newest frame to each device once the pacer says it is due.
+// Shared by the sending thread and the fused pipeline.
+//----------------------------------------------------------------------
+class FrameDelivery {
 public:
-    void push(T value) {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            queue_.push(std::move(value));
-        }
-        cv_.notify_one();
-    }
+    FrameDelivery(const Config& cfg, std::vector<ProtocolEncoder>& encoders, UDPSender& sender,
+                  const std::vector<sockaddr_in>& addrs, Clock::duration period, int slices);
 
-    bool pop(T& value) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait(lock, [this]{ return stop_ || !queue_.empty(); });
-        if (queue_.empty())
-            return false;
-        value = std::move(queue_.front());
-        queue_.pop();
-        return true;
-    }
+    /** A new frame arrived; every device becomes due for it. */
+    void onFrame(Clock::time_point now) { pacer_.onFrame(now); }
 
-    void stop() {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            stop_ = true;
-        }
-        cv_.notify_all();
-    }
+    /** When the next device becomes due. */
+    Clock::time_point nextDue() const { return pacer_.nextDue(); }
+
+    /** Send `frame` to the devices due at `now`; false if none was due. */
+    bool sendDue(const ColorFrame& frame, Clock::time_point now);
+
+    /** Log suppressed packets and devices with new drops or errors. */
+    void logHealth();
 
 private:
-    std::queue<T> queue_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    bool stop_ = false;
+    const Config& cfg_;
+    std::vector<ProtocolEncoder>& encoders_;
+    UDPSender& sender_;
+    const std::vector<sockaddr_in>& addrs_;
+    SendPacer pacer_;
+    ChangeGate gate_;
+    std::vector<size_t> due_;
+    std::vector<size_t> deltaDevices_; ///< Listen for their keyframe requests
+    std::vector<Rgb8> fill_;
+    std::vector<uint64_t> reported_;   ///< Drops + errors already logged
+    uint64_t packetsDue_ = 0;
 };
 
+FrameDelivery::FrameDelivery(const Config& cfg, std::vector<ProtocolEncoder>& encoders, UDPSender& sender,
+                             const std::vector<sockaddr_in>& addrs, Clock::duration period, int slices)
+    : cfg_(cfg), encoders_(encoders), sender_(sender), addrs_(addrs), reported_(addrs.size(), 0) {
+    std::vector<double> maxRates;
+    for (const auto& dev : cfg.devices)
+        maxRates.push_back(dev.maxRate);
+    pacer_.reset(maxRates, period, slices);
+    gate_.reset(addrs.size(), cfg.changeGate);
+    for (size_t i = 0; i < encoders.size(); ++i)
+        if (encoders[i].protocol() == WireProtocol::Delta)
+            deltaDevices_.push_back(i);
+}
+
+//----------------------------------------------------------------------
+// FrameDelivery::sendDue
+//----------------------------------------------------------------------
+// Encoder packets stay valid until the encoder's next frame, so every
+// due device is queued and sent with one flush. A failing device is
+// paused by the sender and does not hold up the others. Devices whose
+// colors did not change are skipped by the gate.
+//----------------------------------------------------------------------
+bool FrameDelivery::sendDue(const ColorFrame& frame, Clock::time_point now) {
+    due_.clear();
+    pacer_.collectDue(now, due_);
+    if (due_.empty())
+        return false;
+    if (!deltaDevices_.empty()) {
+        sender_.receive(deltaDevices_, [this](size_t device, const uint8_t* data, size_t size) {
+            if (DeltaEncoder::isKeyframeRequest(data, size))
+                encoders_[device].requestKeyframe();
+        });
+    }
+    packetsDue_ += due_.size();
+    for (size_t i : due_) {
+        if (encoders_[i].protocol() == WireProtocol::Text) {
+            const auto& rgb = frame.colorFor(i);
+            const uint8_t bytes[3] = {static_cast<uint8_t>(rgb[0]), static_cast<uint8_t>(rgb[1]),
+                                      static_cast<uint8_t>(rgb[2])};
+            if (gate_.pass(i, bytes, sizeof(bytes), now))
+                sender_.queue(i, rgb, static_cast<int>(i));
+            continue;
+        }
+        const auto& pixels = devicePixels(frame, i, cfg_.devices[i].ledCount, fill_);
+        if (!gate_.pass(i, reinterpret_cast<const uint8_t*>(pixels.data()), pixels.size() * 3, now))
+            continue;
+        for (const PacketView& packet : encoders_[i].encode(pixels.data(), pixels.size()))
+            sender_.queuePacket(i, packet.data, packet.size);
+    }
+    sender_.flush();
+    return true;
+}
+
+//----------------------------------------------------------------------
+// FrameDelivery::logHealth
+//----------------------------------------------------------------------
+void FrameDelivery::logHealth() {
+    Logger& logger = Logger::getInstance();
+    if (gate_.enabled() && packetsDue_ > 0) {
+        const uint64_t suppressed = gate_.suppressedTotal();
+        logger.logUDP("Suppressed " + std::to_string(suppressed) + " of " +
+                      std::to_string(packetsDue_) + " unchanged packets (" +
+                      std::to_string(suppressed * 100 / packetsDue_) + "%)");
+    }
+    const auto& health = sender_.health();
+    for (size_t i = 0; i < health.size(); ++i) {
+        const uint64_t problems = health[i].dropped + health[i].errors;
+        if (problems == reported_[i])
+            continue;
+        reported_[i] = problems;
+        logger.logNetworkError(
+            "Device " + std::string(inet_ntoa(addrs_[i].sin_addr)) + ":" +
+            std::to_string(ntohs(addrs_[i].sin_port)) + " sent " +
+            std::to_string(health[i].sent) + ", dropped " +
+            std::to_string(health[i].dropped) + ", errors " +
+            std::to_string(health[i].errors) +
+            (health[i].circuitOpen ? " (paused)" : ""));
+    }
+}
+
 } // namespace
 
 //----------------------------------------------------------------------
@@ -68,17 +227,30 @@ void runMainLoop(const Config& cfg, std::atomic<bool>& stopFlag) {
     logger.log("Main loop starting");
     
     const int interval = cfg.intervalMs > 0 ? cfg.intervalMs : 1000 / 30;
-    logger.log("Capture interval: " + std::to_string(interval) + "ms");
+    const auto period = cfg.schedule.frameRate > 0.0
+                            ? std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double>(1.0 / cfg.schedule.frameRate))
+                            : Clock::duration(std::chrono::milliseconds(interval));
+    logger.log("Capture period: " +
+               std::to_string(std::chrono::duration<double, std::milli>(period).count()) + "ms" +
+               (cfg.schedule.mode == ScheduleMode::Frame ? ", waiting for desktop frames" : ""));
 
     // Resolve destination addresses
     std::vector<sockaddr_in> addrs;
+    std::vector<GroupDelivery> groups;
+    std::vector<ProtocolEncoder> encoders;
     for (const auto& dev : cfg.devices) {
+        encoders.emplace_back(dev.protocol, dev.protocolOptions);
         sockaddr_in addr{};
         addr.sin_family = AF_INET;
         addr.sin_port = htons(dev.port);
         inet_pton(AF_INET, dev.ip.c_str(), &addr.sin_addr);
         addrs.push_back(addr);
-        logger.log("Added device: " + dev.ip + ":" + std::to_string(dev.port));
+        groups.push_back(dev.group);
+        const char* kind = UDPSender::isMulticast(addr) ? " (multicast group)"
+                           : dev.group.broadcast        ? " (broadcast)"
+                                                        : "";
+        logger.log("Added device: " + dev.ip + ":" + std::to_string(dev.port) + kind);
     }
 
     CaptureModule capture;
@@ -105,41 +277,79 @@ void runMainLoop(const Config& cfg, std::atomic<bool>& stopFlag) {
         logger.log("Failed to open UDP sender");
         return;
     }
-    sender.setFormat(cfg.format);
+    if (!sender.setFormat(cfg.format)) {
+        logger.log("Invalid format string: " + cfg.format);
+        return;
+    }
     logger.log("UDP sender initialized with format: " + cfg.format);
+    sender.setDestinations(addrs, cfg.connectedSockets, groups);
+    sender.setHealthOptions(cfg.health);
+    if (cfg.transport != UdpTransport::Batched)
+        sender.setTransport(cfg.transport, cfg.uring); // falls back to batched sends
+    const bool anyBinary = std::any_of(cfg.devices.begin(), cfg.devices.end(), [](const Device& d) {
+        return d.protocol != WireProtocol::Text;
+    });
+    if (cfg.udpSegmentation && anyBinary)
+        sender.setSegmentation(true);
 
-    ThreadSafeQueue<ID3D11Texture2D*> frameQueue;
-    ThreadSafeQueue<std::array<int, 3>> rgbQueue;
+    // Color analyses of the processing thread (average, zones, ...)
+    const double displayWhite = capture.sdrWhiteNits();
+    FrameAnalyzer analyzer(cfg, displayWhite);
+    logger.log("Processing threads: " + std::to_string(analyzer.threadCount()));
+    logger.log("SDR white level: " + std::to_string(cfg.sdrWhiteNits > 0.0 ? cfg.sdrWhiteNits : displayWhite) +
+               " nits" + (cfg.sdrWhiteNits > 0.0 ? " (configured)" : " (display)"));
+    if (cfg.zones.count() > 0)
+        logger.log("Extracting " + std::to_string(cfg.zones.count()) + " edge zones");
 
-    // Capture thread
-    std::thread capThread([&](){
+    // Every capture is copied into a pool buffer of its own, so the pool
+    // bounds the frames in flight. Processing always starts on the newest
+    // capture; a frame replaced before it was taken goes back to the pool.
+    // Processed frames go through a bounded queue, so a slow sender costs
+    // dropped frames, not latency.
+    FramePool framePool(cfg.framePool);
+    LatestMailbox<CapturedFrame> frameMailbox([](CapturedFrame& captured) { captured.frame.reset(); });
+    SpscRing<ColorFrame> rgbQueue(cfg.colorQueue.capacity, cfg.colorQueue.policy);
+
+    // Capture thread, paced on absolute deadlines
+    auto captureLoop = [&](){
         logger.log("Capture thread started");
+        // The default 15.6 ms timer tick would swamp the spin at the end
+        // of each wait
+        timeBeginPeriod(1);
         int frameCount = 0;
+        FrameScheduler scheduler;
+        scheduler.reset(period, std::chrono::microseconds(cfg.schedule.spinUs), Clock::now());
         while (!stopFlag.load()) {
-            ID3D11Texture2D* tex = nullptr;
-            if (capture.grabFrame(tex) && tex) {
-                frameQueue.push(tex);
+            const auto tickAt = scheduler.waitForDeadline();
+            CapturedFrame captured;
+            if (capture.grabFrame(framePool, captured.frame, grabTimeoutMs(cfg.schedule, tickAt, period))) {
+                captured.at = Clock::now();
+                frameMailbox.publish(std::move(captured));
                 frameCount++;
                 if (frameCount % 100 == 0) { // Log every 100 frames
                     logger.logCapture("Captured frame " + std::to_string(frameCount));
                 }
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+            scheduler.advance(Clock::now());
+            logSchedule(scheduler);
         }
+        timeEndPeriod(1);
         logger.log("Capture thread stopping, total frames: " + std::to_string(frameCount));
-        frameQueue.stop();
-    });
+        frameMailbox.stop();
+    };
 
     // Processing thread
-    std::thread procThread([&](){
+    auto processingLoop = [&](){
         logger.log("Processing thread started");
         int processedCount = 0;
-        ID3D11Texture2D* tex = nullptr;
-        while (frameQueue.pop(tex)) {
-            auto rgb = getRGBAverage(tex);
-            if (tex)
-                tex->Release();
-            rgbQueue.push(rgb);
+        CapturedFrame captured;
+        while (frameMailbox.take(captured)) {
+            ColorFrame result;
+            analyzer.analyze(captured.frame.view(), result);
+            result.capturedAt = captured.at;
+            captured.frame.reset(); // back to the pool before the result is queued
+            const auto rgb = result.average;
+            rgbQueue.push(std::move(result));
             processedCount++;
             if (processedCount % 100 == 0) { // Log every 100 processed frames
                 logger.logCapture("Processed frame " + std::to_string(processedCount) + 
@@ -149,33 +359,124 @@ void runMainLoop(const Config& cfg, std::atomic<bool>& stopFlag) {
         }
         logger.log("Processing thread stopping, total processed: " + std::to_string(processedCount));
         rgbQueue.stop();
-    });
+    };
 
     // Sending thread
-    std::thread sendThread([&](){
+    auto sendingLoop = [&](){
         logger.log("Sending thread started");
         int sentCount = 0;
-        std::array<int, 3> rgb;
-        while (rgbQueue.pop(rgb)) {
-            bool allSent = true;
-            for (const auto& addr : addrs) {
-                if (!sender.send(addr, rgb)) {
-                    logger.logNetworkError("Failed to send to " + 
-                                         std::string(inet_ntoa(addr.sin_addr)) + ":" + 
-                                         std::to_string(ntohs(addr.sin_port)));
-                    allSent = false;
-                }
-            }
-            if (allSent) {
+        ColorFrame frame; // newest frame, sent to each device once it is due
+        ColorFrame incoming;
+        bool fresh = false; // frame not sent to any device yet
+        uint64_t reportedQueueDrops = 0;
+        FrameDelivery delivery(cfg, encoders, sender, addrs, period, cfg.paceSlices);
+        LatencyWindow latency(300);
+        for (;;) {
+            bool timedOut = false;
+            if (rgbQueue.popUntil(incoming, delivery.nextDue(), timedOut)) {
+                std::swap(frame, incoming);
+                fresh = true;
+                delivery.onFrame(Clock::now());
                 sentCount++;
                 if (sentCount % 100 == 0) { // Log every 100 sent frames
                     logger.logUDP("Sent frame " + std::to_string(sentCount) + 
                                 " to " + std::to_string(addrs.size()) + " devices");
+                    delivery.logHealth();
+                    // A stage that falls behind shows up as skipped frames
+                    const uint64_t queueDrops =
+                        frameMailbox.dropped() + rgbQueue.dropped() + framePool.exhausted();
+                    if (queueDrops != reportedQueueDrops) {
+                        reportedQueueDrops = queueDrops;
+                        logger.log("Queues: " + std::to_string(frameMailbox.dropped()) + " of " +
+                                   std::to_string(frameMailbox.published()) +
+                                   " captures replaced before processing; colors " +
+                                   std::to_string(rgbQueue.size()) + "/" +
+                                   std::to_string(rgbQueue.capacity()) + " queued, " +
+                                   std::to_string(rgbQueue.dropped()) + " dropped; " +
+                                   std::to_string(framePool.exhausted()) +
+                                   " captures skipped with every frame buffer in use");
+                    }
                 }
+            } else if (!timedOut) {
+                break;
+            }
+
+            if (delivery.sendDue(frame, Clock::now()) && fresh) {
+                fresh = false;
+                latency.add(Clock::now() - frame.capturedAt);
+                logLatency(latency, "threaded");
             }
         }
         logger.log("Sending thread stopping, total sent: " + std::to_string(sentCount));
-    });
+    };
+
+    // Fused pipeline: one thread captures, processes and sends each frame
+    // inline, without handoffs or wakeups between stages
+    auto fusedLoop = [&](){
+        logger.log("Fused pipeline thread started");
+        if (cfg.pipeline.cpu >= 0) {
+            if (pinCurrentThread(cfg.pipeline.cpu))
+                logger.log("Pinned to CPU " + std::to_string(cfg.pipeline.cpu));
+            else
+                logger.log("Could not pin to CPU " + std::to_string(cfg.pipeline.cpu));
+        }
+        if (!setCurrentThreadPriority(cfg.pipeline.priority))
+            logger.log("Could not raise the thread priority, running at normal priority");
+        timeBeginPeriod(1);
+        int frameCount = 0;
+        FrameScheduler scheduler;
+        scheduler.reset(period, std::chrono::microseconds(cfg.schedule.spinUs), Clock::now());
+        // Every device is sent each frame right away; rate-limited ones
+        // catch up on a later cycle
+        FrameDelivery delivery(cfg, encoders, sender, addrs, period, 1);
+        LatencyWindow latency(300);
+        ColorFrame frame;
+        bool fresh = false;
+        while (!stopFlag.load()) {
+            const auto tickAt = scheduler.waitForDeadline();
+            FrameLease captured;
+            if (capture.grabFrame(framePool, captured, grabTimeoutMs(cfg.schedule, tickAt, period))) {
+                ColorFrame result;
+                result.capturedAt = Clock::now();
+                analyzer.analyze(captured.view(), result);
+                captured.reset();
+                frame = std::move(result);
+                fresh = true;
+                delivery.onFrame(Clock::now());
+                frameCount++;
+                if (frameCount % 100 == 0) { // Log every 100 frames
+                    logger.logCapture("Fused frame " + std::to_string(frameCount) + " - RGB(" +
+                                      std::to_string(frame.average[0]) + "," +
+                                      std::to_string(frame.average[1]) + "," +
+                                      std::to_string(frame.average[2]) + ")");
+                    delivery.logHealth();
+                }
+            }
+            if (delivery.sendDue(frame, Clock::now()) && fresh) {
+                fresh = false;
+                latency.add(Clock::now() - frame.capturedAt);
+                logLatency(latency, "fused");
+            }
+            scheduler.advance(Clock::now());
+            logSchedule(scheduler);
+        }
+        timeEndPeriod(1);
+        logger.log("Fused pipeline thread stopping, total frames: " + std::to_string(frameCount));
+    };
+
+    std::vector<std::thread> threads;
+    if (cfg.pipeline.mode == PipelineMode::Fused) {
+        logger.log("Running capture, processing and sending on one thread");
+        if (cfg.paceSlices > 1)
+            logger.log("paceSlices has no effect in the fused pipeline");
+        threads.emplace_back(fusedLoop);
+    } else {
+        if (cfg.paceSlices > 1)
+            logger.log("Spreading each frame over " + std::to_string(cfg.paceSlices) + " send bursts");
+        threads.emplace_back(captureLoop);
+        threads.emplace_back(processingLoop);
+        threads.emplace_back(sendingLoop);
+    }
 
     logger.log("All threads started, waiting for stop signal");
 
@@ -185,9 +486,8 @@ void runMainLoop(const Config& cfg, std::atomic<bool>& stopFlag) {
 
     logger.log("Stop signal received, joining threads");
 
-    capThread.join();
-    procThread.join();
-    sendThread.join();
+    for (auto& thread : threads)
+        thread.join();
 
     logger.log("Closing UDP sender");
     sender.close();
@@ -0,0 +1,265 @@
+#include "PayloadFormat.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr int kMaxWidth = 16;
+
+// Largest number of digits a field can need without padding
+int maxDigits(char name, bool hex) {
+    if (name == 'i')
+        return hex ? 8 : 10;
+    return hex ? 2 : 3;
+}
+
+//----------------------------------------------------------------------
+// writeDigits
+//----------------------------------------------------------------------
+// Digits of `value` in a compile-time base, zero-padded to `width`.
+// Returns the number of bytes written, or 0 if they do not fit.
+//----------------------------------------------------------------------
+template <uint32_t Base>
+size_t writeDigits(uint32_t value, const char* digits, int width, char* out, size_t capacity) {
+    char tmp[kMaxWidth + 10];
+    int n = 0;
+    do {
+        tmp[n++] = digits[value % Base];
+        value /= Base;
+    } while (value != 0);
+    while (n < width)
+        tmp[n++] = '0';
+    if (static_cast<size_t>(n) > capacity)
+        return 0;
+    for (int i = 0; i < n; ++i)
+        out[i] = tmp[n - 1 - i];
+    return static_cast<size_t>(n);
+}
+
+//----------------------------------------------------------------------
+// toHsv
+//----------------------------------------------------------------------
+// Hue in degrees, saturation and value in percent, rounded.
+//----------------------------------------------------------------------
+void toHsv(const std::array<int, 3>& rgb, uint32_t hsv[3]) {
+    const int r = rgb[0], g = rgb[1], b = rgb[2];
+    const int maxC = (std::max)({r, g, b});
+    const int minC = (std::min)({r, g, b});
+    const int delta = maxC - minC;
+
+    double hue = 0.0;
+    if (delta > 0) {
+        if (maxC == r)
+            hue = 60.0 * (static_cast<double>(g - b) / delta);
+        else if (maxC == g)
+            hue = 60.0 * (static_cast<double>(b - r) / delta + 2.0);
+        else
+            hue = 60.0 * (static_cast<double>(r - g) / delta + 4.0);
+        if (hue < 0.0)
+            hue += 360.0;
+    }
+    hsv[0] = static_cast<uint32_t>(hue + 0.5) % 360;
+    hsv[1] = maxC == 0 ? 0 : static_cast<uint32_t>((delta * 200 + maxC) / (2 * maxC));
+    hsv[2] = static_cast<uint32_t>((maxC * 200 + 255) / 510);
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// PayloadFormat
+//----------------------------------------------------------------------
+PayloadFormat::PayloadFormat() : cache_(kCacheSize) {
+    compile("R{r:03d}G{g:03d}B{b:03d}\n");
+}
+
+//----------------------------------------------------------------------
+// compile
+//----------------------------------------------------------------------
+// Split the format string into literal runs and fields. A brace that
+// does not start a known placeholder stays literal; a known placeholder
+// with a malformed spec is an error.
+//----------------------------------------------------------------------
+bool PayloadFormat::compile(const std::string& format, std::string* error) {
+    std::vector<Token> tokens;
+    std::string literals;
+    size_t maxLength = 0;
+    bool usesIndex = false;
+    bool usesHsv = false;
+
+    std::string pending; // literal bytes not yet emitted as a token
+    auto flush = [&] {
+        if (pending.empty())
+            return;
+        Token t;
+        t.offset = static_cast<uint32_t>(literals.size());
+        t.length = static_cast<uint32_t>(pending.size());
+        literals += pending;
+        maxLength += pending.size();
+        tokens.push_back(t);
+        pending.clear();
+    };
+    auto fail = [&](const std::string& message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    if (format.empty())
+        return fail("format is empty");
+
+    const size_t n = format.size();
+    size_t i = 0;
+    while (i < n) {
+        const char c = format[i];
+        if (c == '}' && i + 1 < n && format[i + 1] == '}') {
+            pending += '}';
+            i += 2;
+            continue;
+        }
+        if (c != '{') {
+            pending += c;
+            ++i;
+            continue;
+        }
+        if (i + 1 < n && format[i + 1] == '{') {
+            pending += '{';
+            i += 2;
+            continue;
+        }
+
+        static const char kNames[] = "rgbhsvi";
+        const char* name = i + 1 < n ? std::strchr(kNames, format[i + 1]) : nullptr;
+        const bool closes = i + 2 < n && (format[i + 2] == '}' || format[i + 2] == ':');
+        if (!name || *name == '\0' || !closes) {
+            pending += c; // not a placeholder
+            ++i;
+            continue;
+        }
+
+        Token t;
+        static const Field kFields[] = {Field::R, Field::G, Field::B, Field::H,
+                                        Field::S, Field::V, Field::Index};
+        t.field = kFields[name - kNames];
+        size_t j = i + 2;
+        if (format[j] == ':') {
+            ++j;
+            int width = 0;
+            while (j < n && format[j] >= '0' && format[j] <= '9') {
+                width = width * 10 + (format[j] - '0');
+                if (width > kMaxWidth)
+                    return fail("field width above " + std::to_string(kMaxWidth) + " at offset " +
+                                std::to_string(i));
+                ++j;
+            }
+            if (j >= n || (format[j] != 'd' && format[j] != 'x' && format[j] != 'X'))
+                return fail("expected d, x or X in placeholder at offset " + std::to_string(i));
+            t.base = format[j] == 'd' ? Base::Dec : (format[j] == 'x' ? Base::Hex : Base::HexUpper);
+            t.width = static_cast<uint8_t>(width);
+            ++j;
+            if (j >= n || format[j] != '}')
+                return fail("unterminated placeholder at offset " + std::to_string(i));
+        }
+
+        flush();
+        tokens.push_back(t);
+        maxLength += (std::max)(static_cast<int>(t.width), maxDigits(*name, t.base != Base::Dec));
+        usesIndex = usesIndex || t.field == Field::Index;
+        usesHsv = usesHsv || t.field == Field::H || t.field == Field::S || t.field == Field::V;
+        i = j + 1;
+    }
+    flush();
+    literals.append(16, '\0');
+
+    tokens_ = std::move(tokens);
+    literals_ = std::move(literals);
+    maxLength_ = maxLength;
+    usesIndex_ = usesIndex;
+    usesHsv_ = usesHsv;
+    std::fill(cache_.begin(), cache_.end(), CacheEntry{});
+    return true;
+}
+
+//----------------------------------------------------------------------
+// renderUncached
+//----------------------------------------------------------------------
+// Execute the token program.
+//----------------------------------------------------------------------
+size_t PayloadFormat::renderUncached(const std::array<int, 3>& rgb, int index, char* out,
+                                     size_t capacity) const {
+    uint32_t hsv[3] = {0, 0, 0};
+    if (usesHsv_)
+        toHsv(rgb, hsv);
+
+    size_t pos = 0;
+    for (const Token& t : tokens_) {
+        if (t.field == Field::Literal) {
+            if (pos + t.length > capacity)
+                return 0;
+            // Short runs are copied as one fixed 16-byte block; the
+            // literal pool is padded so the read stays inside it
+            if (t.length <= 16 && capacity - pos >= 16)
+                std::memcpy(out + pos, literals_.data() + t.offset, 16);
+            else
+                std::memcpy(out + pos, literals_.data() + t.offset, t.length);
+            pos += t.length;
+            continue;
+        }
+
+        uint32_t value = 0;
+        switch (t.field) {
+            case Field::R:     value = static_cast<uint32_t>(rgb[0]); break;
+            case Field::G:     value = static_cast<uint32_t>(rgb[1]); break;
+            case Field::B:     value = static_cast<uint32_t>(rgb[2]); break;
+            case Field::H:     value = hsv[0]; break;
+            case Field::S:     value = hsv[1]; break;
+            case Field::V:     value = hsv[2]; break;
+            case Field::Index: value = static_cast<uint32_t>((std::max)(0, index)); break;
+            case Field::Literal: break;
+        }
+        static const char kLower[] = "0123456789abcdef";
+        static const char kUpper[] = "0123456789ABCDEF";
+        const size_t written =
+            t.base == Base::Dec
+                ? writeDigits<10>(value, kLower, t.width, out + pos, capacity - pos)
+                : writeDigits<16>(value, t.base == Base::Hex ? kLower : kUpper, t.width, out + pos,
+                                  capacity - pos);
+        if (written == 0)
+            return 0;
+        pos += written;
+    }
+    return pos;
+}
+
+//----------------------------------------------------------------------
+// render
+//----------------------------------------------------------------------
+// Serve repeated colors from the cache; render and remember the rest.
+//----------------------------------------------------------------------
+size_t PayloadFormat::render(const std::array<int, 3>& rgb, int index, char* out, size_t capacity) {
+    const std::array<int, 3> c = {(std::clamp)(rgb[0], 0, 255), (std::clamp)(rgb[1], 0, 255),
+                                  (std::clamp)(rgb[2], 0, 255)};
+    uint64_t key = (static_cast<uint64_t>(c[0]) << 16) | (static_cast<uint64_t>(c[1]) << 8) |
+                   static_cast<uint64_t>(c[2]);
+    if (usesIndex_)
+        key |= static_cast<uint64_t>(static_cast<uint32_t>(index)) << 24;
+    key += 1;
+
+    CacheEntry& entry = cache_[(key * 0x9E3779B97F4A7C15ull) >> 56];
+    if (entry.key == key) {
+        if (entry.length > capacity)
+            return 0;
+        // A fixed-size copy of the whole slot is a few vector moves; a
+        // variable-length one is a library call
+        if (capacity >= sizeof(entry.data))
+            std::memcpy(out, entry.data, sizeof(entry.data));
+        else
+            std::memcpy(out, entry.data, entry.length);
+        return entry.length;
+    }
+
+    const size_t length = renderUncached(c, index, out, capacity);
+    if (length > 0 && length <= sizeof(entry.data)) {
+        entry.key = key;
+        entry.length = static_cast<uint8_t>(length);
+        std::memcpy(entry.data, out, length);
+    }
+    return length;
+}
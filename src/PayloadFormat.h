@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Format string compiled into a token program.
+ *
+ * Grammar of the format string:
+ * - `{r}`, `{g}`, `{b}`: red, green, blue (0-255)
+ * - `{h}`: hue in degrees (0-359); `{s}`, `{v}`: saturation and value
+ *   in percent (0-100)
+ * - `{i}`: index of the color (device, zone or LED index)
+ * - `{x:Nd}`: decimal, zero-padded to N digits (`{r:03d}` -> `007`)
+ * - `{x:Nx}` / `{x:NX}`: lower / upper case hex, zero-padded to N digits
+ *   (`{r:02x}` -> `0a`)
+ * - `{{` and `}}`: literal `{` and `}`
+ *
+ * Any other brace is copied as is, so JSON-like payloads keep working.
+ *
+ * `compile` parses the string once. `render` then walks the tokens and
+ * writes into a caller-provided buffer without allocating. The last
+ * rendered payloads are kept in a small direct-mapped cache keyed by
+ * color (and index if the format uses `{i}`), so a steady color costs a
+ * lookup and a copy. Rendering mutates the cache; use one instance per
+ * thread.
+ */
+class PayloadFormat {
+public:
+    /** Compiles the default format `R{r:03d}G{g:03d}B{b:03d}\n`. */
+    PayloadFormat();
+
+    /**
+     * Compile a format string. On error the previous program is kept.
+     * @param format Format string.
+     * @param error  Receives a description of the problem, if not null.
+     * @return true if the string was compiled.
+     */
+    bool compile(const std::string& format, std::string* error = nullptr);
+
+    /**
+     * Render a color.
+     * @param rgb      {R, G, B} values, clamped to `[0, 255]`.
+     * @param index    Value of `{i}`.
+     * @param out      Output buffer.
+     * @param capacity Size of `out` in bytes.
+     * @return Number of payload bytes, or 0 if the payload does not fit.
+     *         Bytes of `out` past the payload may be overwritten.
+     */
+    size_t render(const std::array<int, 3>& rgb, int index, char* out, size_t capacity);
+
+    /** Largest payload this program can produce. */
+    size_t maxLength() const { return maxLength_; }
+
+    /** True if the format references `{i}`. */
+    bool usesIndex() const { return usesIndex_; }
+
+private:
+    enum class Field : uint8_t { Literal, R, G, B, H, S, V, Index };
+    enum class Base : uint8_t { Dec, Hex, HexUpper };
+
+    // One step of the program: a literal run or a formatted number
+    struct Token {
+        Field field = Field::Literal;
+        Base base = Base::Dec;
+        uint8_t width = 0;     ///< Minimum digits, zero-padded
+        uint32_t offset = 0;   ///< Literal: start in literals_
+        uint32_t length = 0;   ///< Literal: byte count
+    };
+
+    // Cached payload of one color, one cache line
+    struct alignas(64) CacheEntry {
+        uint64_t key = 0;      ///< Packed color and index + 1; 0 = empty
+        uint8_t length = 0;
+        char data[55];
+    };
+    static constexpr size_t kCacheSize = 256;
+
+    size_t renderUncached(const std::array<int, 3>& rgb, int index, char* out,
+                          size_t capacity) const;
+
+    std::vector<Token> tokens_;
+    std::string literals_;
+    size_t maxLength_ = 0;
+    bool usesIndex_ = false;
+    bool usesHsv_ = false;
+    std::vector<CacheEntry> cache_;
+};
@@ -0,0 +1,156 @@
+#include "PixelFormats.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace {
+//----------------------------------------------------------------------
+// halfToFloat
+//----------------------------------------------------------------------
+// Decode an IEEE 754 binary16 bit pattern, including subnormals,
+// infinities and NaN (which the callers clip).
+//----------------------------------------------------------------------
+float halfToFloat(uint16_t h) {
+    const int sign = (h >> 15) ? -1 : 1;
+    const int exponent = (h >> 10) & 0x1F;
+    const int mantissa = h & 0x3FF;
+    if (exponent == 0)
+        return sign * std::ldexp(static_cast<float>(mantissa), -24);
+    if (exponent == 31)
+        return mantissa ? NAN : sign * INFINITY;
+    return sign * std::ldexp(static_cast<float>(mantissa + 1024), exponent - 25);
+}
+
+// Linear light clipped to [0, 1]; NaN becomes 0
+double clipUnit(double v) {
+    return v > 0.0 ? (std::min)(v, 1.0) : 0.0;
+}
+
+//----------------------------------------------------------------------
+// buildLinearTable
+//----------------------------------------------------------------------
+// Table of `codes + 1` entries (the last one is padding) filled from a
+// code -> linear [0, 1] function.
+//----------------------------------------------------------------------
+template <typename Fn>
+std::vector<uint16_t> buildLinearTable(uint32_t codes, Fn&& toLinear) {
+    std::vector<uint16_t> table(codes + 1, 0);
+    for (uint32_t c = 0; c < codes; ++c)
+        table[c] = static_cast<uint16_t>(std::lround(clipUnit(toLinear(c)) * kLinearLightMax));
+    return table;
+}
+
+//----------------------------------------------------------------------
+// convertRows
+//----------------------------------------------------------------------
+// Per-format conversion loop. `encode` maps a channel code to its 8-bit
+// sRGB value.
+//----------------------------------------------------------------------
+template <PixelFormat F, typename Encode>
+void convertRows(const FrameView& frame, uint8_t* out, size_t outPitch, Encode&& encode) {
+    uint32_t c[3];
+    for (int y = 0; y < frame.height; ++y) {
+        const uint8_t* px = frame.row(y);
+        uint8_t* dst = out + y * outPitch;
+        for (int x = 0; x < frame.width; ++x, px += PixelTraits<F>::kBytes, dst += 4) {
+            PixelTraits<F>::codes(px, c);
+            dst[0] = encode(c[0]);
+            dst[1] = encode(c[1]);
+            dst[2] = encode(c[2]);
+            dst[3] = 255;
+        }
+    }
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// linearToSrgb / srgbToLinear
+//----------------------------------------------------------------------
+double linearToSrgb(double linear) {
+    linear = clipUnit(linear);
+    return linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+}
+
+double srgbToLinear(double encoded) {
+    encoded = clipUnit(encoded);
+    return encoded <= 0.04045 ? encoded / 12.92 : std::pow((encoded + 0.055) / 1.055, 2.4);
+}
+
+//----------------------------------------------------------------------
+// linearLightTable
+//----------------------------------------------------------------------
+// Tables are built on first use and live for the whole process.
+//----------------------------------------------------------------------
+const uint16_t* linearLightTable(PixelFormat format, double sdrWhiteNits) {
+    switch (format) {
+        case PixelFormat::BGRA8:
+        case PixelFormat::RGBA8: {
+            static const std::vector<uint16_t> table =
+                buildLinearTable(256, [](uint32_t c) { return srgbToLinear(c / 255.0); });
+            return table.data();
+        }
+        case PixelFormat::RGB10A2: {
+            static const std::vector<uint16_t> table =
+                buildLinearTable(1024, [](uint32_t c) { return srgbToLinear(c / 1023.0); });
+            return table.data();
+        }
+        case PixelFormat::RGBA16F: {
+            // One table per SDR white level; in practice only one or two
+            // levels are ever used, and entries are never removed
+            static std::mutex mutex;
+            static std::map<double, std::vector<uint16_t>> tables;
+            const double scale = kScRgbWhiteNits / (sdrWhiteNits > 0.0 ? sdrWhiteNits : kScRgbWhiteNits);
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = tables.find(scale);
+            if (it == tables.end()) {
+                it = tables.emplace(scale, buildLinearTable(65536, [scale](uint32_t c) {
+                    return halfToFloat(static_cast<uint16_t>(c)) * scale;
+                })).first;
+            }
+            return it->second.data();
+        }
+    }
+    return nullptr;
+}
+
+//----------------------------------------------------------------------
+// convertToRgba8
+//----------------------------------------------------------------------
+// One pass over the frame into a tightly packed RGBA8 buffer.
+//----------------------------------------------------------------------
+FrameView convertToRgba8(const FrameView& frame, std::vector<uint8_t>& storage, double sdrWhiteNits) {
+    if (frame.empty() || isEightBit(frame.format))
+        return frame;
+
+    const size_t pitch = static_cast<size_t>(frame.width) * 4;
+    if (storage.size() < pitch * frame.height)
+        storage.resize(pitch * frame.height);
+
+    if (frame.format == PixelFormat::RGB10A2) {
+        convertRows<PixelFormat::RGB10A2>(frame, storage.data(), pitch, [](uint32_t c) {
+            return static_cast<uint8_t>((c * 255 + 511) / 1023);
+        });
+    } else {
+        // Linear 16-bit value -> 8-bit sRGB in two table lookups
+        static const std::array<uint8_t, 4096> encode = [] {
+            std::array<uint8_t, 4096> t{};
+            for (size_t i = 0; i < t.size(); ++i)
+                t[i] = static_cast<uint8_t>(std::lround(linearToSrgb((i + 0.5) / t.size()) * 255.0));
+            return t;
+        }();
+        const uint16_t* linear = linearLightTable(PixelFormat::RGBA16F, sdrWhiteNits);
+        convertRows<PixelFormat::RGBA16F>(frame, storage.data(), pitch, [&](uint32_t c) {
+            return encode[linear[c] >> 4];
+        });
+    }
+
+    FrameView out;
+    out.data = storage.data();
+    out.width = frame.width;
+    out.height = frame.height;
+    out.rowPitch = pitch;
+    out.format = PixelFormat::RGBA8;
+    return out;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "FrameView.h"
+
+/**
+ * Compile-time description of a pixel format.
+ *
+ * `codes()` extracts the raw red, green and blue channel codes of one
+ * pixel. Kernels are instantiated per format, so the extraction inlines
+ * into the pixel loop and no per-pixel format switch remains.
+ *
+ * Members:
+ * - `kBytes`: size of a pixel in bytes
+ * - `kMaxCode`: largest channel code
+ * - `kLinear`: codes are linear light (otherwise sRGB encoded)
+ */
+template <PixelFormat F>
+struct PixelTraits;
+
+template <>
+struct PixelTraits<PixelFormat::BGRA8> {
+    static constexpr int kBytes = 4;
+    static constexpr uint32_t kMaxCode = 255;
+    static constexpr bool kLinear = false;
+    static void codes(const uint8_t* px, uint32_t out[3]) {
+        out[0] = px[2];
+        out[1] = px[1];
+        out[2] = px[0];
+    }
+};
+
+template <>
+struct PixelTraits<PixelFormat::RGBA8> {
+    static constexpr int kBytes = 4;
+    static constexpr uint32_t kMaxCode = 255;
+    static constexpr bool kLinear = false;
+    static void codes(const uint8_t* px, uint32_t out[3]) {
+        out[0] = px[0];
+        out[1] = px[1];
+        out[2] = px[2];
+    }
+};
+
+template <>
+struct PixelTraits<PixelFormat::RGB10A2> {
+    static constexpr int kBytes = 4;
+    static constexpr uint32_t kMaxCode = 1023;
+    static constexpr bool kLinear = false;
+    static void codes(const uint8_t* px, uint32_t out[3]) {
+        uint32_t v;
+        std::memcpy(&v, px, sizeof(v));
+        out[0] = v & 0x3FF;
+        out[1] = (v >> 10) & 0x3FF;
+        out[2] = (v >> 20) & 0x3FF;
+    }
+};
+
+/// Codes are the raw IEEE half bit patterns; decode them with
+/// `linearLightTable()`.
+template <>
+struct PixelTraits<PixelFormat::RGBA16F> {
+    static constexpr int kBytes = 8;
+    static constexpr uint32_t kMaxCode = 65535;
+    static constexpr bool kLinear = true;
+    static void codes(const uint8_t* px, uint32_t out[3]) {
+        uint16_t h[3];
+        std::memcpy(h, px, sizeof(h));
+        out[0] = h[0];
+        out[1] = h[1];
+        out[2] = h[2];
+    }
+};
+
+/** Largest 16-bit value stored in a linear-light table (1.0). */
+constexpr uint32_t kLinearLightMax = 65535;
+
+/** Luminance of scRGB 1.0, the reference white of half float frames. */
+constexpr double kScRgbWhiteNits = 80.0;
+
+/**
+ * Table mapping the channel codes of `format` to linear light in
+ * `[0, kLinearLightMax]`.
+ *
+ * sRGB-encoded formats go through the sRGB transfer function. For
+ * RGBA16F the table is indexed by the half bit pattern. An HDR desktop
+ * shows SDR white at `sdrWhiteNits`, i.e. scRGB `sdrWhiteNits / 80`, so
+ * values are scaled by `80 / sdrWhiteNits` to put SDR white at 1.0;
+ * negative values and highlights above it are clipped. Every table has
+ * one zero entry past `kMaxCode` so 32-bit gathers of the last entry
+ * stay in bounds.
+ *
+ * @param format       Pixel format of the codes.
+ * @param sdrWhiteNits SDR white level of the display; only used for
+ *                     RGBA16F. Tables are built once per level.
+ */
+const uint16_t* linearLightTable(PixelFormat format, double sdrWhiteNits = kScRgbWhiteNits);
+
+/** sRGB transfer function, linear `[0, 1]` to encoded `[0, 1]`. */
+double linearToSrgb(double linear);
+
+/** Inverse sRGB transfer function, encoded `[0, 1]` to linear `[0, 1]`. */
+double srgbToLinear(double encoded);
+
+/**
+ * Convert a frame to 8-bit RGBA for the byte-oriented analyses.
+ *
+ * 8-bit frames are returned unchanged. 10-bit channels are rounded to
+ * 8 bits, half floats are scaled to SDR white (see `linearLightTable`),
+ * clipped to `[0, 1]` and sRGB encoded.
+ *
+ * @param frame        Frame in any supported format.
+ * @param storage      Buffer that receives the converted pixels; grows only.
+ * @param sdrWhiteNits SDR white level of the display for half floats.
+ * @return View of `frame` or of `storage`.
+ */
+FrameView convertToRgba8(const FrameView& frame, std::vector<uint8_t>& storage,
+                         double sdrWhiteNits = kScRgbWhiteNits);
@@ -0,0 +1,1143 @@
+#include "PixelKernels.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RGBS_ARCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RGBS_ARCH_ARM64 1
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang only emit AVX2 instructions inside functions that opt in;
+// MSVC accepts the intrinsics anywhere.
+#if defined(RGBS_ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RGBS_TARGET_SSE2 __attribute__((target("sse2")))
+#define RGBS_TARGET_AVX2 __attribute__((target("avx2")))
+#define RGBS_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vbmi")))
+#else
+#define RGBS_TARGET_SSE2
+#define RGBS_TARGET_AVX2
+#define RGBS_TARGET_AVX512
+#endif
+
+namespace {
+
+//----------------------------------------------------------------------
+// sumRowScalar
+//----------------------------------------------------------------------
+// Portable reference kernel. Adds bytes 0, 1 and 2 of each pixel.
+//----------------------------------------------------------------------
+void sumRowScalar(const uint8_t* row, int width, uint64_t sums[3]) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0;
+    for (int x = 0; x < width; ++x) {
+        const uint8_t* px = row + x * 4;
+        s0 += px[0];
+        s1 += px[1];
+        s2 += px[2];
+    }
+    sums[0] += s0;
+    sums[1] += s1;
+    sums[2] += s2;
+}
+
+//----------------------------------------------------------------------
+// sumRowTableScalar
+//----------------------------------------------------------------------
+// Reference table kernel. The table is small enough to stay in L1.
+//----------------------------------------------------------------------
+void sumRowTableScalar(const uint8_t* row, int width, const uint16_t* table, uint64_t sums[3]) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0;
+    for (int x = 0; x < width; ++x) {
+        const uint8_t* px = row + x * 4;
+        s0 += table[px[0]];
+        s1 += table[px[1]];
+        s2 += table[px[2]];
+    }
+    sums[0] += s0;
+    sums[1] += s1;
+    sums[2] += s2;
+}
+
+//----------------------------------------------------------------------
+// sumRowTenBitScalar
+//----------------------------------------------------------------------
+// Reference 10-bit kernel.
+//----------------------------------------------------------------------
+void sumRowTenBitScalar(const uint8_t* row, int width, uint64_t sums[3]) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0;
+    for (int x = 0; x < width; ++x) {
+        uint32_t v;
+        std::memcpy(&v, row + x * 4, sizeof(v));
+        s0 += v & 0x3FF;
+        s1 += (v >> 10) & 0x3FF;
+        s2 += (v >> 20) & 0x3FF;
+    }
+    sums[0] += s0;
+    sums[1] += s1;
+    sums[2] += s2;
+}
+
+//----------------------------------------------------------------------
+// downsampleScalar
+//----------------------------------------------------------------------
+// Reference 2x2 box filter, one byte at a time.
+//----------------------------------------------------------------------
+void downsampleScalar(const uint8_t* row0, const uint8_t* row1, int outWidth, uint8_t* out) {
+    for (int x = 0; x < outWidth; ++x) {
+        const uint8_t* a = row0 + x * 8;
+        const uint8_t* b = row1 + x * 8;
+        for (int c = 0; c < 4; ++c)
+            out[x * 4 + c] = static_cast<uint8_t>((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+    }
+}
+
+//----------------------------------------------------------------------
+// columnSumScalar / blockMeanScalar
+//----------------------------------------------------------------------
+// Reference kernels for the single-pass pyramid level.
+//----------------------------------------------------------------------
+void columnSumScalar(const uint8_t* rows, size_t pitch, int rowCount, int bytes, uint16_t* sums,
+                     bool accumulate) {
+    for (int i = 0; i < bytes; ++i) {
+        unsigned sum = accumulate ? sums[i] : 0;
+        for (int r = 0; r < rowCount; ++r)
+            sum += rows[r * pitch + i];
+        sums[i] = static_cast<uint16_t>(sum);
+    }
+}
+
+void blockMeanScalar(const uint16_t* sums, int outWidth, int shift, uint8_t* out,
+                     uint64_t totals[4]) {
+    const int block = 1 << shift;
+    const uint32_t round = (1u << (2 * shift)) >> 1;
+    for (int x = 0; x < outWidth; ++x) {
+        const uint16_t* px = sums + static_cast<size_t>(x) * block * 4;
+        uint32_t s[4] = {0, 0, 0, 0};
+        for (int i = 0; i < block * 4; i += 4) {
+            for (int c = 0; c < 4; ++c)
+                s[c] += px[i + c];
+        }
+        for (int c = 0; c < 4; ++c) {
+            out[x * 4 + c] = static_cast<uint8_t>((s[c] + round) >> (2 * shift));
+            totals[c] += s[c];
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// withShift
+//----------------------------------------------------------------------
+// Call `fn` with the block shift as a compile-time constant, so the
+// block mean kernels unroll their inner loops for each block size.
+//----------------------------------------------------------------------
+template <typename Fn>
+void withShift(int shift, Fn&& fn) {
+    switch (shift) {
+        case 1: return fn(std::integral_constant<int, 1>{});
+        case 2: return fn(std::integral_constant<int, 2>{});
+        case 3: return fn(std::integral_constant<int, 3>{});
+        case 4: return fn(std::integral_constant<int, 4>{});
+        case 5: return fn(std::integral_constant<int, 5>{});
+        case 6: return fn(std::integral_constant<int, 6>{});
+        case 7: return fn(std::integral_constant<int, 7>{});
+        case 8: return fn(std::integral_constant<int, 8>{});
+    }
+}
+
+//----------------------------------------------------------------------
+// bytesDifferScalar
+//----------------------------------------------------------------------
+bool bytesDifferScalar(const uint8_t* a, const uint8_t* b, size_t size, uint8_t threshold) {
+    for (size_t i = 0; i < size; ++i) {
+        const int delta = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        if (delta > threshold)
+            return true;
+    }
+    return false;
+}
+
+#if defined(RGBS_ARCH_X86)
+//----------------------------------------------------------------------
+// sumRowSSE2
+//----------------------------------------------------------------------
+// Four pixels per 16-byte load. Each channel is isolated with a mask and
+// `_mm_sad_epu8` against zero sums its bytes into two 64-bit lanes, so
+// the accumulators cannot overflow for any realistic frame size.
+//----------------------------------------------------------------------
+RGBS_TARGET_SSE2
+void sumRowSSE2(const uint8_t* row, int width, uint64_t sums[3]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask0 = _mm_set1_epi32(0x000000FF);
+    const __m128i mask1 = _mm_set1_epi32(0x0000FF00);
+    const __m128i mask2 = _mm_set1_epi32(0x00FF0000);
+    __m128i acc0 = zero, acc1 = zero, acc2 = zero;
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+        acc0 = _mm_add_epi64(acc0, _mm_sad_epu8(_mm_and_si128(px, mask0), zero));
+        acc1 = _mm_add_epi64(acc1, _mm_sad_epu8(_mm_and_si128(px, mask1), zero));
+        acc2 = _mm_add_epi64(acc2, _mm_sad_epu8(_mm_and_si128(px, mask2), zero));
+    }
+
+    alignas(16) uint64_t lanes[3][2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), acc0);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), acc1);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), acc2);
+    sums[0] += lanes[0][0] + lanes[0][1];
+    sums[1] += lanes[1][0] + lanes[1][1];
+    sums[2] += lanes[2][0] + lanes[2][1];
+
+    // Remaining 0-3 pixels
+    sumRowScalar(row + x * 4, width - x, sums);
+}
+
+//----------------------------------------------------------------------
+// sumRowAVX2
+//----------------------------------------------------------------------
+// Same scheme as the SSE2 kernel with eight pixels per 32-byte load.
+//----------------------------------------------------------------------
+RGBS_TARGET_AVX2
+void sumRowAVX2(const uint8_t* row, int width, uint64_t sums[3]) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i mask0 = _mm256_set1_epi32(0x000000FF);
+    const __m256i mask1 = _mm256_set1_epi32(0x0000FF00);
+    const __m256i mask2 = _mm256_set1_epi32(0x00FF0000);
+    __m256i acc0 = zero, acc1 = zero, acc2 = zero;
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+        acc0 = _mm256_add_epi64(acc0, _mm256_sad_epu8(_mm256_and_si256(px, mask0), zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_sad_epu8(_mm256_and_si256(px, mask1), zero));
+        acc2 = _mm256_add_epi64(acc2, _mm256_sad_epu8(_mm256_and_si256(px, mask2), zero));
+    }
+
+    alignas(32) uint64_t lanes[3][4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[0]), acc0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[1]), acc1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[2]), acc2);
+    for (int c = 0; c < 3; ++c)
+        sums[c] += lanes[c][0] + lanes[c][1] + lanes[c][2] + lanes[c][3];
+
+    // Remaining 0-7 pixels
+    sumRowScalar(row + x * 4, width - x, sums);
+}
+
+//----------------------------------------------------------------------
+// sumRowTableAVX2
+//----------------------------------------------------------------------
+// Eight pixels per load. Each byte lane is shifted down to a 32-bit
+// index and looked up with a gather of 32-bit words at a 2-byte scale,
+// so the low half of every gathered word is the wanted table entry (the
+// padding entry keeps the last read in bounds). The 32-bit accumulators
+// are flushed before they can overflow.
+//----------------------------------------------------------------------
+RGBS_TARGET_AVX2
+void sumRowTableAVX2(const uint8_t* row, int width, const uint16_t* table, uint64_t sums[3]) {
+    const int* base = reinterpret_cast<const int*>(table);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i wordMask = _mm256_set1_epi32(0xFFFF);
+    constexpr int kFlushPixels = 8 * 32768; // 32768 * 65535 < 2^32 per lane
+
+    int x = 0;
+    while (x + 8 <= width) {
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        __m256i acc2 = _mm256_setzero_si256();
+        const int end = (std::min)(width, x + kFlushPixels);
+        for (; x + 8 <= end; x += 8) {
+            const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+            const __m256i i0 = _mm256_and_si256(px, byteMask);
+            const __m256i i1 = _mm256_and_si256(_mm256_srli_epi32(px, 8), byteMask);
+            const __m256i i2 = _mm256_and_si256(_mm256_srli_epi32(px, 16), byteMask);
+            acc0 = _mm256_add_epi32(acc0, _mm256_and_si256(_mm256_i32gather_epi32(base, i0, 2), wordMask));
+            acc1 = _mm256_add_epi32(acc1, _mm256_and_si256(_mm256_i32gather_epi32(base, i1, 2), wordMask));
+            acc2 = _mm256_add_epi32(acc2, _mm256_and_si256(_mm256_i32gather_epi32(base, i2, 2), wordMask));
+        }
+
+        alignas(32) uint32_t lanes[3][8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[0]), acc0);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[1]), acc1);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[2]), acc2);
+        for (int c = 0; c < 3; ++c) {
+            for (int i = 0; i < 8; ++i)
+                sums[c] += lanes[c][i];
+        }
+    }
+
+    // Remaining 0-7 pixels
+    sumRowTableScalar(row + x * 4, width - x, table, sums);
+}
+
+//----------------------------------------------------------------------
+// sumRowTableAVX512
+//----------------------------------------------------------------------
+// The low and high bytes of the 256 table entries fit in four registers
+// each, and `vpermi2b` looks up 64 bytes in one half of them at once;
+// bit 7 of the index picks the half. Sixteen pixels are first reordered
+// so that each 64-bit lane holds eight bytes of one channel, which lets
+// `_mm512_sad_epu8` add the looked-up bytes per channel directly. The
+// sums of the low and high bytes are combined at the end of the row.
+//----------------------------------------------------------------------
+RGBS_TARGET_AVX512
+void sumRowTableAVX512(const uint8_t* row, int width, const uint16_t* table, uint64_t sums[3]) {
+    // Byte 8q + i of the reordered pixels: channel q / 2 of pixel 8 (q % 2) + i
+    alignas(64) static constexpr uint8_t kChannelOrder[64] = {
+        0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60,
+        1, 5, 9, 13, 17, 21, 25, 29, 33, 37, 41, 45, 49, 53, 57, 61,
+        2, 6, 10, 14, 18, 22, 26, 30, 34, 38, 42, 46, 50, 54, 58, 62,
+        3, 7, 11, 15, 19, 23, 27, 31, 35, 39, 43, 47, 51, 55, 59, 63};
+    alignas(64) static constexpr uint8_t kEvenBytes[64] = {
+        0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30,
+        32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62,
+        64, 66, 68, 70, 72, 74, 76, 78, 80, 82, 84, 86, 88, 90, 92, 94,
+        96, 98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124, 126};
+    const __m512i even = _mm512_load_si512(kEvenBytes);
+    const __m512i odd = _mm512_add_epi8(even, _mm512_set1_epi8(1));
+    __m512i low[4], high[4];
+    for (int i = 0; i < 4; ++i) {
+        const __m512i w0 = _mm512_loadu_si512(table + i * 64);
+        const __m512i w1 = _mm512_loadu_si512(table + i * 64 + 32);
+        low[i] = _mm512_permutex2var_epi8(w0, even, w1);
+        high[i] = _mm512_permutex2var_epi8(w0, odd, w1);
+    }
+    const __m512i order = _mm512_load_si512(kChannelOrder);
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i accLow = zero, accHigh = zero;
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m512i px = _mm512_loadu_si512(row + x * 4);
+        const __m512i index = _mm512_permutex2var_epi8(px, order, px);
+        const __mmask64 upper = _mm512_movepi8_mask(index);
+        const __m512i lo = _mm512_mask_blend_epi8(upper, _mm512_permutex2var_epi8(low[0], index, low[1]),
+                                                  _mm512_permutex2var_epi8(low[2], index, low[3]));
+        const __m512i hi = _mm512_mask_blend_epi8(upper, _mm512_permutex2var_epi8(high[0], index, high[1]),
+                                                  _mm512_permutex2var_epi8(high[2], index, high[3]));
+        accLow = _mm512_add_epi64(accLow, _mm512_sad_epu8(lo, zero));
+        accHigh = _mm512_add_epi64(accHigh, _mm512_sad_epu8(hi, zero));
+    }
+
+    alignas(64) uint64_t lanes[2][8];
+    _mm512_store_si512(lanes[0], accLow);
+    _mm512_store_si512(lanes[1], accHigh);
+    for (int c = 0; c < 3; ++c)
+        sums[c] += lanes[0][2 * c] + lanes[0][2 * c + 1] + ((lanes[1][2 * c] + lanes[1][2 * c + 1]) << 8);
+
+    // Remaining 0-15 pixels
+    sumRowTableScalar(row + x * 4, width - x, table, sums);
+}
+
+//----------------------------------------------------------------------
+// sumRowTenBitSSE2
+//----------------------------------------------------------------------
+// Four pixels per load; each field is shifted down and masked into a
+// 32-bit accumulator, which grows by at most 1023 per iteration.
+//----------------------------------------------------------------------
+RGBS_TARGET_SSE2
+void sumRowTenBitSSE2(const uint8_t* row, int width, uint64_t sums[3]) {
+    const __m128i mask = _mm_set1_epi32(0x3FF);
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    __m128i acc2 = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+        acc0 = _mm_add_epi32(acc0, _mm_and_si128(px, mask));
+        acc1 = _mm_add_epi32(acc1, _mm_and_si128(_mm_srli_epi32(px, 10), mask));
+        acc2 = _mm_add_epi32(acc2, _mm_and_si128(_mm_srli_epi32(px, 20), mask));
+    }
+
+    alignas(16) uint32_t lanes[3][4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), acc0);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), acc1);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), acc2);
+    for (int c = 0; c < 3; ++c)
+        sums[c] += static_cast<uint64_t>(lanes[c][0]) + lanes[c][1] + lanes[c][2] + lanes[c][3];
+
+    // Remaining 0-3 pixels
+    sumRowTenBitScalar(row + x * 4, width - x, sums);
+}
+
+//----------------------------------------------------------------------
+// sumRowTenBitAVX2
+//----------------------------------------------------------------------
+// Same scheme as the SSE2 kernel with eight pixels per load.
+//----------------------------------------------------------------------
+RGBS_TARGET_AVX2
+void sumRowTenBitAVX2(const uint8_t* row, int width, uint64_t sums[3]) {
+    const __m256i mask = _mm256_set1_epi32(0x3FF);
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256();
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+        acc0 = _mm256_add_epi32(acc0, _mm256_and_si256(px, mask));
+        acc1 = _mm256_add_epi32(acc1, _mm256_and_si256(_mm256_srli_epi32(px, 10), mask));
+        acc2 = _mm256_add_epi32(acc2, _mm256_and_si256(_mm256_srli_epi32(px, 20), mask));
+    }
+
+    alignas(32) uint32_t lanes[3][8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[0]), acc0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[1]), acc1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[2]), acc2);
+    for (int c = 0; c < 3; ++c) {
+        for (int i = 0; i < 8; ++i)
+            sums[c] += lanes[c][i];
+    }
+
+    // Remaining 0-7 pixels
+    sumRowTenBitScalar(row + x * 4, width - x, sums);
+}
+
+//----------------------------------------------------------------------
+// downsampleSSE2
+//----------------------------------------------------------------------
+// Eight input pixels of each row per iteration. Bytes are widened to
+// 16 bits, the two rows added, then the two pixels held in each half
+// register added, which leaves four output pixels ready to round and
+// pack back to bytes.
+//----------------------------------------------------------------------
+RGBS_TARGET_SSE2
+void downsampleSSE2(const uint8_t* row0, const uint8_t* row1, int outWidth, uint8_t* out) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+
+    // Sum of two vertically adjacent pixel pairs -> two output pixels
+    auto pairSums = [&](__m128i a, __m128i b) {
+        const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        const __m128i sumLo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        const __m128i sumHi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+        return _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sumLo, sumHi), two), 2);
+    };
+
+    int x = 0;
+    for (; x + 4 <= outWidth; x += 4) {
+        const uint8_t* a = row0 + x * 8;
+        const uint8_t* b = row1 + x * 8;
+        const __m128i p0 = pairSums(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)),
+                                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+        const __m128i p1 = pairSums(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16)),
+                                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(p0, p1));
+    }
+
+    // Remaining 0-3 output pixels
+    downsampleScalar(row0 + x * 8, row1 + x * 8, outWidth - x, out + x * 4);
+}
+
+//----------------------------------------------------------------------
+// columnSumSSE2
+//----------------------------------------------------------------------
+// Sixteen bytes of every row per iteration, widened to 16 bits in their
+// original order and added in registers, so the totals are loaded and
+// stored once per call rather than once per row.
+//----------------------------------------------------------------------
+RGBS_TARGET_SSE2
+void columnSumSSE2(const uint8_t* rows, size_t pitch, int rowCount, int bytes, uint16_t* sums,
+                   bool accumulate) {
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i* out = reinterpret_cast<__m128i*>(sums + i);
+        __m128i lo = accumulate ? _mm_loadu_si128(out) : zero;
+        __m128i hi = accumulate ? _mm_loadu_si128(out + 1) : zero;
+        for (int r = 0; r < rowCount; ++r) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows + r * pitch + i));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+        }
+        _mm_storeu_si128(out, lo);
+        _mm_storeu_si128(out + 1, hi);
+    }
+
+    // Remaining 0-15 bytes
+    columnSumScalar(rows + i, pitch, rowCount, bytes - i, sums + i, accumulate);
+}
+
+//----------------------------------------------------------------------
+// blockMeanSSE2
+//----------------------------------------------------------------------
+// Two pixels of column totals per register. As many registers as the
+// 16-bit lanes allow (`256 / block`) are added before widening to 32
+// bits, which leaves one pixel per half; the rounded mean is packed
+// back to bytes. A row of blocks cannot overflow the 32-bit totals.
+//----------------------------------------------------------------------
+template <int Shift>
+RGBS_TARGET_SSE2
+void blockMeanSSE2T(const uint16_t* sums, int outWidth, uint8_t* out, uint64_t totals[4]) {
+    constexpr int kBlock = 1 << Shift;
+    constexpr int kVectors = kBlock / 2;
+    constexpr int kGroup = (std::min)(kVectors, 256 / kBlock);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32((1 << (2 * Shift)) >> 1);
+    __m128i total = zero;
+    for (int x = 0; x < outWidth; ++x) {
+        const __m128i* px = reinterpret_cast<const __m128i*>(sums) + static_cast<size_t>(x) * kVectors;
+        __m128i acc = zero;
+        for (int v = 0; v < kVectors; v += kGroup) {
+            __m128i g = _mm_loadu_si128(px + v);
+            for (int i = 1; i < kGroup; ++i)
+                g = _mm_add_epi16(g, _mm_loadu_si128(px + v + i));
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_unpacklo_epi16(g, zero), _mm_unpackhi_epi16(g, zero)));
+        }
+        total = _mm_add_epi32(total, acc);
+        const __m128i mean = _mm_srli_epi32(_mm_add_epi32(acc, round), 2 * Shift);
+        const int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(mean, mean), zero));
+        std::memcpy(out + x * 4, &bytes, 4);
+    }
+
+    alignas(16) uint32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+    for (int c = 0; c < 4; ++c)
+        totals[c] += lanes[c];
+}
+
+void blockMeanSSE2(const uint16_t* sums, int outWidth, int shift, uint8_t* out, uint64_t totals[4]) {
+    withShift(shift, [&](auto s) { blockMeanSSE2T<decltype(s)::value>(sums, outWidth, out, totals); });
+}
+
+//----------------------------------------------------------------------
+// columnSumAVX2
+//----------------------------------------------------------------------
+// Thirty-two bytes of every row per iteration. `vpmovzxbw` widens each
+// 16-byte half in order, so the totals keep the layout of the row
+// (the in-lane unpacks of AVX2 would interleave them).
+//----------------------------------------------------------------------
+RGBS_TARGET_AVX2
+void columnSumAVX2(const uint8_t* rows, size_t pitch, int rowCount, int bytes, uint16_t* sums,
+                   bool accumulate) {
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i* out = reinterpret_cast<__m256i*>(sums + i);
+        __m256i lo = accumulate ? _mm256_loadu_si256(out) : zero;
+        __m256i hi = accumulate ? _mm256_loadu_si256(out + 1) : zero;
+        for (int r = 0; r < rowCount; ++r) {
+            const __m128i* v = reinterpret_cast<const __m128i*>(rows + r * pitch + i);
+            lo = _mm256_add_epi16(lo, _mm256_cvtepu8_epi16(_mm_loadu_si128(v)));
+            hi = _mm256_add_epi16(hi, _mm256_cvtepu8_epi16(_mm_loadu_si128(v + 1)));
+        }
+        _mm256_storeu_si256(out, lo);
+        _mm256_storeu_si256(out + 1, hi);
+    }
+
+    // Remaining 0-31 bytes
+    columnSumScalar(rows + i, pitch, rowCount, bytes - i, sums + i, accumulate);
+}
+
+//----------------------------------------------------------------------
+// blockMeanAVX2
+//----------------------------------------------------------------------
+// Same scheme as the SSE2 kernel with four pixels per register; blocks
+// of two pixels use the SSE2 kernel. Blocks of up to 16x16 pixels total
+// at most 65280 per byte, so four blocks at a time are reduced, rounded
+// and packed without leaving 16 bits; only the frame totals widen.
+//----------------------------------------------------------------------
+template <int Shift>
+RGBS_TARGET_AVX2
+void blockMeanAVX2T(const uint16_t* sums, int outWidth, uint8_t* out, uint64_t totals[4]) {
+    constexpr int kBlock = 1 << Shift;
+    if constexpr (kBlock < 4) {
+        blockMeanSSE2T<Shift>(sums, outWidth, out, totals);
+    } else {
+        constexpr int kVectors = kBlock / 4;
+        constexpr int kGroup = (std::min)(kVectors, 256 / kBlock);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i total = zero;
+        int x = 0;
+
+        if constexpr (kBlock <= 16) {
+            const __m256i round = _mm256_set1_epi16(static_cast<short>((1 << (2 * Shift)) >> 1));
+            __m256i total8 = _mm256_setzero_si256();
+            for (; x + 4 <= outWidth; x += 4) {
+                // Four pixels per block in 64-bit lanes: add pairs across
+                // two blocks, then the two 128-bit halves
+                const __m256i* px = reinterpret_cast<const __m256i*>(sums) + static_cast<size_t>(x) * kVectors;
+                __m256i g[4];
+                for (int b = 0; b < 4; ++b) {
+                    g[b] = _mm256_loadu_si256(px + b * kVectors);
+                    for (int i = 1; i < kVectors; ++i)
+                        g[b] = _mm256_add_epi16(g[b], _mm256_loadu_si256(px + b * kVectors + i));
+                }
+                const __m256i t01 = _mm256_add_epi16(_mm256_unpacklo_epi64(g[0], g[1]),
+                                                     _mm256_unpackhi_epi64(g[0], g[1]));
+                const __m256i t23 = _mm256_add_epi16(_mm256_unpacklo_epi64(g[2], g[3]),
+                                                     _mm256_unpackhi_epi64(g[2], g[3]));
+                const __m256i sum = _mm256_add_epi16(_mm256_permute2x128_si256(t01, t23, 0x20),
+                                                     _mm256_permute2x128_si256(t01, t23, 0x31));
+                total8 = _mm256_add_epi32(total8, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(sum)));
+                total8 = _mm256_add_epi32(total8, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(sum, 1)));
+                const __m256i mean = _mm256_srli_epi16(_mm256_add_epi16(sum, round), 2 * Shift);
+                const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(mean, mean), 0x08);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm256_castsi256_si128(packed));
+            }
+            total = _mm_add_epi32(_mm256_castsi256_si128(total8), _mm256_extracti128_si256(total8, 1));
+        }
+
+        const __m128i round = _mm_set1_epi32((1 << (2 * Shift)) >> 1);
+        for (; x < outWidth; ++x) {
+            const __m256i* px = reinterpret_cast<const __m256i*>(sums) + static_cast<size_t>(x) * kVectors;
+            __m256i acc = _mm256_setzero_si256();
+            for (int v = 0; v < kVectors; v += kGroup) {
+                __m256i g = _mm256_loadu_si256(px + v);
+                for (int i = 1; i < kGroup; ++i)
+                    g = _mm256_add_epi16(g, _mm256_loadu_si256(px + v + i));
+                acc = _mm256_add_epi32(acc, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(g)));
+                acc = _mm256_add_epi32(acc, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(g, 1)));
+            }
+            const __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            total = _mm_add_epi32(total, sum);
+            const __m128i mean = _mm_srli_epi32(_mm_add_epi32(sum, round), 2 * Shift);
+            const int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(mean, mean), zero));
+            std::memcpy(out + x * 4, &bytes, 4);
+        }
+
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+        for (int c = 0; c < 4; ++c)
+            totals[c] += lanes[c];
+    }
+}
+
+void blockMeanAVX2(const uint16_t* sums, int outWidth, int shift, uint8_t* out, uint64_t totals[4]) {
+    withShift(shift, [&](auto s) { blockMeanAVX2T<decltype(s)::value>(sums, outWidth, out, totals); });
+}
+
+//----------------------------------------------------------------------
+// bytesDifferSSE2
+//----------------------------------------------------------------------
+// Sixteen bytes per iteration: the two saturating differences OR-ed give
+// |a - b|, and subtracting the threshold with saturation leaves non-zero
+// bytes only where it was exceeded.
+//----------------------------------------------------------------------
+RGBS_TARGET_SSE2
+bool bytesDifferSSE2(const uint8_t* a, const uint8_t* b, size_t size, uint8_t threshold) {
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        const __m128i delta = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        const __m128i over = _mm_subs_epu8(delta, limit);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(over, zero)) != 0xFFFF)
+            return true;
+    }
+
+    // Remaining 0-15 bytes
+    return bytesDifferScalar(a + i, b + i, size - i, threshold);
+}
+
+//----------------------------------------------------------------------
+// cpuSupports
+//----------------------------------------------------------------------
+// Query CPUID for SSE2/AVX2/AVX-512. AVX2 additionally requires the OS
+// to save the YMM registers on context switches (OSXSAVE + XCR0), and
+// AVX-512 the ZMM and mask registers as well.
+//----------------------------------------------------------------------
+bool cpuSupports(KernelIsa isa) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 1);
+    if (isa == KernelIsa::SSE2)
+        return (info[3] & (1 << 26)) != 0;
+    if (isa == KernelIsa::AVX2) {
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+    if (isa == KernelIsa::AVX512) {
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0xE6) != 0xE6)
+            return false;
+        __cpuidex(info, 7, 0);
+        const bool foundation = (info[1] & (1 << 16)) != 0;
+        const bool bw = (info[1] & (1 << 30)) != 0;
+        const bool vbmi = (info[2] & (1 << 1)) != 0;
+        return foundation && bw && vbmi;
+    }
+    return false;
+#else
+    __builtin_cpu_init();
+    if (isa == KernelIsa::SSE2)
+        return __builtin_cpu_supports("sse2");
+    if (isa == KernelIsa::AVX2)
+        return __builtin_cpu_supports("avx2");
+    if (isa == KernelIsa::AVX512) {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+               __builtin_cpu_supports("avx512vbmi");
+    }
+    return false;
+#endif
+}
+#endif // RGBS_ARCH_X86
+
+#if defined(RGBS_ARCH_ARM64)
+//----------------------------------------------------------------------
+// sumRowNEON
+//----------------------------------------------------------------------
+// `vld4q_u8` de-interleaves sixteen pixels into one register per byte
+// lane; pairwise widening adds fold them into 32-bit accumulators. A
+// 32-bit lane grows by at most 1020 per iteration, which leaves room for
+// rows of several million pixels.
+//----------------------------------------------------------------------
+void sumRowNEON(const uint8_t* row, int width, uint64_t sums[3]) {
+    uint32x4_t acc0 = vdupq_n_u32(0);
+    uint32x4_t acc1 = vdupq_n_u32(0);
+    uint32x4_t acc2 = vdupq_n_u32(0);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16x4_t px = vld4q_u8(row + x * 4);
+        acc0 = vpadalq_u16(acc0, vpaddlq_u8(px.val[0]));
+        acc1 = vpadalq_u16(acc1, vpaddlq_u8(px.val[1]));
+        acc2 = vpadalq_u16(acc2, vpaddlq_u8(px.val[2]));
+    }
+    sums[0] += vaddvq_u32(acc0);
+    sums[1] += vaddvq_u32(acc1);
+    sums[2] += vaddvq_u32(acc2);
+
+    // Remaining 0-15 pixels
+    sumRowScalar(row + x * 4, width - x, sums);
+}
+
+//----------------------------------------------------------------------
+// sumRowTableNEON
+//----------------------------------------------------------------------
+// `vld2q_u8` splits the table into its low and high bytes, four 64-byte
+// tables each. Sixteen pixels are de-interleaved per channel and every
+// index is looked up in the four tables in turn with `vqtbx4q_u8`, which
+// leaves lanes whose rebased index is out of range untouched. The low
+// and high byte sums are combined at the end of the row.
+//----------------------------------------------------------------------
+void sumRowTableNEON(const uint8_t* row, int width, const uint16_t* table, uint64_t sums[3]) {
+    uint8x16x4_t low[4], high[4];
+    for (int i = 0; i < 16; ++i) {
+        const uint8x16x2_t entries = vld2q_u8(reinterpret_cast<const uint8_t*>(table + i * 16));
+        low[i / 4].val[i % 4] = entries.val[0];
+        high[i / 4].val[i % 4] = entries.val[1];
+    }
+    const uint8x16_t quarter = vdupq_n_u8(64);
+    uint32x4_t accLow[3], accHigh[3];
+    for (int c = 0; c < 3; ++c)
+        accLow[c] = accHigh[c] = vdupq_n_u32(0);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16x4_t px = vld4q_u8(row + x * 4);
+        for (int c = 0; c < 3; ++c) {
+            const uint8x16_t i0 = px.val[c];
+            const uint8x16_t i1 = vsubq_u8(i0, quarter);
+            const uint8x16_t i2 = vsubq_u8(i1, quarter);
+            const uint8x16_t i3 = vsubq_u8(i2, quarter);
+            uint8x16_t lo = vqtbl4q_u8(low[0], i0);
+            lo = vqtbx4q_u8(lo, low[1], i1);
+            lo = vqtbx4q_u8(lo, low[2], i2);
+            lo = vqtbx4q_u8(lo, low[3], i3);
+            uint8x16_t hi = vqtbl4q_u8(high[0], i0);
+            hi = vqtbx4q_u8(hi, high[1], i1);
+            hi = vqtbx4q_u8(hi, high[2], i2);
+            hi = vqtbx4q_u8(hi, high[3], i3);
+            accLow[c] = vpadalq_u16(accLow[c], vpaddlq_u8(lo));
+            accHigh[c] = vpadalq_u16(accHigh[c], vpaddlq_u8(hi));
+        }
+    }
+    for (int c = 0; c < 3; ++c)
+        sums[c] += vaddlvq_u32(accLow[c]) + (vaddlvq_u32(accHigh[c]) << 8);
+
+    // Remaining 0-15 pixels
+    sumRowTableScalar(row + x * 4, width - x, table, sums);
+}
+
+//----------------------------------------------------------------------
+// sumRowTenBitNEON
+//----------------------------------------------------------------------
+// Four pixels per load, like the SSE2 kernel.
+//----------------------------------------------------------------------
+void sumRowTenBitNEON(const uint8_t* row, int width, uint64_t sums[3]) {
+    const uint32x4_t mask = vdupq_n_u32(0x3FF);
+    uint32x4_t acc0 = vdupq_n_u32(0);
+    uint32x4_t acc1 = vdupq_n_u32(0);
+    uint32x4_t acc2 = vdupq_n_u32(0);
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const uint32x4_t px = vld1q_u32(reinterpret_cast<const uint32_t*>(row + x * 4));
+        acc0 = vaddq_u32(acc0, vandq_u32(px, mask));
+        acc1 = vaddq_u32(acc1, vandq_u32(vshrq_n_u32(px, 10), mask));
+        acc2 = vaddq_u32(acc2, vandq_u32(vshrq_n_u32(px, 20), mask));
+    }
+    sums[0] += vaddlvq_u32(acc0);
+    sums[1] += vaddlvq_u32(acc1);
+    sums[2] += vaddlvq_u32(acc2);
+
+    // Remaining 0-3 pixels
+    sumRowTenBitScalar(row + x * 4, width - x, sums);
+}
+
+//----------------------------------------------------------------------
+// downsampleNEON
+//----------------------------------------------------------------------
+// Four input pixels of each row per iteration. Widening adds combine the
+// rows, the two halves of each sum combine horizontal neighbours and a
+// rounding narrowing shift divides by four.
+//----------------------------------------------------------------------
+void downsampleNEON(const uint8_t* row0, const uint8_t* row1, int outWidth, uint8_t* out) {
+    int x = 0;
+    for (; x + 2 <= outWidth; x += 2) {
+        const uint8x16_t a = vld1q_u8(row0 + x * 8);
+        const uint8x16_t b = vld1q_u8(row1 + x * 8);
+        const uint16x8_t lo = vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+        const uint16x8_t hi = vaddl_u8(vget_high_u8(a), vget_high_u8(b));
+        const uint16x4_t out0 = vadd_u16(vget_low_u16(lo), vget_high_u16(lo));
+        const uint16x4_t out1 = vadd_u16(vget_low_u16(hi), vget_high_u16(hi));
+        vst1_u8(out + x * 4, vrshrn_n_u16(vcombine_u16(out0, out1), 2));
+    }
+
+    // Remaining output pixel
+    downsampleScalar(row0 + x * 8, row1 + x * 8, outWidth - x, out + x * 4);
+}
+
+//----------------------------------------------------------------------
+// columnSumNEON / blockMeanNEON
+//----------------------------------------------------------------------
+// Sixteen bytes of every row per iteration with widening adds, as in
+// the SSE2 kernels.
+//----------------------------------------------------------------------
+void columnSumNEON(const uint8_t* rows, size_t pitch, int rowCount, int bytes, uint16_t* sums,
+                   bool accumulate) {
+    int i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        uint16x8_t lo = accumulate ? vld1q_u16(sums + i) : vdupq_n_u16(0);
+        uint16x8_t hi = accumulate ? vld1q_u16(sums + i + 8) : vdupq_n_u16(0);
+        for (int r = 0; r < rowCount; ++r) {
+            const uint8x16_t v = vld1q_u8(rows + r * pitch + i);
+            lo = vaddw_u8(lo, vget_low_u8(v));
+            hi = vaddw_u8(hi, vget_high_u8(v));
+        }
+        vst1q_u16(sums + i, lo);
+        vst1q_u16(sums + i + 8, hi);
+    }
+
+    // Remaining 0-15 bytes
+    columnSumScalar(rows + i, pitch, rowCount, bytes - i, sums + i, accumulate);
+}
+
+template <int Shift>
+void blockMeanNEONT(const uint16_t* sums, int outWidth, uint8_t* out, uint64_t totals[4]) {
+    constexpr int kBlock = 1 << Shift;
+    constexpr int kVectors = kBlock / 2;
+    constexpr int kGroup = (std::min)(kVectors, 256 / kBlock);
+    const uint32x4_t round = vdupq_n_u32((1u << (2 * Shift)) >> 1);
+    uint32x4_t total = vdupq_n_u32(0);
+    for (int x = 0; x < outWidth; ++x) {
+        const uint16_t* px = sums + static_cast<size_t>(x) * kBlock * 4;
+        uint32x4_t acc = vdupq_n_u32(0);
+        for (int v = 0; v < kVectors; v += kGroup) {
+            uint16x8_t g = vld1q_u16(px + v * 8);
+            for (int i = 1; i < kGroup; ++i)
+                g = vaddq_u16(g, vld1q_u16(px + (v + i) * 8));
+            acc = vaddw_u16(vaddw_u16(acc, vget_low_u16(g)), vget_high_u16(g));
+        }
+        total = vaddq_u32(total, acc);
+        const uint16x4_t mean = vmovn_u32(vshrq_n_u32(vaddq_u32(acc, round), 2 * Shift));
+        const uint32_t bytes = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(mean, mean))), 0);
+        std::memcpy(out + x * 4, &bytes, 4);
+    }
+
+    uint32_t lanes[4];
+    vst1q_u32(lanes, total);
+    for (int c = 0; c < 4; ++c)
+        totals[c] += lanes[c];
+}
+
+void blockMeanNEON(const uint16_t* sums, int outWidth, int shift, uint8_t* out, uint64_t totals[4]) {
+    withShift(shift, [&](auto s) { blockMeanNEONT<decltype(s)::value>(sums, outWidth, out, totals); });
+}
+
+//----------------------------------------------------------------------
+// bytesDifferNEON
+//----------------------------------------------------------------------
+bool bytesDifferNEON(const uint8_t* a, const uint8_t* b, size_t size, uint8_t threshold) {
+    const uint8x16_t limit = vdupq_n_u8(threshold);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const uint8x16_t delta = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        if (vmaxvq_u8(vcgtq_u8(delta, limit)) != 0)
+            return true;
+    }
+
+    // Remaining 0-15 bytes
+    return bytesDifferScalar(a + i, b + i, size - i, threshold);
+}
+#endif // RGBS_ARCH_ARM64
+
+} // namespace
+
+//----------------------------------------------------------------------
+// detectKernelIsa
+//----------------------------------------------------------------------
+// Pick the widest instruction set available on this CPU.
+//----------------------------------------------------------------------
+KernelIsa detectKernelIsa() {
+#if defined(RGBS_ARCH_X86)
+    if (cpuSupports(KernelIsa::AVX512))
+        return KernelIsa::AVX512;
+    if (cpuSupports(KernelIsa::AVX2))
+        return KernelIsa::AVX2;
+    if (cpuSupports(KernelIsa::SSE2))
+        return KernelIsa::SSE2;
+#elif defined(RGBS_ARCH_ARM64)
+    return KernelIsa::NEON;
+#endif
+    return KernelIsa::Scalar;
+}
+
+//----------------------------------------------------------------------
+// kernelIsaName
+//----------------------------------------------------------------------
+const char* kernelIsaName(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar: return "Scalar";
+        case KernelIsa::SSE2:   return "SSE2";
+        case KernelIsa::AVX2:   return "AVX2";
+        case KernelIsa::NEON:   return "NEON";
+        case KernelIsa::AVX512: return "AVX-512";
+    }
+    return "Unknown";
+}
+
+//----------------------------------------------------------------------
+// rowSumKernel
+//----------------------------------------------------------------------
+// Return the kernel for an instruction set, or nullptr when it cannot
+// run here.
+//----------------------------------------------------------------------
+RowSumKernel rowSumKernel(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return sumRowScalar;
+#if defined(RGBS_ARCH_X86)
+        case KernelIsa::SSE2:
+            return cpuSupports(isa) ? sumRowSSE2 : nullptr;
+        case KernelIsa::AVX2:
+        case KernelIsa::AVX512:
+            return cpuSupports(isa) ? sumRowAVX2 : nullptr;
+#endif
+#if defined(RGBS_ARCH_ARM64)
+        case KernelIsa::NEON:
+            return sumRowNEON;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+//----------------------------------------------------------------------
+// activeRowSumKernel
+//----------------------------------------------------------------------
+// The dispatch decision is made once; afterwards this is a plain load.
+//----------------------------------------------------------------------
+RowSumKernel activeRowSumKernel() {
+    static const RowSumKernel kernel = rowSumKernel(detectKernelIsa());
+    return kernel;
+}
+
+//----------------------------------------------------------------------
+// tableRowSumKernel
+//----------------------------------------------------------------------
+TableRowSumKernel tableRowSumKernel(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return sumRowTableScalar;
+#if defined(RGBS_ARCH_X86)
+        case KernelIsa::SSE2:
+            return cpuSupports(isa) ? sumRowTableScalar : nullptr;
+        case KernelIsa::AVX2:
+            return cpuSupports(isa) ? sumRowTableAVX2 : nullptr;
+        case KernelIsa::AVX512:
+            return cpuSupports(isa) ? sumRowTableAVX512 : nullptr;
+#endif
+#if defined(RGBS_ARCH_ARM64)
+        case KernelIsa::NEON:
+            return sumRowTableNEON;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+//----------------------------------------------------------------------
+// activeTableRowSumKernel
+//----------------------------------------------------------------------
+TableRowSumKernel activeTableRowSumKernel() {
+    static const TableRowSumKernel kernel = tableRowSumKernel(detectKernelIsa());
+    return kernel;
+}
+
+//----------------------------------------------------------------------
+// tenBitRowSumKernel
+//----------------------------------------------------------------------
+TenBitRowSumKernel tenBitRowSumKernel(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return sumRowTenBitScalar;
+#if defined(RGBS_ARCH_X86)
+        case KernelIsa::SSE2:
+            return cpuSupports(isa) ? sumRowTenBitSSE2 : nullptr;
+        case KernelIsa::AVX2:
+        case KernelIsa::AVX512:
+            return cpuSupports(isa) ? sumRowTenBitAVX2 : nullptr;
+#endif
+#if defined(RGBS_ARCH_ARM64)
+        case KernelIsa::NEON:
+            return sumRowTenBitNEON;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+//----------------------------------------------------------------------
+// activeTenBitRowSumKernel
+//----------------------------------------------------------------------
+TenBitRowSumKernel activeTenBitRowSumKernel() {
+    static const TenBitRowSumKernel kernel = tenBitRowSumKernel(detectKernelIsa());
+    return kernel;
+}
+
+//----------------------------------------------------------------------
+// downsampleKernel
+//----------------------------------------------------------------------
+DownsampleKernel downsampleKernel(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return downsampleScalar;
+#if defined(RGBS_ARCH_X86)
+        case KernelIsa::SSE2:
+        case KernelIsa::AVX2:
+        case KernelIsa::AVX512:
+            return cpuSupports(isa) ? downsampleSSE2 : nullptr;
+#endif
+#if defined(RGBS_ARCH_ARM64)
+        case KernelIsa::NEON:
+            return downsampleNEON;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+//----------------------------------------------------------------------
+// activeDownsampleKernel
+//----------------------------------------------------------------------
+DownsampleKernel activeDownsampleKernel() {
+    static const DownsampleKernel kernel = downsampleKernel(detectKernelIsa());
+    return kernel;
+}
+
+//----------------------------------------------------------------------
+// columnSumKernel
+//----------------------------------------------------------------------
+ColumnSumKernel columnSumKernel(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return columnSumScalar;
+#if defined(RGBS_ARCH_X86)
+        case KernelIsa::SSE2:
+            return cpuSupports(isa) ? columnSumSSE2 : nullptr;
+        case KernelIsa::AVX2:
+        case KernelIsa::AVX512:
+            return cpuSupports(isa) ? columnSumAVX2 : nullptr;
+#endif
+#if defined(RGBS_ARCH_ARM64)
+        case KernelIsa::NEON:
+            return columnSumNEON;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+//----------------------------------------------------------------------
+// activeColumnSumKernel
+//----------------------------------------------------------------------
+ColumnSumKernel activeColumnSumKernel() {
+    static const ColumnSumKernel kernel = columnSumKernel(detectKernelIsa());
+    return kernel;
+}
+
+//----------------------------------------------------------------------
+// blockMeanKernel
+//----------------------------------------------------------------------
+BlockMeanKernel blockMeanKernel(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return blockMeanScalar;
+#if defined(RGBS_ARCH_X86)
+        case KernelIsa::SSE2:
+            return cpuSupports(isa) ? blockMeanSSE2 : nullptr;
+        case KernelIsa::AVX2:
+        case KernelIsa::AVX512:
+            return cpuSupports(isa) ? blockMeanAVX2 : nullptr;
+#endif
+#if defined(RGBS_ARCH_ARM64)
+        case KernelIsa::NEON:
+            return blockMeanNEON;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+//----------------------------------------------------------------------
+// activeBlockMeanKernel
+//----------------------------------------------------------------------
+BlockMeanKernel activeBlockMeanKernel() {
+    static const BlockMeanKernel kernel = blockMeanKernel(detectKernelIsa());
+    return kernel;
+}
+
+//----------------------------------------------------------------------
+// bytesDifferKernel
+//----------------------------------------------------------------------
+BytesDifferKernel bytesDifferKernel(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return bytesDifferScalar;
+#if defined(RGBS_ARCH_X86)
+        case KernelIsa::SSE2:
+        case KernelIsa::AVX2:
+        case KernelIsa::AVX512:
+            return cpuSupports(isa) ? bytesDifferSSE2 : nullptr;
+#endif
+#if defined(RGBS_ARCH_ARM64)
+        case KernelIsa::NEON:
+            return bytesDifferNEON;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+//----------------------------------------------------------------------
+// activeBytesDifferKernel
+//----------------------------------------------------------------------
+BytesDifferKernel activeBytesDifferKernel() {
+    static const BytesDifferKernel kernel = bytesDifferKernel(detectKernelIsa());
+    return kernel;
+}
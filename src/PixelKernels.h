@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Instruction set used by a pixel kernel.
+ */
+enum class KernelIsa {
+    Scalar, ///< Portable C++ implementation
+    SSE2,   ///< x86 SSE2 (`_mm_sad_epu8` horizontal sums)
+    AVX2,   ///< x86 AVX2 (`_mm256_sad_epu8` horizontal sums)
+    NEON,   ///< AArch64 Advanced SIMD
+    AVX512, ///< x86 AVX-512 BW + VBMI (`vpermi2b` byte tables)
+};
+
+/**
+ * Accumulate the first three bytes of every 4-byte pixel in a row.
+ *
+ * `sums[i]` receives the sum of byte `i` of each pixel. The kernels do not
+ * know about channel order; callers map byte lanes to R, G and B once per
+ * frame instead of once per pixel.
+ *
+ * @param row   First pixel of the row.
+ * @param width Number of pixels in the row.
+ * @param sums  Running totals that the row is added to.
+ */
+using RowSumKernel = void (*)(const uint8_t* row, int width, uint64_t sums[3]);
+
+/**
+ * Best instruction set supported by the running CPU and the current build.
+ */
+KernelIsa detectKernelIsa();
+
+/**
+ * Human readable name of an instruction set, e.g. "AVX2".
+ */
+const char* kernelIsaName(KernelIsa isa);
+
+/**
+ * Row sum kernel for a specific instruction set.
+ *
+ * Only the table row sums have an AVX-512 kernel; the other kernel
+ * families map AVX-512 to their AVX2 kernel.
+ *
+ * @return The requested kernel, or `nullptr` if it is not compiled into
+ *         this build or not supported by the running CPU.
+ */
+RowSumKernel rowSumKernel(KernelIsa isa);
+
+/**
+ * Row sum kernel selected once at startup from `detectKernelIsa()`.
+ */
+RowSumKernel activeRowSumKernel();
+
+/**
+ * Accumulate `table[byte]` for the first three bytes of every 4-byte
+ * pixel in a row.
+ *
+ * Used to average 8-bit frames in linear light: `table` maps sRGB codes
+ * to linear values. Like `RowSumKernel`, the kernel works on byte lanes.
+ *
+ * @param row   First pixel of the row.
+ * @param width Number of pixels in the row.
+ * @param table 256 entries plus one padding entry (see `linearLightTable()`).
+ * @param sums  Running totals that the row is added to.
+ */
+using TableRowSumKernel = void (*)(const uint8_t* row, int width, const uint16_t* table,
+                                   uint64_t sums[3]);
+
+/**
+ * Table row sum kernel for an instruction set, or `nullptr` if it is not
+ * available. AVX-512 and NEON keep the table in registers and look bytes
+ * up sixteen or more at a time; AVX2 uses 32-bit gathers and SSE2 maps
+ * to Scalar.
+ */
+TableRowSumKernel tableRowSumKernel(KernelIsa isa);
+
+/**
+ * Table row sum kernel selected once at startup.
+ */
+TableRowSumKernel activeTableRowSumKernel();
+
+/**
+ * Accumulate the three 10-bit fields (bits 0-9, 10-19 and 20-29) of
+ * every 32-bit pixel in a row, e.g. R, G and B of RGB10A2.
+ *
+ * @param row   First pixel of the row.
+ * @param width Number of pixels in the row, at most 4 million.
+ * @param sums  Running totals that the row is added to.
+ */
+using TenBitRowSumKernel = void (*)(const uint8_t* row, int width, uint64_t sums[3]);
+
+/**
+ * 10-bit row sum kernel for an instruction set, or `nullptr` if it is not
+ * available.
+ */
+TenBitRowSumKernel tenBitRowSumKernel(KernelIsa isa);
+
+/**
+ * 10-bit row sum kernel selected once at startup.
+ */
+TenBitRowSumKernel activeTenBitRowSumKernel();
+
+/**
+ * Halve a pair of rows with a 2x2 box filter.
+ *
+ * Output pixel `x` is the rounded mean of input pixels `2x` and `2x+1`
+ * of both rows, computed per byte (all four channels). Works for any
+ * 4-byte pixel format.
+ *
+ * @param row0     First input row, at least `2 * outWidth` pixels.
+ * @param row1     Second input row, at least `2 * outWidth` pixels.
+ * @param outWidth Number of output pixels.
+ * @param out      Output row.
+ */
+using DownsampleKernel = void (*)(const uint8_t* row0, const uint8_t* row1, int outWidth,
+                                  uint8_t* out);
+
+/**
+ * 2x2 box filter kernel for an instruction set, or `nullptr` if it is not
+ * available. AVX2 has no dedicated kernel and maps to SSE2.
+ */
+DownsampleKernel downsampleKernel(KernelIsa isa);
+
+/**
+ * 2x2 box filter kernel selected once at startup.
+ */
+DownsampleKernel activeDownsampleKernel();
+
+/**
+ * Add `rowCount` rows byte by byte to 16-bit column totals:
+ * `sums[i] = rows[i] + rows[pitch + i] + ...`, plus the previous
+ * `sums[i]` if `accumulate` is set.
+ *
+ * Summing the rows of a block a few at a time this way reads every byte
+ * of a frame exactly once; 16 bits hold the totals of up to 256 rows.
+ *
+ * @param rows       First row.
+ * @param pitch      Bytes from one row to the next.
+ * @param rowCount   Rows to add, at least 1.
+ * @param bytes      Bytes in each row.
+ * @param sums       Column totals, `bytes` entries.
+ * @param accumulate Add to `sums` instead of overwriting it.
+ */
+using ColumnSumKernel = void (*)(const uint8_t* rows, size_t pitch, int rowCount, int bytes,
+                                 uint16_t* sums, bool accumulate);
+
+/**
+ * Column sum kernel for an instruction set, or `nullptr` if it is not
+ * available.
+ */
+ColumnSumKernel columnSumKernel(KernelIsa isa);
+
+/**
+ * Column sum kernel selected once at startup.
+ */
+ColumnSumKernel activeColumnSumKernel();
+
+/**
+ * Turn 16-bit column totals of 4-byte pixels into block means.
+ *
+ * Output pixel `x` is the rounded mean of the `block x block` pixels
+ * whose column totals are pixels `x * block ... x * block + block - 1`
+ * of `sums`, per byte (all four channels), with `block = 1 << shift`.
+ * The exact block totals are added to `totals`, so the frame sum comes
+ * out of the same pass.
+ *
+ * @param sums     Column totals of `block` rows (see `ColumnSumKernel`).
+ * @param outWidth Number of blocks, at most 16384 / `block`.
+ * @param shift    log2 of the block size, 1-8.
+ * @param out      Output row, `outWidth` pixels.
+ * @param totals   Running totals per byte lane that the blocks are added to.
+ */
+using BlockMeanKernel = void (*)(const uint16_t* sums, int outWidth, int shift, uint8_t* out,
+                                 uint64_t totals[4]);
+
+/**
+ * Block mean kernel for an instruction set, or `nullptr` if it is not
+ * available.
+ */
+BlockMeanKernel blockMeanKernel(KernelIsa isa);
+
+/**
+ * Block mean kernel selected once at startup.
+ */
+BlockMeanKernel activeBlockMeanKernel();
+
+/**
+ * Whether any byte of `a` differs from the same byte of `b` by more than
+ * `threshold`.
+ *
+ * @param a         First buffer.
+ * @param b         Second buffer.
+ * @param size      Bytes in each buffer.
+ * @param threshold Largest difference that still counts as equal.
+ */
+using BytesDifferKernel = bool (*)(const uint8_t* a, const uint8_t* b, size_t size,
+                                   uint8_t threshold);
+
+/**
+ * Byte comparison kernel for an instruction set, or `nullptr` if it is
+ * not available. AVX2 has no dedicated kernel and maps to SSE2.
+ */
+BytesDifferKernel bytesDifferKernel(KernelIsa isa);
+
+/**
+ * Byte comparison kernel selected once at startup.
+ */
+BytesDifferKernel activeBytesDifferKernel();
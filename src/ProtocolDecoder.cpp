@@ -0,0 +1,100 @@
+#include "ProtocolDecoder.h"
+
+#include <cstring>
+
+//----------------------------------------------------------------------
+// decodePackets
+//----------------------------------------------------------------------
+// Packets are checked in order; the first mismatch ends the decode.
+//----------------------------------------------------------------------
+bool decodePackets(WireProtocol protocol, const ProtocolOptions& options,
+                   const std::vector<PacketView>& packets, std::vector<Rgb8>& pixels,
+                   int& sequence, std::string& error) {
+    auto be16 = [](const uint8_t* p) { return (p[0] << 8) | p[1]; };
+    auto fail = [&](const std::string& what, size_t packet) {
+        error = what + " in packet " + std::to_string(packet);
+        return false;
+    };
+    pixels.clear();
+    sequence = -1;
+    auto store = [&](size_t first, const uint8_t* data, size_t bytes) {
+        if (pixels.size() < first + bytes / 3)
+            pixels.resize(first + bytes / 3);
+        std::memcpy(pixels.data() + first, data, bytes / 3 * 3);
+    };
+
+    for (size_t i = 0; i < packets.size(); ++i) {
+        const uint8_t* p = packets[i].data;
+        const size_t n = packets[i].size;
+        int seq = -1;
+        switch (protocol) {
+            case WireProtocol::Ddp: {
+                if (n < 10 || (p[0] & 0xC0) != 0x40)
+                    return fail("bad DDP version", i);
+                if (((p[0] & 0x01) != 0) != (i + 1 == packets.size()))
+                    return fail("PUSH flag not on the last packet only", i);
+                if (p[3] != 1 || be16(p + 8) != static_cast<int>(n - 10))
+                    return fail("bad DDP destination or length", i);
+                const size_t offset = (static_cast<size_t>(be16(p + 4)) << 16) | be16(p + 6);
+                if (offset % 3 != 0)
+                    return fail("DDP offset not on a pixel", i);
+                store(offset / 3, p + 10, n - 10);
+                seq = p[1] & 0x0F;
+                break;
+            }
+            case WireProtocol::E131: {
+                if (n < 126 || be16(p) != 0x10 || std::memcmp(p + 4, "ASC-E1.17\0\0\0", 12) != 0)
+                    return fail("bad E1.31 packet identifier", i);
+                if (be16(p + 16) != static_cast<int>(0x7000 | (n - 16)) ||
+                    be16(p + 38) != static_cast<int>(0x7000 | (n - 38)) ||
+                    be16(p + 115) != static_cast<int>(0x7000 | (n - 115)))
+                    return fail("bad E1.31 PDU lengths", i);
+                if (p[21] != 4 || p[43] != 2 || p[117] != 2 || p[118] != 0xA1 || p[125] != 0)
+                    return fail("bad E1.31 vectors or start code", i);
+                if (p[108] != options.priority || be16(p + 123) != static_cast<int>(n - 125))
+                    return fail("bad E1.31 priority or property count", i);
+                const int universe = be16(p + 113);
+                if (universe != (options.universe < 0 ? 1 : options.universe) + static_cast<int>(i))
+                    return fail("universes not consecutive", i);
+                store(i * 170, p + 126, n - 126);
+                seq = p[111];
+                break;
+            }
+            case WireProtocol::ArtNet: {
+                if (n < 18 || std::memcmp(p, "Art-Net\0", 8) != 0 || p[8] != 0x00 || p[9] != 0x50 ||
+                    be16(p + 10) != 14)
+                    return fail("bad ArtDmx header", i);
+                const int length = be16(p + 16);
+                if (length % 2 != 0 || length != static_cast<int>(n - 18))
+                    return fail("bad ArtDmx length", i);
+                const int universe = p[14] | (p[15] << 8);
+                if (universe != (options.universe < 0 ? 0 : options.universe) + static_cast<int>(i))
+                    return fail("universes not consecutive", i);
+                store(i * 170, p + 18, (static_cast<size_t>(length) / 3) * 3);
+                seq = p[12];
+                break;
+            }
+            case WireProtocol::Wled:
+                if (n < 2 || p[1] != options.wledTimeout)
+                    return fail("bad WLED timeout", i);
+                if (p[0] == 2) {
+                    if (packets.size() != 1)
+                        return fail("DRGB split over several packets", i);
+                    store(0, p + 2, n - 2);
+                } else if (p[0] == 4) {
+                    store(static_cast<size_t>(be16(p + 2)), p + 4, n - 4);
+                } else {
+                    return fail("unknown WLED protocol", i);
+                }
+                break;
+            case WireProtocol::Text:
+                return fail("text is not a binary protocol", i);
+            case WireProtocol::Delta:
+                return fail("delta frames need a DeltaDecoder", i);
+        }
+        if (seq >= 0 && sequence >= 0 && seq != sequence)
+            return fail("sequence differs within a frame", i);
+        sequence = seq;
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "LedProtocol.h"
+
+/**
+ * Receiver side of the binary protocols, used to verify ProtocolEncoder.
+ *
+ * Written from the protocol specifications rather than from the encoder:
+ * checks the fixed header fields of every packet of one frame, collects
+ * the pixels at the offsets the packets claim and returns the sequence
+ * number of the frame.
+ *
+ * @param protocol Protocol the packets were encoded with; Text and Delta
+ *                 are rejected (see DeltaDecoder).
+ * @param options  Options the encoder was created with.
+ * @param packets  Packets of one frame, in order.
+ * @param pixels   Receives the decoded LED colors.
+ * @param sequence Receives the sequence number, or -1 if the protocol
+ *                 has none.
+ * @param error    Receives the first mismatch found.
+ * @return false with `error` set on any mismatch.
+ */
+bool decodePackets(WireProtocol protocol, const ProtocolOptions& options,
+                   const std::vector<PacketView>& packets, std::vector<Rgb8>& pixels,
+                   int& sequence, std::string& error);
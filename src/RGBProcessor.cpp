@@ -1,94 +1,455 @@
 #include "RGBProcessor.h"
+#include "PixelFormats.h"
+#include "PixelKernels.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <vector>
 
+namespace {
 //----------------------------------------------------------------------
-// getRGBAverage
+// LaneDecoding
 //----------------------------------------------------------------------
-// Calculate the average red, green and blue values for the provided
-// Direct3D texture. The texture must be CPU-readable (typically a
-// staging texture). If the pointer is null or the texture cannot be
-// mapped, {0,0,0} is returned.
+// How the {R,G,B} lane totals of a frame are to be read: optionally
+// through a linear-light table, with the largest value one pixel can
+// add and whether the totals are linear light.
 //----------------------------------------------------------------------
-std::array<int, 3> getRGBAverage(ID3D11Texture2D* tex) {
-    // Initialize return value to {0,0,0} in case anything fails
+struct LaneDecoding {
+    const uint16_t* table = nullptr;
+    uint32_t maxValue = 255;
+    bool linear = false;
+};
+
+LaneDecoding decodingFor(PixelFormat format, bool linearLight, double sdrWhiteNits = kScRgbWhiteNits) {
+    // Half floats are linear already and always need their table
+    if (linearLight || format == PixelFormat::RGBA16F)
+        return {linearLightTable(format, sdrWhiteNits), kLinearLightMax, true};
+    return {nullptr, format == PixelFormat::RGB10A2 ? 1023u : 255u, false};
+}
+
+//----------------------------------------------------------------------
+// averageFromLanes
+//----------------------------------------------------------------------
+// Turn {R,G,B} totals into an 8-bit sRGB average. Plain 8-bit totals
+// keep the integer division of the original path; everything else is
+// normalized and, for linear totals, encoded with the sRGB curve.
+//----------------------------------------------------------------------
+std::array<int, 3> averageFromLanes(const uint64_t lanes[3], const LaneDecoding& decoding,
+                                    uint64_t totalPixels) {
     std::array<int, 3> result{0, 0, 0};
-    if (!tex)
+    if (totalPixels == 0)
         return result;
 
-    // Obtain device and immediate context from the texture. These are
-    // needed to map the texture memory so the CPU can read it.
-    ID3D11Device* device = nullptr;
-    tex->GetDevice(&device);
-    if (!device)
-        return result;
+    for (int c = 0; c < 3; ++c) {
+        if (!decoding.linear && decoding.maxValue == 255) {
+            result[c] = static_cast<int>(lanes[c] / totalPixels);
+            continue;
+        }
+        double v = static_cast<double>(lanes[c]) / static_cast<double>(totalPixels) / decoding.maxValue;
+        if (decoding.linear)
+            v = linearToSrgb(v);
+        result[c] = (std::min)(255, static_cast<int>(v * 255.0 + 0.5));
+    }
+    return result;
+}
 
-    ID3D11DeviceContext* context = nullptr;
-    device->GetImmediateContext(&context);
-    device->Release(); // device no longer needed after acquiring context
-    if (!context)
-        return result;
+uint64_t pixelCount(const FrameView& frame) {
+    return static_cast<uint64_t>(frame.width) * static_cast<uint64_t>(frame.height);
+}
 
-    // Retrieve texture description (width, height, pixel format, ...)
-    D3D11_TEXTURE2D_DESC desc;
-    tex->GetDesc(&desc);
+//----------------------------------------------------------------------
+// sumSpanT
+//----------------------------------------------------------------------
+// Add `count` pixels, `step` bytes apart, to the {R,G,B} totals. One
+// instantiation per format and table use.
+//----------------------------------------------------------------------
+template <PixelFormat F, bool UseTable, bool Contiguous>
+void sumSpanStep(const uint8_t* px, int count, size_t step, const uint16_t* table, uint64_t lanes[3]) {
+    if constexpr (Contiguous)
+        step = PixelTraits<F>::kBytes;
+    uint64_t s0 = 0, s1 = 0, s2 = 0;
+    uint32_t c[3];
+    for (int i = 0; i < count; ++i, px += step) {
+        PixelTraits<F>::codes(px, c);
+        if constexpr (UseTable) {
+            s0 += table[c[0]];
+            s1 += table[c[1]];
+            s2 += table[c[2]];
+        } else {
+            s0 += c[0];
+            s1 += c[1];
+            s2 += c[2];
+        }
+    }
+    lanes[0] += s0;
+    lanes[1] += s1;
+    lanes[2] += s2;
+}
 
-    // Map the texture so that the CPU can directly read the pixel data
-    D3D11_MAPPED_SUBRESOURCE mapped{};
-    HRESULT hr = context->Map(tex, 0, D3D11_MAP_READ, 0, &mapped);
-    if (FAILED(hr)) {
-        context->Release();
-        return result;
+// A compile-time step lets the compiler vectorize the plain sums
+template <PixelFormat F, bool UseTable>
+void sumSpanT(const uint8_t* px, int count, size_t step, const uint16_t* table, uint64_t lanes[3]) {
+    if (step == PixelTraits<F>::kBytes)
+        sumSpanStep<F, UseTable, true>(px, count, step, table, lanes);
+    else
+        sumSpanStep<F, UseTable, false>(px, count, step, table, lanes);
+}
+
+template <PixelFormat F>
+void sumSpanAs(const uint8_t* px, int count, size_t step, const uint16_t* table, uint64_t lanes[3]) {
+    if (table)
+        sumSpanT<F, true>(px, count, step, table, lanes);
+    else
+        sumSpanT<F, false>(px, count, step, table, lanes);
+}
+
+//----------------------------------------------------------------------
+// sumSpan
+//----------------------------------------------------------------------
+// Pick the instantiation for the frame format. Called once per row, so
+// the switch does not show up next to the pixel loop.
+//----------------------------------------------------------------------
+void sumSpan(const uint8_t* px, int count, size_t step, PixelFormat format,
+             const LaneDecoding& decoding, uint64_t lanes[3]) {
+    switch (format) {
+        case PixelFormat::BGRA8:
+            return sumSpanAs<PixelFormat::BGRA8>(px, count, step, decoding.table, lanes);
+        case PixelFormat::RGBA8:
+            return sumSpanAs<PixelFormat::RGBA8>(px, count, step, decoding.table, lanes);
+        case PixelFormat::RGB10A2:
+            return sumSpanAs<PixelFormat::RGB10A2>(px, count, step, decoding.table, lanes);
+        case PixelFormat::RGBA16F:
+            return sumSpanAs<PixelFormat::RGBA16F>(px, count, step, decoding.table, lanes);
+    }
+}
+
+//----------------------------------------------------------------------
+// sumRows
+//----------------------------------------------------------------------
+// Add the {R,G,B} totals of rows [y0, y1) to `lanes`. 8-bit frames use
+// the SIMD byte-lane kernels, whose lanes are put into R,G,B order once
+// per call, and plain 10-bit sums the SIMD field kernel; other cases use
+// their template instantiation.
+//----------------------------------------------------------------------
+void sumRows(const FrameView& frame, int y0, int y1, const LaneDecoding& decoding,
+             uint64_t lanes[3]) {
+    if (frame.format == PixelFormat::RGB10A2 && !decoding.table) {
+        const TenBitRowSumKernel kernel = activeTenBitRowSumKernel();
+        for (int y = y0; y < y1; ++y)
+            kernel(frame.row(y), frame.width, lanes);
+        return;
+    }
+    if (!isEightBit(frame.format)) {
+        const size_t step = static_cast<size_t>(bytesPerPixel(frame.format));
+        for (int y = y0; y < y1; ++y)
+            sumSpan(frame.row(y), frame.width, step, frame.format, decoding, lanes);
+        return;
+    }
+
+    uint64_t byteLanes[3] = {0, 0, 0};
+    if (decoding.table) {
+        const TableRowSumKernel kernel = activeTableRowSumKernel();
+        for (int y = y0; y < y1; ++y)
+            kernel(frame.row(y), frame.width, decoding.table, byteLanes);
+    } else {
+        const RowSumKernel kernel = activeRowSumKernel();
+        for (int y = y0; y < y1; ++y)
+            kernel(frame.row(y), frame.width, byteLanes);
+    }
+    const int rLane = frame.format == PixelFormat::RGBA8 ? 0 : 2;
+    lanes[0] += byteLanes[rLane];
+    lanes[1] += byteLanes[1];
+    lanes[2] += byteLanes[2 - rLane];
+}
+
+//----------------------------------------------------------------------
+// resolveStrides
+//----------------------------------------------------------------------
+// Turn sampling options into concrete strides for a frame. A sample
+// budget uses the same stride in both directions.
+//----------------------------------------------------------------------
+void resolveStrides(const FrameView& frame, const SamplingOptions& options,
+                    int& strideX, int& strideY) {
+    strideX = (std::max)(1, options.strideX);
+    strideY = (std::max)(1, options.strideY);
+    if (options.sampleBudget > 0) {
+        const double ratio = static_cast<double>(pixelCount(frame)) /
+                             static_cast<double>(options.sampleBudget);
+        const int stride = (std::max)(1, static_cast<int>(std::ceil(std::sqrt(ratio))));
+        strideX = stride;
+        strideY = stride;
+    }
+    strideX = (std::min)(strideX, frame.width);
+    strideY = (std::min)(strideY, frame.height);
+}
+
+//----------------------------------------------------------------------
+// averageFull
+//----------------------------------------------------------------------
+// Read every pixel. With a pool, row bands are reduced in parallel;
+// several bands per thread keep the threads busy when some of them are
+// descheduled.
+//----------------------------------------------------------------------
+std::array<int, 3> averageFull(const FrameView& frame, WorkerPool* pool, bool linearLight,
+                               double sdrWhiteNits = kScRgbWhiteNits) {
+    if (frame.empty())
+        return {0, 0, 0};
+    const LaneDecoding decoding = decodingFor(frame.format, linearLight, sdrWhiteNits);
+
+    if (!pool || pool->threadCount() == 1 ||
+        static_cast<long long>(pixelCount(frame)) < kParallelMinPixels) {
+        uint64_t lanes[3] = {0, 0, 0};
+        sumRows(frame, 0, frame.height, decoding, lanes);
+        return averageFromLanes(lanes, decoding, pixelCount(frame));
+    }
+
+    const int bandCount = (std::min)(frame.height, pool->threadCount() * 4);
+    const int bandRows = (frame.height + bandCount - 1) / bandCount;
+    std::vector<std::array<uint64_t, 3>> partial(bandCount, {0, 0, 0});
+
+    pool->run(bandCount, [&](int band) {
+        const int y0 = band * bandRows;
+        const int y1 = (std::min)(frame.height, y0 + bandRows);
+        // Accumulate locally and store once to avoid false sharing
+        uint64_t local[3] = {0, 0, 0};
+        if (y0 < y1)
+            sumRows(frame, y0, y1, decoding, local);
+        partial[band] = {local[0], local[1], local[2]};
+    });
+
+    // Merge in band order so the result does not depend on scheduling
+    uint64_t lanes[3] = {0, 0, 0};
+    for (const auto& p : partial) {
+        lanes[0] += p[0];
+        lanes[1] += p[1];
+        lanes[2] += p[2];
+    }
+    return averageFromLanes(lanes, decoding, pixelCount(frame));
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// getRGBAverage
+//----------------------------------------------------------------------
+// Calculate the average red, green and blue values of a CPU frame using
+// the SIMD row kernel picked at startup.
+//----------------------------------------------------------------------
+std::array<int, 3> getRGBAverage(const FrameView& frame) {
+    return averageFull(frame, nullptr, false);
+}
+
+//----------------------------------------------------------------------
+// getRGBAverage (parallel)
+//----------------------------------------------------------------------
+std::array<int, 3> getRGBAverage(const FrameView& frame, WorkerPool* pool) {
+    return averageFull(frame, pool, false);
+}
+
+//----------------------------------------------------------------------
+// getRGBAverageSampled
+//----------------------------------------------------------------------
+// Read a sparse grid of pixels. Each band of `strideY` rows contributes
+// one row, and that row starts at some column within the first
+// `strideX` pixels. Both offsets follow the R2 low-discrepancy sequence
+// (generalized golden ratio), so consecutive bands spread their samples
+// evenly over the stride instead of stacking them on one row or column
+// of a regular UI grid.
+//----------------------------------------------------------------------
+std::array<int, 3> getRGBAverageSampled(const FrameView& frame, const SamplingOptions& options) {
+    if (frame.empty())
+        return {0, 0, 0};
+
+    int strideX = 1, strideY = 1;
+    resolveStrides(frame, options, strideX, strideY);
+    if (strideX == 1 && strideY == 1)
+        return averageFull(frame, nullptr, options.linearLight, options.sdrWhiteNits);
+
+    constexpr double kR2Alpha1 = 0.7548776662466927; // 1 / plastic number
+    constexpr double kR2Alpha2 = 0.5698402909980532; // 1 / plastic number^2
+    const LaneDecoding decoding = decodingFor(frame.format, options.linearLight, options.sdrWhiteNits);
+    const size_t pixelBytes = static_cast<size_t>(bytesPerPixel(frame.format));
+    const size_t step = static_cast<size_t>(strideX) * pixelBytes;
+    uint64_t lanes[3] = {0, 0, 0};
+    uint64_t samples = 0;
+    double phaseX = 0.5;
+    double phaseY = 0.5;
+
+    for (int band = 0; band < frame.height; band += strideY) {
+        const int y = band + static_cast<int>(phaseY * strideY);
+        const int x0 = static_cast<int>(phaseX * strideX);
+        phaseX += kR2Alpha1;
+        phaseY += kR2Alpha2;
+        if (phaseX >= 1.0)
+            phaseX -= 1.0;
+        if (phaseY >= 1.0)
+            phaseY -= 1.0;
+        if (y >= frame.height)
+            continue;
+
+        const int count = (frame.width - x0 + strideX - 1) / strideX;
+        sumSpan(frame.row(y) + x0 * pixelBytes, count, step, frame.format, decoding, lanes);
+        samples += static_cast<uint64_t>(count);
     }
 
-    // Pointers and dimensions used for iteration
-    const uint8_t* data = static_cast<const uint8_t*>(mapped.pData);
-    const int width = static_cast<int>(desc.Width);
-    const int height = static_cast<int>(desc.Height);
-
-    // Running totals for each color channel
-    unsigned long long sumR = 0;
-    unsigned long long sumG = 0;
-    unsigned long long sumB = 0;
-
-    // Walk over every pixel in the texture and accumulate each color
-    // component. Assumes 4 bytes per pixel.
-    for (int y = 0; y < height; ++y) {
-        const uint8_t* row = data + y * mapped.RowPitch;
-        for (int x = 0; x < width; ++x) {
-            const uint8_t* px = row + x * 4;
-            uint8_t r, g, b;
-            if (desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM ||
-                desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) {
-                // RGBA layout
-                r = px[0];
-                g = px[1];
-                b = px[2];
-            } else {
-                // Assume BGRA layout for all other 8-bit formats
-                b = px[0];
-                g = px[1];
-                r = px[2];
+    return averageFromLanes(lanes, decoding, samples);
+}
+
+//----------------------------------------------------------------------
+// getRGBAverage (sampling options)
+//----------------------------------------------------------------------
+// Entry point used by the processing thread.
+//----------------------------------------------------------------------
+std::array<int, 3> getRGBAverage(const FrameView& frame, const SamplingOptions& options,
+                                 WorkerPool* pool) {
+    if (options.isFull())
+        return averageFull(frame, pool, options.linearLight, options.sdrWhiteNits);
+    return getRGBAverageSampled(frame, options);
+}
+
+//----------------------------------------------------------------------
+// measureSamplingError
+//----------------------------------------------------------------------
+// Largest and mean per-channel deviation of the sampled estimate from
+// the exact average over a corpus of frames.
+//----------------------------------------------------------------------
+SamplingError measureSamplingError(const std::vector<FrameView>& corpus,
+                                   const SamplingOptions& options) {
+    SamplingError error;
+    long long total = 0;
+    long long channels = 0;
+    for (size_t i = 0; i < corpus.size(); ++i) {
+        const auto exact = averageFull(corpus[i], nullptr, options.linearLight, options.sdrWhiteNits);
+        const auto sampled = getRGBAverageSampled(corpus[i], options);
+        for (int c = 0; c < 3; ++c) {
+            const int diff = std::abs(exact[c] - sampled[c]);
+            total += diff;
+            ++channels;
+            if (diff > error.maxError) {
+                error.maxError = diff;
+                error.worstFrame = static_cast<int>(i);
             }
-            sumR += r;
-            sumG += g;
-            sumB += b;
         }
     }
+    if (channels > 0)
+        error.meanError = static_cast<double>(total) / static_cast<double>(channels);
+    return error;
+}
 
-    // Done reading the texture data
-    context->Unmap(tex, 0);
-    context->Release();
+//----------------------------------------------------------------------
+// getRGBAverageScalar
+//----------------------------------------------------------------------
+// Straightforward per-pixel loop used as the correctness reference.
+//----------------------------------------------------------------------
+std::array<int, 3> getRGBAverageScalar(const FrameView& frame) {
+    if (frame.empty())
+        return {0, 0, 0};
+
+    const LaneDecoding decoding = decodingFor(frame.format, false);
+    const size_t step = static_cast<size_t>(bytesPerPixel(frame.format));
+    uint64_t lanes[3] = {0, 0, 0};
+    for (int y = 0; y < frame.height; ++y)
+        sumSpan(frame.row(y), frame.width, step, frame.format, decoding, lanes);
+
+    return averageFromLanes(lanes, decoding, pixelCount(frame));
+}
+
+#ifdef _WIN32
+//----------------------------------------------------------------------
+// MappedTexture
+//----------------------------------------------------------------------
+// Map the texture for reading and describe it as a FrameView.
+//----------------------------------------------------------------------
+MappedTexture::MappedTexture(ID3D11DeviceContext* context, ID3D11Texture2D* tex)
+    : context_(context), tex_(tex) {
+    if (!context_ || !tex_)
+        return;
+
+    // Retrieve texture description (width, height, pixel format, ...)
+    D3D11_TEXTURE2D_DESC desc;
+    tex_->GetDesc(&desc);
 
-    // Compute the average for each channel if at least one pixel was read
-    const unsigned long long totalPixels =
-        static_cast<unsigned long long>(width) *
-        static_cast<unsigned long long>(height);
-    if (totalPixels > 0) {
-        result[0] = static_cast<int>(sumR / totalPixels);
-        result[1] = static_cast<int>(sumG / totalPixels);
-        result[2] = static_cast<int>(sumB / totalPixels);
+    PixelFormat format;
+    switch (desc.Format) {
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+            format = PixelFormat::BGRA8;
+            break;
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            format = PixelFormat::RGBA8;
+            break;
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+            format = PixelFormat::RGB10A2;
+            break;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            format = PixelFormat::RGBA16F;
+            break;
+        default:
+            // Unknown layout: reading it would produce garbage colors
+            return;
     }
 
-    return result;
+    // Map the texture so that the CPU can directly read the pixel data
+    D3D11_MAPPED_SUBRESOURCE mapped{};
+    HRESULT hr = context_->Map(tex_, 0, D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr))
+        return;
+
+    mapped_ = true;
+
+    view_.data = static_cast<const uint8_t*>(mapped.pData);
+    view_.width = static_cast<int>(desc.Width);
+    view_.height = static_cast<int>(desc.Height);
+    view_.rowPitch = mapped.RowPitch;
+    view_.format = format;
+}
+
+MappedTexture::~MappedTexture() {
+    // Done reading the texture data
+    if (mapped_)
+        context_->Unmap(tex_, 0);
+}
+
+//----------------------------------------------------------------------
+// getRGBAverage (texture)
+//----------------------------------------------------------------------
+// Map a CPU-readable Direct3D texture and average it through the
+// FrameView path. If the texture cannot be mapped, {0,0,0} is returned.
+//----------------------------------------------------------------------
+std::array<int, 3> getRGBAverage(ID3D11DeviceContext* context, ID3D11Texture2D* tex,
+                                 const SamplingOptions& options, WorkerPool* pool) {
+    MappedTexture mapped(context, tex);
+    if (!mapped)
+        return {0, 0, 0};
+    return getRGBAverage(mapped.view(), options, pool);
 }
 
+//----------------------------------------------------------------------
+// getRGBAverage (texture, implicit context)
+//----------------------------------------------------------------------
+// Obtain the immediate context from the texture's device and forward to
+// the overload above.
+//----------------------------------------------------------------------
+std::array<int, 3> getRGBAverage(ID3D11Texture2D* tex) {
+    if (!tex)
+        return {0, 0, 0};
+
+    ID3D11Device* device = nullptr;
+    tex->GetDevice(&device);
+    if (!device)
+        return {0, 0, 0};
+
+    ID3D11DeviceContext* context = nullptr;
+    device->GetImmediateContext(&context);
+    device->Release(); // device no longer needed after acquiring context
+    if (!context)
+        return {0, 0, 0};
+
+    auto result = getRGBAverage(context, tex);
+    context->Release();
+    return result;
+}
+#endif
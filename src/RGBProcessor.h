@@ -1,17 +1,167 @@
 #pragma once
 
 #include <array>
+#include <vector>
+#include "FrameView.h"
+#include "PixelFormats.h"
+
+class WorkerPool;
+
+#ifdef _WIN32
 #include <d3d11.h>
+#endif
+
+/**
+ * Compute the average red, green and blue values of a CPU frame.
+ *
+ * Rows of 8-bit frames are summed with the fastest SIMD kernel supported
+ * by the running CPU (see `PixelKernels.h`); 10-bit and half float frames
+ * use kernels specialized per format (see `PixelFormats.h`). Half float
+ * frames are averaged in linear light, the others on their stored sRGB
+ * values.
+ *
+ * @param frame Frame to analyze. An empty view yields {0, 0, 0}.
+ * @return Array with average {R, G, B} values in the range `[0, 255]`.
+ */
+std::array<int, 3> getRGBAverage(const FrameView& frame);
+
+/**
+ * Parallel variant of `getRGBAverage(const FrameView&)`.
+ *
+ * The frame is split into row bands that are reduced on `pool`; the
+ * partial sums are merged in band order, so the result is identical to
+ * the single-threaded version. Frames smaller than
+ * `kParallelMinPixels` or a null pool fall back to one thread.
+ *
+ * @param frame Frame to analyze.
+ * @param pool  Worker pool used for the bands. May be `nullptr`.
+ */
+std::array<int, 3> getRGBAverage(const FrameView& frame, WorkerPool* pool);
+
+/** Frames with fewer pixels are always averaged on the calling thread. */
+constexpr long long kParallelMinPixels = 256 * 1024;
+
+/**
+ * Pixel sampling pattern used to estimate a frame average.
+ *
+ * With the default values every pixel is read. Larger strides read every
+ * `strideX`-th pixel of every `strideY`-th row; the first column of each
+ * sampled row is shifted along a golden-ratio (low-discrepancy) sequence
+ * so thin vertical UI elements are not systematically hit or missed.
+ *
+ * `linearLight` decodes sRGB values through a lookup table before they
+ * are summed and encodes the result again, which gives the physically
+ * correct mix of light (a black and white checkerboard averages to 188,
+ * not 127).
+ */
+struct SamplingOptions {
+    int strideX = 1;            ///< Distance between samples in a row
+    int strideY = 1;            ///< Distance between sampled rows
+    long long sampleBudget = 0; ///< If > 0, strides are chosen to read at most this many pixels
+    bool linearLight = false;   ///< Average in linear light instead of on sRGB values
+    double sdrWhiteNits = kScRgbWhiteNits; ///< SDR white of half float frames (see `linearLightTable`)
+
+    /** True if every pixel is read. */
+    bool isFull() const { return sampleBudget <= 0 && strideX <= 1 && strideY <= 1; }
+};
+
+/**
+ * Estimate the average color by reading only the pixels selected by
+ * `options`.
+ *
+ * @param frame   Frame to analyze. An empty view yields {0, 0, 0}.
+ * @param options Sampling pattern. A full pattern reads every pixel.
+ * @return Array with average {R, G, B} values in the range `[0, 255]`.
+ */
+std::array<int, 3> getRGBAverageSampled(const FrameView& frame, const SamplingOptions& options);
+
+/**
+ * Average a frame with the cheapest path allowed by `options`: the
+ * parallel full-frame reduction for a full pattern, the sampled
+ * estimate otherwise.
+ */
+std::array<int, 3> getRGBAverage(const FrameView& frame, const SamplingOptions& options,
+                                 WorkerPool* pool);
+
+/**
+ * Error of a sampling pattern compared with the full average.
+ */
+struct SamplingError {
+    int maxError = 0;        ///< Largest per-channel difference over the corpus
+    double meanError = 0.0;  ///< Mean per-channel difference over the corpus
+    int worstFrame = -1;     ///< Index of the frame with the largest error
+};
+
+/**
+ * Compare `getRGBAverageSampled` with the full `getRGBAverage` result on
+ * every frame of a corpus.
+ *
+ * @param corpus  Frames to evaluate.
+ * @param options Sampling pattern under test.
+ */
+SamplingError measureSamplingError(const std::vector<FrameView>& corpus,
+                                   const SamplingOptions& options);
+
+/**
+ * Scalar reference implementation of `getRGBAverage(const FrameView&)`.
+ *
+ * Walks the frame one pixel at a time. Used to validate the SIMD kernels
+ * and as a baseline for benchmarks.
+ */
+std::array<int, 3> getRGBAverageScalar(const FrameView& frame);
+
+#ifdef _WIN32
+/**
+ * Maps a CPU-readable texture for the lifetime of the object and exposes
+ * it as a FrameView.
+ *
+ * Textures in a DXGI format without a matching `PixelFormat` are not
+ * mapped.
+ */
+class MappedTexture {
+public:
+    MappedTexture(ID3D11DeviceContext* context, ID3D11Texture2D* tex);
+    ~MappedTexture();
+
+    MappedTexture(const MappedTexture&) = delete;
+    MappedTexture& operator=(const MappedTexture&) = delete;
+
+    /** True if the texture was mapped successfully. */
+    explicit operator bool() const { return mapped_; }
+
+    /** View of the mapped pixels; empty if mapping failed. */
+    const FrameView& view() const { return view_; }
+
+private:
+    ID3D11DeviceContext* context_;
+    ID3D11Texture2D* tex_;
+    FrameView view_;
+    bool mapped_ = false;
+};
 
 /**
  * Compute the average red, green and blue values of a texture.
  *
  * The texture should be a staging texture or otherwise CPU readable and
- * must use a 32-bit-per-pixel format (for example
- * `DXGI_FORMAT_B8G8R8A8_UNORM` or `DXGI_FORMAT_R8G8B8A8_UNORM`).
+ * use one of the formats listed in `PixelFormat`.
+ *
+ * @param context Device context used to map the texture.
+ * @param tex     Pointer to the texture to analyze. May be `nullptr`.
+ * @param options Sampling pattern; reads every pixel by default.
+ * @param pool    Optional worker pool for large frames.
+ * @return Array with average {R, G, B} values in the range `[0, 255]`.
+ */
+std::array<int, 3> getRGBAverage(ID3D11DeviceContext* context, ID3D11Texture2D* tex,
+                                 const SamplingOptions& options = SamplingOptions{},
+                                 WorkerPool* pool = nullptr);
+
+/**
+ * Convenience overload that looks up the immediate context of the
+ * texture's device on every call. Prefer the overload taking a context
+ * on hot paths.
  *
  * @param tex Pointer to the texture to analyze. May be `nullptr`.
  * @return Array with average {R, G, B} values in the range `[0, 255]`.
  */
 std::array<int, 3> getRGBAverage(ID3D11Texture2D* tex);
-
+#endif
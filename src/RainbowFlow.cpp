@@ -78,39 +78,23 @@ std::array<int, 3> RainbowFlow::hsvToRgb(double h, double s, double v) {
     return rgb;
 }
 
-bool RainbowFlow::generateTexture(ID3D11Device* device, ID3D11DeviceContext* context, 
-                                 ID3D11Texture2D*& outTex, const DXGI_OUTPUT_DESC& outputDesc) {
-    if (!device || !context) {
-        return false;
-    }
-
+bool RainbowFlow::generateFrame(FramePool& pool, FrameLease& outFrame,
+                                const DXGI_OUTPUT_DESC& outputDesc) {
     // Use a default resolution if we don't have output description
-    UINT width = 1920;
-    UINT height = 1080;
+    int width = 1920;
+    int height = 1080;
     if (outputDesc.DesktopCoordinates.right > 0 && outputDesc.DesktopCoordinates.bottom > 0) {
         width = outputDesc.DesktopCoordinates.right - outputDesc.DesktopCoordinates.left;
         height = outputDesc.DesktopCoordinates.bottom - outputDesc.DesktopCoordinates.top;
     }
 
-    // Create or recreate rainbow texture if needed
-    if (!rainbowTex_) {
-        D3D11_TEXTURE2D_DESC desc = {};
-        desc.Width = width;
-        desc.Height = height;
-        desc.MipLevels = 1;
-        desc.ArraySize = 1;
-        desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-        desc.SampleDesc.Count = 1;
-        desc.SampleDesc.Quality = 0;
-        desc.Usage = D3D11_USAGE_DYNAMIC;
-        desc.BindFlags = 0;
-        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-        desc.MiscFlags = 0;
-
-        HRESULT hr = device->CreateTexture2D(&desc, nullptr, rainbowTex_.ReleaseAndGetAddressOf());
-        if (FAILED(hr)) {
-            return false;
-        }
+    // Draw into a buffer of its own, so a frame still being processed is
+    // not overwritten
+    if (pool.width() != width || pool.height() != height || pool.format() != PixelFormat::BGRA8)
+        pool.resize(width, height, PixelFormat::BGRA8);
+    FrameLease frame = pool.acquire();
+    if (!frame) {
+        return false;
     }
 
     // Get current time for animation
@@ -119,17 +103,11 @@ bool RainbowFlow::generateTexture(ID3D11Device* device, ID3D11DeviceContext* con
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime);
     float timeSeconds = elapsed.count() / 1000.0f;
 
-    // Map the texture for CPU write access
-    D3D11_MAPPED_SUBRESOURCE mappedResource;
-    HRESULT hr = context->Map(rainbowTex_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-    if (FAILED(hr)) {
-        return false;
-    }
-
     // Generate rainbow pattern
-    UINT8* data = static_cast<UINT8*>(mappedResource.pData);
-    for (UINT y = 0; y < height; ++y) {
-        for (UINT x = 0; x < width; ++x) {
+    uint8_t* data = frame.data();
+    const size_t rowPitch = frame.view().rowPitch;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
             // Create animated rainbow pattern
             float hue = (x / static_cast<float>(width) + timeSeconds * 0.1f) * 360.0f;
             hue = fmod(hue, 360.0f);
@@ -151,26 +129,15 @@ bool RainbowFlow::generateTexture(ID3D11Device* device, ID3D11DeviceContext* con
                 case 5: r = 1.0f; g = 0.0f; b = q; break;
             }
             
-            // Convert to BGRA format and apply to texture
-            UINT8* pixel = data + (y * mappedResource.RowPitch + x * 4);
-            pixel[0] = static_cast<UINT8>(b * 255.0f); // Blue
-            pixel[1] = static_cast<UINT8>(g * 255.0f); // Green
-            pixel[2] = static_cast<UINT8>(r * 255.0f); // Red
+            // Convert to BGRA format and write to the frame
+            uint8_t* pixel = data + (y * rowPitch + x * 4);
+            pixel[0] = static_cast<uint8_t>(b * 255.0f); // Blue
+            pixel[1] = static_cast<uint8_t>(g * 255.0f); // Green
+            pixel[2] = static_cast<uint8_t>(r * 255.0f); // Red
             pixel[3] = 255; // Alpha
         }
     }
 
-    // Unmap the texture
-    context->Unmap(rainbowTex_.Get(), 0);
-
-    // Return the rainbow texture
-    outTex = rainbowTex_.Get();
-    if (outTex) {
-        outTex->AddRef();
-    }
+    outFrame = std::move(frame);
     return true;
 }
-
-void RainbowFlow::cleanup() {
-    rainbowTex_.Reset();
-} 
\ No newline at end of file
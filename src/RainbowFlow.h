@@ -4,15 +4,13 @@
 #include <chrono>
 #include <cmath>
 
-// Windows DirectX headers for texture generation
-#include <d3d11.h>      // DirectX 11 core functionality
-#include <dxgi1_2.h>    // DXGI 1.2 for texture formats
-#include <wrl/client.h> // Microsoft WRL (Windows Runtime Library) for COM smart pointers
+#include <dxgi1_2.h>    // DXGI 1.2 for the output description
+#include "FramePool.h"
 
 /**
  * RainbowFlow - Generates animated rainbow patterns for fallback scenarios
  * 
- * This class provides functionality to create animated rainbow textures
+ * This class provides functionality to create animated rainbow frames
  * when monitor access is lost or unavailable. It creates smooth color
  * transitions that cycle through the rainbow spectrum over time.
  */
@@ -30,20 +28,13 @@ public:
     void reset();
 
     /**
-     * Generate a rainbow pattern texture
-     * @param device DirectX 11 device for texture creation
-     * @param context DirectX 11 context for texture operations
-     * @param outTex Reference to receive the generated texture
+     * Generate a rainbow pattern frame
+     * @param pool Pool providing the frame buffer; resized to the output
+     * @param outFrame Receives the generated frame
      * @param outputDesc DXGI output description for resolution info
-     * @return true if texture generated successfully, false otherwise
+     * @return true if a frame was generated, false if the pool is exhausted
      */
-    bool generateTexture(ID3D11Device* device, ID3D11DeviceContext* context, 
-                        ID3D11Texture2D*& outTex, const DXGI_OUTPUT_DESC& outputDesc);
-
-    /**
-     * Clean up rainbow texture resources
-     */
-    void cleanup();
+    bool generateFrame(FramePool& pool, FrameLease& outFrame, const DXGI_OUTPUT_DESC& outputDesc);
 
 private:
     // Convert HSV to RGB
@@ -52,7 +43,4 @@ private:
     double currentHue_;           // Current hue angle (0-360 degrees)
     double speed_;                // Speed in degrees per second
     std::chrono::steady_clock::time_point lastUpdate_; // Last update time
-
-    // Rainbow texture - animated fallback texture
-    Microsoft::WRL::ComPtr<ID3D11Texture2D> rainbowTex_;
 }; 
\ No newline at end of file
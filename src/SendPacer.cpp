@@ -0,0 +1,66 @@
+#include "SendPacer.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------
+// reset
+//----------------------------------------------------------------------
+void SendPacer::reset(const std::vector<double>& maxRates, Clock::duration frameInterval,
+                      int slices) {
+    devices_.assign(maxRates.size(), Device{});
+    for (size_t i = 0; i < maxRates.size(); ++i) {
+        if (maxRates[i] > 0.0)
+            devices_[i].period = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(1.0 / maxRates[i]));
+    }
+    frameInterval_ = frameInterval;
+    slices_ = (std::max)(slices, 1);
+    nextDue_ = Clock::time_point::max();
+}
+
+//----------------------------------------------------------------------
+// onFrame
+//----------------------------------------------------------------------
+// A device is due at its slice of the interval, or later once its bucket
+// refills. A device still waiting for a token keeps its earlier due
+// time: the newer frame simply replaces the one it would have sent.
+//----------------------------------------------------------------------
+void SendPacer::onFrame(Clock::time_point now) {
+    for (size_t i = 0; i < devices_.size(); ++i) {
+        Device& d = devices_[i];
+        const auto slice = static_cast<Clock::rep>(i % static_cast<size_t>(slices_));
+        const Clock::time_point due = (std::max)(now + frameInterval_ * slice / slices_, d.tokenAt);
+        d.due = d.pending ? (std::min)(d.due, due) : due;
+        d.pending = true;
+    }
+    updateNextDue();
+}
+
+//----------------------------------------------------------------------
+// collectDue
+//----------------------------------------------------------------------
+// The next token comes a full period after the actual send, so a late
+// wake-up never lets two packets out closer than the rate allows.
+//----------------------------------------------------------------------
+void SendPacer::collectDue(Clock::time_point now, std::vector<size_t>& out) {
+    if (now < nextDue_)
+        return;
+    for (size_t i = 0; i < devices_.size(); ++i) {
+        Device& d = devices_[i];
+        if (!d.pending || d.due > now)
+            continue;
+        d.pending = false;
+        d.tokenAt = now + d.period;
+        out.push_back(i);
+    }
+    updateNextDue();
+}
+
+//----------------------------------------------------------------------
+// updateNextDue
+//----------------------------------------------------------------------
+void SendPacer::updateNextDue() {
+    nextDue_ = Clock::time_point::max();
+    for (const Device& d : devices_)
+        if (d.pending)
+            nextDue_ = (std::min)(nextDue_, d.due);
+}
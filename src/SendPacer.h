@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Decides when each device gets the newest frame.
+ *
+ * Every device has a token bucket holding at most one packet, refilled at
+ * its `maxRate`: a device is due only once it holds a token, so it never
+ * exceeds its rate, and frames arriving meanwhile coalesce into the
+ * newest one (the caller always sends its latest frame). Unlimited
+ * devices (rate 0) always hold a token.
+ *
+ * With `slices` > 1 the fan-out of a frame is spread across the frame
+ * interval: device `i` is due `(i % slices) / slices` of an interval
+ * after the frame arrived, so each send burst carries only every
+ * `slices`th device. With one slice and no rate limits every device is
+ * due as soon as a frame arrives, which is the unpaced behavior.
+ */
+class SendPacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Configure the devices and forget any pending frame.
+     * @param maxRates      Packets per second per device, 0 = unlimited.
+     * @param frameInterval Time between two frames, spread by the slices.
+     * @param slices        Send bursts per frame interval (1 = no spreading).
+     */
+    void reset(const std::vector<double>& maxRates, Clock::duration frameInterval, int slices);
+
+    /** A new frame arrived: every device has it pending. */
+    void onFrame(Clock::time_point now);
+
+    /**
+     * Append the devices that are due at `now` to `out` and take a token
+     * from each.
+     */
+    void collectDue(Clock::time_point now, std::vector<size_t>& out);
+
+    /** Earliest time a pending device is due, `Clock::time_point::max()` if none. */
+    Clock::time_point nextDue() const { return nextDue_; }
+
+    /** Number of devices. */
+    size_t size() const { return devices_.size(); }
+
+private:
+    struct Device {
+        Clock::duration period{};     ///< Time to refill one token, zero = unlimited
+        Clock::time_point tokenAt{};  ///< When the bucket holds a token again
+        Clock::time_point due{};      ///< When the pending frame goes out
+        bool pending = false;
+    };
+
+    void updateNextDue();
+
+    std::vector<Device> devices_;
+    Clock::duration frameInterval_{};
+    int slices_ = 1;
+    Clock::time_point nextDue_ = Clock::time_point::max();
+};
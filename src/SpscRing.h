@@ -0,0 +1,245 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include "EventCount.h"
+
+/**
+ * What a full ring does with another item.
+ */
+enum class OverflowPolicy {
+    Block,      ///< The producer waits for room
+    DropOldest, ///< The oldest queued item makes room, so the consumer gets the freshest
+    DropNewest  ///< The new item is discarded
+};
+
+/**
+ * Size and overflow policy of a queue between two pipeline stages.
+ */
+struct QueueOptions {
+    size_t capacity = 2;                              ///< Items the queue holds (1-1024)
+    OverflowPolicy policy = OverflowPolicy::DropOldest; ///< What a full queue does
+};
+
+/**
+ * Bounded queue between one producer and one consumer thread.
+ *
+ * Items live in a fixed ring of slots; each slot carries a sequence
+ * number telling whose turn it is (Vyukov), so neither side takes a
+ * lock. The indices sit on separate cache lines so the two threads do
+ * not invalidate each other's line on every item. A side that finds the
+ * ring empty (or full, with `OverflowPolicy::Block`) spins briefly and
+ * then sleeps on an EventCount.
+ *
+ * With `OverflowPolicy::DropOldest` the producer evicts the oldest item
+ * by claiming the head slot like the consumer does. Dropped items go to
+ * the drop handler on the producer thread, e.g. to release a texture,
+ * and are counted, so a stage that falls behind shows up as drops
+ * instead of a growing backlog.
+ */
+template <typename T>
+class SpscRing {
+public:
+    using Clock = std::chrono::steady_clock;
+    using DropHandler = std::function<void(T&)>;
+
+    /**
+     * @param capacity Items the ring holds, at least 1.
+     * @param policy   What `push` does when the ring is full.
+     * @param onDrop   Called with every item that is not delivered.
+     */
+    SpscRing(size_t capacity, OverflowPolicy policy, DropHandler onDrop = nullptr)
+        : capacity_(capacity < 1 ? 1 : capacity),
+          policy_(policy),
+          onDrop_(std::move(onDrop)),
+          slots_(new Slot[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i)
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * Queue an item (producer thread).
+     * @return false if the item was dropped (`DropNewest` on a full
+     *         ring, or the ring is stopped); it went to the drop handler.
+     */
+    bool push(T value) {
+        for (;;) {
+            if (stopped_.load(std::memory_order_acquire)) {
+                drop(value);
+                return false;
+            }
+            if (tryPush(value)) {
+                notEmpty_.notifyAll();
+                return true;
+            }
+            if (policy_ == OverflowPolicy::DropNewest) {
+                drop(value);
+                return false;
+            }
+            if (policy_ == OverflowPolicy::DropOldest) {
+                // Only evict from a ring that is really full: a slot the
+                // consumer has claimed but not yet emptied frees up soon
+                T oldest{};
+                if (size() >= capacity_ && tryPop(oldest))
+                    drop(oldest);
+                else
+                    std::this_thread::yield();
+                continue;
+            }
+            if (spinFor([&] { return size() < capacity_; }))
+                continue;
+            const uint32_t key = notFull_.prepareWait();
+            if (size() < capacity_ || stopped_.load(std::memory_order_acquire)) {
+                notFull_.cancelWait();
+                continue;
+            }
+            notFull_.wait(key);
+        }
+    }
+
+    /**
+     * Take the oldest item (consumer thread), waiting for one.
+     * @return false once the ring is stopped and empty.
+     */
+    bool pop(T& value) {
+        bool timedOut = false;
+        return popUntil(value, Clock::time_point::max(), timedOut);
+    }
+
+    /**
+     * Like `pop`, but gives up at `deadline`; `timedOut` tells a timeout
+     * from a stopped ring.
+     */
+    bool popUntil(T& value, Clock::time_point deadline, bool& timedOut) {
+        timedOut = false;
+        for (;;) {
+            if (tryPop(value)) {
+                notFull_.notifyAll();
+                return true;
+            }
+            if (stopped_.load(std::memory_order_acquire))
+                return takeLast(value);
+            if (spinFor([&] { return size() > 0; }))
+                continue;
+            const uint32_t key = notEmpty_.prepareWait();
+            if (size() > 0 || stopped_.load(std::memory_order_acquire)) {
+                notEmpty_.cancelWait();
+                continue;
+            }
+            if (!notEmpty_.wait(key, deadline)) {
+                if (tryPop(value)) {
+                    notFull_.notifyAll();
+                    return true;
+                }
+                timedOut = true;
+                return false;
+            }
+        }
+    }
+
+    /** Wake both sides; `pop` returns false once the ring is empty. */
+    void stop() {
+        stopped_.store(true, std::memory_order_release);
+        notEmpty_.notifyAll();
+        notFull_.notifyAll();
+    }
+
+    /** Items currently queued. */
+    size_t size() const {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+    OverflowPolicy policy() const { return policy_; }
+
+    /** Items dropped so far, by either overflow policy or after `stop`. */
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0}; ///< pos: free for push pos; pos + 1: holds item pos
+        T value{};
+    };
+
+    static constexpr size_t kCacheLine = 64;
+
+    // Producer only: the slot at tail is free once its consumer moved out
+    bool tryPush(T& value) {
+        const size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos % capacity_];
+        if (slot.sequence.load(std::memory_order_acquire) != pos)
+            return false;
+        slot.value = std::move(value);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer, or the producer evicting: claim the head slot, then hand
+    // it back to the producer for the lap after
+    bool tryPop(T& value) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos % capacity_];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != pos + 1) {
+                if (sequence < pos + 1)
+                    return false; // empty
+                pos = head_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+                value = std::move(slot.value);
+                slot.sequence.store(pos + capacity_, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    // After stop: an item the producer pushed right before still counts
+    bool takeLast(T& value) {
+        if (!tryPop(value))
+            return false;
+        notFull_.notifyAll();
+        return true;
+    }
+
+    template <typename Ready>
+    bool spinFor(Ready ready) const {
+        for (int i = spinIterations(); i > 0; --i) {
+            if (ready())
+                return true;
+            cpuRelax();
+        }
+        return false;
+    }
+
+    void drop(T& value) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        if (onDrop_)
+            onDrop_(value);
+    }
+
+    const size_t capacity_;
+    const OverflowPolicy policy_;
+    DropHandler onDrop_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(kCacheLine) std::atomic<size_t> head_{0}; ///< Next item to pop
+    alignas(kCacheLine) std::atomic<size_t> tail_{0}; ///< Next slot to push, written by the producer only
+    alignas(kCacheLine) std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> stopped_{false};
+    EventCount notEmpty_; ///< Consumer sleeps here
+    EventCount notFull_;  ///< Producer sleeps here with OverflowPolicy::Block
+};
@@ -0,0 +1,68 @@
+#include "ThreadTuning.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace {
+
+constexpr int kHighNice = -10;
+constexpr int kFifoPriority = 10; // of 1-99; threaded IRQs run at 50
+
+} // namespace
+
+//----------------------------------------------------------------------
+// pinCurrentThread
+//----------------------------------------------------------------------
+bool pinCurrentThread(int cpu) {
+    if (cpu < 0)
+        return false;
+#ifdef _WIN32
+    if (cpu >= 64)
+        return false;
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// setCurrentThreadPriority
+//----------------------------------------------------------------------
+// On Linux a nice value applies to the calling thread only when it is
+// set for the thread id; the process id would change the main thread.
+//----------------------------------------------------------------------
+bool setCurrentThreadPriority(ThreadPriority priority) {
+    if (priority == ThreadPriority::Normal)
+        return true;
+#ifdef _WIN32
+    const int level = priority == ThreadPriority::Realtime ? THREAD_PRIORITY_TIME_CRITICAL
+                                                            : THREAD_PRIORITY_HIGHEST;
+    return SetThreadPriority(GetCurrentThread(), level) != 0;
+#else
+    if (priority == ThreadPriority::Realtime) {
+        sched_param param{};
+        param.sched_priority = kFifoPriority;
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+#ifdef __linux__
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), kHighNice) == 0;
+#else
+    return false;
+#endif
+#endif
+}
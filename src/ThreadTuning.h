@@ -0,0 +1,45 @@
+#pragma once
+
+/**
+ * How the frame pipeline is spread over threads.
+ */
+enum class PipelineMode {
+    Threaded, ///< Capture, processing and sending threads handing frames over
+    Fused     ///< One thread captures, processes and sends each frame inline
+};
+
+/**
+ * Scheduling class requested for a latency-critical thread.
+ */
+enum class ThreadPriority {
+    Normal,  ///< Left as created
+    High,    ///< Above normal threads (THREAD_PRIORITY_HIGHEST, nice -10)
+    Realtime ///< Preempts normal threads (THREAD_PRIORITY_TIME_CRITICAL, SCHED_FIFO)
+};
+
+/**
+ * Thread layout of the pipeline.
+ */
+struct PipelineOptions {
+    PipelineMode mode = PipelineMode::Threaded;    ///< Threads the pipeline uses
+    int cpu = -1;                                  ///< Core the fused thread is pinned to (-1 = any)
+    ThreadPriority priority = ThreadPriority::Normal; ///< Priority of the fused thread
+};
+
+/**
+ * Pin the calling thread to one logical CPU.
+ * @return false if the CPU does not exist or pinning is not supported.
+ */
+bool pinCurrentThread(int cpu);
+
+/**
+ * Change the scheduling priority of the calling thread.
+ *
+ * Raising it usually needs a privilege (CAP_SYS_NICE or an rtprio limit
+ * on Linux); without one the call fails and the thread stays as it was.
+ * The realtime class uses a low SCHED_FIFO priority, so kernel threads
+ * and audio still preempt it.
+ *
+ * @return false if the priority could not be applied.
+ */
+bool setCurrentThreadPriority(ThreadPriority priority);
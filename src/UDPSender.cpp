@@ -1,9 +1,115 @@
 #include "UDPSender.h"
 #include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <netinet/udp.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103 // linux/udp.h, for older C libraries
+#endif
+#endif
 
-#include <cstdio>
-#include <sstream>
-#include <regex>
+namespace {
+//----------------------------------------------------------------------
+// closeSocket
+//----------------------------------------------------------------------
+void closeSocket(UDPSender::SocketHandle s) {
+#ifdef _WIN32
+    ::closesocket(s);
+#else
+    ::close(s);
+#endif
+}
+
+// Result of a single send attempt
+enum class SendStatus { Sent, WouldBlock, Failed };
+
+//----------------------------------------------------------------------
+// lastSendStatus
+//----------------------------------------------------------------------
+// Classify the error of a failed send. A full socket buffer is transient
+// and not the device's fault; anything else (refused, unreachable, ...)
+// counts against the device.
+//----------------------------------------------------------------------
+SendStatus lastSendStatus() {
+#ifdef _WIN32
+    const int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAENOBUFS ? SendStatus::WouldBlock
+                                                          : SendStatus::Failed;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ? SendStatus::WouldBlock
+                                                                       : SendStatus::Failed;
+#endif
+}
+
+//----------------------------------------------------------------------
+// sendOnce
+//----------------------------------------------------------------------
+// Send one datagram, to `addr` or, if null, to the peer of a connected
+// socket. Only interrupted calls are repeated: a retry right away would
+// delay every other device and rarely succeeds.
+//----------------------------------------------------------------------
+SendStatus sendOnce(UDPSender::SocketHandle s, const sockaddr_in* addr, const void* data,
+                    size_t size) {
+    for (;;) {
+        const int sent = static_cast<int>(
+            ::sendto(s, static_cast<const char*>(data), static_cast<int>(size), 0,
+                     reinterpret_cast<const sockaddr*>(addr), addr ? sizeof(*addr) : 0));
+        if (sent == static_cast<int>(size))
+            return SendStatus::Sent;
+#ifndef _WIN32
+        if (sent < 0 && errno == EINTR)
+            continue;
+#endif
+        return sent < 0 ? lastSendStatus() : SendStatus::Failed;
+    }
+}
+
+//----------------------------------------------------------------------
+// setNonBlocking
+//----------------------------------------------------------------------
+bool setNonBlocking(UDPSender::SocketHandle s) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ::ioctlsocket(s, FIONBIO, &on) == 0;
+#else
+    const int flags = ::fcntl(s, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+//----------------------------------------------------------------------
+// setIntOption
+//----------------------------------------------------------------------
+bool setIntOption(UDPSender::SocketHandle s, int level, int name, int value) {
+    return ::setsockopt(s, level, name, reinterpret_cast<const char*>(&value), sizeof(value)) == 0;
+}
+
+//----------------------------------------------------------------------
+// applyGroupOptions
+//----------------------------------------------------------------------
+// Set up a socket for a multicast group (TTL, interface, loopback) or a
+// broadcast address, which the kernel refuses without SO_BROADCAST.
+//----------------------------------------------------------------------
+bool applyGroupOptions(UDPSender::SocketHandle s, const sockaddr_in& addr,
+                       const GroupDelivery& group) {
+    if (!UDPSender::isMulticast(addr))
+        return setIntOption(s, SOL_SOCKET, SO_BROADCAST, 1);
+    if (!setIntOption(s, IPPROTO_IP, IP_MULTICAST_TTL, group.multicastTtl) ||
+        !setIntOption(s, IPPROTO_IP, IP_MULTICAST_LOOP, group.multicastLoop ? 1 : 0))
+        return false;
+    if (group.multicastInterface.s_addr == htonl(INADDR_ANY))
+        return true;
+    return ::setsockopt(s, IPPROTO_IP, IP_MULTICAST_IF,
+                        reinterpret_cast<const char*>(&group.multicastInterface),
+                        sizeof(group.multicastInterface)) == 0;
+}
+} // namespace
 
 //----------------------------------------------------------------------
 // open
@@ -14,23 +120,27 @@
 bool UDPSender::open() {
     Logger& logger = Logger::getInstance();
     logger.logUDP("Opening UDP sender");
-    
+
     close();
 
+#ifdef _WIN32
     WSADATA data{};
     if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
         logger.logNetworkError("WSAStartup failed");
         return false;
     }
     initialized_ = true;
+#endif
 
     sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (sock_ == INVALID_SOCKET) {
+    if (sock_ == kInvalidSocket) {
         logger.logNetworkError("Failed to create UDP socket");
         close();
         return false;
     }
-    
+    if (!setNonBlocking(sock_))
+        logger.logNetworkError("Cannot make the UDP socket non-blocking, a full buffer will stall sends");
+
     logger.logUDP("UDP sender opened successfully");
     return true;
 }
@@ -38,103 +148,634 @@ bool UDPSender::open() {
 //----------------------------------------------------------------------
 // setFormat
 //----------------------------------------------------------------------
-// Set the format string for RGB data transmission. The format string
-// should contain placeholders {r}, {g}, {b} for RGB values.
+// Compile the format string once; send() only executes the program.
 //----------------------------------------------------------------------
-void UDPSender::setFormat(const std::string& format) {
-    format_ = format;
+bool UDPSender::setFormat(const std::string& format) {
+    std::string error;
+    if (!format_.compile(format, &error)) {
+        Logger::getInstance().logNetworkError("Invalid UDP format (" + error + "), keeping previous format");
+        return false;
+    }
     Logger::getInstance().logUDP("UDP format set to: " + format);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// setDestinations
+//----------------------------------------------------------------------
+// Remember the device addresses and, if asked, connect one socket per
+// device. Multicast and broadcast devices always get their own socket,
+// so their options do not leak into the shared one.
+//----------------------------------------------------------------------
+bool UDPSender::setDestinations(const std::vector<sockaddr_in>& addrs, bool connected,
+                                const std::vector<GroupDelivery>& groups) {
+    Logger& logger = Logger::getInstance();
+#ifdef RGBSTREAMER_HAS_URING
+    // Sends in flight still point at the old addresses and sockets
+    if (uring_.isOpen())
+        uring_.drain(reaped_);
+    reaped_.clear();
+#endif
+    for (SocketHandle s : connected_)
+        if (s != kInvalidSocket)
+            closeSocket(s);
+    connected_.clear();
+    addrs_ = addrs;
+    health_.assign(addrs_.size(), DeviceHealth{});
+    outcome_.assign(addrs_.size(), 0);
+    if (sock_ == kInvalidSocket) {
+        logger.logNetworkError("Cannot set destinations: UDP socket not initialized");
+        return false;
+    }
+
+    int count = 0, wanted = 0;
+    connected_.assign(addrs_.size(), kInvalidSocket);
+    for (size_t i = 0; i < addrs_.size(); ++i) {
+        const GroupDelivery group = i < groups.size() ? groups[i] : GroupDelivery{};
+        const bool isGroup = isMulticast(addrs_[i]) || group.broadcast ||
+                             addrs_[i].sin_addr.s_addr == htonl(INADDR_BROADCAST);
+        if (!connected && !isGroup)
+            continue;
+        ++wanted;
+        SocketHandle s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (s == kInvalidSocket)
+            continue;
+        if (!setNonBlocking(s)) {
+            closeSocket(s);
+            continue;
+        }
+        if (isGroup && !applyGroupOptions(s, addrs_[i], group)) {
+            logger.logNetworkError("Cannot set multicast/broadcast options for device " +
+                                   std::to_string(i));
+            closeSocket(s);
+            continue;
+        }
+        if (::connect(s, reinterpret_cast<const sockaddr*>(&addrs_[i]), sizeof(addrs_[i])) != 0) {
+            closeSocket(s);
+            continue;
+        }
+        connected_[i] = s;
+        ++count;
+    }
+    if (wanted == 0) {
+        connected_.clear();
+        return true;
+    }
+    logger.logUDP("Connected " + std::to_string(count) + " of " + std::to_string(wanted) +
+                  " device sockets");
+    if (count < wanted)
+        logger.logNetworkError("Some device sockets could not be connected, they use the shared socket");
+    return true;
+}
+
+//----------------------------------------------------------------------
+// isMulticast
+//----------------------------------------------------------------------
+bool UDPSender::isMulticast(const sockaddr_in& addr) {
+    return (ntohl(addr.sin_addr.s_addr) & 0xF0000000u) == 0xE0000000u;
+}
+
+//----------------------------------------------------------------------
+// setTransport
+//----------------------------------------------------------------------
+bool UDPSender::setTransport(UdpTransport transport, const UringOptions& options) {
+    Logger& logger = Logger::getInstance();
+#ifdef RGBSTREAMER_HAS_URING
+    uring_.close();
+    if (transport == UdpTransport::IoUring) {
+        if (!uring_.open(options)) {
+            logger.logNetworkError("io_uring unavailable, using batched sends");
+            return false;
+        }
+        logger.logUDP("UDP transport: io_uring");
+    }
+    return true;
+#else
+    (void)options;
+    if (transport == UdpTransport::IoUring) {
+        logger.logNetworkError("io_uring is not supported on this platform, using batched sends");
+        return false;
+    }
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------
+// setSegmentation
+//----------------------------------------------------------------------
+// Kernels with UDP GSO know the UDP_SEGMENT socket option, so reading it
+// is the probe.
+//----------------------------------------------------------------------
+bool UDPSender::setSegmentation(bool enabled) {
+    segmentation_ = false;
+    if (!enabled)
+        return true;
+#ifdef __linux__
+    int size = 0;
+    socklen_t length = sizeof(size);
+    if (sock_ != kInvalidSocket && ::getsockopt(sock_, SOL_UDP, UDP_SEGMENT, &size, &length) == 0) {
+        segmentation_ = true;
+        Logger::getInstance().logUDP("UDP segmentation offload enabled");
+        return true;
+    }
+#endif
+    Logger::getInstance().logUDP("UDP segmentation offload unavailable, sending packets one by one");
+    return false;
 }
 
 //----------------------------------------------------------------------
 // send
 //----------------------------------------------------------------------
-// Send RGB data using the configured format string. The format string
-// should contain placeholders {r}, {g}, {b} for RGB values.
-// Retries up to 3 times on failure.
+// Render the compiled format into a stack buffer and send it.
 //----------------------------------------------------------------------
-bool UDPSender::send(const sockaddr_in& addr,
-                     const std::array<int, 3>& rgb) {
-    if (sock_ == INVALID_SOCKET) {
+bool UDPSender::send(const sockaddr_in& addr, const std::array<int, 3>& rgb, int index) {
+    if (sock_ == kInvalidSocket) {
         Logger::getInstance().logNetworkError("Cannot send: UDP socket not initialized");
         return false;
     }
 
-    // Replace placeholders in the format string
-    std::string message = format_;
-    
-    // Helper function to replace format specifiers
-    auto replaceFormat = [](std::string& str, const std::string& pattern, int value) {
-        std::regex regex_pattern(pattern);
-        std::smatch match;
-        std::string result = str;
-        
-        while (std::regex_search(result, match, regex_pattern)) {
-            std::string replacement;
-            if (match[1].matched) {
-                // Format specifier present, e.g., {r:01d}
-                int width = std::stoi(match[1].str());
-                char buf[32];
-                // For 01d, we want at least 1 digit, but for 02d, 03d, etc. we want that many digits
-                if (width == 1) {
-                    // 01d means just 1 digit, no padding
-                    std::snprintf(buf, sizeof(buf), "%d", value);
-                } else {
-                    // 02d, 03d, etc. means zero-padded to that width
-                    std::snprintf(buf, sizeof(buf), "%0*d", width, value);
-                }
-                replacement = buf;
-            } else {
-                // Simple placeholder
-                replacement = std::to_string(value);
+    char message[kMaxPayload];
+    const size_t length = format_.render(rgb, index, message, sizeof(message));
+    if (length == 0) {
+        Logger::getInstance().logNetworkError("Cannot send: payload exceeds " +
+                                              std::to_string(kMaxPayload) + " bytes");
+        return false;
+    }
+
+    return sendPacket(addr, message, length);
+}
+
+//----------------------------------------------------------------------
+// sendPacket
+//----------------------------------------------------------------------
+// Send a datagram as is.
+//----------------------------------------------------------------------
+bool UDPSender::sendPacket(const sockaddr_in& addr, const void* data, size_t size) {
+    if (sock_ == kInvalidSocket) {
+        Logger::getInstance().logNetworkError("Cannot send: UDP socket not initialized");
+        return false;
+    }
+    const SendStatus status = sendOnce(sock_, &addr, data, size);
+    if (status == SendStatus::Failed)
+        Logger::getInstance().logNetworkError("UDP send failed");
+    return status == SendStatus::Sent;
+}
+
+//----------------------------------------------------------------------
+// queue
+//----------------------------------------------------------------------
+// Render into the batch arena. Without `{i}` the payload only depends on
+// the color, so a device showing a color rendered earlier in the batch
+// points at the same bytes.
+//----------------------------------------------------------------------
+bool UDPSender::queue(size_t device, const std::array<int, 3>& rgb, int index) {
+    const bool shareable = !format_.usesIndex();
+    if (shareable) {
+        for (const Rendered& r : rendered_) {
+            if (r.rgb == rgb) {
+                batch_.push_back({device, nullptr, r.offset, r.size});
+                return true;
+            }
+        }
+    }
+
+    char message[kMaxPayload];
+    const size_t length = format_.render(rgb, index, message, sizeof(message));
+    if (length == 0) {
+        Logger::getInstance().logNetworkError("Cannot send: payload exceeds " +
+                                              std::to_string(kMaxPayload) + " bytes");
+        return false;
+    }
+    const size_t offset = arena_.size();
+    arena_.insert(arena_.end(), message, message + length);
+    batch_.push_back({device, nullptr, offset, length});
+    if (shareable) {
+        if (rendered_.size() == kSharedPayloads)
+            rendered_.erase(rendered_.begin());
+        rendered_.push_back({rgb, offset, length});
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// queuePacket
+//----------------------------------------------------------------------
+void UDPSender::queuePacket(size_t device, const void* data, size_t size) {
+    batch_.push_back({device, data, 0, size});
+}
+
+//----------------------------------------------------------------------
+// socketFor
+//----------------------------------------------------------------------
+UDPSender::SocketHandle UDPSender::socketFor(size_t device) const {
+    if (device < connected_.size() && connected_[device] != kInvalidSocket)
+        return connected_[device];
+    return sock_;
+}
+
+//----------------------------------------------------------------------
+// segmentRun
+//----------------------------------------------------------------------
+// Number of datagrams from batch_[first] on that can leave as one
+// segmented datagram: caller packets of one device, back to back in
+// memory, all as large as the first except a shorter last one.
+//----------------------------------------------------------------------
+size_t UDPSender::segmentRun(size_t first, size_t count) const {
+    constexpr size_t kMaxUdpPayload = 65507;
+    const Outgoing& head = batch_[first];
+    if (!head.data)
+        return 1;
+    size_t n = 1, total = head.size;
+    while (n < (std::min)(count, kMaxSegments)) {
+        const Outgoing& previous = batch_[first + n - 1];
+        const Outgoing& o = batch_[first + n];
+        if (o.device != head.device || o.data != static_cast<const char*>(previous.data) + previous.size ||
+            previous.size != head.size || o.size == 0 || o.size > head.size ||
+            total + o.size > kMaxUdpPayload)
+            break;
+        total += o.size;
+        ++n;
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// record
+//----------------------------------------------------------------------
+// Count the outcome of one datagram for its device.
+//----------------------------------------------------------------------
+void UDPSender::record(size_t device, Outcome outcome) {
+    if (device < health_.size()) {
+        DeviceHealth& h = health_[device];
+        if (outcome == kSent)
+            ++h.sent;
+        else if (outcome == kDropped)
+            ++h.dropped;
+        else
+            ++h.errors;
+        outcome_[device] |= outcome;
+    }
+    if (outcome != kSent && std::find(failed_.begin(), failed_.end(), device) == failed_.end())
+        failed_.push_back(device);
+}
+
+//----------------------------------------------------------------------
+// skipOpenCircuits
+//----------------------------------------------------------------------
+// Drop the datagrams of paused devices. Once a pause is over the next
+// frame goes out as a probe.
+//----------------------------------------------------------------------
+void UDPSender::skipOpenCircuits(std::chrono::steady_clock::time_point now) {
+    const bool anyPaused = std::any_of(health_.begin(), health_.end(), [&](const DeviceHealth& h) {
+        return h.circuitOpen && now < h.retryAt;
+    });
+    if (!anyPaused)
+        return;
+    batch_.erase(std::remove_if(batch_.begin(), batch_.end(),
+                                [&](const Outgoing& o) {
+                                    if (o.device >= health_.size())
+                                        return false;
+                                    DeviceHealth& h = health_[o.device];
+                                    if (!h.circuitOpen || now >= h.retryAt)
+                                        return false;
+                                    ++h.dropped;
+                                    return true;
+                                }),
+                 batch_.end());
+}
+
+//----------------------------------------------------------------------
+// updateHealth
+//----------------------------------------------------------------------
+// Fold the outcomes of this flush into the circuit breakers. A frame
+// with an error adds 2 to the device's score and a clean frame takes 1
+// away; frames only dropped for a full buffer do not count. Scoring
+// instead of counting failures in a row matters because a refused or
+// unreachable peer is reported on the send after the one that caused
+// it, so a dead device fails every other frame. At twice the threshold
+// the device is paused; a probe that fails again doubles the pause.
+//----------------------------------------------------------------------
+void UDPSender::updateHealth(std::chrono::steady_clock::time_point now) {
+    const int limit = 2 * (std::clamp)(healthOptions_.failureThreshold, 1, 1 << 24);
+    for (size_t i = 0; i < outcome_.size(); ++i) {
+        const uint8_t outcome = outcome_[i];
+        if (outcome == 0)
+            continue;
+        outcome_[i] = 0;
+        DeviceHealth& h = health_[i];
+        if (outcome & kFailed) {
+            h.failureScore = (std::min)(h.failureScore + 2, limit);
+            if (h.failureScore < limit)
+                continue;
+            h.backoff = h.backoff.count() > 0 ? (std::min)(h.backoff * 2, healthOptions_.maxBackoff)
+                                              : healthOptions_.backoff;
+            h.circuitOpen = true;
+            h.retryAt = now + h.backoff;
+            Logger::getInstance().logNetworkError(
+                "Device " + std::to_string(i) + " keeps failing (" + std::to_string(h.errors) +
+                " errors), paused for " + std::to_string(h.backoff.count()) + " ms");
+        } else if (outcome & kSent) {
+            // A successful probe closes the circuit, but the pause only
+            // resets once the score has decayed
+            h.circuitOpen = false;
+            if (h.failureScore > 0 && --h.failureScore == 0 && h.backoff.count() > 0) {
+                h.backoff = std::chrono::milliseconds{0};
+                Logger::getInstance().logUDP("Device " + std::to_string(i) + " recovered");
             }
-            result.replace(match.position(), match.length(), replacement);
         }
-        return result;
+    }
+}
+
+//----------------------------------------------------------------------
+// sendRun
+//----------------------------------------------------------------------
+// Send batch_[first, first + count), which all leave through the same
+// socket: the shared one (with a destination per datagram) or one
+// device's connected socket. On Linux this is one sendmmsg call per
+// 1024 messages, where with segmentation one message carries a whole
+// packet run. A rejected message is skipped; once the socket buffer is
+// full the rest of the run is dropped instead of waited for.
+//----------------------------------------------------------------------
+bool UDPSender::sendRun(size_t first, size_t count) {
+    const SocketHandle s = socketFor(batch_[first].device);
+    const bool shared = s == sock_;
+    bool ok = true;
+
+#ifdef __linux__
+    // One message per datagram, or per run of packets with segmentation
+    msgs_.clear();
+    msgFirst_.clear();
+    iovs_.resize(count);
+    controls_.resize(count);
+    for (size_t k = 0; k < count;) {
+        const Outgoing& o = batch_[first + k];
+        const size_t segments = segmentation_ ? segmentRun(first + k, count - k) : 1;
+        const size_t m = msgs_.size();
+        iovs_[m].iov_base = const_cast<void*>(o.data ? o.data : arena_.data() + o.offset);
+        iovs_[m].iov_len = 0;
+        for (size_t n = 0; n < segments; ++n)
+            iovs_[m].iov_len += batch_[first + k + n].size;
+        mmsghdr msg{};
+        msg.msg_hdr.msg_iov = &iovs_[m];
+        msg.msg_hdr.msg_iovlen = 1;
+        if (shared) {
+            msg.msg_hdr.msg_name = &addrs_[o.device];
+            msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+        if (segments > 1) {
+            msg.msg_hdr.msg_control = controls_[m].bytes;
+            msg.msg_hdr.msg_controllen = sizeof(controls_[m].bytes);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&msg.msg_hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const uint16_t segmentSize = static_cast<uint16_t>(o.size);
+            std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+        }
+        msgs_.push_back(msg);
+        msgFirst_.push_back(k);
+        k += segments;
+    }
+    msgFirst_.push_back(count);
+
+    // Outcome of message m for every datagram it carries
+    auto recordMessage = [&](size_t m, Outcome outcome) {
+        for (size_t k = msgFirst_[m]; k < msgFirst_[m + 1]; ++k)
+            record(batch_[first + k].device, outcome);
     };
-    
-    // Replace red, green, and blue placeholders
-    message = replaceFormat(message, R"(\{r(?::(\d+)d)?\})", rgb[0]);
-    message = replaceFormat(message, R"(\{g(?::(\d+)d)?\})", rgb[1]);
-    message = replaceFormat(message, R"(\{b(?::(\d+)d)?\})", rgb[2]);
-
-    int attempts = 0;
-    while (attempts < 3) {
-        int sent = ::sendto(sock_, message.c_str(), static_cast<int>(message.length()), 0,
-                            reinterpret_cast<const sockaddr*>(&addr),
-                            sizeof(addr));
-        if (sent == static_cast<int>(message.length())) {
-            return true;
-        }
-        ++attempts;
-        
-        if (attempts < 3) {
-            Logger::getInstance().logNetworkError("UDP send attempt " + std::to_string(attempts) + 
-                                                " failed, retrying...");
-        }
-    }
-    
-    Logger::getInstance().logNetworkError("UDP send failed after 3 attempts");
+    const size_t messages = msgs_.size();
+    size_t sent = 0;
+    while (sent < messages) {
+        const unsigned int chunk = static_cast<unsigned int>((std::min)(messages - sent, size_t{1024}));
+        const int n = ::sendmmsg(s, msgs_.data() + sent, chunk, 0);
+        if (n > 0) {
+            for (int k = 0; k < n; ++k)
+                recordMessage(sent + static_cast<size_t>(k), kSent);
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        ok = false;
+        if (n < 0 && lastSendStatus() == SendStatus::WouldBlock) {
+            for (; sent < messages; ++sent)
+                recordMessage(sent, kDropped);
+            break;
+        }
+        // A route whose MTU is below the segment size, or a device
+        // without checksum offload, rejects segmented datagrams: send
+        // packets one by one from the next flush on
+        if (n < 0 && msgs_[sent].msg_hdr.msg_control &&
+            (errno == EINVAL || errno == EIO || errno == EOPNOTSUPP)) {
+            segmentation_ = false;
+            Logger::getInstance().logNetworkError("UDP segmentation offload rejected (" +
+                                                  std::string(std::strerror(errno)) +
+                                                  "), sending packets one by one");
+        }
+        // msgs_[sent] was rejected: skip it and send the rest
+        recordMessage(sent, kFailed);
+        ++sent;
+    }
+#else
+    for (size_t k = 0; k < count; ++k) {
+        const Outgoing& o = batch_[first + k];
+        const void* bytes = o.data ? o.data : arena_.data() + o.offset;
+        const SendStatus status = sendOnce(s, shared ? &addrs_[o.device] : nullptr, bytes, o.size);
+        record(o.device, status == SendStatus::Sent         ? kSent
+                         : status == SendStatus::WouldBlock ? kDropped
+                                                            : kFailed);
+        ok = ok && status == SendStatus::Sent;
+    }
+#endif
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// isUring
+//----------------------------------------------------------------------
+bool UDPSender::isUring() const {
+#ifdef RGBSTREAMER_HAS_URING
+    return uring_.isOpen();
+#else
     return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// flushUring
+//----------------------------------------------------------------------
+// Copy the batch into ring slots and submit it in one io_uring_enter.
+// Failures reported by completions of earlier flushes are collected
+// first. If every slot is still in flight the datagram is dropped
+// rather than waited for.
+//----------------------------------------------------------------------
+bool UDPSender::flushUring() {
+#ifdef RGBSTREAMER_HAS_URING
+    bool ok = true;
+    reaped_.clear();
+    uring_.reap(reaped_);
+    for (const Outgoing& o : batch_) {
+        const SocketHandle s = socketFor(o.device);
+        const sockaddr_in* addr = s == sock_ ? &addrs_[o.device] : nullptr;
+        const void* bytes = o.data ? o.data : arena_.data() + o.offset;
+        if (uring_.queue(s, addr, bytes, o.size, o.device)) {
+            record(o.device, kSent);
+            continue;
+        }
+        // Ring full: push what is prepared and retry once with the
+        // completions that arrived meanwhile
+        uring_.submit();
+        uring_.reap(reaped_);
+        if (uring_.queue(s, addr, bytes, o.size, o.device)) {
+            record(o.device, kSent);
+        } else {
+            record(o.device, kDropped);
+            ok = false;
+        }
+    }
+    if (!uring_.submit()) {
+        Logger::getInstance().logNetworkError("io_uring submission failed");
+        ok = false;
+    }
+    // Errors of sends from earlier flushes are charged to this one
+    uring_.reap(reaped_);
+    for (const UringFailure& f : reaped_) {
+        const bool wouldBlock = f.error == EAGAIN || f.error == EWOULDBLOCK || f.error == ENOBUFS;
+        record(f.tag, wouldBlock ? kDropped : kFailed);
+    }
+    return ok && reaped_.empty();
+#else
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// flush
+//----------------------------------------------------------------------
+// Split the batch into runs per socket and send them. Datagrams for the
+// shared socket go out together; each connected device gets its own run.
+// Paused devices are left out, then the outcomes update their health.
+//----------------------------------------------------------------------
+bool UDPSender::flush() {
+    failed_.clear();
+    bool ok = true;
+    const auto now = std::chrono::steady_clock::now();
+    if (sock_ == kInvalidSocket) {
+        if (!batch_.empty())
+            Logger::getInstance().logNetworkError("Cannot send: UDP socket not initialized");
+        for (const Outgoing& o : batch_)
+            record(o.device, kDropped);
+        ok = batch_.empty();
+    } else {
+        skipOpenCircuits(now);
+        if (isUring()) {
+            ok = flushUring();
+        } else {
+            size_t i = 0;
+            while (i < batch_.size()) {
+                const SocketHandle s = socketFor(batch_[i].device);
+                size_t j = i + 1;
+                if (s == sock_) {
+                    while (j < batch_.size() && socketFor(batch_[j].device) == sock_)
+                        ++j;
+                } else {
+                    while (j < batch_.size() && batch_[j].device == batch_[i].device)
+                        ++j;
+                }
+                ok = sendRun(i, j - i) && ok;
+                i = j;
+            }
+        }
+    }
+    updateHealth(now);
+    batch_.clear();
+    arena_.clear();
+    rendered_.clear();
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// receive
+//----------------------------------------------------------------------
+// Each socket is drained up to a limit, so a chatty receiver cannot keep
+// the send loop here.
+//----------------------------------------------------------------------
+size_t UDPSender::receive(const std::vector<size_t>& devices,
+                          const std::function<void(size_t, const uint8_t*, size_t)>& handler) {
+    constexpr int kMaxReads = 64;
+    uint8_t buffer[kMaxPayload];
+    size_t received = 0;
+
+    bool shared = false;
+    for (size_t device : devices) {
+        if (device >= addrs_.size())
+            continue;
+        const SocketHandle s = socketFor(device);
+        if (s == sock_) {
+            shared = true;
+            continue;
+        }
+        for (int n = 0; n < kMaxReads; ++n) {
+            const int size = static_cast<int>(
+                ::recv(s, reinterpret_cast<char*>(buffer), static_cast<int>(sizeof(buffer)), 0));
+            if (size < 0)
+                break;
+            handler(device, buffer, static_cast<size_t>(size));
+            ++received;
+        }
+    }
+
+    if (!shared || sock_ == kInvalidSocket)
+        return received;
+    for (int n = 0; n < kMaxReads; ++n) {
+        sockaddr_in from{};
+#ifdef _WIN32
+        int fromLength = sizeof(from);
+#else
+        socklen_t fromLength = sizeof(from);
+#endif
+        const int size = static_cast<int>(
+            ::recvfrom(sock_, reinterpret_cast<char*>(buffer), static_cast<int>(sizeof(buffer)), 0,
+                       reinterpret_cast<sockaddr*>(&from), &fromLength));
+        if (size < 0)
+            break;
+        for (size_t device : devices) {
+            if (device >= addrs_.size() || socketFor(device) != sock_ ||
+                addrs_[device].sin_addr.s_addr != from.sin_addr.s_addr ||
+                addrs_[device].sin_port != from.sin_port)
+                continue;
+            handler(device, buffer, static_cast<size_t>(size));
+            ++received;
+        }
+    }
+    return received;
 }
 
 //----------------------------------------------------------------------
 // close
 //----------------------------------------------------------------------
-// Clean up the socket and Winsock resources.
+// Clean up the sockets and Winsock resources.
 //----------------------------------------------------------------------
 void UDPSender::close() {
     Logger& logger = Logger::getInstance();
-    
-    if (sock_ != INVALID_SOCKET) {
+
+#ifdef RGBSTREAMER_HAS_URING
+    uring_.close();
+#endif
+    for (SocketHandle s : connected_)
+        if (s != kInvalidSocket)
+            closeSocket(s);
+    connected_.clear();
+    if (sock_ != kInvalidSocket) {
         logger.logUDP("Closing UDP socket");
-        ::closesocket(sock_);
-        sock_ = INVALID_SOCKET;
+        closeSocket(sock_);
+        sock_ = kInvalidSocket;
     }
+#ifdef _WIN32
     if (initialized_) {
         logger.logUDP("Cleaning up Winsock");
         WSACleanup();
         initialized_ = false;
     }
+#endif
 }
-
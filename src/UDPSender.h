@@ -1,16 +1,113 @@
 #pragma once
 
 #include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
-#include <regex>
+#include <vector>
+#ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+#include "PayloadFormat.h"
+#include "UringTransport.h"
 
 /**
- * Simple wrapper around a UDP socket for sending RGB values.
+ * How `UDPSender::flush` hands a batch to the kernel.
+ */
+enum class UdpTransport {
+    Batched, ///< sendmmsg on Linux, sendto elsewhere; returns once sent
+    IoUring  ///< io_uring submission, completions reaped on later flushes (Linux)
+};
+
+/**
+ * Delivery options of a destination that reaches many receivers with one
+ * datagram: an IPv4 multicast group (224.0.0.0/4) or a broadcast address.
+ */
+struct GroupDelivery {
+    bool broadcast = false;     ///< Destination is a subnet broadcast address (SO_BROADCAST)
+    int multicastTtl = 1;       ///< IP_MULTICAST_TTL; 1 keeps datagrams on the local subnet
+    in_addr multicastInterface{}; ///< IP_MULTICAST_IF; INADDR_ANY follows the routing table
+    bool multicastLoop = false; ///< IP_MULTICAST_LOOP: also deliver to receivers on this host
+};
+
+/**
+ * When a device that keeps failing is taken out of the fan-out.
+ */
+struct HealthOptions {
+    int failureThreshold = 5;                  ///< Failed frames, net of clean ones, that open the circuit
+    std::chrono::milliseconds backoff{250};    ///< First pause of an open circuit
+    std::chrono::milliseconds maxBackoff{8000}; ///< The pause doubles up to this
+};
+
+/**
+ * Send counters and circuit breaker state of one device.
+ */
+struct DeviceHealth {
+    uint64_t sent = 0;      ///< Datagrams handed to the kernel
+    uint64_t dropped = 0;   ///< Datagrams skipped: socket buffer full or circuit open
+    uint64_t errors = 0;    ///< Datagrams the kernel rejected (refused, unreachable, ...)
+    int failureScore = 0;        ///< +2 per failed frame, -1 per clean one
+    bool circuitOpen = false;    ///< Datagrams are dropped until `retryAt`
+    std::chrono::steady_clock::time_point retryAt{}; ///< Next probe of an open circuit
+    std::chrono::milliseconds backoff{0};            ///< Current pause of the circuit
+};
+
+/**
+ * UDP socket for sending RGB values, on Winsock or POSIX sockets.
+ *
+ * Besides sending one packet at a time, the sender batches a frame:
+ * `queue`/`queuePacket` collect the datagrams for all devices and
+ * `flush` sends them. On Linux a flush is a single `sendmmsg` call for
+ * all devices (one per device with connected sockets), so the syscall
+ * cost no longer grows with the device count. Devices that show the same
+ * color share one rendered payload.
+ *
+ * Sockets are non-blocking and every datagram gets a single attempt, so
+ * a sick device never delays the others: a datagram that would block is
+ * dropped (the next frame supersedes it, so a device never has more than
+ * its newest frame pending), and a device whose sends keep failing is
+ * skipped for an exponentially growing pause (circuit breaker) before it
+ * is probed again. `health` exposes per-device counters.
+ *
+ * A destination may be a multicast group or a broadcast address, so one
+ * datagram reaches every controller listening on it. Such a destination
+ * always gets its own socket, carrying its `GroupDelivery` options.
+ *
+ * Long strips arrive as runs of equally sized packets (DDP offsets,
+ * universes) for one device. With `setSegmentation` such a run leaves in
+ * one segmented datagram (UDP GSO) that the kernel, or the NIC, splits
+ * back into the packets, so a 10k-LED frame costs one send instead of
+ * one per packet.
+ *
+ * `receive` reads what devices send back, e.g. the keyframe requests of
+ * the delta protocol.
+ *
+ * With `UdpTransport::IoUring` a flush copies the batch into registered
+ * ring buffers and submits it without waiting; send errors surface in
+ * `failedDevices` of a later flush.
  */
 class UDPSender {
 public:
+#ifdef _WIN32
+    using SocketHandle = SOCKET;
+    static constexpr SocketHandle kInvalidSocket = INVALID_SOCKET;
+#else
+    using SocketHandle = int;
+    static constexpr SocketHandle kInvalidSocket = -1;
+#endif
+
+    UDPSender() = default;
+    UDPSender(const UDPSender&) = delete;
+    UDPSender& operator=(const UDPSender&) = delete;
+    ~UDPSender() { close(); }
+
     /**
      * Initialize Winsock and create the UDP socket.
      * @return true on success, false otherwise.
@@ -19,23 +116,177 @@ public:
 
     /**
      * Set the format string for RGB data transmission.
-     * @param format Format string with placeholders {r}, {g}, {b} for RGB values.
+     * @param format Format string, see `PayloadFormat` for the placeholders.
+     * @return false if the string is invalid; the previous format is kept.
+     */
+    bool setFormat(const std::string& format);
+
+    /**
+     * Register the devices addressed by `queue` and `queuePacket`.
+     * @param addrs     Destination of each device, indexed like the queue calls.
+     * @param connected Give every device its own connected socket, so the
+     *                  kernel skips the route lookup on each send. Devices
+     *                  whose socket cannot be connected use the shared one.
+     * @param groups    Delivery options per device, indexed like `addrs`
+     *                  (may be shorter). Multicast and broadcast
+     *                  destinations get a connected socket carrying them.
+     * @return false if the sender is not open.
+     */
+    bool setDestinations(const std::vector<sockaddr_in>& addrs, bool connected = false,
+                         const std::vector<GroupDelivery>& groups = {});
+
+    /** Whether `addr` is an IPv4 multicast group. */
+    static bool isMulticast(const sockaddr_in& addr);
+
+    /**
+     * Select how batches are sent. Call after `open`.
+     * @param transport Transport to use.
+     * @param options   Ring tuning for `UdpTransport::IoUring`.
+     * @return false if the transport is unavailable; the sender then
+     *         keeps the batched transport.
+     */
+    bool setTransport(UdpTransport transport, const UringOptions& options = UringOptions{});
+
+    /**
+     * Coalesce packet runs into segmented datagrams (UDP_SEGMENT, Linux
+     * 4.18+). Applies to the batched transport; call after `open`.
+     * @return false if the kernel has no UDP segmentation offload; the
+     *         packets then go out one datagram each.
      */
-    void setFormat(const std::string& format);
+    bool setSegmentation(bool enabled);
+
+    /** Whether packet runs are sent as segmented datagrams. */
+    bool segmentation() const { return segmentation_; }
 
     /**
      * Send an RGB triple to the specified address.
+     * @param addr  Destination address.
+     * @param rgb   Array with {R,G,B} values in range [0,255].
+     * @param index Value of the `{i}` placeholder.
+     * @return true if the packet was sent successfully.
+     */
+    bool send(const sockaddr_in& addr, const std::array<int, 3>& rgb, int index = 0);
+
+    /**
+     * Send one prebuilt datagram, e.g. a binary protocol packet.
      * @param addr Destination address.
-     * @param rgb  Array with {R,G,B} values in range [0,255].
+     * @param data Packet bytes.
+     * @param size Packet size in bytes.
      * @return true if the packet was sent successfully.
      */
-    bool send(const sockaddr_in& addr, const std::array<int, 3>& rgb);
+    bool sendPacket(const sockaddr_in& addr, const void* data, size_t size);
+
+    /**
+     * Render an RGB triple for a device into the current batch.
+     * @param device Index into the destinations.
+     * @param rgb    {R,G,B} values in range [0,255].
+     * @param index  Value of the `{i}` placeholder.
+     * @return false if the payload does not fit a datagram.
+     */
+    bool queue(size_t device, const std::array<int, 3>& rgb, int index = 0);
+
+    /**
+     * Add a prebuilt datagram for a device to the current batch. The
+     * bytes are not copied and must stay valid until `flush`.
+     */
+    void queuePacket(size_t device, const void* data, size_t size);
+
+    /**
+     * Send the current batch and start a new one.
+     * @return true if every datagram was sent; see `failedDevices`.
+     */
+    bool flush();
 
-    /** Close the socket and clean up Winsock. */
+    /**
+     * Devices with a datagram that could not be sent by the last flush.
+     * Paused devices are not listed; see `health`.
+     */
+    const std::vector<size_t>& failedDevices() const { return failed_; }
+
+    /** Set when failing devices are paused; applies from the next flush. */
+    void setHealthOptions(const HealthOptions& options) { healthOptions_ = options; }
+
+    /** Counters and circuit state per device, indexed like the destinations. */
+    const std::vector<DeviceHealth>& health() const { return health_; }
+
+    /**
+     * Read the datagrams devices sent back, without blocking.
+     *
+     * Replies on the shared socket are matched to devices by source
+     * address and port. Only the connected sockets of `devices` are read,
+     * since a read also consumes the ICMP errors that the send path
+     * counts against a device.
+     * @param devices Devices whose replies are wanted.
+     * @param handler Called with the device index and the datagram bytes.
+     * @return Number of datagrams handed to `handler`.
+     */
+    size_t receive(const std::vector<size_t>& devices,
+                   const std::function<void(size_t device, const uint8_t* data, size_t size)>& handler);
+
+    /** Close the sockets and clean up Winsock. */
     void close();
 
+    /** Largest payload that fits an Ethernet frame without IP fragmentation. */
+    static constexpr size_t kMaxPayload = 1472;
+
+    /** Most packets in one segmented datagram (UDP_MAX_SEGMENTS of older kernels). */
+    static constexpr size_t kMaxSegments = 64;
+
 private:
-    SOCKET sock_ = INVALID_SOCKET; ///< UDP socket handle
-    bool initialized_ = false;     ///< Whether WSAStartup succeeded
-    std::string format_ = "R{r:03d}G{g:03d}B{b:03d}\n"; ///< Format string for RGB data
+    // One datagram of the batch. Rendered payloads live in arena_ and are
+    // resolved at flush time, since the arena may grow meanwhile.
+    struct Outgoing {
+        size_t device = 0;
+        const void* data = nullptr; ///< Caller's bytes, or null for arena_
+        size_t offset = 0;          ///< Start in arena_ when data is null
+        size_t size = 0;
+    };
+
+    // Payload rendered in this batch, reused by devices with the same color
+    struct Rendered {
+        std::array<int, 3> rgb;
+        size_t offset = 0;
+        size_t size = 0;
+    };
+    static constexpr size_t kSharedPayloads = 8;
+
+    // Per-flush outcome of a device, combined bitwise
+    enum Outcome : uint8_t { kSent = 1, kDropped = 2, kFailed = 4 };
+
+    SocketHandle socketFor(size_t device) const;
+    size_t segmentRun(size_t first, size_t count) const;
+    void skipOpenCircuits(std::chrono::steady_clock::time_point now);
+    bool sendRun(size_t first, size_t count);
+    bool flushUring();
+    bool isUring() const;
+    void record(size_t device, Outcome outcome);
+    void updateHealth(std::chrono::steady_clock::time_point now);
+
+    SocketHandle sock_ = kInvalidSocket; ///< Shared UDP socket
+    bool initialized_ = false;           ///< Whether WSAStartup succeeded
+    PayloadFormat format_;               ///< Compiled format string
+    std::vector<sockaddr_in> addrs_;     ///< Destinations of the batch API
+    std::vector<SocketHandle> connected_; ///< Per-device connected or group sockets (may be invalid)
+    std::vector<Outgoing> batch_;
+    std::vector<char> arena_;            ///< Rendered payloads of the batch
+    std::vector<Rendered> rendered_;     ///< Most recent distinct payloads of the batch
+    std::vector<size_t> failed_;
+    HealthOptions healthOptions_;
+    std::vector<DeviceHealth> health_;   ///< Indexed like addrs_
+    std::vector<uint8_t> outcome_;       ///< Outcome bits of the current flush, per device
+    bool segmentation_ = false;          ///< Send packet runs as segmented datagrams
+#ifdef __linux__
+    // Control message carrying the segment size of one datagram
+    struct SegmentControl {
+        alignas(cmsghdr) char bytes[CMSG_SPACE(sizeof(uint16_t))];
+    };
+    std::vector<mmsghdr> msgs_;          ///< sendmmsg vector, reused across flushes
+    std::vector<iovec> iovs_;
+    std::vector<SegmentControl> controls_;
+    std::vector<size_t> msgFirst_;       ///< First datagram of the run behind each message
+#endif
+#ifdef RGBSTREAMER_HAS_URING
+    UringTransport uring_;               ///< Open when the io_uring transport is selected
+    std::vector<UringFailure> reaped_;   ///< Failed sends collected from the ring
+#endif
 };
@@ -0,0 +1,288 @@
+#include "UringTransport.h"
+
+#ifdef RGBSTREAMER_HAS_URING
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+template <typename T>
+T* at(void* base, size_t offset) {
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(base) + offset);
+}
+
+unsigned loadAcquire(unsigned* p) {
+    return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+void storeRelease(unsigned* p, unsigned v) {
+    std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------
+// supportsAddressedSends
+//----------------------------------------------------------------------
+// IORING_OP_SEND only honours a destination in `addr2` from Linux 6.0
+// on; older kernels accept the ring but fail every send on an
+// unconnected socket. IORING_OP_SEND_ZC arrived in the same release, so
+// the opcode probe tells the two apart.
+//----------------------------------------------------------------------
+bool supportsAddressedSends(int ringFd) {
+    constexpr unsigned kProbeOps = 256;
+    std::vector<uint64_t> storage(
+        (sizeof(io_uring_probe) + kProbeOps * sizeof(io_uring_probe_op) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, kProbeOps) != 0)
+        return false;
+    return IORING_OP_SEND_ZC <= probe->last_op && IORING_OP_SEND_ZC < probe->ops_len &&
+           (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// open
+//----------------------------------------------------------------------
+// Set up the ring with the raw syscalls and map its queues. A kernel
+// older than 6.0 is rejected right after setup, so the caller keeps its
+// batched path. Failing to register the payload region (e.g.
+// RLIMIT_MEMLOCK) is not fatal: sends then simply do not use the fixed
+// buffer.
+//----------------------------------------------------------------------
+bool UringTransport::open(const UringOptions& options) {
+    close();
+    options_ = options;
+    options_.entries = (std::clamp)(options_.entries, 8u, 4096u);
+    options_.slotSize = (std::max)(options_.slotSize, size_t{64});
+
+    io_uring_params params{};
+    if (options_.sqPoll) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = 100; // ms before the poll thread sleeps
+    }
+    const int fd = static_cast<int>(syscall(__NR_io_uring_setup, options_.entries, &params));
+    if (fd < 0)
+        return false;
+    ringFd_ = fd;
+    if (!supportsAddressedSends(ringFd_)) {
+        close();
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap)
+        sqRingSize_ = cqRingSize_ = (std::max)(sqRingSize_, cqRingSize_);
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                   IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        close();
+        return false;
+    }
+    cqRing_ = singleMmap ? sqRing_
+                         : mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                      IORING_OFF_SQES);
+    if (cqRing_ == MAP_FAILED || sqes == MAP_FAILED) {
+        if (cqRing_ == MAP_FAILED)
+            cqRing_ = nullptr;
+        if (sqes != MAP_FAILED)
+            sqes_ = static_cast<io_uring_sqe*>(sqes);
+        close();
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sqHead_ = at<unsigned>(sqRing_, params.sq_off.head);
+    sqTail_ = at<unsigned>(sqRing_, params.sq_off.tail);
+    sqMask_ = *at<unsigned>(sqRing_, params.sq_off.ring_mask);
+    sqArray_ = at<unsigned>(sqRing_, params.sq_off.array);
+    sqFlags_ = at<unsigned>(sqRing_, params.sq_off.flags);
+    sqEntries_ = params.sq_entries;
+    sqLocalTail_ = *sqTail_;
+    cqHead_ = at<unsigned>(cqRing_, params.cq_off.head);
+    cqTail_ = at<unsigned>(cqRing_, params.cq_off.tail);
+    cqMask_ = *at<unsigned>(cqRing_, params.cq_off.ring_mask);
+    cqes_ = at<io_uring_cqe>(cqRing_, params.cq_off.cqes);
+
+    // One slot per SQE; a zero-copy send holds its slot for two CQEs,
+    // which the default CQ size (twice the SQ) absorbs
+    slotCount_ = params.sq_entries;
+    regionSize_ = slotCount_ * options_.slotSize;
+    void* region = mmap(nullptr, regionSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        close();
+        return false;
+    }
+    region_ = static_cast<uint8_t*>(region);
+    iovec iov{region_, regionSize_};
+    registered_ = syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+
+    slots_.assign(slotCount_, Slot{});
+    freeSlots_.resize(slotCount_);
+    for (size_t i = 0; i < slotCount_; ++i)
+        freeSlots_[i] = static_cast<uint32_t>(slotCount_ - 1 - i);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// close
+//----------------------------------------------------------------------
+void UringTransport::close() {
+    if (ringFd_ >= 0 && sqes_ && cqes_) {
+        std::vector<UringFailure> ignored;
+        drain(ignored);
+    }
+    if (region_)
+        munmap(region_, regionSize_);
+    if (sqes_)
+        munmap(sqes_, sqesSize_);
+    if (cqRing_ && cqRing_ != sqRing_)
+        munmap(cqRing_, cqRingSize_);
+    if (sqRing_)
+        munmap(sqRing_, sqRingSize_);
+    if (ringFd_ >= 0)
+        ::close(ringFd_);
+    ringFd_ = -1;
+    sqRing_ = cqRing_ = nullptr;
+    sqes_ = nullptr;
+    cqes_ = nullptr;
+    region_ = nullptr;
+    registered_ = false;
+    slots_.clear();
+    freeSlots_.clear();
+    slotCount_ = 0;
+}
+
+//----------------------------------------------------------------------
+// enter
+//----------------------------------------------------------------------
+int UringTransport::enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+//----------------------------------------------------------------------
+// queue
+//----------------------------------------------------------------------
+// Copy the payload into a slot and fill an SQE: IORING_OP_SEND_ZC from
+// the fixed buffer for large payloads, IORING_OP_SEND otherwise. Both
+// take the destination in addr2/addr_len.
+//----------------------------------------------------------------------
+bool UringTransport::queue(int fd, const sockaddr_in* addr, const void* data, size_t size,
+                           size_t tag) {
+    if (ringFd_ < 0 || freeSlots_.empty() || size > options_.slotSize)
+        return false;
+    if (sqLocalTail_ - loadAcquire(sqHead_) >= sqEntries_)
+        return false;
+
+    const uint32_t slot = freeSlots_.back();
+    freeSlots_.pop_back();
+    uint8_t* bytes = region_ + static_cast<size_t>(slot) * options_.slotSize;
+    std::memcpy(bytes, data, size);
+    const bool zeroCopy = options_.zeroCopyThreshold > 0 && size >= options_.zeroCopyThreshold;
+    slots_[slot] = {tag, zeroCopy, false};
+
+    const unsigned index = sqLocalTail_ & sqMask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = zeroCopy ? IORING_OP_SEND_ZC : IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(bytes);
+    sqe->len = static_cast<uint32_t>(size);
+    sqe->user_data = slot;
+    if (addr) {
+        sqe->addr2 = reinterpret_cast<uint64_t>(addr);
+        sqe->addr_len = sizeof(sockaddr_in);
+    }
+    if (zeroCopy && registered_) {
+        sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+        sqe->buf_index = 0;
+    }
+    sqArray_[index] = index;
+    ++sqLocalTail_;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// submit
+//----------------------------------------------------------------------
+// Publish the prepared SQEs and let the kernel consume them. The kernel
+// issues the sends inline and completes them without blocking us; a
+// partial submission leaves the rest in the SQ for the next call.
+//----------------------------------------------------------------------
+bool UringTransport::submit() {
+    if (ringFd_ < 0)
+        return false;
+    storeRelease(sqTail_, sqLocalTail_);
+    const unsigned pending = sqLocalTail_ - loadAcquire(sqHead_);
+    if (pending == 0)
+        return true;
+    if (options_.sqPoll) {
+        // The poll thread sees the new tail by itself unless it went idle
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if ((loadAcquire(sqFlags_) & IORING_SQ_NEED_WAKEUP) == 0)
+            return true;
+        return enter(0, 0, IORING_ENTER_SQ_WAKEUP) >= 0 || errno == EINTR;
+    }
+    const int n = enter(pending, 0, 0);
+    return n >= 0 || errno == EAGAIN || errno == EBUSY || errno == EINTR;
+}
+
+//----------------------------------------------------------------------
+// reap
+//----------------------------------------------------------------------
+// Walk the ready CQEs. A zero-copy send posts its result first (with
+// IORING_CQE_F_MORE) and a notification once the kernel released the
+// buffer; only then is the slot free again.
+//----------------------------------------------------------------------
+size_t UringTransport::reap(std::vector<UringFailure>& failures) {
+    if (ringFd_ < 0)
+        return 0;
+    unsigned head = *cqHead_;
+    const unsigned tail = loadAcquire(cqTail_);
+    size_t seen = 0;
+    for (; head != tail; ++head, ++seen) {
+        const io_uring_cqe& cqe = cqes_[head & cqMask_];
+        const uint32_t slot = static_cast<uint32_t>(cqe.user_data);
+        if (slot >= slots_.size())
+            continue;
+        if (cqe.flags & IORING_CQE_F_NOTIF) {
+            freeSlots_.push_back(slot);
+            continue;
+        }
+        if (cqe.res < 0)
+            failures.push_back({slots_[slot].tag, -cqe.res});
+        if (cqe.flags & IORING_CQE_F_MORE)
+            slots_[slot].waitingNotif = true;
+        else
+            freeSlots_.push_back(slot);
+    }
+    storeRelease(cqHead_, head);
+    return seen;
+}
+
+//----------------------------------------------------------------------
+// drain
+//----------------------------------------------------------------------
+void UringTransport::drain(std::vector<UringFailure>& failures) {
+    submit();
+    while (inFlight() > 0) {
+        if (reap(failures) > 0)
+            continue;
+        if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            break;
+    }
+}
+
+#endif // RGBSTREAMER_HAS_URING
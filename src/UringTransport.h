@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#ifdef IORING_RECVSEND_FIXED_BUF // send with fixed buffers and SEND_ZC: Linux 6.0 headers
+#define RGBSTREAMER_HAS_URING 1
+#endif
+#endif
+
+/**
+ * Tuning of the io_uring transport.
+ */
+struct UringOptions {
+    unsigned entries = 1024;        ///< Submission queue size and number of payload slots
+    size_t slotSize = 2048;         ///< Bytes per payload slot (at least one datagram)
+    size_t zeroCopyThreshold = 0;   ///< Datagrams this large use IORING_OP_SEND_ZC (0 = never)
+    bool sqPoll = false;            ///< A kernel thread polls the ring, so submit needs no syscall
+};
+
+#ifdef RGBSTREAMER_HAS_URING
+
+/**
+ * A send that completed with an error.
+ */
+struct UringFailure {
+    size_t tag = 0;  ///< Tag passed to `queue`
+    int error = 0;   ///< errno value of the send
+};
+
+/**
+ * Asynchronous UDP transmit path on io_uring, without liburing.
+ *
+ * Payloads are copied into slots of one region that is registered with
+ * the ring once, so zero-copy sends (`IORING_OP_SEND_ZC` with a fixed
+ * buffer) need no per-send page pinning. Smaller datagrams use a plain
+ * `IORING_OP_SEND`, which is cheaper than the zero-copy notification
+ * round trip; on loopback and for datagrams below a few KB the copy
+ * always wins, so zero copy is off unless a threshold is set. `submit`
+ * hands all prepared sends to the kernel in one `io_uring_enter`
+ * without waiting (with `sqPoll`, a kernel thread picks them up and no
+ * syscall is made at all), and `reap` collects the completions that are
+ * already there, so the caller never sleeps in the kernel. A
+ * slot is reused once its send (and, for zero copy, its notification)
+ * completed; when all slots are in flight `queue` refuses new datagrams
+ * rather than waiting.
+ */
+class UringTransport {
+public:
+    UringTransport() = default;
+    UringTransport(const UringTransport&) = delete;
+    UringTransport& operator=(const UringTransport&) = delete;
+    ~UringTransport() { close(); }
+
+    /**
+     * Create the ring and register the payload region.
+     * @return false if io_uring is unavailable (seccomp, ...) or the
+     *         kernel is older than 6.0 and cannot send to an address.
+     */
+    bool open(const UringOptions& options = UringOptions{});
+
+    /** Wait for the sends in flight, then release the ring. */
+    void close();
+
+    bool isOpen() const { return ringFd_ >= 0; }
+
+    /**
+     * Copy a datagram into a free slot and prepare its send.
+     * @param fd   Socket to send on.
+     * @param addr Destination, or null for a connected socket. Must stay
+     *             valid until the send completed.
+     * @param data Payload, copied.
+     * @param size Payload size, at most `slotSize`.
+     * @param tag  Caller value reported back with failed sends.
+     * @return false if no slot is free or the payload is too large.
+     */
+    bool queue(int fd, const sockaddr_in* addr, const void* data, size_t size, size_t tag);
+
+    /**
+     * Hand the prepared sends to the kernel without waiting.
+     * @return false if the kernel rejected the submission.
+     */
+    bool submit();
+
+    /**
+     * Collect the completions that are ready.
+     * @param failures Receives every send that failed.
+     * @return Number of completions seen.
+     */
+    size_t reap(std::vector<UringFailure>& failures);
+
+    /** Wait until every send in flight completed. */
+    void drain(std::vector<UringFailure>& failures);
+
+    /** Number of slots whose send has not completed yet. */
+    size_t inFlight() const { return slotCount_ - freeSlots_.size(); }
+
+private:
+    struct Slot {
+        size_t tag = 0;
+        bool zeroCopy = false;
+        bool waitingNotif = false; ///< Send completed, notification pending
+    };
+
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+
+    UringOptions options_;
+    int ringFd_ = -1;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqesSize_ = 0;
+
+    // Ring fields, pointing into the shared mappings
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* sqFlags_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    uint8_t* region_ = nullptr;    ///< Registered payload slots
+    size_t regionSize_ = 0;
+    bool registered_ = false;      ///< Region registered as fixed buffer 0
+    size_t slotCount_ = 0;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> freeSlots_;
+    unsigned sqEntries_ = 0;
+    unsigned sqLocalTail_ = 0;     ///< Tail including prepared, unpublished SQEs
+};
+
+#endif // RGBSTREAMER_HAS_URING
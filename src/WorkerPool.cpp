@@ -0,0 +1,122 @@
+#include "WorkerPool.h"
+
+//----------------------------------------------------------------------
+// WorkerPool
+//----------------------------------------------------------------------
+// Start `threads - 1` workers; the thread calling run() is the last one.
+//----------------------------------------------------------------------
+WorkerPool::WorkerPool(int threads) {
+    if (threads < 1)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads < 1)
+        threads = 1;
+    for (int i = 1; i < threads; ++i)
+        workers_.emplace_back([this] { workerLoop(); });
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeCv_.notify_all();
+    for (auto& t : workers_)
+        t.join();
+}
+
+//----------------------------------------------------------------------
+// run
+//----------------------------------------------------------------------
+// Publish a job, help executing it and block until every task is done
+// and no worker still references the task.
+//----------------------------------------------------------------------
+void WorkerPool::run(int taskCount, const std::function<void(int)>& task) {
+    if (taskCount <= 0)
+        return;
+    if (workers_.empty() || taskCount == 1) {
+        for (int i = 0; i < taskCount; ++i)
+            task(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(runMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        taskCount_ = taskCount;
+        pendingTasks_ = taskCount;
+        nextTask_.store(0, std::memory_order_relaxed);
+        ++generation_;
+    }
+    wakeCv_.notify_all();
+
+    finishTasks(drainTasks(task, taskCount), false);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock, [this] { return pendingTasks_ == 0 && activeWorkers_ == 0; });
+    task_ = nullptr;
+}
+
+//----------------------------------------------------------------------
+// drainTasks
+//----------------------------------------------------------------------
+// Claim task indices until the current job is exhausted. Returns the
+// number of tasks executed by this thread.
+//----------------------------------------------------------------------
+int WorkerPool::drainTasks(const std::function<void(int)>& task, int taskCount) {
+    int done = 0;
+    for (;;) {
+        const int i = nextTask_.fetch_add(1, std::memory_order_relaxed);
+        if (i >= taskCount)
+            break;
+        task(i);
+        ++done;
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// finishTasks
+//----------------------------------------------------------------------
+// Account for executed tasks and wake the caller once the job is done.
+//----------------------------------------------------------------------
+void WorkerPool::finishTasks(int done, bool leavingWorker) {
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingTasks_ -= done;
+        if (leavingWorker)
+            --activeWorkers_;
+        finished = pendingTasks_ == 0 && activeWorkers_ == 0;
+    }
+    if (finished)
+        doneCv_.notify_one();
+}
+
+//----------------------------------------------------------------------
+// workerLoop
+//----------------------------------------------------------------------
+// Sleep until a new job generation is published, then help drain it.
+// The job is captured under the lock so a late worker never touches a
+// task that run() has already returned from.
+//----------------------------------------------------------------------
+void WorkerPool::workerLoop() {
+    unsigned seen = 0;
+    for (;;) {
+        const std::function<void(int)>* task = nullptr;
+        int taskCount = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeCv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_)
+                return;
+            seen = generation_;
+            if (!task_ || pendingTasks_ == 0)
+                continue;
+            task = task_;
+            taskCount = taskCount_;
+            ++activeWorkers_;
+        }
+        finishTasks(drainTasks(*task, taskCount), true);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Persistent pool of worker threads for data-parallel frame processing.
+ *
+ * `run` splits a job into numbered tasks that are executed by the
+ * workers and by the calling thread. The threads are created once and
+ * sleep between jobs, so dispatching a job costs a wakeup rather than a
+ * thread start.
+ */
+class WorkerPool {
+public:
+    /**
+     * Create a pool.
+     * @param threads Total number of threads working on a job, including
+     *                the caller. Values below 1 select
+     *                `std::thread::hardware_concurrency()`.
+     */
+    explicit WorkerPool(int threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /** Number of threads that execute a job, including the caller. */
+    int threadCount() const { return static_cast<int>(workers_.size()) + 1; }
+
+    /**
+     * Execute `task(0) ... task(taskCount - 1)` and wait for completion.
+     *
+     * Tasks may run in any order and on any thread. Only one job runs at
+     * a time; concurrent callers are serialized.
+     */
+    void run(int taskCount, const std::function<void(int)>& task);
+
+private:
+    void workerLoop();
+    int drainTasks(const std::function<void(int)>& task, int taskCount);
+    void finishTasks(int done, bool leavingWorker);
+
+    std::vector<std::thread> workers_;
+    std::mutex runMutex_;                ///< Serializes callers of run()
+    std::mutex mutex_;
+    std::condition_variable wakeCv_;     ///< Signals a new job or shutdown
+    std::condition_variable doneCv_;     ///< Signals job completion
+    const std::function<void(int)>* task_ = nullptr;
+    int taskCount_ = 0;
+    std::atomic<int> nextTask_{0};
+    int pendingTasks_ = 0;               ///< Guarded by mutex_
+    int activeWorkers_ = 0;              ///< Workers inside the job, guarded by mutex_
+    unsigned generation_ = 0;            ///< Incremented for each job
+    bool stop_ = false;
+};
@@ -0,0 +1,134 @@
+#include "ZoneExtractor.h"
+#include "PixelKernels.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------
+// setLayout
+//----------------------------------------------------------------------
+// Store the layout and invalidate the cached geometry.
+//----------------------------------------------------------------------
+void ZoneExtractor::setLayout(const ZoneLayout& layout) {
+    layout_ = layout;
+    width_ = 0;
+    height_ = 0;
+}
+
+//----------------------------------------------------------------------
+// prepare
+//----------------------------------------------------------------------
+// Precompute which zone every pixel of an edge band belongs to. Only
+// runs when the resolution or the layout changes.
+//----------------------------------------------------------------------
+void ZoneExtractor::prepare(int width, int height, int sourceHeight) {
+    width_ = width;
+    height_ = height;
+    sourceHeight_ = sourceHeight;
+    depth_ = (std::min)(width, height) / 10;
+    if (layout_.depth > 0) {
+        depth_ = layout_.depth;
+        if (sourceHeight > 0)
+            depth_ = static_cast<int>(static_cast<long long>(layout_.depth) * height / sourceHeight);
+    }
+    depth_ = (std::max)(1, (std::min)({depth_, width, height}));
+
+    const int topBase = 0;
+    const int rightBase = topBase + layout_.top;
+    const int bottomBase = rightBase + layout_.right;
+    const int leftBase = bottomBase + layout_.bottom;
+    const int zoneCount = layout_.count();
+
+    pixelsPerZone_.assign(zoneCount, 0);
+    sums_.assign(static_cast<size_t>(zoneCount) * 3, 0);
+
+    // Horizontal edges: split the columns into equal segments
+    topSegments_.clear();
+    for (int i = 0; i < layout_.top; ++i) {
+        const int x0 = i * width / layout_.top;
+        const int x1 = (i + 1) * width / layout_.top;
+        topSegments_.push_back({x0, x1, topBase + i});
+        pixelsPerZone_[topBase + i] = static_cast<uint64_t>(x1 - x0) * depth_;
+    }
+    bottomSegments_.clear();
+    for (int i = 0; i < layout_.bottom; ++i) {
+        const int x0 = i * width / layout_.bottom;
+        const int x1 = (i + 1) * width / layout_.bottom;
+        // Bottom edge runs right to left
+        const int zone = bottomBase + layout_.bottom - 1 - i;
+        bottomSegments_.push_back({x0, x1, zone});
+        pixelsPerZone_[zone] = static_cast<uint64_t>(x1 - x0) * depth_;
+    }
+
+    // Vertical edges: one zone per row
+    leftZoneOfRow_.assign(layout_.left > 0 ? height : 0, 0);
+    for (int y = 0; y < static_cast<int>(leftZoneOfRow_.size()); ++y) {
+        // Left edge runs bottom to top
+        const int zone = leftBase + layout_.left - 1 - y * layout_.left / height;
+        leftZoneOfRow_[y] = zone;
+        pixelsPerZone_[zone] += depth_;
+    }
+    rightZoneOfRow_.assign(layout_.right > 0 ? height : 0, 0);
+    for (int y = 0; y < static_cast<int>(rightZoneOfRow_.size()); ++y) {
+        const int zone = rightBase + y * layout_.right / height;
+        rightZoneOfRow_[y] = zone;
+        pixelsPerZone_[zone] += depth_;
+    }
+}
+
+//----------------------------------------------------------------------
+// extract
+//----------------------------------------------------------------------
+// Walk the rows once and add each edge segment to its zone, then turn
+// the sums into colors.
+//----------------------------------------------------------------------
+void ZoneExtractor::extract(const FrameView& frame, std::vector<Rgb8>& out, int sourceHeight) {
+    const int zoneCount = layout_.count();
+    if (zoneCount == 0 || frame.empty()) {
+        out.clear();
+        return;
+    }
+    if (frame.width != width_ || frame.height != height_ || sourceHeight != sourceHeight_)
+        prepare(frame.width, frame.height, sourceHeight);
+
+    std::fill(sums_.begin(), sums_.end(), 0);
+    const RowSumKernel kernel = activeRowSumKernel();
+    const bool hasLeft = !leftZoneOfRow_.empty();
+    const bool hasRight = !rightZoneOfRow_.empty();
+    const int rightX = width_ - depth_;
+
+    for (int y = 0; y < height_; ++y) {
+        const bool inTop = y < depth_;
+        const bool inBottom = y >= height_ - depth_;
+        // Interior rows of a layout without side zones are skipped
+        if (!inTop && !inBottom && !hasLeft && !hasRight)
+            continue;
+
+        const uint8_t* row = frame.row(y);
+        if (inTop) {
+            for (const auto& seg : topSegments_)
+                kernel(row + seg.x0 * 4, seg.x1 - seg.x0, &sums_[seg.zone * 3]);
+        }
+        if (inBottom) {
+            for (const auto& seg : bottomSegments_)
+                kernel(row + seg.x0 * 4, seg.x1 - seg.x0, &sums_[seg.zone * 3]);
+        }
+        if (hasLeft)
+            kernel(row, depth_, &sums_[leftZoneOfRow_[y] * 3]);
+        if (hasRight)
+            kernel(row + rightX * 4, depth_, &sums_[rightZoneOfRow_[y] * 3]);
+    }
+
+    const int rLane = frame.format == PixelFormat::RGBA8 ? 0 : 2;
+    const int bLane = frame.format == PixelFormat::RGBA8 ? 2 : 0;
+    out.resize(zoneCount);
+    for (int z = 0; z < zoneCount; ++z) {
+        const uint64_t n = pixelsPerZone_[z];
+        const uint64_t* s = &sums_[z * 3];
+        if (n == 0) {
+            out[z] = {0, 0, 0};
+            continue;
+        }
+        out[z] = {static_cast<uint8_t>(s[rLane] / n),
+                  static_cast<uint8_t>(s[1] / n),
+                  static_cast<uint8_t>(s[bLane] / n)};
+    }
+}
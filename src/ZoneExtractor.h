@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ColorFrame.h"
+#include "FrameView.h"
+
+/**
+ * Number of LED zones along each screen edge and how far they reach
+ * into the picture.
+ */
+struct ZoneLayout {
+    int top = 0;    ///< Zones along the top edge
+    int right = 0;  ///< Zones along the right edge
+    int bottom = 0; ///< Zones along the bottom edge
+    int left = 0;   ///< Zones along the left edge
+    int depth = 0;  ///< Zone depth in pixels (0 = 1/10 of the shorter side)
+
+    /** Total number of zones. */
+    int count() const { return top + right + bottom + left; }
+};
+
+/**
+ * Computes the average color of every edge zone in one pass over a
+ * frame.
+ *
+ * Zones are ordered clockwise, the way LED strips are usually glued
+ * behind a screen: top edge left to right, right edge top to bottom,
+ * bottom edge right to left, left edge bottom to top. Corner pixels
+ * contribute to both adjoining edges.
+ *
+ * Each row of the frame is read once. Pixels inside a zone are summed
+ * with the SIMD row kernel, one call per zone segment of the row, so
+ * the cost stays close to that of a single full-frame average no matter
+ * how many zones are configured.
+ */
+class ZoneExtractor {
+public:
+    /** Set the zone layout. Geometry is rebuilt on the next frame. */
+    void setLayout(const ZoneLayout& layout);
+
+    /** Current zone layout. */
+    const ZoneLayout& layout() const { return layout_; }
+
+    /**
+     * Compute the zone colors of a frame.
+     * @param frame Frame to analyze.
+     * @param out   Receives `layout().count()` colors; cleared if the
+     *              layout is empty or the frame is empty.
+     * @param sourceHeight Height of the captured frame when `frame` is a
+     *              downscaled copy of it (0 = not scaled). The zone depth
+     *              is given in captured pixels and scaled accordingly.
+     */
+    void extract(const FrameView& frame, std::vector<Rgb8>& out, int sourceHeight = 0);
+
+private:
+    // Contiguous run of pixels in a row that belongs to one zone
+    struct Segment {
+        int x0;
+        int x1;
+        int zone;
+    };
+
+    void prepare(int width, int height, int sourceHeight);
+
+    ZoneLayout layout_;
+    int width_ = 0;
+    int height_ = 0;
+    int sourceHeight_ = 0;
+    int depth_ = 0;
+    std::vector<Segment> topSegments_;    ///< Segments of rows y < depth
+    std::vector<Segment> bottomSegments_; ///< Segments of rows y >= height - depth
+    std::vector<int> leftZoneOfRow_;      ///< Left zone index per row
+    std::vector<int> rightZoneOfRow_;     ///< Right zone index per row
+    std::vector<uint64_t> pixelsPerZone_;
+    std::vector<uint64_t> sums_;          ///< Three byte lanes per zone
+};
@@ -0,0 +1,70 @@
+#include "TestSupport.h"
+#include "DeltaCodec.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------
+// testDelta
+//----------------------------------------------------------------------
+// Lossless round trips of strips of several lengths, with changes from
+// a single LED to the whole strip, then 1000 LEDs over a link dropping
+// 5% of the datagrams. The decoder's keyframe request reaches the
+// encoder before its next frame; every frame the decoder completes
+// without a pending request must match, and it must recover once the
+// loss stops.
+//----------------------------------------------------------------------
+void testDelta() {
+    std::mt19937 rng(19);
+    auto randomColor = [&] {
+        return Rgb8{static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng())};
+    };
+
+    for (size_t count : {size_t{1}, size_t{300}, size_t{489}, size_t{490}, size_t{1000}, size_t{5000}}) {
+        DeltaEncoder encoder;
+        DeltaDecoder decoder;
+        std::vector<Rgb8> pixels(count);
+        for (auto& px : pixels)
+            px = randomColor();
+        for (int frame = 0; frame < 60; ++frame) {
+            if (frame % 4 == 0) {
+                for (auto& px : pixels)
+                    px = randomColor();
+            } else {
+                for (size_t c = rng() % (count / 8 + 2); c > 0; --c)
+                    pixels[rng() % count] = randomColor();
+            }
+            bool applied = true;
+            for (const PacketView& packet : encoder.encode(pixels.data(), pixels.size()))
+                applied = applied && packet.size <= DeltaWire::kMaxPacket && decoder.apply(packet.data, packet.size);
+            if (!expect(applied && !decoder.needsKeyframe() && decoder.pixels() == pixels,
+                        std::to_string(count) + " LEDs: round trip differs in frame " + std::to_string(frame)))
+                break;
+        }
+    }
+
+    DeltaEncoder lossy;
+    DeltaDecoder receiver;
+    std::vector<Rgb8> pixels(1000);
+    for (auto& px : pixels)
+        px = randomColor();
+    int wrong = 0;
+    constexpr int kFrames = 3000;
+    for (int frame = 0; frame < kFrames + 30; ++frame) {
+        for (size_t i = 400; i < 600; ++i)
+            pixels[i] = randomColor();
+        const uint64_t completed = receiver.frames();
+        for (const PacketView& packet : lossy.encode(pixels.data(), pixels.size())) {
+            if (frame < kFrames && rng() % 100 < 5)
+                continue;
+            receiver.apply(packet.data, packet.size);
+        }
+        if (receiver.needsKeyframe())
+            lossy.requestKeyframe();
+        else if (receiver.frames() != completed && receiver.pixels() != pixels)
+            ++wrong;
+    }
+    expect(wrong == 0, std::to_string(wrong) + " frames completed with stale pixels");
+    expect(!receiver.needsKeyframe() && receiver.pixels() == pixels, "decoder did not recover after loss");
+}
@@ -0,0 +1,176 @@
+#include "TestSupport.h"
+#include "LetterboxDetector.h"
+#include "PixelFormats.h"
+#include "RGBProcessor.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+//----------------------------------------------------------------------
+// floatToHalf
+//----------------------------------------------------------------------
+// Round a value in [0, 1] to the nearest IEEE half bit pattern.
+//----------------------------------------------------------------------
+uint16_t floatToHalf(double v) {
+    if (v <= 0.0)
+        return 0;
+    int e = 0;
+    const double m = std::frexp(v, &e); // v = m * 2^e, m in [0.5, 1)
+    int exponent = e - 1 + 15;
+    if (exponent <= 0)
+        return static_cast<uint16_t>(std::lround(std::ldexp(v, 24)));
+    int mantissa = static_cast<int>(std::lround((2.0 * m - 1.0) * 1024.0));
+    if (mantissa == 1024) {
+        mantissa = 0;
+        ++exponent;
+    }
+    return static_cast<uint16_t>((exponent << 10) | mantissa);
+}
+
+std::string rgb(const std::array<int, 3>& c) {
+    return std::to_string(c[0]) + "," + std::to_string(c[1]) + "," + std::to_string(c[2]);
+}
+
+//----------------------------------------------------------------------
+// checkAgreement
+//----------------------------------------------------------------------
+// The same noise picture as RGBA8, RGB10A2 and linear half floats, at
+// a size with a remainder for every SIMD width: the 10-bit average must
+// be within one step of the 8-bit one and the half float average within
+// one step of the 8-bit linear-light one.
+//----------------------------------------------------------------------
+void checkAgreement(int width, int height) {
+    auto frame = makeFrame(width, height, PixelFormat::RGBA8, 77);
+    std::vector<uint8_t> tenBit(static_cast<size_t>(width) * height * 4);
+    std::vector<uint8_t> half(static_cast<size_t>(width) * height * 8);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* src = frame.view.row(y);
+        for (int x = 0; x < width; ++x) {
+            const uint8_t* px = src + x * 4;
+            uint32_t packed = 3u << 30;
+            uint16_t h[4] = {0, 0, 0, 0x3C00};
+            for (int c = 0; c < 3; ++c) {
+                packed |= static_cast<uint32_t>((px[c] << 2) | (px[c] >> 6)) << (10 * c);
+                h[c] = floatToHalf(srgbToLinear(px[c] / 255.0));
+            }
+            const size_t i = static_cast<size_t>(y) * width + x;
+            std::memcpy(&tenBit[i * 4], &packed, 4);
+            std::memcpy(&half[i * 8], h, 8);
+        }
+    }
+    const FrameView tenBitView{tenBit.data(), width, height, static_cast<size_t>(width) * 4, PixelFormat::RGB10A2};
+    const FrameView halfView{half.data(), width, height, static_cast<size_t>(width) * 8, PixelFormat::RGBA16F};
+
+    SamplingOptions linear;
+    linear.linearLight = true;
+    const auto mean8 = getRGBAverage(frame.view);
+    const auto linear8 = getRGBAverage(frame.view, linear, nullptr);
+    const auto mean10 = getRGBAverage(tenBitView);
+    const auto half16 = getRGBAverage(halfView);
+    auto near = [](const std::array<int, 3>& a, const std::array<int, 3>& b) {
+        for (int c = 0; c < 3; ++c) {
+            if (std::abs(a[c] - b[c]) > 1)
+                return false;
+        }
+        return true;
+    };
+    const std::string size = std::to_string(width) + "x" + std::to_string(height);
+    expect(near(mean10, mean8), size + ": RGB10A2 average " + rgb(mean10) + ", RGBA8 " + rgb(mean8));
+    expect(near(half16, linear8), size + ": RGBA16F average " + rgb(half16) + ", RGBA8 linear light " + rgb(linear8));
+}
+
+//----------------------------------------------------------------------
+// checkLinearCheckerboard
+//----------------------------------------------------------------------
+// Black and white pixels average to half the light, which is 188 in
+// sRGB, not the 128 of averaging the encoded values.
+//----------------------------------------------------------------------
+void checkLinearCheckerboard() {
+    auto checker = makeFrame(64, 64, PixelFormat::BGRA8, 1);
+    for (int y = 0; y < 64; ++y) {
+        uint8_t* row = checker.pixels.data() + y * checker.view.rowPitch;
+        for (int x = 0; x < 64; ++x)
+            std::fill(row + x * 4, row + x * 4 + 4, static_cast<uint8_t>((x + y) % 2 ? 255 : 0));
+    }
+    SamplingOptions linear;
+    linear.linearLight = true;
+    const auto mix = getRGBAverage(checker.view, linear, nullptr);
+    expect(mix == std::array<int, 3>{188, 188, 188}, "linear checkerboard average " + rgb(mix));
+}
+
+//----------------------------------------------------------------------
+// checkSdrWhite
+//----------------------------------------------------------------------
+// HDR desktop with SDR white at 240 nits: scRGB 3.0 converts to white
+// and 1.0 to a third of it in linear light.
+//----------------------------------------------------------------------
+void checkSdrWhite() {
+    const uint16_t pixel[4] = {0x4200, 0x3C00, 0x4200, 0x3C00}; // 3.0, 1.0, 3.0, 1.0
+    const FrameView hdr{reinterpret_cast<const uint8_t*>(pixel), 1, 1, 8, PixelFormat::RGBA16F};
+    std::vector<uint8_t> converted;
+    const FrameView sdr = convertToRgba8(hdr, converted, 240.0);
+    const int third = static_cast<int>(std::lround(linearToSrgb(1.0 / 3.0) * 255.0));
+    expect(sdr.data[0] == 255 && std::abs(sdr.data[1] - third) <= 1 && sdr.data[2] == 255,
+           "SDR white scaling gave " + std::to_string(sdr.data[0]) + "," + std::to_string(sdr.data[1]) + "," +
+               std::to_string(sdr.data[2]));
+}
+
+//----------------------------------------------------------------------
+// checkLetterboxWhiteLevel
+//----------------------------------------------------------------------
+// Half float bars at scRGB 0.02 are brighter than the black threshold
+// on an 80-nit desktop but below it once SDR white is at 240 nits, the
+// level the analyzer averages the frame at. The detector must find the
+// bars only in the second case.
+//----------------------------------------------------------------------
+void checkLetterboxWhiteLevel() {
+    const int w = 640, h = 360, bar = 60;
+    const uint16_t dim = floatToHalf(0.02);
+    const uint16_t bright = floatToHalf(0.5);
+    std::vector<uint16_t> pixels(static_cast<size_t>(w) * h * 4);
+    for (int y = 0; y < h; ++y) {
+        const uint16_t v = y < bar || y >= h - bar ? dim : bright;
+        for (int x = 0; x < w; ++x) {
+            uint16_t* px = &pixels[(static_cast<size_t>(y) * w + x) * 4];
+            px[0] = px[1] = px[2] = v;
+            px[3] = 0x3C00;
+        }
+    }
+    const FrameView frame{reinterpret_cast<const uint8_t*>(pixels.data()), w, h, static_cast<size_t>(w) * 8,
+                          PixelFormat::RGBA16F};
+    const LetterboxOptions options;
+    const int settleFrames = options.recheckFrames * options.stableChecks;
+    for (double nits : {kScRgbWhiteNits, 240.0}) {
+        LetterboxDetector detector;
+        detector.setOptions(options, nits);
+        for (int i = 0; i < settleFrames; ++i)
+            detector.update(frame);
+        const ContentBounds expected = nits == kScRgbWhiteNits ? ContentBounds{0, 0, w, h}
+                                                               : ContentBounds{0, bar, w, h - 2 * bar};
+        const ContentBounds& b = detector.bounds();
+        expect(b == expected, "SDR white " + std::to_string(static_cast<int>(nits)) + " nits: bounds " +
+                                  std::to_string(b.x) + "," + std::to_string(b.y) + " " + std::to_string(b.width) +
+                                  "x" + std::to_string(b.height));
+    }
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// testFormats
+//----------------------------------------------------------------------
+// 10-bit and half float averages against the 8-bit ones, linear-light
+// averaging and the SDR white level of HDR desktops, in the analyzer
+// and in the letterbox detector.
+//----------------------------------------------------------------------
+void testFormats() {
+    checkAgreement(1920, 1080);
+    checkAgreement(333, 71);
+    checkLinearCheckerboard();
+    checkSdrWhite();
+    checkLetterboxWhiteLevel();
+}
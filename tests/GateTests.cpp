@@ -0,0 +1,89 @@
+#include "TestSupport.h"
+#include "ChangeGate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------
+// testGate
+//----------------------------------------------------------------------
+// Feed the change gate 20 s each of a static picture with +-1 noise, a
+// slow fade and a busy picture at 30 fps, for a single color and a
+// 300-LED strip, with a threshold of 2 and a 1 s keepalive. Every
+// decision must match a reference that compares with the colors last
+// passed, and no gap between two passed frames may exceed the
+// keepalive by more than a frame. A disabled gate passes everything.
+//----------------------------------------------------------------------
+void testGate() {
+    using Clock = ChangeGate::Clock;
+    constexpr int kFps = 30;
+    constexpr int kPhaseFrames = 20 * kFps;
+    const auto frameTime = std::chrono::microseconds(1000000 / kFps);
+    ChangeGateOptions options;
+    options.threshold = 2;
+    options.keepalive = std::chrono::milliseconds(1000);
+
+    std::mt19937 rng(7);
+    const char* phases[] = {"static + noise", "slow fade", "busy"};
+    for (size_t bytes : {size_t{3}, size_t{900}}) {
+        ChangeGate gate;
+        gate.reset(1, options);
+        std::vector<uint8_t> base(bytes), colors(bytes), reference;
+        for (auto& b : base)
+            b = static_cast<uint8_t>(64 + rng() % 128);
+        Clock::time_point now{}, referenceAt{};
+        Clock::duration longestGap{};
+        uint64_t suppressed = 0;
+        const std::string strip = bytes == 3 ? "single color" : "300 LEDs";
+        for (int phase = 0; phase < 3; ++phase) {
+            int mismatches = 0;
+            for (int f = 0; f < kPhaseFrames; ++f) {
+                for (size_t i = 0; i < bytes; ++i) {
+                    int v = base[i];
+                    if (phase == 0)
+                        v += static_cast<int>(rng() % 3) - 1;
+                    else if (phase == 1)
+                        v += f / 10;
+                    else
+                        v = static_cast<int>(rng() % 256);
+                    colors[i] = static_cast<uint8_t>((std::clamp)(v, 0, 255));
+                }
+                bool expected = reference.empty() || now - referenceAt >= options.keepalive;
+                for (size_t i = 0; i < bytes && !expected; ++i)
+                    expected = std::abs(colors[i] - reference[i]) > options.threshold;
+                const bool passed = gate.pass(0, colors.data(), bytes, now);
+                mismatches += passed != expected ? 1 : 0;
+                if (passed) {
+                    if (!reference.empty())
+                        longestGap = (std::max)(longestGap, now - referenceAt);
+                    reference = colors;
+                    referenceAt = now;
+                } else {
+                    ++suppressed;
+                }
+                now += frameTime;
+            }
+            expect(mismatches == 0, strip + ", " + phases[phase] + ": " + std::to_string(mismatches) +
+                                        " decisions differ from the reference");
+        }
+        expect(gate.suppressed(0) == suppressed, strip + ": suppressed count " +
+                                                     std::to_string(gate.suppressed(0)) + ", expected " +
+                                                     std::to_string(suppressed));
+        expect(longestGap <= options.keepalive + frameTime,
+               strip + ": keepalive missed, longest gap " +
+                   std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(longestGap).count()) +
+                   " ms");
+    }
+
+    ChangeGate off;
+    off.reset(1, ChangeGateOptions{});
+    const uint8_t color[3] = {10, 20, 30};
+    bool allPassed = true;
+    for (int i = 0; i < 10; ++i)
+        allPassed = off.pass(0, color, 3, Clock::time_point{}) && allPassed;
+    expect(allPassed && off.suppressedTotal() == 0, "disabled gate suppressed a packet");
+}
@@ -0,0 +1,72 @@
+#include "TestSupport.h"
+#include "ProtocolDecoder.h"
+#include "UDPSender.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------
+// testGso
+//----------------------------------------------------------------------
+// A 10k-LED frame as DDP (21 packets) and E1.31 (59 universes) to a
+// loopback receiver, one datagram per packet and as one segmented
+// datagram (UDP GSO), over the shared and a connected socket. The
+// receiver must get every packet with its own header and the decoded
+// frame must match.
+//----------------------------------------------------------------------
+void testGso() {
+#ifdef _WIN32
+    std::cout << "  UDP segmentation offload is Linux only, skipped\n";
+#else
+    constexpr size_t kLeds = 10000;
+    LoopbackReceivers receiver;
+    if (!expect(receiver.open(1, 4 << 20), "cannot bind a loopback receiver"))
+        return;
+
+    std::mt19937 rng(20);
+    std::vector<Rgb8> pixels(kLeds);
+    for (auto& px : pixels)
+        px = {static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng())};
+
+    struct Named {
+        const char* name;
+        WireProtocol protocol;
+    };
+    for (const Named& named : {Named{"DDP", WireProtocol::Ddp}, Named{"E1.31", WireProtocol::E131}}) {
+        const ProtocolOptions options;
+        ProtocolEncoder encoder(named.protocol, options);
+        for (bool segmented : {false, true}) {
+            for (bool connected : {false, true}) {
+                const std::string run = std::string(named.name) + (segmented ? " segmented" : "") +
+                                        (connected ? " connected" : "");
+                UDPSender sender;
+                if (!expect(sender.open() && sender.setDestinations(receiver.addrs, connected), run + ": cannot open the sender"))
+                    continue;
+                if (segmented && !sender.setSegmentation(true)) {
+                    std::cout << "  kernel without UDP_SEGMENT, " << run << " skipped\n";
+                    continue;
+                }
+                const auto& packets = encoder.encode(pixels.data(), pixels.size());
+                for (const PacketView& packet : packets)
+                    sender.queuePacket(0, packet.data, packet.size);
+                const bool flushed = sender.flush();
+
+                const auto received = receiver.receive(0);
+                std::vector<PacketView> views;
+                for (const auto& datagram : received)
+                    views.push_back({datagram.data(), datagram.size()});
+                std::vector<Rgb8> decoded;
+                int sequence = -1;
+                std::string error;
+                expect(flushed, run + ": flush failed");
+                expect(received.size() == packets.size(), run + ": " + std::to_string(received.size()) + " of " +
+                                                              std::to_string(packets.size()) + " packets");
+                expect(decodePackets(named.protocol, options, views, decoded, sequence, error) && decoded == pixels,
+                       run + ": " + (error.empty() ? "frame differs" : error));
+            }
+        }
+    }
+#endif
+}
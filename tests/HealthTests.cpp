@@ -0,0 +1,93 @@
+#include "TestSupport.h"
+#include "UDPSender.h"
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------
+// testHealth
+//----------------------------------------------------------------------
+// 50 frames to 8 connected loopback devices, the first of which is a
+// closed port that refuses every other send, without and with the
+// circuit breaker. The healthy devices must receive every frame and
+// show no error or open circuit; the refusing device must count errors
+// and be paused only by the breaker. With every device healthy nothing
+// is paused.
+//----------------------------------------------------------------------
+void testHealth() {
+#ifdef _WIN32
+    std::cout << "  needs POSIX sockets for the receivers, skipped\n";
+#else
+    constexpr int kDevices = 8;
+    constexpr int kFrames = 50;
+    LoopbackReceivers receivers;
+    if (!expect(receivers.open(kDevices), "cannot bind loopback receivers"))
+        return;
+    const std::vector<sockaddr_in> addrs = receivers.addrs;
+    ::close(receivers.sockets[0]); // nobody listens on device 0 anymore
+    receivers.sockets.erase(receivers.sockets.begin());
+
+    const std::array<int, 3> color = {4, 5, 6};
+    const std::string expected = "R004G005B006\n";
+    struct Variant {
+        const char* label;
+        bool dead;
+        int failureThreshold;
+    };
+    const Variant variants[] = {{"all healthy", false, 5},
+                                {"one refusing, no breaker", true, 1 << 24},
+                                {"one refusing, breaker", true, 5}};
+    for (const auto& variant : variants) {
+        const std::string label = variant.label;
+        UDPSender sender;
+        HealthOptions options;
+        options.failureThreshold = variant.failureThreshold;
+        sender.setHealthOptions(options);
+        std::vector<sockaddr_in> targets = addrs;
+        if (!variant.dead)
+            targets[0] = addrs[1];
+        if (!expect(sender.open() && sender.setDestinations(targets, true), label + ": cannot open the sender"))
+            continue;
+        for (int f = 0; f < kFrames; ++f) {
+            for (int i = 0; i < kDevices; ++i)
+                sender.queue(static_cast<size_t>(i), color);
+            sender.flush();
+        }
+
+        // Receiver r listens for device r + 1; device 0 of the healthy
+        // run also sends to receiver 0
+        for (size_t r = 0; r < receivers.sockets.size(); ++r) {
+            const auto datagrams = receivers.receive(r);
+            const size_t want = !variant.dead && r == 0 ? 2 * kFrames : kFrames;
+            bool payloads = true;
+            for (const auto& d : datagrams)
+                payloads = payloads && std::string(d.begin(), d.end()) == expected;
+            expect(datagrams.size() == want && payloads,
+                   label + ": device " + std::to_string(r + 1) + " got " + std::to_string(datagrams.size()) +
+                       " of " + std::to_string(want) + " frames" + (payloads ? "" : " with a wrong payload"));
+        }
+        const auto& health = sender.health();
+        for (size_t i = 1; i < health.size(); ++i) {
+            expect(health[i].errors == 0 && !health[i].circuitOpen && health[i].sent == kFrames,
+                   label + ": healthy device " + std::to_string(i) + " has " + std::to_string(health[i].errors) +
+                       " errors" + (health[i].circuitOpen ? ", paused" : ""));
+        }
+        const DeviceHealth& first = health[0];
+        if (!variant.dead) {
+            expect(first.errors == 0 && !first.circuitOpen, label + ": device 0 has errors");
+            continue;
+        }
+        const bool breaker = variant.failureThreshold < (1 << 24);
+        expect(first.errors > 0, label + ": refusing device has no errors");
+        expect(first.circuitOpen == breaker, label + (breaker ? ": refusing device not paused"
+                                                              : ": refusing device paused without a breaker"));
+        if (breaker)
+            expect(first.dropped > 0, label + ": paused device had nothing dropped");
+    }
+#endif
+}
@@ -0,0 +1,140 @@
+#include "TestSupport.h"
+#include "PixelFormats.h"
+#include "PixelKernels.h"
+#include "RGBProcessor.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+const KernelIsa kVectorIsas[] = {KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::AVX512, KernelIsa::NEON};
+
+std::string mismatch(KernelIsa isa, const std::string& what) {
+    return std::string(kernelIsaName(isa)) + " " + what + " differs from the scalar kernel";
+}
+
+//----------------------------------------------------------------------
+// testRowSums
+//----------------------------------------------------------------------
+// Plain, table and 10-bit row sums on rows that end in a partial vector.
+//----------------------------------------------------------------------
+void testRowSums() {
+    auto frame = makeFrame(1920 - 5, 64, PixelFormat::RGBA8, 1234);
+    const uint16_t* table = linearLightTable(PixelFormat::RGBA8);
+    uint64_t expected[3][3] = {};
+    for (int y = 0; y < frame.view.height; ++y) {
+        rowSumKernel(KernelIsa::Scalar)(frame.view.row(y), frame.view.width, expected[0]);
+        tableRowSumKernel(KernelIsa::Scalar)(frame.view.row(y), frame.view.width, table, expected[1]);
+        tenBitRowSumKernel(KernelIsa::Scalar)(frame.view.row(y), frame.view.width, expected[2]);
+    }
+
+    for (KernelIsa isa : kVectorIsas) {
+        const RowSumKernel plain = rowSumKernel(isa);
+        const TableRowSumKernel lookup = tableRowSumKernel(isa);
+        const TenBitRowSumKernel tenBit = tenBitRowSumKernel(isa);
+        uint64_t actual[3][3] = {};
+        for (int y = 0; y < frame.view.height; ++y) {
+            if (plain)
+                plain(frame.view.row(y), frame.view.width, actual[0]);
+            if (lookup)
+                lookup(frame.view.row(y), frame.view.width, table, actual[1]);
+            if (tenBit)
+                tenBit(frame.view.row(y), frame.view.width, actual[2]);
+        }
+        expect(!plain || std::equal(actual[0], actual[0] + 3, expected[0]), mismatch(isa, "row sum"));
+        expect(!lookup || std::equal(actual[1], actual[1] + 3, expected[1]), mismatch(isa, "table row sum"));
+        expect(!tenBit || std::equal(actual[2], actual[2] + 3, expected[2]), mismatch(isa, "10-bit row sum"));
+    }
+
+    // The dispatched average on odd widths, BGRA and RGBA
+    for (PixelFormat format : {PixelFormat::BGRA8, PixelFormat::RGBA8}) {
+        auto odd = makeFrame(1920 - 3, 7, format, 99);
+        expect(getRGBAverage(odd.view) == getRGBAverageScalar(odd.view), "average differs on an odd width");
+    }
+}
+
+//----------------------------------------------------------------------
+// testPyramidKernels
+//----------------------------------------------------------------------
+// Box filter, column sums (overwriting, then accumulating) and block
+// means for every block size, with column totals as large as the rows
+// of a block can make them.
+//----------------------------------------------------------------------
+void testPyramidKernels() {
+    const int width = 1920;
+    auto frame = makeFrame(width, 16, PixelFormat::BGRA8, 8);
+    const int w = width / 2;
+    const int bytes = width * 4;
+    const size_t pitch = frame.view.rowPitch;
+    std::vector<uint8_t> expected(w * 4), actual(w * 4), expectedMeans(w * 4), actualMeans(w * 4);
+    std::vector<uint16_t> expectedColumns(bytes), actualColumns(bytes), blockColumns(bytes);
+    downsampleKernel(KernelIsa::Scalar)(frame.view.row(0), frame.view.row(1), w, expected.data());
+    for (int rows : {3, 8})
+        columnSumKernel(KernelIsa::Scalar)(frame.view.row(0), pitch, rows, bytes, expectedColumns.data(), rows == 8);
+
+    for (KernelIsa isa : kVectorIsas) {
+        if (DownsampleKernel kernel = downsampleKernel(isa)) {
+            kernel(frame.view.row(0), frame.view.row(1), w, actual.data());
+            expect(actual == expected, mismatch(isa, "box filter"));
+        }
+        if (ColumnSumKernel kernel = columnSumKernel(isa)) {
+            for (int rows : {3, 8})
+                kernel(frame.view.row(0), pitch, rows, bytes, actualColumns.data(), rows == 8);
+            expect(actualColumns == expectedColumns, mismatch(isa, "column sum"));
+        }
+        if (BlockMeanKernel kernel = blockMeanKernel(isa)) {
+            for (int shift = 1; shift <= 8; ++shift) {
+                const int block = 1 << shift;
+                for (int i = 0; i < bytes; ++i)
+                    blockColumns[i] = static_cast<uint16_t>(frame.view.row(0)[i] * block);
+                uint64_t expectedTotals[4] = {0, 0, 0, 0}, actualTotals[4] = {0, 0, 0, 0};
+                blockMeanKernel(KernelIsa::Scalar)(blockColumns.data(), width >> shift, shift,
+                                                   expectedMeans.data(), expectedTotals);
+                kernel(blockColumns.data(), width >> shift, shift, actualMeans.data(), actualTotals);
+                expect(actualMeans == expectedMeans && std::equal(expectedTotals, expectedTotals + 4, actualTotals),
+                       mismatch(isa, "block mean of " + std::to_string(block)));
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// testBytesDiffer
+//----------------------------------------------------------------------
+// Byte comparison with the difference in each position of a vector and
+// in the tail, just inside and just outside the threshold.
+//----------------------------------------------------------------------
+void testBytesDiffer() {
+    std::vector<uint8_t> noise = makeFrame(900, 1, PixelFormat::BGRA8, 7).pixels;
+    for (KernelIsa isa : kVectorIsas) {
+        const BytesDifferKernel kernel = bytesDifferKernel(isa);
+        if (!kernel)
+            continue;
+        bool same = true;
+        for (size_t size : {size_t{3}, size_t{16}, size_t{45}, size_t{900}}) {
+            std::vector<uint8_t> a(noise.begin(), noise.begin() + size), b = a;
+            for (size_t pos = 0; pos < size && same; ++pos) {
+                for (int delta : {-3, -2, 2, 3}) {
+                    b[pos] = static_cast<uint8_t>((std::clamp)(a[pos] + delta, 0, 255));
+                    const bool expected = bytesDifferKernel(KernelIsa::Scalar)(a.data(), b.data(), size, 2);
+                    same = same && kernel(a.data(), b.data(), size, 2) == expected;
+                }
+                b[pos] = a[pos];
+            }
+        }
+        expect(same, mismatch(isa, "byte comparison"));
+    }
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// testKernels
+//----------------------------------------------------------------------
+// Every SIMD kernel the build and CPU support against the scalar one.
+//----------------------------------------------------------------------
+void testKernels() {
+    testRowSums();
+    testPyramidKernels();
+    testBytesDiffer();
+}
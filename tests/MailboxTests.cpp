@@ -0,0 +1,52 @@
+#include "TestSupport.h"
+#include "LatestMailbox.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------
+// testMailbox
+//----------------------------------------------------------------------
+// Publish 200k sequence numbers as fast as possible to a consumer on
+// another thread. Taken stamps must be in order without repeats, every
+// frame is either taken or replaced (and handed to the drop handler),
+// and the last frame is still delivered after stop.
+//----------------------------------------------------------------------
+void testMailbox() {
+    constexpr int kItems = 200000;
+    std::atomic<uint64_t> handled{0};
+    LatestMailbox<int> mailbox([&](int&) { handled.fetch_add(1, std::memory_order_relaxed); });
+    std::vector<int> taken;
+    std::thread consumer([&] {
+        int value = 0;
+        while (mailbox.take(value))
+            taken.push_back(value);
+    });
+    for (int i = 0; i < kItems; ++i)
+        mailbox.publish(i);
+    mailbox.stop();
+    consumer.join();
+
+    expect(std::is_sorted(taken.begin(), taken.end()) &&
+               std::adjacent_find(taken.begin(), taken.end()) == taken.end(),
+           "stamps repeated or out of order");
+    expect(mailbox.published() == kItems, std::to_string(mailbox.published()) + " of " +
+                                              std::to_string(kItems) + " frames published");
+    expect(taken.size() + mailbox.dropped() == kItems,
+           std::to_string(taken.size()) + " taken and " + std::to_string(mailbox.dropped()) + " replaced of " +
+               std::to_string(kItems));
+    expect(handled.load() == mailbox.dropped(), std::to_string(handled.load()) +
+                                                    " frames handed to the drop handler, " +
+                                                    std::to_string(mailbox.dropped()) + " replaced");
+    expect(!taken.empty() && taken.back() == kItems - 1, "last frame not delivered after stop");
+
+    // Published after stop: refused and dropped
+    LatestMailbox<int> stopped;
+    stopped.stop();
+    int value = 0;
+    expect(!stopped.publish(1) && stopped.dropped() == 1 && !stopped.take(value),
+           "publish after stop was not dropped");
+}
@@ -0,0 +1,80 @@
+#include "TestSupport.h"
+#include "SendPacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------
+// testPacing
+//----------------------------------------------------------------------
+// Run the send pacer for 10 s of simulated 60 fps capture with 200
+// devices, one limited to 20 and one to 120 packets per second. The
+// device at 20/s must stay at its rate with gaps of at least one
+// period, no device may get more packets than there are frames and the
+// unlimited ones get every frame; spreading over 4 slices must cut the
+// largest burst to a quarter.
+//----------------------------------------------------------------------
+void testPacing() {
+    using Clock = SendPacer::Clock;
+    constexpr int kDevices = 200;
+    constexpr double kFps = 60.0;
+    constexpr double kSeconds = 10.0;
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / kFps));
+    std::vector<double> rates(kDevices, 0.0);
+    rates[0] = 20.0;
+    rates[1] = 120.0;
+
+    for (int slices : {1, 4}) {
+        SendPacer pacer;
+        pacer.reset(rates, interval, slices);
+        const Clock::time_point start{};
+        const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+                                                  std::chrono::duration<double>(kSeconds));
+        std::vector<size_t> sends(kDevices, 0);
+        std::vector<Clock::time_point> last(kDevices, Clock::time_point::min());
+        Clock::duration minGap0 = Clock::duration::max();
+        size_t maxBurst = 0;
+        size_t frames = 0;
+        Clock::time_point nextFrame = start;
+        std::vector<size_t> due;
+        while (true) {
+            const Clock::time_point now = (std::min)(nextFrame, pacer.nextDue());
+            if (now >= end)
+                break;
+            if (now == nextFrame) {
+                ++frames;
+                pacer.onFrame(now);
+                nextFrame += interval;
+            }
+            due.clear();
+            pacer.collectDue(now, due);
+            maxBurst = (std::max)(maxBurst, due.size());
+            for (size_t i : due) {
+                if (i == 0 && last[0] != Clock::time_point::min())
+                    minGap0 = (std::min)(minGap0, now - last[0]);
+                last[i] = now;
+                ++sends[i];
+            }
+        }
+
+        const std::string run = std::to_string(slices) + (slices > 1 ? " slices" : " slice");
+        const double rate0 = static_cast<double>(sends[0]) / kSeconds;
+        expect(rate0 <= rates[0] + 0.1 && rate0 >= rates[0] * 0.95,
+               run + ": device 0 at " + std::to_string(rate0) + "/s, limit " + std::to_string(rates[0]) + "/s");
+        expect(minGap0 >= std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rates[0])),
+               run + ": device 0 sent " +
+                   std::to_string(std::chrono::duration<double, std::milli>(minGap0).count()) + " ms apart");
+        bool bounded = true;
+        for (size_t s : sends)
+            bounded = bounded && s <= frames;
+        expect(bounded, run + ": a device got more packets than the " + std::to_string(frames) + " frames");
+        expect(sends[1] >= frames * 99 / 100 && sends[2] >= frames * 99 / 100,
+               run + ": devices above the frame rate got " + std::to_string(sends[1]) + " and " +
+                   std::to_string(sends[2]) + " of " + std::to_string(frames) + " frames");
+        const size_t burstLimit = (kDevices + slices - 1) / slices + 2;
+        expect(maxBurst <= burstLimit, run + ": burst of " + std::to_string(maxBurst) + " packets, limit " +
+                                           std::to_string(burstLimit));
+    }
+}
@@ -0,0 +1,61 @@
+#include "TestSupport.h"
+#include "PayloadFormat.h"
+
+#include <array>
+#include <cstdio>
+#include <string>
+
+//----------------------------------------------------------------------
+// testPayload
+//----------------------------------------------------------------------
+// The formats of the original regex path render like printf across the
+// color range, and every placeholder of the extended grammar renders as
+// documented. Malformed placeholders are rejected with an error.
+//----------------------------------------------------------------------
+void testPayload() {
+    char buf[256], expected[256];
+    struct Legacy {
+        const char* format;
+        const char* printfFormat;
+    };
+    const Legacy legacy[] = {{"R{r:03d}G{g:03d}B{b:03d}\n", "R%03dG%03dB%03d\n"},
+                             {"{r},{g},{b}", "%d,%d,%d"}};
+    for (const auto& l : legacy) {
+        PayloadFormat compiled;
+        expect(compiled.compile(l.format), std::string("cannot compile ") + l.format);
+        for (int v = 0; v < 256; v += 7) {
+            const std::array<int, 3> rgb = {v, 255 - v, (v * 3) % 256};
+            const size_t n = compiled.render(rgb, 0, buf, sizeof(buf));
+            std::snprintf(expected, sizeof(expected), l.printfFormat, rgb[0], rgb[1], rgb[2]);
+            if (!expect(std::string(buf, n) == expected, std::string("wrong render of ") + l.format + ": " +
+                                                              std::string(buf, n)))
+                break;
+        }
+    }
+
+    struct Case {
+        const char* format;
+        std::array<int, 3> rgb;
+        int index;
+        const char* expected;
+    };
+    const Case cases[] = {
+        {"#{r:02x}{g:02x}{b:02X}", {10, 171, 255}, 0, "#0aabFF"},
+        {"{h} {s} {v}", {255, 0, 0}, 0, "0 100 100"},
+        {"{h} {s} {v}", {0, 128, 128}, 0, "180 100 50"},
+        {"{i:03d}:{r}", {1, 2, 3}, 7, "007:1"},
+        {"{{r}} {r}}}", {9, 0, 0}, 0, "{r} 9}"},
+        {"{x} {r", {1, 0, 0}, 0, "{x} {r"},
+        {"{\"seg\":{{\"col\":[[{r},{g},{b}]]}}}}", {1, 2, 3}, 0, "{\"seg\":{\"col\":[[1,2,3]]}}"},
+    };
+    for (const auto& c : cases) {
+        PayloadFormat compiled;
+        compiled.compile(c.format);
+        const size_t n = compiled.render(c.rgb, c.index, buf, sizeof(buf));
+        expect(std::string(buf, n) == c.expected,
+               std::string("wrong render of ") + c.format + ": " + std::string(buf, n));
+    }
+
+    std::string error;
+    expect(!PayloadFormat().compile("{r:3q}", &error) && !error.empty(), "malformed placeholder accepted");
+}
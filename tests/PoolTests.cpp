@@ -0,0 +1,131 @@
+#include "TestSupport.h"
+#include "FramePool.h"
+#include "LatestMailbox.h"
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+//----------------------------------------------------------------------
+// checkBounds
+//----------------------------------------------------------------------
+// A 3-buffer pool hands out three leases and no fourth, with page
+// aligned buffers, cache-line aligned rows and the copied contents. A
+// released buffer is reused, shrinking reallocates nothing and leaves
+// a lease at the old size alone, growing reallocates once.
+//----------------------------------------------------------------------
+void checkBounds(const TestFrame& frame) {
+    const size_t rowBytes = static_cast<size_t>(frame.view.width) * 4;
+    FramePool pool(FramePoolOptions{3, false});
+    FrameLease a = pool.copy(frame.view);
+    FrameLease b = pool.acquire();
+    FrameLease c = pool.acquire();
+    FrameLease d = pool.acquire();
+    expect(a && b && c && !d && pool.exhausted() == 1 && pool.available() == 0,
+           "pool of 3 did not hand out exactly 3 leases");
+    if (!expect(static_cast<bool>(a), "copy returned an empty lease"))
+        return;
+    bool contents = true;
+    for (int y = 0; y < frame.view.height; ++y)
+        contents = contents && std::memcmp(a.view().row(y), frame.view.row(y), rowBytes) == 0;
+    expect(contents, "copied frame differs");
+    expect(reinterpret_cast<uintptr_t>(a.data()) % 4096 == 0, "buffer not page aligned");
+    expect(a.view().rowPitch % 64 == 0, "row pitch " + std::to_string(a.view().rowPitch) +
+                                            " not a multiple of a cache line");
+
+    b.reset();
+    FrameLease e = pool.acquire();
+    expect(e && pool.available() == 0, "released buffer not reused");
+
+    const uint64_t before = pool.allocations();
+    pool.resize(1280, 720, PixelFormat::RGBA8);
+    e.reset();
+    FrameLease small = pool.acquire();
+    expect(small && small.view().width == 1280 && small.view().format == PixelFormat::RGBA8,
+           "shrunk lease has the wrong geometry");
+    expect(a.view().width == 1920, "shrinking changed a leased frame");
+    expect(pool.allocations() == before, "shrinking reallocated");
+    small.reset();
+    pool.resize(2560, 1440, PixelFormat::BGRA8);
+    FrameLease large = pool.acquire();
+    expect(large && large.view().width == 2560 && pool.allocations() == before + 1,
+           "growing did not reallocate exactly once");
+}
+
+//----------------------------------------------------------------------
+// checkLeasesThroughMailbox
+//----------------------------------------------------------------------
+// Capture fills 3000 frames with one value each, changing resolution
+// now and then, and hands them to processing as leases through the
+// latest-frame mailbox. Processing must never see a frame with mixed
+// values, every lease comes back to the pool and each buffer grows at
+// most once per resolution.
+//----------------------------------------------------------------------
+void checkLeasesThroughMailbox() {
+    constexpr int kFrames = 3000;
+    constexpr int kSide = 256;
+    constexpr size_t kBytes = size_t(kSide) * kSide * 4;
+    FramePool pool(FramePoolOptions{3, false});
+    std::vector<uint8_t> source(kBytes);
+    FrameView sourceView{source.data(), kSide, kSide, size_t(kSide) * 4, PixelFormat::BGRA8};
+    LatestMailbox<FrameLease> mailbox([](FrameLease& lease) { lease.reset(); });
+    int torn = 0;
+    int seen = 0;
+    std::thread processing([&] {
+        FrameLease lease;
+        while (mailbox.take(lease)) {
+            const FrameView& v = lease.view();
+            bool same = true;
+            for (int y = 0; y < v.height && same; ++y) {
+                const uint8_t* row = v.row(y);
+                for (int x = 0; x < v.width * 4 && same; ++x)
+                    same = row[x] == v.data[0];
+            }
+            torn += same ? 0 : 1;
+            ++seen;
+            lease.reset();
+        }
+    });
+    for (int i = 0; i < kFrames; ++i) {
+        sourceView.width = sourceView.height = (i / 500) % 2 ? kSide / 2 : kSide;
+        std::memset(source.data(), i & 0xff, kBytes);
+        FrameLease lease = pool.copy(sourceView);
+        if (lease)
+            mailbox.publish(std::move(lease));
+    }
+    mailbox.stop();
+    processing.join();
+
+    expect(seen > 0, "processing saw no frames");
+    expect(torn == 0, std::to_string(torn) + " of " + std::to_string(seen) + " frames half overwritten");
+    expect(pool.available() == pool.capacity(), std::to_string(pool.capacity() - pool.available()) +
+                                                    " leases not returned");
+    // A buffer first leased at the small size grows once at the large one
+    expect(pool.allocations() <= 2 * static_cast<uint64_t>(pool.capacity()),
+           std::to_string(pool.allocations()) + " allocations for " + std::to_string(pool.capacity()) + " buffers");
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// testPool
+//----------------------------------------------------------------------
+// Repeated copies of an unchanged 1080p frame allocate once, with and
+// without huge pages; then the bounds, alignment and resize rules and
+// the lease handoff between threads.
+//----------------------------------------------------------------------
+void testPool() {
+    auto frame = makeFrame(1920, 1080, PixelFormat::BGRA8, 31);
+    for (bool huge : {false, true}) {
+        FramePool pool(FramePoolOptions{3, huge});
+        for (int i = 0; i < 10; ++i) {
+            FrameLease lease = pool.copy(frame.view);
+            expect(static_cast<bool>(lease), "copy returned an empty lease");
+        }
+        expect(pool.allocations() == 1, std::string(huge ? "huge pages: " : "") + "unchanged frame size took " +
+                                            std::to_string(pool.allocations()) + " allocations");
+    }
+    checkBounds(frame);
+    checkLeasesThroughMailbox();
+}
@@ -0,0 +1,73 @@
+#include "TestSupport.h"
+#include "ProtocolDecoder.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------
+// testProtocols
+//----------------------------------------------------------------------
+// Encode strips of lengths around the packet and universe boundaries
+// with every binary protocol for a few frames, decode them with the
+// independent decoder and compare. Sequence numbers must advance. A
+// strip starting two universes before the last one of E1.31 or Art-Net
+// ends on that universe and its remaining LEDs are not sent.
+//----------------------------------------------------------------------
+void testProtocols() {
+    struct Named {
+        const char* name;
+        WireProtocol protocol;
+    };
+    const Named protocols[] = {{"ddp", WireProtocol::Ddp},
+                               {"e131", WireProtocol::E131},
+                               {"artnet", WireProtocol::ArtNet},
+                               {"wled", WireProtocol::Wled}};
+    const size_t counts[] = {1, 170, 171, 480, 490, 491, 1000};
+
+    std::mt19937 rng(99);
+    for (const auto& named : protocols) {
+        ProtocolOptions options;
+        options.universe = named.protocol == WireProtocol::E131 ? 7 : 3;
+        options.priority = 150;
+        options.wledTimeout = 5;
+        for (size_t count : counts) {
+            const std::string strip = std::string(named.name) + " " + std::to_string(count) + " LEDs";
+            ProtocolEncoder encoder(named.protocol, options);
+            std::vector<Rgb8> pixels(count), decoded;
+            int previous = -1;
+            for (int frame = 0; frame < 3; ++frame) {
+                for (auto& px : pixels)
+                    px = {static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()),
+                          static_cast<uint8_t>(rng())};
+                int sequence = -1;
+                std::string error;
+                const auto& packets = encoder.encode(pixels.data(), pixels.size());
+                if (!expect(decodePackets(named.protocol, options, packets, decoded, sequence, error),
+                            strip + ": " + error))
+                    break;
+                expect(decoded == pixels, strip + ": pixels differ");
+                expect(sequence != previous || sequence <= 0, strip + ": sequence did not advance");
+                previous = sequence;
+            }
+        }
+    }
+
+    for (const auto& named : {protocols[1], protocols[2]}) {
+        ProtocolOptions options;
+        options.universe = ProtocolEncoder::maxUniverse(named.protocol) - 1;
+        ProtocolEncoder encoder(named.protocol, options);
+        std::vector<Rgb8> pixels(500), decoded;
+        for (auto& px : pixels)
+            px = {static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng())};
+        int sequence = -1;
+        std::string error;
+        const std::string strip = std::string(named.name) + " from universe " + std::to_string(options.universe);
+        const auto& packets = encoder.encode(pixels.data(), pixels.size());
+        expect(packets.size() == 2, strip + ": " + std::to_string(packets.size()) + " universes sent");
+        expect(decodePackets(named.protocol, options, packets, decoded, sequence, error) && decoded.size() == 340 &&
+                   std::equal(decoded.begin(), decoded.end(), pixels.begin()),
+               strip + ": " + (error.empty() ? "pixels differ" : error));
+    }
+}
@@ -0,0 +1,86 @@
+#include "TestSupport.h"
+#include "FramePyramid.h"
+#include "RGBProcessor.h"
+#include "WorkerPool.h"
+
+#include <string>
+
+namespace {
+//----------------------------------------------------------------------
+// finestLevelExact
+//----------------------------------------------------------------------
+// Every byte of the finest level is the rounded mean of its block.
+//----------------------------------------------------------------------
+bool finestLevelExact(const FramePyramid& pyramid, const FrameView& frame) {
+    const FrameView finest = pyramid.level(0);
+    const int block = pyramid.levelScale(0);
+    for (int y = 0; y < finest.height; ++y) {
+        for (int x = 0; x < finest.width * 4; ++x) {
+            uint32_t sum = 0;
+            for (int by = 0; by < block; ++by) {
+                for (int bx = 0; bx < block; ++bx)
+                    sum += frame.row(y * block + by)[(x / 4 * block + bx) * 4 + x % 4];
+            }
+            if (finest.row(y)[x] != (sum + block * block / 2) / (block * block))
+                return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// coarseLevelsExact
+//----------------------------------------------------------------------
+// Every coarser level is the rounded 2x2 mean of the one before it.
+//----------------------------------------------------------------------
+bool coarseLevelsExact(const FramePyramid& pyramid) {
+    for (int k = 1; k < pyramid.levelCount(); ++k) {
+        const FrameView src = pyramid.level(k - 1);
+        const FrameView dst = pyramid.level(k);
+        for (int y = 0; y < dst.height; ++y) {
+            for (int x = 0; x < dst.width * 4; ++x) {
+                const int i = (x / 4 * 2) * 4 + x % 4;
+                const int sum = src.row(2 * y)[i] + src.row(2 * y)[i + 4] + src.row(2 * y + 1)[i] +
+                                src.row(2 * y + 1)[i + 4];
+                if (dst.row(y)[x] != (sum + 2) / 4)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// testPyramid
+//----------------------------------------------------------------------
+// Frames with and without a remainder below and right of the last
+// block, reduced on one thread and on a pool: the thumbnail keeps the
+// target size, the levels are exact block means and the average equals
+// the full-frame one.
+//----------------------------------------------------------------------
+void testPyramid() {
+    const int sizes[][2] = {{1920, 1080}, {1366, 768}, {3840, 2160}};
+    const int targets[][2] = {{64, 36}, {128, 72}};
+    WorkerPool pool(4);
+    for (const auto& size : sizes) {
+        auto frame = makeFrame(size[0], size[1], PixelFormat::BGRA8, 8);
+        const auto average = getRGBAverage(frame.view);
+        for (const auto& target : targets) {
+            const std::string name = std::to_string(size[0]) + "x" + std::to_string(size[1]) + " -> " +
+                                     std::to_string(target[0]) + "x" + std::to_string(target[1]);
+            for (WorkerPool* p : {static_cast<WorkerPool*>(nullptr), &pool}) {
+                FramePyramid pyramid;
+                pyramid.setTargetSize(target[0], target[1]);
+                const FrameView thumb = pyramid.build(frame.view, p);
+                const std::string run = name + (p ? " on the pool" : "");
+                expect(thumb.width >= target[0] && thumb.width < 2 * target[0] && thumb.height >= target[1] &&
+                           thumb.height < 2 * target[1],
+                       run + ": thumbnail is " + std::to_string(thumb.width) + "x" + std::to_string(thumb.height));
+                expect(pyramid.average() == average, run + ": average differs from getRGBAverage");
+                expect(finestLevelExact(pyramid, frame.view), run + ": finest level is not the block means");
+                expect(coarseLevelsExact(pyramid), run + ": coarser levels are not 2x2 means");
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include "TestSupport.h"
+#include "SpscRing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------
+// testRings
+//----------------------------------------------------------------------
+// Pass 200k sequence numbers through an 8-slot ring under each overflow
+// policy, against a consumer that keeps up (block) or that is slower
+// than the producer (drop). Nothing may be reordered or duplicated,
+// every item is either delivered or dropped (and handed to the drop
+// callback), block drops nothing, drop-oldest delivers the last item
+// and drop-newest the first.
+//----------------------------------------------------------------------
+void testRings() {
+    constexpr int kItems = 200000;
+    struct Named {
+        const char* name;
+        OverflowPolicy policy;
+    };
+    for (const Named& named : {Named{"block", OverflowPolicy::Block},
+                               Named{"drop oldest", OverflowPolicy::DropOldest},
+                               Named{"drop newest", OverflowPolicy::DropNewest}}) {
+        std::atomic<uint64_t> handled{0};
+        SpscRing<int> ring(8, named.policy, [&](int&) { handled.fetch_add(1, std::memory_order_relaxed); });
+        std::vector<int> received;
+        received.reserve(kItems);
+        const bool slow = named.policy != OverflowPolicy::Block;
+        std::thread consumer([&] {
+            int value = 0;
+            while (ring.pop(value)) {
+                received.push_back(value);
+                if (slow && value % 64 == 0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+        for (int i = 0; i < kItems; ++i)
+            ring.push(i);
+        ring.stop();
+        consumer.join();
+
+        const std::string name = named.name;
+        const uint64_t dropped = ring.dropped();
+        expect(std::is_sorted(received.begin(), received.end()) &&
+                   std::adjacent_find(received.begin(), received.end()) == received.end(),
+               name + ": items reordered or duplicated");
+        expect(received.size() + dropped == kItems, name + ": " + std::to_string(received.size()) +
+                                                        " delivered and " + std::to_string(dropped) +
+                                                        " dropped of " + std::to_string(kItems));
+        expect(handled.load() == dropped, name + ": " + std::to_string(handled.load()) +
+                                              " items handed to the drop callback, " + std::to_string(dropped) +
+                                              " dropped");
+        if (!expect(!received.empty(), name + ": nothing delivered"))
+            continue;
+        if (named.policy == OverflowPolicy::Block)
+            expect(dropped == 0, name + ": dropped items");
+        if (named.policy == OverflowPolicy::DropOldest)
+            expect(received.back() == kItems - 1, name + ": last item not delivered");
+        if (named.policy == OverflowPolicy::DropNewest)
+            expect(received.front() == 0, name + ": first item not delivered");
+    }
+}
@@ -0,0 +1,84 @@
+#include "TestSupport.h"
+#include "RGBProcessor.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+//----------------------------------------------------------------------
+// makeCorpus
+//----------------------------------------------------------------------
+// Frames that stress sampling: noise, smooth gradients, a sparse grid
+// of one-pixel UI lines on black and a mostly dark desktop with a single
+// bright window.
+//----------------------------------------------------------------------
+std::vector<TestFrame> makeCorpus(int width, int height) {
+    std::vector<TestFrame> corpus;
+    corpus.push_back(makeFrame(width, height, PixelFormat::BGRA8, 7));
+
+    auto fill = [&](auto&& pixel) {
+        TestFrame f = makeFrame(width, height, PixelFormat::BGRA8, 0);
+        for (int y = 0; y < height; ++y) {
+            uint8_t* row = f.pixels.data() + y * f.view.rowPitch;
+            for (int x = 0; x < width; ++x) {
+                uint8_t* px = row + x * 4;
+                pixel(x, y, px);
+                px[3] = 255;
+            }
+        }
+        corpus.push_back(std::move(f));
+    };
+
+    fill([&](int x, int y, uint8_t* px) {
+        px[0] = static_cast<uint8_t>(x * 255 / width);
+        px[1] = static_cast<uint8_t>(y * 255 / height);
+        px[2] = static_cast<uint8_t>(255 - x * 255 / width);
+    });
+    fill([&](int x, int y, uint8_t* px) {
+        const uint8_t v = (x % 8 == 0 || y % 16 == 0) ? 255 : 0;
+        px[0] = px[1] = px[2] = v;
+    });
+    fill([&](int x, int y, uint8_t* px) {
+        const bool window = x > width / 3 && x < width / 2 && y > height / 4 && y < height / 2;
+        px[0] = window ? 40 : 18;
+        px[1] = window ? 60 : 18;
+        px[2] = window ? 230 : 20;
+    });
+    return corpus;
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// testSampling
+//----------------------------------------------------------------------
+// The full pattern must reproduce the exact average, and strided and
+// budgeted patterns must stay within a few 8-bit steps of it on the
+// corpus, the UI line grid included.
+//----------------------------------------------------------------------
+void testSampling() {
+    constexpr int kMaxSampledError = 8;
+    auto corpus = makeCorpus(3840, 2160);
+    std::vector<FrameView> views;
+    for (const auto& f : corpus)
+        views.push_back(f.view);
+
+    expect(measureSamplingError(views, SamplingOptions{}).maxError == 0, "full sampling is not exact");
+
+    struct Case {
+        const char* label;
+        SamplingOptions options;
+    };
+    const Case cases[] = {
+        {"stride 2x2", {2, 2, 0}},
+        {"stride 8x8", {8, 8, 0}},
+        {"stride 16x8", {16, 8, 0}},
+        {"budget 65536", {1, 1, 65536}},
+        {"budget 16384", {1, 1, 16384}},
+    };
+    for (const auto& c : cases) {
+        const SamplingError err = measureSamplingError(views, c.options);
+        expect(err.maxError <= kMaxSampledError,
+               std::string(c.label) + " is off by " + std::to_string(err.maxError) + " steps");
+    }
+}
@@ -0,0 +1,103 @@
+#include "TestSupport.h"
+#include "FrameScheduler.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace {
+using Clock = FrameScheduler::Clock;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+//----------------------------------------------------------------------
+// checkAdvance
+//----------------------------------------------------------------------
+// A cycle done before the next deadline moves one period on; one that
+// runs past deadlines skips them and realigns on the grid; one done
+// exactly at a deadline is not an overrun.
+//----------------------------------------------------------------------
+void checkAdvance(Clock::time_point t0) {
+    FrameScheduler s;
+    s.reset(milliseconds(10), microseconds(0), t0);
+    expect(s.deadline() == t0, "first deadline is not the start");
+    s.advance(t0 + milliseconds(1));
+    expect(s.deadline() == t0 + milliseconds(10) && s.stats().overruns == 0, "on-time cycle did not move one period");
+    s.advance(t0 + milliseconds(35)); // 20 and 30 are past
+    expect(s.deadline() == t0 + milliseconds(40), "overrun did not realign on the grid");
+    expect(s.stats().overruns == 1 && s.stats().skipped == 2,
+           "overrun counted " + std::to_string(s.stats().overruns) + " overruns and " +
+               std::to_string(s.stats().skipped) + " skipped deadlines");
+    s.advance(t0 + milliseconds(40));
+    expect(s.deadline() == t0 + milliseconds(50) && s.stats().overruns == 1,
+           "cycle ending on a deadline counted as an overrun");
+}
+
+//----------------------------------------------------------------------
+// checkGrid
+//----------------------------------------------------------------------
+// A simulated loop of 4 ms periods whose work takes 0.3-1.5 ms with a
+// 10 ms overrun every 50 cycles: every deadline stays on the grid, and
+// after n cycles with k skipped deadlines the loop is n + k periods in.
+//----------------------------------------------------------------------
+void checkGrid(Clock::time_point t0) {
+    constexpr auto kPeriod = milliseconds(4);
+    constexpr int kCycles = 150;
+    std::mt19937 rng(3);
+    FrameScheduler s;
+    s.reset(kPeriod, microseconds(0), t0);
+    bool onGrid = true;
+    for (int i = 0; i < kCycles; ++i) {
+        const Clock::time_point reached = s.deadline();
+        s.tick(reached);
+        const auto busy = i % 50 == 25 ? microseconds(10000) : microseconds(300 + rng() % 1200);
+        s.advance(reached + busy);
+        onGrid = onGrid && (s.deadline() - t0) % kPeriod == Clock::duration::zero() &&
+                 s.deadline() > reached + busy;
+    }
+    const ScheduleStats st = s.stats();
+    expect(onGrid, "a deadline left the grid or lay in the past");
+    expect(st.overruns == kCycles / 50, std::to_string(st.overruns) + " overruns in " + std::to_string(kCycles) +
+                                            " cycles");
+    expect(st.skipped == 2 * st.overruns, std::to_string(st.skipped) + " deadlines skipped for " +
+                                              std::to_string(st.overruns) + " 10 ms overruns");
+    expect(s.deadline() - t0 == kPeriod * static_cast<int>(kCycles + st.skipped),
+           "loop is not on the deadline its cycles and skips add up to");
+}
+
+//----------------------------------------------------------------------
+// checkStats
+//----------------------------------------------------------------------
+// Ticks at 0, 10, 21 and 41 ms of a 10 ms grid: the skipped deadline
+// counts as two periods, so the deviations are 0, 1 and 0 ms.
+//----------------------------------------------------------------------
+void checkStats(Clock::time_point t0) {
+    FrameScheduler s;
+    s.reset(milliseconds(10), microseconds(0), t0);
+    s.tick(t0);
+    s.tick(t0 + milliseconds(10));
+    s.tick(t0 + milliseconds(21));
+    s.tick(t0 + milliseconds(41));
+    const ScheduleStats st = s.stats();
+    expect(st.ticks == 4, std::to_string(st.ticks) + " ticks counted");
+    expect(std::abs(st.meanPeriodUs - 41000.0 / 3) < 0.5, "mean period " + std::to_string(st.meanPeriodUs) + " us");
+    expect(std::abs(st.maxDeviationUs - 1000.0) < 0.5, "max deviation " + std::to_string(st.maxDeviationUs) + " us");
+    expect(std::abs(st.jitterUs - std::sqrt(1.0 / 3) * 1000.0) < 0.5, "jitter " + std::to_string(st.jitterUs) + " us");
+    s.resetStats();
+    expect(s.stats().ticks == 0 && s.stats().overruns == 0, "resetStats kept counts");
+}
+} // namespace
+
+//----------------------------------------------------------------------
+// testSchedule
+//----------------------------------------------------------------------
+// FrameScheduler deadline, skip and statistics arithmetic on synthetic
+// time points; nothing sleeps.
+//----------------------------------------------------------------------
+void testSchedule() {
+    const Clock::time_point t0 = Clock::now();
+    checkAdvance(t0);
+    checkGrid(t0);
+    checkStats(t0);
+}
@@ -0,0 +1,53 @@
+#include "TestSupport.h"
+
+#include <iostream>
+#include <string>
+
+namespace {
+struct TestEntry {
+    const char* name;
+    void (*run)();
+};
+
+const TestEntry kTests[] = {
+    {"kernels", testKernels},
+    {"sampling", testSampling},
+    {"pyramid", testPyramid},
+    {"protocols", testProtocols},
+    {"payload", testPayload},
+    {"delta", testDelta},
+    {"gso", testGso},
+    {"rings", testRings},
+    {"mailbox", testMailbox},
+    {"pool", testPool},
+    {"schedule", testSchedule},
+    {"formats", testFormats},
+    {"gate", testGate},
+    {"health", testHealth},
+    {"pacing", testPacing},
+};
+} // namespace
+
+// Entry point of the correctness tests, registered with ctest one test
+// at a time.
+//
+// Usage: RGBStreamerTests [name|all]
+int main(int argc, char* argv[]) {
+    const std::string name = argc > 1 ? argv[1] : "all";
+    bool found = false;
+    for (const auto& test : kTests) {
+        if (name != "all" && name != test.name)
+            continue;
+        found = true;
+        std::cout << test.name << "\n";
+        test.run();
+    }
+    if (!found) {
+        std::cerr << "Unknown test: " << name << "\nAvailable: all";
+        for (const auto& test : kTests)
+            std::cerr << ", " << test.name;
+        std::cerr << "\n";
+        return 1;
+    }
+    return failedChecks() == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include "TestSupport.h"
+
+#include <iostream>
+#include <random>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+int gFailedChecks = 0;
+} // namespace
+
+//----------------------------------------------------------------------
+// makeFrame
+//----------------------------------------------------------------------
+TestFrame makeFrame(int width, int height, PixelFormat format, uint32_t seed) {
+    TestFrame f;
+    const size_t pitch = (static_cast<size_t>(width) * 4 + 255) & ~static_cast<size_t>(255);
+    f.pixels.resize(pitch * height);
+    std::mt19937 rng(seed);
+    for (auto& b : f.pixels)
+        b = static_cast<uint8_t>(rng());
+    f.view.data = f.pixels.data();
+    f.view.width = width;
+    f.view.height = height;
+    f.view.rowPitch = pitch;
+    f.view.format = format;
+    return f;
+}
+
+//----------------------------------------------------------------------
+// expect
+//----------------------------------------------------------------------
+bool expect(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cout << "  FAILED: " << what << "\n";
+        ++gFailedChecks;
+    }
+    return condition;
+}
+
+//----------------------------------------------------------------------
+// failedChecks
+//----------------------------------------------------------------------
+int failedChecks() {
+    return gFailedChecks;
+}
+
+#ifndef _WIN32
+//----------------------------------------------------------------------
+// LoopbackReceivers
+//----------------------------------------------------------------------
+LoopbackReceivers::~LoopbackReceivers() {
+    for (int s : sockets)
+        ::close(s);
+}
+
+bool LoopbackReceivers::open(int count, int receiveBuffer) {
+    for (int i = 0; i < count; ++i) {
+        const int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (s < 0)
+            return false;
+        sockets.push_back(s);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            getsockname(s, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+            return false;
+        if (receiveBuffer > 0)
+            setsockopt(s, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+        addrs.push_back(addr);
+    }
+    return true;
+}
+
+std::vector<std::vector<uint8_t>> LoopbackReceivers::receive(size_t index) {
+    std::vector<std::vector<uint8_t>> datagrams;
+    std::vector<uint8_t> buf(65536);
+    ssize_t n;
+    while ((n = recv(sockets[index], buf.data(), buf.size(), MSG_DONTWAIT)) >= 0)
+        datagrams.emplace_back(buf.begin(), buf.begin() + n);
+    return datagrams;
+}
+#endif
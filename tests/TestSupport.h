@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FrameView.h"
+#ifndef _WIN32
+#include <netinet/in.h>
+#endif
+
+/**
+ * Helpers shared by the correctness tests.
+ *
+ * Every test is a function that records failed checks with `expect` and
+ * keeps going, so one run reports all of them. `RGBStreamerTests <name>`
+ * runs a single test and exits non-zero if any of its checks failed.
+ */
+
+/** CPU frame owning its pixels, used as test input. */
+struct TestFrame {
+    std::vector<uint8_t> pixels;
+    FrameView view;
+};
+
+/**
+ * Frame of deterministic noise. The row pitch is padded the way GPU
+ * staging textures usually are.
+ */
+TestFrame makeFrame(int width, int height, PixelFormat format, uint32_t seed);
+
+/**
+ * Record a check. Prints `what` and counts a failure if `condition` is
+ * false.
+ * @return `condition`, so callers can stop early.
+ */
+bool expect(bool condition, const std::string& what);
+
+/** Failed checks since the start of the process. */
+int failedChecks();
+
+#ifndef _WIN32
+/** UDP sockets bound to ephemeral loopback ports, closed on destruction. */
+struct LoopbackReceivers {
+    std::vector<int> sockets;
+    std::vector<sockaddr_in> addrs;
+
+    LoopbackReceivers() = default;
+    LoopbackReceivers(const LoopbackReceivers&) = delete;
+    LoopbackReceivers& operator=(const LoopbackReceivers&) = delete;
+    ~LoopbackReceivers();
+
+    /**
+     * Bind `count` receivers.
+     * @param receiveBuffer SO_RCVBUF of each socket in bytes; 0 keeps the default.
+     */
+    bool open(int count, int receiveBuffer = 0);
+
+    /** Datagrams waiting at receiver `index`, emptying its queue. */
+    std::vector<std::vector<uint8_t>> receive(size_t index);
+};
+#endif
+
+// Tests, one per ctest entry
+void testKernels();
+void testSampling();
+void testPyramid();
+void testProtocols();
+void testPayload();
+void testDelta();
+void testGso();
+void testRings();
+void testMailbox();
+void testPool();
+void testSchedule();
+void testFormats();
+void testGate();
+void testHealth();
+void testPacing();